@@ -434,11 +434,141 @@ void AudioDataConverters::convertFormatToFloat (const DataFormat sourceFormat,
 }
 
 //==============================================================================
+namespace InterleavingHelpers
+{
+    // With the channel count known at compile-time, each frame can be
+    // written (or read) in one go, rather than making a pass per channel.
+    template <int numChannels>
+    static void interleave (const float* const* source, float* dest, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            for (int chan = 0; chan < numChannels; ++chan)
+                *dest++ = source[chan][i];
+    }
+
+    template <int numChannels>
+    static void deinterleave (const float* source, float* const* dest, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            for (int chan = 0; chan < numChannels; ++chan)
+                dest[chan][i] = *source++;
+    }
+
+   #if JUCE_USE_SSE_INTRINSICS
+    template <>
+    void interleave<2> (const float* const* source, float* dest, int numSamples) noexcept
+    {
+        const float* left = source[0];
+        const float* right = source[1];
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const __m128 l = _mm_loadu_ps (left + i);
+            const __m128 r = _mm_loadu_ps (right + i);
+
+            _mm_storeu_ps (dest + 2 * i,     _mm_unpacklo_ps (l, r));
+            _mm_storeu_ps (dest + 2 * i + 4, _mm_unpackhi_ps (l, r));
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            dest[2 * i]     = left[i];
+            dest[2 * i + 1] = right[i];
+        }
+    }
+
+    template <>
+    void deinterleave<2> (const float* source, float* const* dest, int numSamples) noexcept
+    {
+        float* left = dest[0];
+        float* right = dest[1];
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const __m128 a = _mm_loadu_ps (source + 2 * i);
+            const __m128 b = _mm_loadu_ps (source + 2 * i + 4);
+
+            _mm_storeu_ps (left + i,  _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0)));
+            _mm_storeu_ps (right + i, _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1)));
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            left[i]  = source[2 * i];
+            right[i] = source[2 * i + 1];
+        }
+    }
+
+    template <>
+    void interleave<4> (const float* const* source, float* dest, int numSamples) noexcept
+    {
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            __m128 c0 = _mm_loadu_ps (source[0] + i), c1 = _mm_loadu_ps (source[1] + i),
+                   c2 = _mm_loadu_ps (source[2] + i), c3 = _mm_loadu_ps (source[3] + i);
+
+            _MM_TRANSPOSE4_PS (c0, c1, c2, c3);
+
+            _mm_storeu_ps (dest + 4 * i,      c0);
+            _mm_storeu_ps (dest + 4 * i + 4,  c1);
+            _mm_storeu_ps (dest + 4 * i + 8,  c2);
+            _mm_storeu_ps (dest + 4 * i + 12, c3);
+        }
+
+        for (; i < numSamples; ++i)
+            for (int chan = 0; chan < 4; ++chan)
+                dest[4 * i + chan] = source[chan][i];
+    }
+
+    template <>
+    void deinterleave<4> (const float* source, float* const* dest, int numSamples) noexcept
+    {
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            __m128 f0 = _mm_loadu_ps (source + 4 * i),     f1 = _mm_loadu_ps (source + 4 * i + 4),
+                   f2 = _mm_loadu_ps (source + 4 * i + 8), f3 = _mm_loadu_ps (source + 4 * i + 12);
+
+            _MM_TRANSPOSE4_PS (f0, f1, f2, f3);
+
+            _mm_storeu_ps (dest[0] + i, f0);
+            _mm_storeu_ps (dest[1] + i, f1);
+            _mm_storeu_ps (dest[2] + i, f2);
+            _mm_storeu_ps (dest[3] + i, f3);
+        }
+
+        for (; i < numSamples; ++i)
+            for (int chan = 0; chan < 4; ++chan)
+                dest[chan][i] = source[4 * i + chan];
+    }
+   #endif
+}
+
 void AudioDataConverters::interleaveSamples (const float** const source,
                                              float* const dest,
                                              const int numSamples,
                                              const int numChannels)
 {
+    using namespace InterleavingHelpers;
+
+    switch (numChannels)
+    {
+        case 1:     memcpy (dest, source[0], sizeof (float) * (size_t) numSamples); return;
+        case 2:     interleave<2> (source, dest, numSamples); return;
+        case 3:     interleave<3> (source, dest, numSamples); return;
+        case 4:     interleave<4> (source, dest, numSamples); return;
+        case 5:     interleave<5> (source, dest, numSamples); return;
+        case 6:     interleave<6> (source, dest, numSamples); return;
+        case 7:     interleave<7> (source, dest, numSamples); return;
+        case 8:     interleave<8> (source, dest, numSamples); return;
+        default:    break;
+    }
+
     for (int chan = 0; chan < numChannels; ++chan)
     {
         int i = chan;
@@ -457,6 +587,21 @@ void AudioDataConverters::deinterleaveSamples (const float* const source,
                                                const int numSamples,
                                                const int numChannels)
 {
+    using namespace InterleavingHelpers;
+
+    switch (numChannels)
+    {
+        case 1:     memcpy (dest[0], source, sizeof (float) * (size_t) numSamples); return;
+        case 2:     deinterleave<2> (source, dest, numSamples); return;
+        case 3:     deinterleave<3> (source, dest, numSamples); return;
+        case 4:     deinterleave<4> (source, dest, numSamples); return;
+        case 5:     deinterleave<5> (source, dest, numSamples); return;
+        case 6:     deinterleave<6> (source, dest, numSamples); return;
+        case 7:     deinterleave<7> (source, dest, numSamples); return;
+        case 8:     deinterleave<8> (source, dest, numSamples); return;
+        default:    break;
+    }
+
     for (int chan = 0; chan < numChannels; ++chan)
     {
         int i = chan;
@@ -470,6 +615,237 @@ void AudioDataConverters::deinterleaveSamples (const float* const source,
     }
 }
 
+//==============================================================================
+namespace BlockConversionHelpers
+{
+    inline int readInt16LE (const uint8* p) noexcept      { return (int16) (p[0] | (p[1] << 8)); }
+    inline int readInt24LE (const uint8* p) noexcept      { return (int) (((uint32) p[0] << 8) | ((uint32) p[1] << 16) | ((uint32) p[2] << 24)) >> 8; }
+
+    // Reads a 24-bit sample with a single 32-bit load, so this will touch the byte after it!
+    inline int readInt24LEFast (const uint8* p) noexcept  { uint32 n; memcpy (&n, p, 4); return (int) (n << 8) >> 8; }
+
+    inline void writeInt16LE (uint8* p, int v) noexcept   { p[0] = (uint8) v; p[1] = (uint8) (v >> 8); }
+    inline void writeInt24LE (uint8* p, int v) noexcept   { p[0] = (uint8) v; p[1] = (uint8) (v >> 8); p[2] = (uint8) (v >> 16); }
+
+    // These match the rounding and clipping of AudioData::Int16 and AudioData::Int24
+    template <int maxValue>
+    inline int floatToInt (float v) noexcept
+    {
+        return jlimit (-maxValue, maxValue, roundToInt (v * (1.0 + maxValue)));
+    }
+
+   #if JUCE_USE_SSE_INTRINSICS
+    static bool canUseSSE2() noexcept
+    {
+       #if JUCE_64BIT
+        return true;
+       #else
+        static const bool sse2 = SystemStats::hasSSE2();
+        return sse2;
+       #endif
+    }
+
+    // The multiply by a power of two is exact, and _mm_cvtps_epi32 rounds to nearest-even like
+    // roundToInt(), so clamping before the conversion gives the same results as floatToInt().
+    template <int maxValue>
+    inline __m128i floatToInt (__m128 v) noexcept
+    {
+        const __m128 limit = _mm_set1_ps ((float) maxValue);
+        v = _mm_mul_ps (v, _mm_set1_ps ((float) (1.0 + maxValue)));
+        v = _mm_min_ps (_mm_max_ps (v, _mm_sub_ps (_mm_setzero_ps(), limit)), limit);
+        return _mm_cvtps_epi32 (v);
+    }
+
+    inline __m128 gatherFloats (const float* source, int stride) noexcept
+    {
+        return _mm_setr_ps (source[0], source[stride], source[2 * stride], source[3 * stride]);
+    }
+
+    inline void scatterFloats (float* dest, int stride, __m128 v) noexcept
+    {
+        float f[4];
+        _mm_storeu_ps (f, v);
+
+        for (int i = 0; i < 4; ++i)
+            dest[i * stride] = f[i];
+    }
+   #endif
+}
+
+void AudioData::BlockConversions::int16LEToFloat (float* dest, const int destStride, const void* const source,
+                                                  const int sourceStride, const int numSamples) noexcept
+{
+    using namespace BlockConversionHelpers;
+    const uint8* src = static_cast<const uint8*> (source);
+    const int srcStep = 2 * sourceStride;
+    const float scale = 1.0f / 0x8000;
+    int i = 0;
+
+   #if JUCE_USE_SSE_INTRINSICS
+    if (canUseSSE2())
+    {
+        const __m128 mult = _mm_set1_ps (scale);
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            __m128i ints;
+
+            if (sourceStride == 1)
+            {
+                ints = _mm_loadl_epi64 (reinterpret_cast<const __m128i*> (src));
+                ints = _mm_srai_epi32 (_mm_unpacklo_epi16 (ints, ints), 16);
+            }
+            else if (sourceStride == 2 && i + 5 <= numSamples) // (this reads one sample beyond the last one it uses)
+            {
+                ints = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src));
+                ints = _mm_srai_epi32 (_mm_slli_epi32 (ints, 16), 16);
+            }
+            else
+            {
+                ints = _mm_setr_epi32 (readInt16LE (src), readInt16LE (src + srcStep),
+                                       readInt16LE (src + 2 * srcStep), readInt16LE (src + 3 * srcStep));
+            }
+
+            const __m128 v = _mm_mul_ps (_mm_cvtepi32_ps (ints), mult);
+
+            if (destStride == 1)  _mm_storeu_ps (dest, v);
+            else                  scatterFloats (dest, destStride, v);
+
+            src += 4 * srcStep;
+            dest += 4 * destStride;
+        }
+    }
+   #endif
+
+    for (; i < numSamples; ++i)
+    {
+        *dest = readInt16LE (src) * scale;
+        src += srcStep;
+        dest += destStride;
+    }
+}
+
+void AudioData::BlockConversions::int24LEToFloat (float* dest, const int destStride, const void* const source,
+                                                  const int sourceStride, const int numSamples) noexcept
+{
+    using namespace BlockConversionHelpers;
+    const uint8* src = static_cast<const uint8*> (source);
+    const int srcStep = 3 * sourceStride;
+    const float scale = 1.0f / 0x800000;
+    int i = 0;
+
+   #if JUCE_USE_SSE_INTRINSICS
+    if (canUseSSE2())
+    {
+        const __m128 mult = _mm_set1_ps (scale);
+
+        for (; i + 5 <= numSamples; i += 4) // (stops early, as the last read goes one byte past the sample)
+        {
+            const __m128i ints = _mm_setr_epi32 (readInt24LEFast (src), readInt24LEFast (src + srcStep),
+                                                 readInt24LEFast (src + 2 * srcStep), readInt24LEFast (src + 3 * srcStep));
+
+            const __m128 v = _mm_mul_ps (_mm_cvtepi32_ps (ints), mult);
+
+            if (destStride == 1)  _mm_storeu_ps (dest, v);
+            else                  scatterFloats (dest, destStride, v);
+
+            src += 4 * srcStep;
+            dest += 4 * destStride;
+        }
+    }
+   #endif
+
+    for (; i < numSamples; ++i)
+    {
+        *dest = readInt24LE (src) * scale;
+        src += srcStep;
+        dest += destStride;
+    }
+}
+
+void AudioData::BlockConversions::floatToInt16LE (void* const dest, const int destStride, const float* source,
+                                                  const int sourceStride, const int numSamples) noexcept
+{
+    using namespace BlockConversionHelpers;
+    uint8* dst = static_cast<uint8*> (dest);
+    const int dstStep = 2 * destStride;
+    int i = 0;
+
+   #if JUCE_USE_SSE_INTRINSICS
+    if (canUseSSE2())
+    {
+        if (sourceStride == 1 && destStride == 1)
+        {
+            for (; i + 8 <= numSamples; i += 8)
+            {
+                const __m128i lo = floatToInt<0x7fff> (_mm_loadu_ps (source));
+                const __m128i hi = floatToInt<0x7fff> (_mm_loadu_ps (source + 4));
+                _mm_storeu_si128 (reinterpret_cast<__m128i*> (dst), _mm_packs_epi32 (lo, hi));
+
+                source += 8;
+                dst += 16;
+            }
+        }
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            int32 ints[4];
+            _mm_storeu_si128 (reinterpret_cast<__m128i*> (ints),
+                              floatToInt<0x7fff> (sourceStride == 1 ? _mm_loadu_ps (source)
+                                                                    : gatherFloats (source, sourceStride)));
+
+            for (int j = 0; j < 4; ++j)
+                writeInt16LE (dst + j * dstStep, ints[j]);
+
+            source += 4 * sourceStride;
+            dst += 4 * dstStep;
+        }
+    }
+   #endif
+
+    for (; i < numSamples; ++i)
+    {
+        writeInt16LE (dst, floatToInt<0x7fff> (*source));
+        source += sourceStride;
+        dst += dstStep;
+    }
+}
+
+void AudioData::BlockConversions::floatToInt24LE (void* const dest, const int destStride, const float* source,
+                                                  const int sourceStride, const int numSamples) noexcept
+{
+    using namespace BlockConversionHelpers;
+    uint8* dst = static_cast<uint8*> (dest);
+    const int dstStep = 3 * destStride;
+    int i = 0;
+
+   #if JUCE_USE_SSE_INTRINSICS
+    if (canUseSSE2())
+    {
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            int32 ints[4];
+            _mm_storeu_si128 (reinterpret_cast<__m128i*> (ints),
+                              floatToInt<0x7fffff> (sourceStride == 1 ? _mm_loadu_ps (source)
+                                                                      : gatherFloats (source, sourceStride)));
+
+            for (int j = 0; j < 4; ++j)
+                writeInt24LE (dst + j * dstStep, ints[j]);
+
+            source += 4 * sourceStride;
+            dst += 4 * dstStep;
+        }
+    }
+   #endif
+
+    for (; i < numSamples; ++i)
+    {
+        writeInt24LE (dst, floatToInt<0x7fffff> (*source));
+        source += sourceStride;
+        dst += dstStep;
+    }
+}
+
 
 //==============================================================================
 #if JUCE_UNIT_TESTS
@@ -592,6 +968,123 @@ public:
         Test1 <AudioData::Int32>::test (*this, r);
         beginTest ("Round-trip conversion: Float32");
         Test1 <AudioData::Float32>::test (*this, r);
+
+        beginTest ("Block conversions match sample-by-sample conversion");
+        BlockTest <AudioData::Int16>::test (*this, r);
+        BlockTest <AudioData::Int24>::test (*this, r);
+
+        beginTest ("Interleaving");
+        testInterleaving (r);
+    }
+
+    // Converts interleaved integer data to and from floats via Pointer::convertSamples()
+    // (which uses AudioData::BlockConversions), and compares the results with a plain
+    // sample-by-sample conversion.
+    template <class IntFormat>
+    struct BlockTest
+    {
+        typedef AudioData::Pointer<IntFormat, AudioData::LittleEndian, AudioData::Interleaved, AudioData::NonConst> IntPointer;
+        typedef AudioData::Pointer<AudioData::Float32, AudioData::NativeEndian, AudioData::Interleaved, AudioData::NonConst> FloatPointer;
+        typedef AudioData::Pointer<IntFormat, AudioData::LittleEndian, AudioData::Interleaved, AudioData::Const> ConstIntPointer;
+        typedef AudioData::Pointer<AudioData::Float32, AudioData::NativeEndian, AudioData::Interleaved, AudioData::Const> ConstFloatPointer;
+
+        static void test (UnitTest& unitTest, Random& r)
+        {
+            const int strides[] = { 1, 2, 3, 5 };
+
+            for (int i = 0; i < numElementsInArray (strides); ++i)
+                for (int j = 0; j < numElementsInArray (strides); ++j)
+                    test (unitTest, r, strides[i], strides[j], r.nextInt (300));
+        }
+
+        static void test (UnitTest& unitTest, Random& r, int intStride, int floatStride, int numSamples)
+        {
+            HeapBlock<char> ints1, ints2;
+            HeapBlock<float> floats1, floats2;
+            ints1.calloc ((size_t) (numSamples * intStride * IntPointer::getBytesPerSample() + 1));
+            ints2.calloc ((size_t) (numSamples * intStride * IntPointer::getBytesPerSample() + 1));
+            floats1.calloc ((size_t) (numSamples * floatStride + 1));
+            floats2.calloc ((size_t) (numSamples * floatStride + 1));
+
+            {
+                FloatPointer f (floats1, floatStride);
+                IntPointer n (ints1, intStride);
+
+                for (int i = 0; i < numSamples; ++i, ++f, ++n)
+                {
+                    // include some out-of-range values and some that round to a half
+                    f.setAsFloat ((i & 7) == 0 ? (r.nextInt (2001) - 1000) / (1.0f + IntFormat::maxValue)
+                                               : r.nextFloat() * 2.4f - 1.2f);
+                    n.setAsInt32 (r.nextInt());
+                }
+            }
+
+            // int to float..
+            FloatPointer (floats2, floatStride).convertSamples (ConstIntPointer (ints1, intStride), numSamples);
+
+            bool matches = true;
+
+            {
+                FloatPointer f (floats2, floatStride);
+                IntPointer n (ints1, intStride);
+
+                for (int i = 0; i < numSamples; ++i, ++f, ++n)
+                    matches = matches && f.getAsFloat() == n.getAsFloat();
+            }
+
+            unitTest.expect (matches);
+
+            // ..and float to int
+            IntPointer (ints2, intStride).convertSamples (ConstFloatPointer (floats1, floatStride), numSamples);
+
+            {
+                FloatPointer f (floats1, floatStride);
+                IntPointer n (ints2, intStride);
+                HeapBlock<char> expected ((size_t) IntPointer::getBytesPerSample());
+
+                for (int i = 0; i < numSamples; ++i, ++f, ++n)
+                {
+                    AudioData::Pointer<IntFormat, AudioData::LittleEndian, AudioData::NonInterleaved, AudioData::NonConst> e (expected);
+                    e.setAsFloat (f.getAsFloat());
+                    matches = matches && e.getAsInt32() == n.getAsInt32();
+                }
+            }
+
+            unitTest.expect (matches);
+        }
+    };
+
+    void testInterleaving (Random& r)
+    {
+        for (int numChannels = 1; numChannels <= 9; ++numChannels)
+        {
+            const int numSamples = r.nextInt (200);
+            AudioSampleBuffer channels (numChannels, numSamples + 1), deinterleaved (numChannels, numSamples + 1);
+            HeapBlock<float> interleaved ((size_t) (numChannels * numSamples + 1));
+
+            for (int chan = 0; chan < numChannels; ++chan)
+                for (int i = 0; i < numSamples; ++i)
+                    *channels.getSampleData (chan, i) = r.nextFloat();
+
+            AudioDataConverters::interleaveSamples (const_cast<const float**> (channels.getArrayOfChannels()),
+                                                    interleaved, numSamples, numChannels);
+            AudioDataConverters::deinterleaveSamples (interleaved, deinterleaved.getArrayOfChannels(),
+                                                      numSamples, numChannels);
+
+            bool interleavedCorrectly = true, deinterleavedCorrectly = true;
+
+            for (int chan = 0; chan < numChannels; ++chan)
+            {
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    interleavedCorrectly   = interleavedCorrectly   && interleaved[i * numChannels + chan] == *channels.getSampleData (chan, i);
+                    deinterleavedCorrectly = deinterleavedCorrectly && *deinterleaved.getSampleData (chan, i) == *channels.getSampleData (chan, i);
+                }
+            }
+
+            expect (interleavedCorrectly);
+            expect (deinterleavedCorrectly);
+        }
     }
 };
 
@@ -305,6 +305,58 @@ public:
         enum { isInterleavedType = 1 };
     };
 
+    //==============================================================================
+    /** Optimised versions of the most common conversions, which Pointer::convertSamples()
+        uses in place of its sample-by-sample loop when the source and destination don't overlap.
+        The integer data is little-endian, the floats are native, and each stride is the distance
+        from one sample to the next, measured in samples.
+    */
+    struct JUCE_API BlockConversions
+    {
+        static void int16LEToFloat (float* dest, int destStride, const void* source, int sourceStride, int numSamples) noexcept;
+        static void int24LEToFloat (float* dest, int destStride, const void* source, int sourceStride, int numSamples) noexcept;
+        static void floatToInt16LE (void* dest, int destStride, const float* source, int sourceStride, int numSamples) noexcept;
+        static void floatToInt24LE (void* dest, int destStride, const float* source, int sourceStride, int numSamples) noexcept;
+    };
+
+    // Chooses one of the BlockConversions at compile-time for a pair of formats, if there is one.
+    template <class DestFormat, class SourceFormat, int unused = 0>
+    struct BlockConverter
+    {
+        enum { isAvailable = 0 };
+        static void convert (void*, int, const void*, int, int) noexcept {}
+    };
+
+   #if JUCE_LITTLE_ENDIAN
+    template <int unused>
+    struct BlockConverter<Float32, Int16, unused>
+    {
+        enum { isAvailable = 1 };
+        static void convert (void* d, int ds, const void* s, int ss, int num) noexcept    { BlockConversions::int16LEToFloat (static_cast<float*> (d), ds, s, ss, num); }
+    };
+
+    template <int unused>
+    struct BlockConverter<Float32, Int24, unused>
+    {
+        enum { isAvailable = 1 };
+        static void convert (void* d, int ds, const void* s, int ss, int num) noexcept    { BlockConversions::int24LEToFloat (static_cast<float*> (d), ds, s, ss, num); }
+    };
+
+    template <int unused>
+    struct BlockConverter<Int16, Float32, unused>
+    {
+        enum { isAvailable = 1 };
+        static void convert (void* d, int ds, const void* s, int ss, int num) noexcept    { BlockConversions::floatToInt16LE (d, ds, static_cast<const float*> (s), ss, num); }
+    };
+
+    template <int unused>
+    struct BlockConverter<Int24, Float32, unused>
+    {
+        enum { isAvailable = 1 };
+        static void convert (void* d, int ds, const void* s, int ss, int num) noexcept    { BlockConversions::floatToInt24LE (d, ds, static_cast<const float*> (s), ss, num); }
+    };
+   #endif
+
     //==============================================================================
     class NonConst
     {
@@ -355,6 +407,9 @@ public:
     class Pointer  : private InterleavingType  // (inherited for EBCO)
     {
     public:
+        typedef SampleFormat SampleFormatType;
+        typedef Endianness EndiannessType;
+
         //==============================================================================
         /** Creates a non-interleaved pointer from some raw data in the appropriate format.
             This constructor is only used if you've specified the AudioData::NonInterleaved option -
@@ -460,6 +515,17 @@ public:
 
             Pointer dest (*this);
 
+            typedef BlockConverter<SampleFormat, typename OtherPointerType::SampleFormatType> FastConverter;
+
+            if (FastConverter::isAvailable && ! (Endianness::isBigEndian || OtherPointerType::EndiannessType::isBigEndian)
+                 && ! overlaps (source, numSamples))
+            {
+                FastConverter::convert (dest.data.data, getNumBytesBetweenSamples() / getBytesPerSample(),
+                                        source.getRawData(), source.getNumBytesBetweenSamples() / source.getBytesPerSample(),
+                                        numSamples);
+                return;
+            }
+
             if (source.getRawData() != getRawData() || source.getNumBytesBetweenSamples() >= getNumBytesBetweenSamples())
             {
                 while (--numSamples >= 0)
@@ -566,6 +632,16 @@ public:
 
         inline void advance() noexcept                          { this->advanceData (data); }
 
+        template <class OtherPointerType>
+        bool overlaps (const OtherPointerType& other, int numSamples) const noexcept
+        {
+            const char* const start = static_cast<const char*> (getRawData());
+            const char* const otherStart = static_cast<const char*> (other.getRawData());
+
+            return start < otherStart + numSamples * other.getNumBytesBetweenSamples()
+                    && otherStart < start + numSamples * getNumBytesBetweenSamples();
+        }
+
         Pointer operator++ (int); // private to force you to use the more efficient pre-increment!
         Pointer operator-- (int);
     };
@@ -274,14 +274,9 @@ void AudioSampleBuffer::applyGainRamp (const int channel,
         jassert (isPositiveAndBelow (channel, numChannels));
         jassert (startSample >= 0 && startSample + numSamples <= size);
 
-        const float increment = (endGain - startGain) / numSamples;
-        float* d = channels [channel] + startSample;
-
-        while (--numSamples >= 0)
-        {
-            *d++ *= startGain;
-            startGain += increment;
-        }
+        if (numSamples > 0)
+            FloatVectorOperations::multiplyWithRamp (channels [channel] + startSample, startGain,
+                                                     (endGain - startGain) / numSamples, numSamples);
     }
 }
 
@@ -368,16 +363,8 @@ void AudioSampleBuffer::addFromWithRamp (const int destChannel,
     else
     {
         if (numSamples > 0 && (startGain != 0.0f || endGain != 0.0f))
-        {
-            const float increment = (endGain - startGain) / numSamples;
-            float* d = channels [destChannel] + destStartSample;
-
-            while (--numSamples >= 0)
-            {
-                *d++ += startGain * *source++;
-                startGain += increment;
-            }
-        }
+            FloatVectorOperations::addWithRamp (channels [destChannel] + destStartSample, source, startGain,
+                                                (endGain - startGain) / numSamples, numSamples);
     }
 }
 
@@ -459,16 +446,8 @@ void AudioSampleBuffer::copyFromWithRamp (const int destChannel,
     else
     {
         if (numSamples > 0 && (startGain != 0.0f || endGain != 0.0f))
-        {
-            const float increment = (endGain - startGain) / numSamples;
-            float* d = channels [destChannel] + destStartSample;
-
-            while (--numSamples >= 0)
-            {
-                *d++ = startGain * *source++;
-                startGain += increment;
-            }
-        }
+            FloatVectorOperations::copyWithRamp (channels [destChannel] + destStartSample, source, startGain,
+                                                 (endGain - startGain) / numSamples, numSamples);
     }
 }
 
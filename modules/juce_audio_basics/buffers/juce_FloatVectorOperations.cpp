@@ -25,8 +25,9 @@
 namespace FloatVectorHelpers
 {
 
-    #define JUCE_INCREMENT_SRC_DEST    dest += 4; src += 4;
-    #define JUCE_INCREMENT_DEST        dest += 4;
+    // (the number of values that fit into a 128-bit register depends on the type being processed)
+    #define JUCE_INCREMENT_SRC_DEST    dest += (16 / sizeof (*dest)); src += (16 / sizeof (*src));
+    #define JUCE_INCREMENT_DEST        dest += (16 / sizeof (*dest));
 
    #if JUCE_USE_SSE_INTRINSICS
     static bool sse2Present = false;
@@ -45,46 +46,94 @@ namespace FloatVectorHelpers
         return (((pointer_sized_int) p) & 15) == 0;
     }
 
-    static inline float findMinimumOrMaximum (const float* src, int num, const bool isMinimum) noexcept
+    struct BasicOps32
     {
-        const int numLongOps = num / 4;
+        typedef float Type;
+        typedef __m128 ParallelType;
+        enum { numParallel = 4 };
+
+        static forcedinline ParallelType load1 (Type v) noexcept                        { return _mm_load1_ps (&v); }
+        static forcedinline ParallelType loadA (const Type* v) noexcept                 { return _mm_load_ps (v); }
+        static forcedinline ParallelType loadU (const Type* v) noexcept                 { return _mm_loadu_ps (v); }
+        static forcedinline void storeA (Type* dest, ParallelType a) noexcept           { _mm_store_ps (dest, a); }
+        static forcedinline void storeU (Type* dest, ParallelType a) noexcept           { _mm_storeu_ps (dest, a); }
+        static forcedinline ParallelType add (ParallelType a, ParallelType b) noexcept  { return _mm_add_ps (a, b); }
+        static forcedinline ParallelType mul (ParallelType a, ParallelType b) noexcept  { return _mm_mul_ps (a, b); }
+        static forcedinline ParallelType min (ParallelType a, ParallelType b) noexcept  { return _mm_min_ps (a, b); }
+        static forcedinline ParallelType max (ParallelType a, ParallelType b) noexcept  { return _mm_max_ps (a, b); }
+
+        static forcedinline ParallelType ramp (Type start, Type increment) noexcept
+        {
+            return _mm_setr_ps (start, start + increment, start + 2 * increment, start + 3 * increment);
+        }
+
+        static forcedinline Type min (ParallelType a) noexcept  { Type v[4]; storeU (v, a); return jmin (v[0], v[1], v[2], v[3]); }
+        static forcedinline Type max (ParallelType a) noexcept  { Type v[4]; storeU (v, a); return jmax (v[0], v[1], v[2], v[3]); }
+    };
+
+    struct BasicOps64
+    {
+        typedef double Type;
+        typedef __m128d ParallelType;
+        enum { numParallel = 2 };
+
+        static forcedinline ParallelType load1 (Type v) noexcept                        { return _mm_load1_pd (&v); }
+        static forcedinline ParallelType loadA (const Type* v) noexcept                 { return _mm_load_pd (v); }
+        static forcedinline ParallelType loadU (const Type* v) noexcept                 { return _mm_loadu_pd (v); }
+        static forcedinline void storeA (Type* dest, ParallelType a) noexcept           { _mm_store_pd (dest, a); }
+        static forcedinline void storeU (Type* dest, ParallelType a) noexcept           { _mm_storeu_pd (dest, a); }
+        static forcedinline ParallelType add (ParallelType a, ParallelType b) noexcept  { return _mm_add_pd (a, b); }
+        static forcedinline ParallelType mul (ParallelType a, ParallelType b) noexcept  { return _mm_mul_pd (a, b); }
+        static forcedinline ParallelType min (ParallelType a, ParallelType b) noexcept  { return _mm_min_pd (a, b); }
+        static forcedinline ParallelType max (ParallelType a, ParallelType b) noexcept  { return _mm_max_pd (a, b); }
+
+        static forcedinline ParallelType ramp (Type start, Type increment) noexcept
+        {
+            return _mm_setr_pd (start, start + increment);
+        }
+
+        static forcedinline Type min (ParallelType a) noexcept  { Type v[2]; storeU (v, a); return jmin (v[0], v[1]); }
+        static forcedinline Type max (ParallelType a) noexcept  { Type v[2]; storeU (v, a); return jmax (v[0], v[1]); }
+    };
+
+    // Picks the BasicOps class that matches the size of the type being processed
+    template <int typeSize> struct ModeType    { typedef BasicOps32 Mode; };
+    template <>             struct ModeType<8> { typedef BasicOps64 Mode; };
+
+    template <class Mode>
+    static inline typename Mode::Type findMinimumOrMaximum (const typename Mode::Type* src, int num, const bool isMinimum) noexcept
+    {
+        const int numLongOps = num / Mode::numParallel;
 
         if (numLongOps > 1 && FloatVectorHelpers::isSSE2Available())
         {
-            __m128 val;
+            typename Mode::ParallelType val;
 
             #define JUCE_MINIMUMMAXIMUM_SSE_LOOP(loadOp, minMaxOp) \
                 val = loadOp (src); \
-                src += 4; \
+                src += Mode::numParallel; \
                 for (int i = 1; i < numLongOps; ++i) \
                 { \
-                    const __m128 s = loadOp (src); \
+                    const typename Mode::ParallelType s = loadOp (src); \
                     val = minMaxOp (val, s); \
-                    src += 4; \
+                    src += Mode::numParallel; \
                 }
 
             if (isMinimum)
             {
-                if (FloatVectorHelpers::isAligned (src)) { JUCE_MINIMUMMAXIMUM_SSE_LOOP (_mm_load_ps,  _mm_min_ps) }
-                else                                     { JUCE_MINIMUMMAXIMUM_SSE_LOOP (_mm_loadu_ps, _mm_min_ps) }
+                if (FloatVectorHelpers::isAligned (src)) { JUCE_MINIMUMMAXIMUM_SSE_LOOP (Mode::loadA, Mode::min) }
+                else                                     { JUCE_MINIMUMMAXIMUM_SSE_LOOP (Mode::loadU, Mode::min) }
             }
             else
             {
-                if (FloatVectorHelpers::isAligned (src)) { JUCE_MINIMUMMAXIMUM_SSE_LOOP (_mm_load_ps, _mm_max_ps) }
-                else                                     { JUCE_MINIMUMMAXIMUM_SSE_LOOP (_mm_loadu_ps,_mm_max_ps) }
+                if (FloatVectorHelpers::isAligned (src)) { JUCE_MINIMUMMAXIMUM_SSE_LOOP (Mode::loadA, Mode::max) }
+                else                                     { JUCE_MINIMUMMAXIMUM_SSE_LOOP (Mode::loadU, Mode::max) }
             }
 
-            float localVal;
+            typename Mode::Type localVal = isMinimum ? Mode::min (val)
+                                                     : Mode::max (val);
 
-            {
-                float vals[4];
-                _mm_storeu_ps (vals, val);
-
-                localVal = isMinimum ? jmin (vals[0], vals[1], vals[2], vals[3])
-                                     : jmax (vals[0], vals[1], vals[2], vals[3]);
-            }
-
-            num &= 3;
+            num &= (Mode::numParallel - 1);
 
             for (int i = 0; i < num; ++i)
                 localVal = isMinimum ? jmin (localVal, src[i])
@@ -97,13 +146,59 @@ namespace FloatVectorHelpers
                          : juce::findMaximum (src, num);
     }
 
+    template <class Mode>
+    static inline bool findMinAndMax (const typename Mode::Type* src, int num,
+                                      typename Mode::Type& minResult, typename Mode::Type& maxResult) noexcept
+    {
+        const int numLongOps = num / Mode::numParallel;
+
+        if (numLongOps > 1 && FloatVectorHelpers::isSSE2Available())
+        {
+            typename Mode::ParallelType mn, mx;
+
+            #define JUCE_MINMAX_SSE_LOOP(loadOp) \
+                mn = loadOp (src); \
+                mx = mn; \
+                src += Mode::numParallel; \
+                for (int i = 1; i < numLongOps; ++i) \
+                { \
+                    const typename Mode::ParallelType s = loadOp (src); \
+                    mn = Mode::min (mn, s); \
+                    mx = Mode::max (mx, s); \
+                    src += Mode::numParallel; \
+                }
+
+            if (FloatVectorHelpers::isAligned (src)) { JUCE_MINMAX_SSE_LOOP (Mode::loadA) }
+            else                                     { JUCE_MINMAX_SSE_LOOP (Mode::loadU) }
+
+            typename Mode::Type localMin = Mode::min (mn);
+            typename Mode::Type localMax = Mode::max (mx);
+
+            num &= (Mode::numParallel - 1);
+
+            for (int i = 0; i < num; ++i)
+            {
+                const typename Mode::Type s = src[i];
+                localMin = jmin (localMin, s);
+                localMax = jmax (localMax, s);
+            }
+
+            minResult = localMin;
+            maxResult = localMax;
+            return true;
+        }
+
+        return false;
+    }
+
     #define JUCE_BEGIN_SSE_OP \
         if (FloatVectorHelpers::isSSE2Available()) \
         { \
-            const int numLongOps = num / 4;
+            typedef FloatVectorHelpers::ModeType<sizeof (*dest)>::Mode Mode; \
+            const int numLongOps = num / Mode::numParallel;
 
     #define JUCE_FINISH_SSE_OP(normalOp) \
-            num &= 3; \
+            num &= (Mode::numParallel - 1); \
             if (num == 0) return; \
         } \
         for (int i = 0; i < num; ++i) normalOp;
@@ -117,30 +212,74 @@ namespace FloatVectorHelpers
         }
 
     #define JUCE_LOAD_NONE(srcLoad, dstLoad)
-    #define JUCE_LOAD_DEST(srcLoad, dstLoad)     const __m128 d = dstLoad (dest);
-    #define JUCE_LOAD_SRC(srcLoad, dstLoad)      const __m128 s = srcLoad (src);
-    #define JUCE_LOAD_SRC_DEST(srcLoad, dstLoad) const __m128 d = dstLoad (dest); const __m128 s = srcLoad (src);
+    #define JUCE_LOAD_DEST(srcLoad, dstLoad)     const Mode::ParallelType d = dstLoad (dest);
+    #define JUCE_LOAD_SRC(srcLoad, dstLoad)      const Mode::ParallelType s = srcLoad (src);
+    #define JUCE_LOAD_SRC_DEST(srcLoad, dstLoad) const Mode::ParallelType d = dstLoad (dest); const Mode::ParallelType s = srcLoad (src);
 
     #define JUCE_PERFORM_SSE_OP_DEST(normalOp, sseOp, locals) \
         JUCE_BEGIN_SSE_OP \
-        if (FloatVectorHelpers::isAligned (dest))   JUCE_SSE_LOOP (sseOp, dummy, _mm_load_ps,  _mm_store_ps,  locals, JUCE_INCREMENT_DEST) \
-        else                                        JUCE_SSE_LOOP (sseOp, dummy, _mm_loadu_ps, _mm_storeu_ps, locals, JUCE_INCREMENT_DEST) \
+        if (FloatVectorHelpers::isAligned (dest))   JUCE_SSE_LOOP (sseOp, dummy, Mode::loadA, Mode::storeA, locals, JUCE_INCREMENT_DEST) \
+        else                                        JUCE_SSE_LOOP (sseOp, dummy, Mode::loadU, Mode::storeU, locals, JUCE_INCREMENT_DEST) \
         JUCE_FINISH_SSE_OP (normalOp)
 
     #define JUCE_PERFORM_SSE_OP_SRC_DEST(normalOp, sseOp, locals, increment) \
         JUCE_BEGIN_SSE_OP \
         if (FloatVectorHelpers::isAligned (dest)) \
         { \
-            if (FloatVectorHelpers::isAligned (src)) JUCE_SSE_LOOP (sseOp, _mm_load_ps,  _mm_load_ps, _mm_store_ps, locals, increment) \
-            else                                     JUCE_SSE_LOOP (sseOp, _mm_loadu_ps, _mm_load_ps, _mm_store_ps, locals, increment) \
+            if (FloatVectorHelpers::isAligned (src)) JUCE_SSE_LOOP (sseOp, Mode::loadA, Mode::loadA, Mode::storeA, locals, increment) \
+            else                                     JUCE_SSE_LOOP (sseOp, Mode::loadU, Mode::loadA, Mode::storeA, locals, increment) \
         }\
         else \
         { \
-            if (FloatVectorHelpers::isAligned (src)) JUCE_SSE_LOOP (sseOp, _mm_load_ps,  _mm_loadu_ps, _mm_storeu_ps, locals, increment) \
-            else                                     JUCE_SSE_LOOP (sseOp, _mm_loadu_ps, _mm_loadu_ps, _mm_storeu_ps, locals, increment) \
+            if (FloatVectorHelpers::isAligned (src)) JUCE_SSE_LOOP (sseOp, Mode::loadA, Mode::loadU, Mode::storeU, locals, increment) \
+            else                                     JUCE_SSE_LOOP (sseOp, Mode::loadU, Mode::loadU, Mode::storeU, locals, increment) \
         } \
         JUCE_FINISH_SSE_OP (normalOp)
 
+    #define JUCE_SSE_LOOP_SRC1_SRC2(sseOp, srcLoad, dstStore) \
+        for (int i = 0; i < numLongOps; ++i) \
+        { \
+            const Mode::ParallelType s1 = srcLoad (src1); \
+            const Mode::ParallelType s2 = srcLoad (src2); \
+            dstStore (dest, sseOp); \
+            dest += Mode::numParallel; src1 += Mode::numParallel; src2 += Mode::numParallel; \
+        }
+
+    #define JUCE_PERFORM_SSE_OP_SRC1_SRC2_DEST(normalOp, sseOp) \
+        JUCE_BEGIN_SSE_OP \
+        if (FloatVectorHelpers::isAligned (dest) && FloatVectorHelpers::isAligned (src1) && FloatVectorHelpers::isAligned (src2)) \
+            JUCE_SSE_LOOP_SRC1_SRC2 (sseOp, Mode::loadA, Mode::storeA) \
+        else \
+            JUCE_SSE_LOOP_SRC1_SRC2 (sseOp, Mode::loadU, Mode::storeU) \
+        JUCE_FINISH_SSE_OP (normalOp)
+
+    /*  For the ramp ops, the caller must have a startGain and a gainIncrement. Each SSE
+        op can use a "gain" register, which holds the gains for the values it's working on,
+        and startGain is moved along past the values that were done with SSE, so that
+        the normal op can finish off the rest.
+    */
+    #define JUCE_BEGIN_SSE_RAMP_OP \
+        JUCE_BEGIN_SSE_OP \
+        Mode::ParallelType gain = Mode::ramp (startGain, gainIncrement); \
+        const Mode::ParallelType gainStep = Mode::load1 (gainIncrement * Mode::numParallel);
+
+    #define JUCE_FINISH_SSE_RAMP_OP(normalOp) \
+        startGain += gainIncrement * (numLongOps * Mode::numParallel); \
+        JUCE_FINISH_SSE_OP (normalOp)
+
+    #define JUCE_PERFORM_SSE_RAMP_OP_DEST(normalOp, sseOp, locals) \
+        JUCE_BEGIN_SSE_RAMP_OP \
+        if (FloatVectorHelpers::isAligned (dest))   JUCE_SSE_LOOP (sseOp, dummy, Mode::loadA, Mode::storeA, locals, JUCE_INCREMENT_DEST gain = Mode::add (gain, gainStep);) \
+        else                                        JUCE_SSE_LOOP (sseOp, dummy, Mode::loadU, Mode::storeU, locals, JUCE_INCREMENT_DEST gain = Mode::add (gain, gainStep);) \
+        JUCE_FINISH_SSE_RAMP_OP (normalOp)
+
+    #define JUCE_PERFORM_SSE_RAMP_OP_SRC_DEST(normalOp, sseOp, locals) \
+        JUCE_BEGIN_SSE_RAMP_OP \
+        if (FloatVectorHelpers::isAligned (dest) && FloatVectorHelpers::isAligned (src)) \
+            JUCE_SSE_LOOP (sseOp, Mode::loadA, Mode::loadA, Mode::storeA, locals, JUCE_INCREMENT_SRC_DEST gain = Mode::add (gain, gainStep);) \
+        else \
+            JUCE_SSE_LOOP (sseOp, Mode::loadU, Mode::loadU, Mode::storeU, locals, JUCE_INCREMENT_SRC_DEST gain = Mode::add (gain, gainStep);) \
+        JUCE_FINISH_SSE_RAMP_OP (normalOp)
 
     //==============================================================================
    #elif JUCE_USE_ARM_NEON
@@ -220,11 +359,197 @@ namespace FloatVectorHelpers
         JUCE_NEON_LOOP (neonOp, vld1q_f32, vld1q_f32,  vst1q_f32,  locals, JUCE_INCREMENT_SRC_DEST) \
         JUCE_FINISH_NEON_OP (normalOp)
 
+    #define JUCE_PERFORM_NEON_OP_SRC1_SRC2_DEST(normalOp, neonOp) \
+        JUCE_BEGIN_NEON_OP \
+        for (int i = 0; i < numLongOps; ++i) \
+        { \
+            const float32x4_t s1 = vld1q_f32 (src1); \
+            const float32x4_t s2 = vld1q_f32 (src2); \
+            vst1q_f32 (dest, neonOp); \
+            dest += 4; src1 += 4; src2 += 4; \
+        } \
+        JUCE_FINISH_NEON_OP (normalOp)
+
+    #endif
+
     //==============================================================================
-    #else
+    // (where there's no SSE, these are used for the ops which don't have a NEON version)
+    #if ! JUCE_USE_SSE_INTRINSICS
      #define JUCE_PERFORM_SSE_OP_DEST(normalOp, unused1, unused2)              for (int i = 0; i < num; ++i) normalOp;
      #define JUCE_PERFORM_SSE_OP_SRC_DEST(normalOp, sseOp, locals, increment)  for (int i = 0; i < num; ++i) normalOp;
+     #define JUCE_PERFORM_SSE_OP_SRC1_SRC2_DEST(normalOp, sseOp)               for (int i = 0; i < num; ++i) normalOp;
+     #define JUCE_PERFORM_SSE_RAMP_OP_DEST(normalOp, sseOp, locals)            for (int i = 0; i < num; ++i) normalOp;
+     #define JUCE_PERFORM_SSE_RAMP_OP_SRC_DEST(normalOp, sseOp, locals)        for (int i = 0; i < num; ++i) normalOp;
     #endif
+
+    //==============================================================================
+   #if JUCE_USE_AVX_INTRINSICS
+    enum AVXSupport
+    {
+        noAVX = 0,
+        avxOnly,
+        avxWithFMA
+    };
+
+    static int avxSupport = -1; // (-1 means that it hasn't been checked yet)
+
+    static int getAVXSupport() noexcept
+    {
+        if (avxSupport < 0)
+            avxSupport = SystemStats::hasAVX() ? (SystemStats::hasFMA() ? avxWithFMA : avxOnly)
+                                               : noAVX;
+
+        return avxSupport;
+    }
+
+    inline static bool isAVXAligned (const void* p) noexcept
+    {
+        return (((pointer_sized_int) p) & 31) == 0;
+    }
+
+    /*  These work on 8 floats at a time. They're only compiled for AVX themselves, so
+        mustn't be called unless getAVXSupport() says that the CPU can run them.
+    */
+    namespace AVX
+    {
+        #define JUCE_AVX_LOOP(avxOp, srcLoad, dstLoad, dstStore, locals, increment) \
+            for (int i = 0; i < numLongOps; ++i) \
+            { \
+                locals (srcLoad, dstLoad); \
+                dstStore (dest, avxOp); \
+                increment; \
+            }
+
+        #define JUCE_AVX_LOAD_NONE(srcLoad, dstLoad)
+        #define JUCE_AVX_LOAD_DEST(srcLoad, dstLoad)     const __m256 d = dstLoad (dest);
+        #define JUCE_AVX_LOAD_SRC(srcLoad, dstLoad)      const __m256 s = srcLoad (src);
+        #define JUCE_AVX_LOAD_SRC_DEST(srcLoad, dstLoad) const __m256 d = dstLoad (dest); const __m256 s = srcLoad (src);
+
+        #define JUCE_AVX_INCREMENT_DEST      dest += 8;
+        #define JUCE_AVX_INCREMENT_SRC_DEST  dest += 8; src += 8;
+
+        // (the upper halves of the registers are cleared afterwards, to avoid a stall when the caller goes back to SSE code)
+        #define JUCE_FINISH_AVX_OP(normalOp) \
+            _mm256_zeroupper(); \
+            num &= 7; \
+            for (int i = 0; i < num; ++i) normalOp;
+
+        #define JUCE_PERFORM_AVX_OP_DEST(normalOp, avxOp, locals) \
+            const int numLongOps = num / 8; \
+            if (isAVXAligned (dest))  JUCE_AVX_LOOP (avxOp, dummy, _mm256_load_ps,  _mm256_store_ps,  locals, JUCE_AVX_INCREMENT_DEST) \
+            else                      JUCE_AVX_LOOP (avxOp, dummy, _mm256_loadu_ps, _mm256_storeu_ps, locals, JUCE_AVX_INCREMENT_DEST) \
+            JUCE_FINISH_AVX_OP (normalOp)
+
+        #define JUCE_PERFORM_AVX_OP_SRC_DEST(normalOp, avxOp, locals) \
+            const int numLongOps = num / 8; \
+            if (isAVXAligned (dest) && isAVXAligned (src)) \
+                JUCE_AVX_LOOP (avxOp, _mm256_load_ps,  _mm256_load_ps,  _mm256_store_ps,  locals, JUCE_AVX_INCREMENT_SRC_DEST) \
+            else \
+                JUCE_AVX_LOOP (avxOp, _mm256_loadu_ps, _mm256_loadu_ps, _mm256_storeu_ps, locals, JUCE_AVX_INCREMENT_SRC_DEST) \
+            JUCE_FINISH_AVX_OP (normalOp)
+
+        JUCE_AVX_TARGET static void copyWithMultiply (float* dest, const float* src, float multiplier, int num) noexcept
+        {
+            const __m256 mult = _mm256_set1_ps (multiplier);
+            JUCE_PERFORM_AVX_OP_SRC_DEST (dest[i] = src[i] * multiplier, _mm256_mul_ps (mult, s), JUCE_AVX_LOAD_SRC)
+        }
+
+        JUCE_AVX_TARGET static void add (float* dest, const float* src, int num) noexcept
+        {
+            JUCE_PERFORM_AVX_OP_SRC_DEST (dest[i] += src[i], _mm256_add_ps (d, s), JUCE_AVX_LOAD_SRC_DEST)
+        }
+
+        JUCE_AVX_TARGET static void addWithMultiply (float* dest, const float* src, float multiplier, int num) noexcept
+        {
+            const __m256 mult = _mm256_set1_ps (multiplier);
+            JUCE_PERFORM_AVX_OP_SRC_DEST (dest[i] += src[i] * multiplier, _mm256_add_ps (d, _mm256_mul_ps (mult, s)), JUCE_AVX_LOAD_SRC_DEST)
+        }
+
+        JUCE_FMA_TARGET static void addWithMultiplyFMA (float* dest, const float* src, float multiplier, int num) noexcept
+        {
+            const __m256 mult = _mm256_set1_ps (multiplier);
+            JUCE_PERFORM_AVX_OP_SRC_DEST (dest[i] += src[i] * multiplier, _mm256_fmadd_ps (mult, s, d), JUCE_AVX_LOAD_SRC_DEST)
+        }
+
+        JUCE_AVX_TARGET static void multiply (float* dest, const float* src, int num) noexcept
+        {
+            JUCE_PERFORM_AVX_OP_SRC_DEST (dest[i] *= src[i], _mm256_mul_ps (d, s), JUCE_AVX_LOAD_SRC_DEST)
+        }
+
+        JUCE_AVX_TARGET static void multiply (float* dest, float multiplier, int num) noexcept
+        {
+            const __m256 mult = _mm256_set1_ps (multiplier);
+            JUCE_PERFORM_AVX_OP_DEST (dest[i] *= multiplier, _mm256_mul_ps (d, mult), JUCE_AVX_LOAD_DEST)
+        }
+
+        JUCE_AVX_TARGET static void convertFixedToFloat (float* dest, const int* src, float multiplier, int num) noexcept
+        {
+            const __m256 mult = _mm256_set1_ps (multiplier);
+            const int numLongOps = num / 8;
+
+            if (isAVXAligned (dest))
+                JUCE_AVX_LOOP (_mm256_mul_ps (mult, _mm256_cvtepi32_ps (_mm256_loadu_si256 ((const __m256i*) src))),
+                               dummy, dummy, _mm256_store_ps, JUCE_AVX_LOAD_NONE, JUCE_AVX_INCREMENT_SRC_DEST)
+            else
+                JUCE_AVX_LOOP (_mm256_mul_ps (mult, _mm256_cvtepi32_ps (_mm256_loadu_si256 ((const __m256i*) src))),
+                               dummy, dummy, _mm256_storeu_ps, JUCE_AVX_LOAD_NONE, JUCE_AVX_INCREMENT_SRC_DEST)
+
+            JUCE_FINISH_AVX_OP (dest[i] = src[i] * multiplier)
+        }
+
+        JUCE_AVX_TARGET static void findMinAndMax (const float* src, int num, float& minResult, float& maxResult) noexcept
+        {
+            const int numLongOps = num / 8;
+            jassert (numLongOps > 1);
+
+            __m256 mn, mx;
+
+            #define JUCE_MINMAX_AVX_LOOP(loadOp) \
+                mn = loadOp (src); \
+                mx = mn; \
+                src += 8; \
+                for (int i = 1; i < numLongOps; ++i) \
+                { \
+                    const __m256 s = loadOp (src); \
+                    mn = _mm256_min_ps (mn, s); \
+                    mx = _mm256_max_ps (mx, s); \
+                    src += 8; \
+                }
+
+            if (isAVXAligned (src)) { JUCE_MINMAX_AVX_LOOP (_mm256_load_ps) }
+            else                    { JUCE_MINMAX_AVX_LOOP (_mm256_loadu_ps) }
+
+            float mns[8], mxs[8];
+            _mm256_storeu_ps (mns, mn);
+            _mm256_storeu_ps (mxs, mx);
+            _mm256_zeroupper();
+
+            float localMin = jmin (jmin (mns[0], mns[1], mns[2], mns[3]), jmin (mns[4], mns[5], mns[6], mns[7]));
+            float localMax = jmax (jmax (mxs[0], mxs[1], mxs[2], mxs[3]), jmax (mxs[4], mxs[5], mxs[6], mxs[7]));
+
+            num &= 7;
+
+            for (int i = 0; i < num; ++i)
+            {
+                const float s = src[i];
+                localMin = jmin (localMin, s);
+                localMax = jmax (localMax, s);
+            }
+
+            minResult = localMin;
+            maxResult = localMax;
+        }
+    }
+
+    #define JUCE_USE_AVX_IF_AVAILABLE(avxCall) \
+        if (FloatVectorHelpers::getAVXSupport() != FloatVectorHelpers::noAVX) \
+        { \
+            FloatVectorHelpers::AVX::avxCall; \
+            return; \
+        }
+   #else
+    #define JUCE_USE_AVX_IF_AVAILABLE(avxCall)
+   #endif
 }
 
 //==============================================================================
@@ -237,6 +562,15 @@ void JUCE_CALLTYPE FloatVectorOperations::clear (float* dest, int num) noexcept
    #endif
 }
 
+void JUCE_CALLTYPE FloatVectorOperations::clear (double* dest, int num) noexcept
+{
+   #if JUCE_USE_VDSP_FRAMEWORK
+    vDSP_vclrD (dest, 1, (size_t) num);
+   #else
+    zeromem (dest, num * sizeof (double));
+   #endif
+}
+
 void JUCE_CALLTYPE FloatVectorOperations::fill (float* dest, float valueToFill, int num) noexcept
 {
    #if JUCE_USE_VDSP_FRAMEWORK
@@ -252,11 +586,28 @@ void JUCE_CALLTYPE FloatVectorOperations::fill (float* dest, float valueToFill,
    #endif
 }
 
+void JUCE_CALLTYPE FloatVectorOperations::fill (double* dest, double valueToFill, int num) noexcept
+{
+   #if JUCE_USE_VDSP_FRAMEWORK
+    vDSP_vfillD (&valueToFill, dest, 1, (size_t) num);
+   #else
+    #if JUCE_USE_SSE_INTRINSICS
+     const __m128d val = _mm_load1_pd (&valueToFill);
+    #endif
+    JUCE_PERFORM_SSE_OP_DEST (dest[i] = valueToFill, val, JUCE_LOAD_NONE)
+   #endif
+}
+
 void JUCE_CALLTYPE FloatVectorOperations::copy (float* dest, const float* src, int num) noexcept
 {
     memcpy (dest, src, (size_t) num * sizeof (float));
 }
 
+void JUCE_CALLTYPE FloatVectorOperations::copy (double* dest, const double* src, int num) noexcept
+{
+    memcpy (dest, src, (size_t) num * sizeof (double));
+}
+
 void JUCE_CALLTYPE FloatVectorOperations::copyWithMultiply (float* dest, const float* src, float multiplier, int num) noexcept
 {
    #if JUCE_USE_VDSP_FRAMEWORK
@@ -264,6 +615,8 @@ void JUCE_CALLTYPE FloatVectorOperations::copyWithMultiply (float* dest, const f
    #elif JUCE_USE_ARM_NEON
     JUCE_PERFORM_NEON_OP_SRC_DEST (dest[i] += src[i], vmulq_n_f32(s, multiplier), JUCE_LOAD_SRC)
    #else
+    JUCE_USE_AVX_IF_AVAILABLE (copyWithMultiply (dest, src, multiplier, num))
+
     #if JUCE_USE_SSE_INTRINSICS
      const __m128 mult = _mm_load1_ps (&multiplier);
     #endif
@@ -272,6 +625,31 @@ void JUCE_CALLTYPE FloatVectorOperations::copyWithMultiply (float* dest, const f
    #endif
 }
 
+void JUCE_CALLTYPE FloatVectorOperations::copyWithMultiply (double* dest, const double* src, double multiplier, int num) noexcept
+{
+   #if JUCE_USE_VDSP_FRAMEWORK
+    vDSP_vsmulD (src, 1, &multiplier, dest, 1, (vDSP_Length) num);
+   #else
+    #if JUCE_USE_SSE_INTRINSICS
+     const __m128d mult = _mm_load1_pd (&multiplier);
+    #endif
+    JUCE_PERFORM_SSE_OP_SRC_DEST (dest[i] = src[i] * multiplier, _mm_mul_pd (mult, s),
+                                  JUCE_LOAD_SRC, JUCE_INCREMENT_SRC_DEST)
+   #endif
+}
+
+void JUCE_CALLTYPE FloatVectorOperations::copyWithRamp (float* dest, const float* src, float startGain, float gainIncrement, int num) noexcept
+{
+    JUCE_PERFORM_SSE_RAMP_OP_SRC_DEST (dest[i] = src[i] * (startGain + (float) i * gainIncrement),
+                                       _mm_mul_ps (s, gain), JUCE_LOAD_SRC)
+}
+
+void JUCE_CALLTYPE FloatVectorOperations::copyWithRamp (double* dest, const double* src, double startGain, double gainIncrement, int num) noexcept
+{
+    JUCE_PERFORM_SSE_RAMP_OP_SRC_DEST (dest[i] = src[i] * (startGain + (double) i * gainIncrement),
+                                       _mm_mul_pd (s, gain), JUCE_LOAD_SRC)
+}
+
 void JUCE_CALLTYPE FloatVectorOperations::add (float* dest, float amount, int num) noexcept
 {
    #if JUCE_USE_ARM_NEON
@@ -285,6 +663,14 @@ void JUCE_CALLTYPE FloatVectorOperations::add (float* dest, float amount, int nu
    #endif
 }
 
+void JUCE_CALLTYPE FloatVectorOperations::add (double* dest, double amount, int num) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    const __m128d amountToAdd = _mm_load1_pd (&amount);
+   #endif
+    JUCE_PERFORM_SSE_OP_DEST (dest[i] += amount, _mm_add_pd (d, amountToAdd), JUCE_LOAD_DEST)
+}
+
 void JUCE_CALLTYPE FloatVectorOperations::add (float* dest, const float* src, int num) noexcept
 {
    #if JUCE_USE_VDSP_FRAMEWORK
@@ -292,10 +678,40 @@ void JUCE_CALLTYPE FloatVectorOperations::add (float* dest, const float* src, in
    #elif JUCE_USE_ARM_NEON
     JUCE_PERFORM_NEON_OP_SRC_DEST (dest[i] += src[i], vaddq_f32 (d, s), JUCE_LOAD_SRC_DEST)
    #else
+    JUCE_USE_AVX_IF_AVAILABLE (add (dest, src, num))
     JUCE_PERFORM_SSE_OP_SRC_DEST (dest[i] += src[i], _mm_add_ps (d, s), JUCE_LOAD_SRC_DEST, JUCE_INCREMENT_SRC_DEST)
    #endif
 }
 
+void JUCE_CALLTYPE FloatVectorOperations::add (double* dest, const double* src, int num) noexcept
+{
+   #if JUCE_USE_VDSP_FRAMEWORK
+    vDSP_vaddD (src, 1, dest, 1, dest, 1, (vDSP_Length) num);
+   #else
+    JUCE_PERFORM_SSE_OP_SRC_DEST (dest[i] += src[i], _mm_add_pd (d, s), JUCE_LOAD_SRC_DEST, JUCE_INCREMENT_SRC_DEST)
+   #endif
+}
+
+void JUCE_CALLTYPE FloatVectorOperations::add (float* dest, const float* src1, const float* src2, int num) noexcept
+{
+   #if JUCE_USE_VDSP_FRAMEWORK
+    vDSP_vadd (src1, 1, src2, 1, dest, 1, num);
+   #elif JUCE_USE_ARM_NEON
+    JUCE_PERFORM_NEON_OP_SRC1_SRC2_DEST (dest[i] = src1[i] + src2[i], vaddq_f32 (s1, s2))
+   #else
+    JUCE_PERFORM_SSE_OP_SRC1_SRC2_DEST (dest[i] = src1[i] + src2[i], _mm_add_ps (s1, s2))
+   #endif
+}
+
+void JUCE_CALLTYPE FloatVectorOperations::add (double* dest, const double* src1, const double* src2, int num) noexcept
+{
+   #if JUCE_USE_VDSP_FRAMEWORK
+    vDSP_vaddD (src1, 1, src2, 1, dest, 1, (vDSP_Length) num);
+   #else
+    JUCE_PERFORM_SSE_OP_SRC1_SRC2_DEST (dest[i] = src1[i] + src2[i], _mm_add_pd (s1, s2))
+   #endif
+}
+
 void JUCE_CALLTYPE FloatVectorOperations::subtract (float* dest, const float* src, int num) noexcept
 {
    #if JUCE_USE_VDSP_FRAMEWORK
@@ -307,6 +723,15 @@ void JUCE_CALLTYPE FloatVectorOperations::subtract (float* dest, const float* sr
    #endif
 }
 
+void JUCE_CALLTYPE FloatVectorOperations::subtract (double* dest, const double* src, int num) noexcept
+{
+   #if JUCE_USE_VDSP_FRAMEWORK
+    vDSP_vsubD (src, 1, dest, 1, dest, 1, (vDSP_Length) num);
+   #else
+    JUCE_PERFORM_SSE_OP_SRC_DEST (dest[i] -= src[i], _mm_sub_pd (d, s), JUCE_LOAD_SRC_DEST, JUCE_INCREMENT_SRC_DEST)
+   #endif
+}
+
 void JUCE_CALLTYPE FloatVectorOperations::addWithMultiply (float* dest, const float* src, float multiplier, int num) noexcept
 {
    #if JUCE_USE_ARM_NEON
@@ -314,6 +739,16 @@ void JUCE_CALLTYPE FloatVectorOperations::addWithMultiply (float* dest, const fl
                                    vmlaq_n_f32 (d, s, multiplier),
                                    JUCE_LOAD_SRC_DEST)
    #else
+    #if JUCE_USE_AVX_INTRINSICS
+     if (FloatVectorHelpers::getAVXSupport() == FloatVectorHelpers::avxWithFMA)
+     {
+         FloatVectorHelpers::AVX::addWithMultiplyFMA (dest, src, multiplier, num);
+         return;
+     }
+    #endif
+
+    JUCE_USE_AVX_IF_AVAILABLE (addWithMultiply (dest, src, multiplier, num))
+
     #if JUCE_USE_SSE_INTRINSICS
      const __m128 mult = _mm_load1_ps (&multiplier);
     #endif
@@ -325,6 +760,29 @@ void JUCE_CALLTYPE FloatVectorOperations::addWithMultiply (float* dest, const fl
 
 }
 
+void JUCE_CALLTYPE FloatVectorOperations::addWithMultiply (double* dest, const double* src, double multiplier, int num) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    const __m128d mult = _mm_load1_pd (&multiplier);
+   #endif
+
+    JUCE_PERFORM_SSE_OP_SRC_DEST (dest[i] += src[i] * multiplier,
+                                  _mm_add_pd (d, _mm_mul_pd (mult, s)),
+                                  JUCE_LOAD_SRC_DEST, JUCE_INCREMENT_SRC_DEST)
+}
+
+void JUCE_CALLTYPE FloatVectorOperations::addWithRamp (float* dest, const float* src, float startGain, float gainIncrement, int num) noexcept
+{
+    JUCE_PERFORM_SSE_RAMP_OP_SRC_DEST (dest[i] += src[i] * (startGain + (float) i * gainIncrement),
+                                       _mm_add_ps (d, _mm_mul_ps (s, gain)), JUCE_LOAD_SRC_DEST)
+}
+
+void JUCE_CALLTYPE FloatVectorOperations::addWithRamp (double* dest, const double* src, double startGain, double gainIncrement, int num) noexcept
+{
+    JUCE_PERFORM_SSE_RAMP_OP_SRC_DEST (dest[i] += src[i] * (startGain + (double) i * gainIncrement),
+                                       _mm_add_pd (d, _mm_mul_pd (s, gain)), JUCE_LOAD_SRC_DEST)
+}
+
 void JUCE_CALLTYPE FloatVectorOperations::multiply (float* dest, const float* src, int num) noexcept
 {
    #if JUCE_USE_VDSP_FRAMEWORK
@@ -332,10 +790,20 @@ void JUCE_CALLTYPE FloatVectorOperations::multiply (float* dest, const float* sr
    #elif JUCE_USE_ARM_NEON
     JUCE_PERFORM_NEON_OP_SRC_DEST (dest[i] *= src[i], vmulq_f32 (d, s), JUCE_LOAD_SRC_DEST)
    #else
+    JUCE_USE_AVX_IF_AVAILABLE (multiply (dest, src, num))
     JUCE_PERFORM_SSE_OP_SRC_DEST  (dest[i] *= src[i], _mm_mul_ps (d, s), JUCE_LOAD_SRC_DEST, JUCE_INCREMENT_SRC_DEST)
    #endif
 }
 
+void JUCE_CALLTYPE FloatVectorOperations::multiply (double* dest, const double* src, int num) noexcept
+{
+   #if JUCE_USE_VDSP_FRAMEWORK
+    vDSP_vmulD (src, 1, dest, 1, dest, 1, (vDSP_Length) num);
+   #else
+    JUCE_PERFORM_SSE_OP_SRC_DEST (dest[i] *= src[i], _mm_mul_pd (d, s), JUCE_LOAD_SRC_DEST, JUCE_INCREMENT_SRC_DEST)
+   #endif
+}
+
 void JUCE_CALLTYPE FloatVectorOperations::multiply (float* dest, float multiplier, int num) noexcept
 {
    #if JUCE_USE_VDSP_FRAMEWORK
@@ -343,6 +811,8 @@ void JUCE_CALLTYPE FloatVectorOperations::multiply (float* dest, float multiplie
    #elif JUCE_USE_ARM_NEON
     JUCE_PERFORM_NEON_OP_DEST (dest[i] *= multiplier, vmulq_n_f32 (d, multiplier), JUCE_LOAD_DEST)
    #else
+    JUCE_USE_AVX_IF_AVAILABLE (multiply (dest, multiplier, num))
+
     #if JUCE_USE_SSE_INTRINSICS
      const __m128 mult = _mm_load1_ps (&multiplier);
     #endif
@@ -350,6 +820,30 @@ void JUCE_CALLTYPE FloatVectorOperations::multiply (float* dest, float multiplie
    #endif
 }
 
+void JUCE_CALLTYPE FloatVectorOperations::multiply (double* dest, double multiplier, int num) noexcept
+{
+   #if JUCE_USE_VDSP_FRAMEWORK
+    vDSP_vsmulD (dest, 1, &multiplier, dest, 1, (vDSP_Length) num);
+   #else
+    #if JUCE_USE_SSE_INTRINSICS
+     const __m128d mult = _mm_load1_pd (&multiplier);
+    #endif
+    JUCE_PERFORM_SSE_OP_DEST (dest[i] *= multiplier, _mm_mul_pd (d, mult), JUCE_LOAD_DEST)
+   #endif
+}
+
+void JUCE_CALLTYPE FloatVectorOperations::multiplyWithRamp (float* dest, float startGain, float gainIncrement, int num) noexcept
+{
+    JUCE_PERFORM_SSE_RAMP_OP_DEST (dest[i] *= (startGain + (float) i * gainIncrement),
+                                   _mm_mul_ps (d, gain), JUCE_LOAD_DEST)
+}
+
+void JUCE_CALLTYPE FloatVectorOperations::multiplyWithRamp (double* dest, double startGain, double gainIncrement, int num) noexcept
+{
+    JUCE_PERFORM_SSE_RAMP_OP_DEST (dest[i] *= (startGain + (double) i * gainIncrement),
+                                   _mm_mul_pd (d, gain), JUCE_LOAD_DEST)
+}
+
 void FloatVectorOperations::negate (float* dest, const float* src, int num) noexcept
 {
    #if JUCE_USE_VDSP_FRAMEWORK
@@ -359,6 +853,15 @@ void FloatVectorOperations::negate (float* dest, const float* src, int num) noex
    #endif
 }
 
+void FloatVectorOperations::negate (double* dest, const double* src, int num) noexcept
+{
+   #if JUCE_USE_VDSP_FRAMEWORK
+    vDSP_vnegD ((double*) src, 1, dest, 1, (vDSP_Length) num);
+   #else
+    copyWithMultiply (dest, src, -1.0, num);
+   #endif
+}
+
 void JUCE_CALLTYPE FloatVectorOperations::convertFixedToFloat (float* dest, const int* src, float multiplier, int num) noexcept
 {
    #if JUCE_USE_ARM_NEON
@@ -366,6 +869,8 @@ void JUCE_CALLTYPE FloatVectorOperations::convertFixedToFloat (float* dest, cons
                                    vmulq_n_f32 (vcvtq_f32_s32 (vld1q_s32 (src)), multiplier),
                                    JUCE_LOAD_NONE)
    #else
+    JUCE_USE_AVX_IF_AVAILABLE (convertFixedToFloat (dest, src, multiplier, num))
+
     #if JUCE_USE_SSE_INTRINSICS
      const __m128 mult = _mm_load1_ps (&multiplier);
     #endif
@@ -379,51 +884,15 @@ void JUCE_CALLTYPE FloatVectorOperations::convertFixedToFloat (float* dest, cons
 void JUCE_CALLTYPE FloatVectorOperations::findMinAndMax (const float* src, int num, float& minResult, float& maxResult) noexcept
 {
    #if JUCE_USE_SSE_INTRINSICS
-    const int numLongOps = num / 4;
-
-    if (numLongOps > 1 && FloatVectorHelpers::isSSE2Available())
-    {
-        __m128 mn, mx;
-
-        #define JUCE_MINMAX_SSE_LOOP(loadOp) \
-            mn = loadOp (src); \
-            mx = mn; \
-            src += 4; \
-            for (int i = 1; i < numLongOps; ++i) \
-            { \
-                const __m128 s = loadOp (src); \
-                mn = _mm_min_ps (mn, s); \
-                mx = _mm_max_ps (mx, s); \
-                src += 4; \
-            }
-
-        if (FloatVectorHelpers::isAligned (src)) { JUCE_MINMAX_SSE_LOOP (_mm_load_ps) }
-        else                                     { JUCE_MINMAX_SSE_LOOP (_mm_loadu_ps) }
-
-        float localMin, localMax;
-
-        {
-            float mns[4], mxs[4];
-            _mm_storeu_ps (mns, mn);
-            _mm_storeu_ps (mxs, mx);
-
-            localMin = jmin (mns[0], mns[1], mns[2], mns[3]);
-            localMax = jmax (mxs[0], mxs[1], mxs[2], mxs[3]);
-        }
-
-        num &= 3;
-
-        for (int i = 0; i < num; ++i)
-        {
-            const float s = src[i];
-            localMin = jmin (localMin, s);
-            localMax = jmax (localMax, s);
-        }
+    #if JUCE_USE_AVX_INTRINSICS
+     if (num >= 16)
+     {
+         JUCE_USE_AVX_IF_AVAILABLE (findMinAndMax (src, num, minResult, maxResult))
+     }
+    #endif
 
-        minResult = localMin;
-        maxResult = localMax;
+    if (FloatVectorHelpers::findMinAndMax<FloatVectorHelpers::BasicOps32> (src, num, minResult, maxResult))
         return;
-    }
    #elif JUCE_USE_ARM_NEON
     const int numLongOps = num / 4;
 
@@ -474,24 +943,56 @@ void JUCE_CALLTYPE FloatVectorOperations::findMinAndMax (const float* src, int n
     juce::findMinAndMax (src, num, minResult, maxResult);
 }
 
+void JUCE_CALLTYPE FloatVectorOperations::findMinAndMax (const double* src, int num, double& minResult, double& maxResult) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    if (FloatVectorHelpers::findMinAndMax<FloatVectorHelpers::BasicOps64> (src, num, minResult, maxResult))
+        return;
+   #endif
+
+    juce::findMinAndMax (src, num, minResult, maxResult);
+}
+
 float JUCE_CALLTYPE FloatVectorOperations::findMinimum (const float* src, int num) noexcept
 {
-   #if JUCE_USE_SSE_INTRINSICS || JUCE_USE_ARM_NEON
+   #if JUCE_USE_SSE_INTRINSICS
+    return FloatVectorHelpers::findMinimumOrMaximum<FloatVectorHelpers::BasicOps32> (src, num, true);
+   #elif JUCE_USE_ARM_NEON
     return FloatVectorHelpers::findMinimumOrMaximum (src, num, true);
    #else
     return juce::findMinimum (src, num);
    #endif
 }
 
+double JUCE_CALLTYPE FloatVectorOperations::findMinimum (const double* src, int num) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    return FloatVectorHelpers::findMinimumOrMaximum<FloatVectorHelpers::BasicOps64> (src, num, true);
+   #else
+    return juce::findMinimum (src, num);
+   #endif
+}
+
 float JUCE_CALLTYPE FloatVectorOperations::findMaximum (const float* src, int num) noexcept
 {
-   #if JUCE_USE_SSE_INTRINSICS || JUCE_USE_ARM_NEON
+   #if JUCE_USE_SSE_INTRINSICS
+    return FloatVectorHelpers::findMinimumOrMaximum<FloatVectorHelpers::BasicOps32> (src, num, false);
+   #elif JUCE_USE_ARM_NEON
     return FloatVectorHelpers::findMinimumOrMaximum (src, num, false);
    #else
     return juce::findMaximum (src, num);
    #endif
 }
 
+double JUCE_CALLTYPE FloatVectorOperations::findMaximum (const double* src, int num) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    return FloatVectorHelpers::findMinimumOrMaximum<FloatVectorHelpers::BasicOps64> (src, num, false);
+   #else
+    return juce::findMaximum (src, num);
+   #endif
+}
+
 void JUCE_CALLTYPE FloatVectorOperations::enableFlushToZeroMode (bool shouldEnable) noexcept
 {
    #if JUCE_USE_SSE_INTRINSICS
@@ -513,7 +1014,170 @@ public:
     void runTest()
     {
         beginTest ("FloatVectorOperations");
+        runAllChecks();
+
+       #if JUCE_USE_AVX_INTRINSICS
+        // Run the same checks again for each of the instruction sets that this CPU can use..
+        const int avxSupport = FloatVectorHelpers::getAVXSupport();
+
+        for (int i = FloatVectorHelpers::noAVX; i <= avxSupport; ++i)
+        {
+            beginTest ("FloatVectorOperations using " + getInstructionSetName (i));
+
+            const ScopedValueSetter<int> setter (FloatVectorHelpers::avxSupport, i);
+            runAllChecks();
+        }
+       #endif
+    }
+
+    static String getInstructionSetName (const int avxSupport)
+    {
+       #if JUCE_USE_AVX_INTRINSICS
+        if (avxSupport == FloatVectorHelpers::avxOnly)     return "AVX";
+        if (avxSupport == FloatVectorHelpers::avxWithFMA)  return "AVX+FMA";
+       #endif
+
+        (void) avxSupport;
+        return "SSE";
+    }
+
+    void runAllChecks()
+    {
+        TestRunner<float>::runTest (*this);
+        TestRunner<double>::runTest (*this);
+        checkFixedToFloatConversion();
+    }
+
+    template <typename ValueType>
+    struct TestRunner
+    {
+        static void runTest (UnitTest& u)
+        {
+            Random random (u.getRandom());
+
+            for (int i = 100; --i >= 0;)
+            {
+                const int num = random.nextInt (500) + 1;
+
+                HeapBlock<ValueType> buffer1 (num + 16), buffer2 (num + 16), buffer3 (num + 16);
+
+               #if JUCE_ARM
+                ValueType* const data1 = buffer1;
+                ValueType* const data2 = buffer2;
+                ValueType* const data3 = buffer3;
+               #else
+                ValueType* const data1 = addBytesToPointer (buffer1.getData(), random.nextInt (16));
+                ValueType* const data2 = addBytesToPointer (buffer2.getData(), random.nextInt (16));
+                ValueType* const data3 = addBytesToPointer (buffer3.getData(), random.nextInt (16));
+               #endif
+
+                fillRandomly (random, data1, num);
+                fillRandomly (random, data2, num);
+
+                ValueType mn1, mx1, mn2, mx2;
+                FloatVectorOperations::findMinAndMax (data1, num, mn1, mx1);
+                juce::findMinAndMax (data1, num, mn2, mx2);
+                u.expect (mn1 == mn2);
+                u.expect (mx1 == mx2);
+
+                u.expect (FloatVectorOperations::findMinimum (data1, num) == juce::findMinimum (data1, num));
+                u.expect (FloatVectorOperations::findMaximum (data1, num) == juce::findMaximum (data1, num));
+
+                u.expect (FloatVectorOperations::findMinimum (data2, num) == juce::findMinimum (data2, num));
+                u.expect (FloatVectorOperations::findMaximum (data2, num) == juce::findMaximum (data2, num));
+
+                FloatVectorOperations::clear (data1, num);
+                u.expect (areAllValuesEqual (data1, num, 0));
+
+                FloatVectorOperations::fill (data1, (ValueType) 2, num);
+                u.expect (areAllValuesEqual (data1, num, (ValueType) 2));
+
+                FloatVectorOperations::add (data1, (ValueType) 2, num);
+                u.expect (areAllValuesEqual (data1, num, (ValueType) 4));
 
+                FloatVectorOperations::copy (data2, data1, num);
+                u.expect (areAllValuesEqual (data2, num, (ValueType) 4));
+
+                FloatVectorOperations::add (data2, data1, num);
+                u.expect (areAllValuesEqual (data2, num, (ValueType) 8));
+
+                FloatVectorOperations::add (data2, data1, data2, num);
+                u.expect (areAllValuesEqual (data2, num, (ValueType) 12));
+
+                FloatVectorOperations::copyWithMultiply (data2, data1, (ValueType) 4, num);
+                u.expect (areAllValuesEqual (data2, num, (ValueType) 16));
+
+                FloatVectorOperations::addWithMultiply (data2, data1, (ValueType) 4, num);
+                u.expect (areAllValuesEqual (data2, num, (ValueType) 32));
+
+                FloatVectorOperations::multiply (data1, (ValueType) 2, num);
+                u.expect (areAllValuesEqual (data1, num, (ValueType) 8));
+
+                FloatVectorOperations::multiply (data1, data2, num);
+                u.expect (areAllValuesEqual (data1, num, (ValueType) 256));
+
+                FloatVectorOperations::negate (data2, data1, num);
+                u.expect (areAllValuesEqual (data2, num, (ValueType) -256));
+
+                FloatVectorOperations::subtract (data1, data2, num);
+                u.expect (areAllValuesEqual (data1, num, (ValueType) 512));
+
+                // The ramps are compared with a simple loop that works out each gain directly..
+                const ValueType startGain = (ValueType) random.nextFloat();
+                const ValueType gainIncrement = (ValueType) (random.nextFloat() - 0.5f) / num;
+
+                fillRandomly (random, data1, num);
+                fillRandomly (random, data2, num);
+
+                FloatVectorOperations::copy (data3, data1, num);
+                FloatVectorOperations::multiplyWithRamp (data3, startGain, gainIncrement, num);
+                u.expect (rampMatches (data3, data1, nullptr, startGain, gainIncrement, num));
+
+                FloatVectorOperations::copyWithRamp (data3, data1, startGain, gainIncrement, num);
+                u.expect (rampMatches (data3, data1, nullptr, startGain, gainIncrement, num));
+
+                FloatVectorOperations::copy (data3, data2, num);
+                FloatVectorOperations::addWithRamp (data3, data1, startGain, gainIncrement, num);
+                u.expect (rampMatches (data3, data1, data2, startGain, gainIncrement, num));
+            }
+        }
+
+        static void fillRandomly (Random& random, ValueType* d, int num)
+        {
+            while (--num >= 0)
+                *d++ = (ValueType) (random.nextDouble() * 1000.0);
+        }
+
+        static bool areAllValuesEqual (const ValueType* d, int num, ValueType target)
+        {
+            while (--num >= 0)
+                if (*d++ != target)
+                    return false;
+
+            return true;
+        }
+
+        static bool rampMatches (const ValueType* result, const ValueType* src, const ValueType* originalDest,
+                                 ValueType startGain, ValueType gainIncrement, int num)
+        {
+            for (int i = 0; i < num; ++i)
+            {
+                ValueType expected = src[i] * (startGain + i * gainIncrement);
+
+                if (originalDest != nullptr)
+                    expected += originalDest[i];
+
+                // (the gain may be accumulated differently, so allow for some rounding errors in it)
+                if (std::abs (result[i] - expected) > (std::abs (src[i]) + std::abs (expected)) * (ValueType) 1.0e-4)
+                    return false;
+            }
+
+            return true;
+        }
+    };
+
+    void checkFixedToFloatConversion()
+    {
         for (int i = 100; --i >= 0;)
         {
             const int num = getRandom().nextInt (500) + 1;
@@ -531,98 +1195,177 @@ public:
             int* const int1 = addBytesToPointer (buffer3.getData(), getRandom().nextInt (16));
            #endif
 
-            fillRandomly (data1, num);
-            fillRandomly (data2, num);
+            fillRandomly (int1, num);
+            FloatVectorOperations::convertFixedToFloat (data1, int1, 2.0f, num);
+            convertFixed (data2, int1, 2.0f, num);
+            expect (buffersMatch (data1, data2, num));
+        }
+    }
 
-            float mn1, mx1, mn2, mx2;
-            FloatVectorOperations::findMinAndMax (data1, num, mn1, mx1);
-            juce::findMinAndMax (data1, num, mn2, mx2);
-            expect (mn1 == mn2);
-            expect (mx1 == mx2);
+    void fillRandomly (int* d, int num)
+    {
+        while (--num >= 0)
+            *d++ = getRandom().nextInt();
+    }
 
-            expect (FloatVectorOperations::findMinimum (data1, num) == juce::findMinimum (data1, num));
-            expect (FloatVectorOperations::findMaximum (data1, num) == juce::findMaximum (data1, num));
+    static void convertFixed (float* d, const int* s, float multiplier, int num)
+    {
+        while (--num >= 0)
+            *d++ = *s++ * multiplier;
+    }
 
-            expect (FloatVectorOperations::findMinimum (data2, num) == juce::findMinimum (data2, num));
-            expect (FloatVectorOperations::findMaximum (data2, num) == juce::findMaximum (data2, num));
+    static bool buffersMatch (const float* d1, const float* d2, int num)
+    {
+        while (--num >= 0)
+            if (std::abs (*d1++ - *d2++) > std::numeric_limits<float>::epsilon())
+                return false;
 
-            FloatVectorOperations::clear (data1, num);
-            expect (areAllValuesEqual (data1, num, 0));
+        return true;
+    }
+};
 
-            FloatVectorOperations::fill (data1, 2.0f, num);
-            expect (areAllValuesEqual (data1, num, 2.0f));
+static FloatVectorOperationsTests vectorOpTests;
 
-            FloatVectorOperations::add (data1, 2.0f, num);
-            expect (areAllValuesEqual (data1, num, 4.0f));
+//==============================================================================
+/*  Times each of the kernels which have specialised versions, with a range of buffer
+    sizes and with both aligned and unaligned data, using each instruction set that
+    the CPU supports. The results are just logged, so that they can be compared.
+*/
+class FloatVectorOperationsBenchmarks  : public UnitTest
+{
+public:
+    FloatVectorOperationsBenchmarks() : UnitTest ("FloatVectorOperations benchmarks") {}
 
-            FloatVectorOperations::copy (data2, data1, num);
-            expect (areAllValuesEqual (data2, num, 4.0f));
+    enum { maxBufferSize = 16384 };
 
-            FloatVectorOperations::add (data2, data1, num);
-            expect (areAllValuesEqual (data2, num, 8.0f));
+    void runTest()
+    {
+        beginTest ("Kernel timings");
 
-            FloatVectorOperations::copyWithMultiply (data2, data1, 4.0f, num);
-            expect (areAllValuesEqual (data2, num, 16.0f));
+        HeapBlock<float> buffer1 (maxBufferSize + 16), buffer2 (maxBufferSize + 16);
+        HeapBlock<int> buffer3 (maxBufferSize + 16);
 
-            FloatVectorOperations::addWithMultiply (data2, data1, 4.0f, num);
-            expect (areAllValuesEqual (data2, num, 32.0f));
+        const int bufferSizes[] = { 64, 512, 4096, maxBufferSize };
 
-            FloatVectorOperations::multiply (data1, 2.0f, num);
-            expect (areAllValuesEqual (data1, num, 8.0f));
+        for (int alignment = 0; alignment < 2; ++alignment)
+        {
+            // (offsetting all the pointers by one float means that none of them will be aligned)
+            float* const data1 = alignPointer (buffer1.getData(), alignment);
+            float* const data2 = alignPointer (buffer2.getData(), alignment);
+            int* const ints    = alignPointer (buffer3.getData(), alignment);
 
-            FloatVectorOperations::multiply (data1, data2, num);
-            expect (areAllValuesEqual (data1, num, 256.0f));
+            for (int i = 0; i < maxBufferSize; ++i)
+            {
+                // (data2 is kept close to 1.0, so that the multiply kernel, which is run thousands
+                // of times on the same data, doesn't turn data1 into denormals and slow down)
+                data1[i] = getRandom().nextFloat();
+                data2[i] = 0.999f + 0.002f * getRandom().nextFloat();
+                ints[i] = getRandom().nextInt();
+            }
 
-            FloatVectorOperations::negate (data2, data1, num);
-            expect (areAllValuesEqual (data2, num, -256.0f));
+            for (int sizeIndex = 0; sizeIndex < numElementsInArray (bufferSizes); ++sizeIndex)
+            {
+                const int num = bufferSizes [sizeIndex];
 
-            FloatVectorOperations::subtract (data1, data2, num);
-            expect (areAllValuesEqual (data1, num, 512.0f));
+                for (int kernel = 0; kernel < numKernels; ++kernel)
+                {
+                    String line;
+                    line << getKernelName (kernel) << ", " << num << (alignment == 0 ? " aligned" : " unaligned") << ":";
 
-            fillRandomly (int1, num);
-            FloatVectorOperations::convertFixedToFloat (data1, int1, 2.0f, num);
-            convertFixed (data2, int1, 2.0f, num);
-            expect (buffersMatch (data1, data2, num));
+                   #if JUCE_USE_AVX_INTRINSICS
+                    const int avxSupport = FloatVectorHelpers::getAVXSupport();
+
+                    for (int instructionSet = FloatVectorHelpers::noAVX; instructionSet <= avxSupport; ++instructionSet)
+                    {
+                        const ScopedValueSetter<int> setter (FloatVectorHelpers::avxSupport, instructionSet);
+                   #else
+                    {
+                        const int instructionSet = 0;
+                   #endif
+
+                        const double nanosecondsPerSample = timeKernel (kernel, data1, data2, ints, num);
+
+                        line << "  " << FloatVectorOperationsTests::getInstructionSetName (instructionSet)
+                             << " " << String (nanosecondsPerSample, 3) << "ns";
+                    }
+
+                    logMessage (line);
+                }
+            }
         }
     }
 
-    void fillRandomly (float* d, int num)
+private:
+    enum
     {
-        while (--num >= 0)
-            *d++ = getRandom().nextFloat() * 1000.0f;
-    }
-
-    void fillRandomly (int* d, int num)
+        addKernel,
+        addWithMultiplyKernel,
+        multiplyKernel,
+        multiplyByScalarKernel,
+        copyWithMultiplyKernel,
+        findMinAndMaxKernel,
+        convertFixedToFloatKernel,
+        numKernels
+    };
+
+    template <typename Type>
+    static Type* alignPointer (Type* p, const int extraValues) noexcept
     {
-        while (--num >= 0)
-            *d++ = getRandom().nextInt();
+        return reinterpret_cast<Type*> ((((pointer_sized_int) p) + 31) & ~(pointer_sized_int) 31) + extraValues;
     }
 
-    static void convertFixed (float* d, const int* s, float multiplier, int num)
+    static const char* getKernelName (const int kernel) noexcept
     {
-        while (--num >= 0)
-            *d++ = *s++ * multiplier;
+        switch (kernel)
+        {
+            case addKernel:                  return "add";
+            case addWithMultiplyKernel:      return "addWithMultiply";
+            case multiplyKernel:             return "multiply";
+            case multiplyByScalarKernel:     return "multiply (scalar)";
+            case copyWithMultiplyKernel:     return "copyWithMultiply";
+            case findMinAndMaxKernel:        return "findMinAndMax";
+            case convertFixedToFloatKernel:  return "convertFixedToFloat";
+            default:                         jassertfalse; return "";
+        }
     }
 
-    static bool areAllValuesEqual (const float* d, int num, float target)
+    static void runKernel (const int kernel, float* data1, float* data2, const int* ints, const int num) noexcept
     {
-        while (--num >= 0)
-            if (*d++ != target)
-                return false;
+        float mn, mx;
 
-        return true;
+        switch (kernel)
+        {
+            case addKernel:                  FloatVectorOperations::add (data1, data2, num); break;
+            case addWithMultiplyKernel:      FloatVectorOperations::addWithMultiply (data1, data2, 0.5f, num); break;
+            case multiplyKernel:             FloatVectorOperations::multiply (data1, data2, num); break;
+            case multiplyByScalarKernel:     FloatVectorOperations::multiply (data1, 0.999f, num); break;
+            case copyWithMultiplyKernel:     FloatVectorOperations::copyWithMultiply (data1, data2, 0.5f, num); break;
+            case findMinAndMaxKernel:        FloatVectorOperations::findMinAndMax (data2, num, mn, mx); break;
+            case convertFixedToFloatKernel:  FloatVectorOperations::convertFixedToFloat (data1, ints, 1.0f / 0x7fffffff, num); break;
+            default:                         jassertfalse; break;
+        }
     }
 
-    static bool buffersMatch (const float* d1, const float* d2, int num)
+    static double timeKernel (const int kernel, float* data1, float* data2, const int* ints, const int num)
     {
-        while (--num >= 0)
-            if (std::abs (*d1++ - *d2++) > std::numeric_limits<float>::epsilon())
-                return false;
+        const int numRepetitions = jmax (1, 2000000 / num);
 
-        return true;
+        runKernel (kernel, data1, data2, ints, num); // (to warm up the cache)
+
+        const int64 startTime = Time::getHighResolutionTicks();
+
+        for (int i = numRepetitions; --i >= 0;)
+            runKernel (kernel, data1, data2, ints, num);
+
+        const double seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTime);
+
+        // (stops the values from growing without limit, in case that slows anything down)
+        FloatVectorOperations::fill (data1, 0.5f, num);
+
+        return seconds * 1.0e9 / ((double) numRepetitions * num);
     }
 };
 
-static FloatVectorOperationsTests vectorOpTests;
+static FloatVectorOperationsBenchmarks vectorOpBenchmarks;
 
 #endif
@@ -28,8 +28,8 @@
 
 //==============================================================================
 /**
-    A collection of simple vector operations on arrays of floats, accelerated with
-    SIMD instructions where possible.
+    A collection of simple vector operations on arrays of floats and doubles,
+    accelerated with SIMD instructions where possible.
 */
 class JUCE_API  FloatVectorOperations
 {
@@ -38,48 +38,132 @@ public:
     /** Clears a vector of floats. */
     static void JUCE_CALLTYPE clear (float* dest, int numValues) noexcept;
 
+    /** Clears a vector of doubles. */
+    static void JUCE_CALLTYPE clear (double* dest, int numValues) noexcept;
+
     /** Copies a repeated value into a vector of floats. */
     static void JUCE_CALLTYPE fill (float* dest, float valueToFill, int numValues) noexcept;
 
+    /** Copies a repeated value into a vector of doubles. */
+    static void JUCE_CALLTYPE fill (double* dest, double valueToFill, int numValues) noexcept;
+
     /** Copies a vector of floats. */
     static void JUCE_CALLTYPE copy (float* dest, const float* src, int numValues) noexcept;
 
+    /** Copies a vector of doubles. */
+    static void JUCE_CALLTYPE copy (double* dest, const double* src, int numValues) noexcept;
+
     /** Copies a vector of floats, multiplying each value by a given multiplier */
     static void JUCE_CALLTYPE copyWithMultiply (float* dest, const float* src, float multiplier, int numValues) noexcept;
 
+    /** Copies a vector of doubles, multiplying each value by a given multiplier */
+    static void JUCE_CALLTYPE copyWithMultiply (double* dest, const double* src, double multiplier, int numValues) noexcept;
+
+    /** Copies a vector of floats, multiplying each value by a linear gain ramp.
+        The first value is multiplied by startGain, and the gain increases by gainIncrement
+        for each value after that.
+    */
+    static void JUCE_CALLTYPE copyWithRamp (float* dest, const float* src, float startGain, float gainIncrement, int numValues) noexcept;
+
+    /** Copies a vector of doubles, multiplying each value by a linear gain ramp.
+        The first value is multiplied by startGain, and the gain increases by gainIncrement
+        for each value after that.
+    */
+    static void JUCE_CALLTYPE copyWithRamp (double* dest, const double* src, double startGain, double gainIncrement, int numValues) noexcept;
+
     /** Adds a fixed value to the destination values. */
     static void JUCE_CALLTYPE add (float* dest, float amount, int numValues) noexcept;
 
+    /** Adds a fixed value to the destination values. */
+    static void JUCE_CALLTYPE add (double* dest, double amount, int numValues) noexcept;
+
     /** Adds the source values to the destination values. */
     static void JUCE_CALLTYPE add (float* dest, const float* src, int numValues) noexcept;
 
+    /** Adds the source values to the destination values. */
+    static void JUCE_CALLTYPE add (double* dest, const double* src, int numValues) noexcept;
+
+    /** Adds each source1 value to the corresponding source2 value and stores the result in the destination vector. */
+    static void JUCE_CALLTYPE add (float* dest, const float* src1, const float* src2, int numValues) noexcept;
+
+    /** Adds each source1 value to the corresponding source2 value and stores the result in the destination vector. */
+    static void JUCE_CALLTYPE add (double* dest, const double* src1, const double* src2, int numValues) noexcept;
+
     /** Subtracts the source values from the destination values. */
     static void JUCE_CALLTYPE subtract (float* dest, const float* src, int numValues) noexcept;
 
+    /** Subtracts the source values from the destination values. */
+    static void JUCE_CALLTYPE subtract (double* dest, const double* src, int numValues) noexcept;
+
     /** Multiplies each source value by the given multiplier, then adds it to the destination value. */
     static void JUCE_CALLTYPE addWithMultiply (float* dest, const float* src, float multiplier, int numValues) noexcept;
 
+    /** Multiplies each source value by the given multiplier, then adds it to the destination value. */
+    static void JUCE_CALLTYPE addWithMultiply (double* dest, const double* src, double multiplier, int numValues) noexcept;
+
+    /** Multiplies each source value by a linear gain ramp, then adds it to the destination value.
+        The first value is multiplied by startGain, and the gain increases by gainIncrement
+        for each value after that.
+    */
+    static void JUCE_CALLTYPE addWithRamp (float* dest, const float* src, float startGain, float gainIncrement, int numValues) noexcept;
+
+    /** Multiplies each source value by a linear gain ramp, then adds it to the destination value.
+        The first value is multiplied by startGain, and the gain increases by gainIncrement
+        for each value after that.
+    */
+    static void JUCE_CALLTYPE addWithRamp (double* dest, const double* src, double startGain, double gainIncrement, int numValues) noexcept;
+
     /** Multiplies the destination values by the source values. */
     static void JUCE_CALLTYPE multiply (float* dest, const float* src, int numValues) noexcept;
 
+    /** Multiplies the destination values by the source values. */
+    static void JUCE_CALLTYPE multiply (double* dest, const double* src, int numValues) noexcept;
+
     /** Multiplies each of the destination values by a fixed multiplier. */
     static void JUCE_CALLTYPE multiply (float* dest, float multiplier, int numValues) noexcept;
 
+    /** Multiplies each of the destination values by a fixed multiplier. */
+    static void JUCE_CALLTYPE multiply (double* dest, double multiplier, int numValues) noexcept;
+
+    /** Multiplies the destination values by a linear gain ramp.
+        The first value is multiplied by startGain, and the gain increases by gainIncrement
+        for each value after that.
+    */
+    static void JUCE_CALLTYPE multiplyWithRamp (float* dest, float startGain, float gainIncrement, int numValues) noexcept;
+
+    /** Multiplies the destination values by a linear gain ramp.
+        The first value is multiplied by startGain, and the gain increases by gainIncrement
+        for each value after that.
+    */
+    static void JUCE_CALLTYPE multiplyWithRamp (double* dest, double startGain, double gainIncrement, int numValues) noexcept;
+
     /** Copies a source vector to a destination, negating each value. */
     static void JUCE_CALLTYPE negate (float* dest, const float* src, int numValues) noexcept;
 
+    /** Copies a source vector to a destination, negating each value. */
+    static void JUCE_CALLTYPE negate (double* dest, const double* src, int numValues) noexcept;
+
     /** Converts a stream of integers to floats, multiplying each one by the given multiplier. */
     static void JUCE_CALLTYPE convertFixedToFloat (float* dest, const int* src, float multiplier, int numValues) noexcept;
 
     /** Finds the miniumum and maximum values in the given array. */
     static void JUCE_CALLTYPE findMinAndMax (const float* src, int numValues, float& minResult, float& maxResult) noexcept;
 
+    /** Finds the miniumum and maximum values in the given array. */
+    static void JUCE_CALLTYPE findMinAndMax (const double* src, int numValues, double& minResult, double& maxResult) noexcept;
+
     /** Finds the miniumum value in the given array. */
     static float JUCE_CALLTYPE findMinimum (const float* src, int numValues) noexcept;
 
+    /** Finds the miniumum value in the given array. */
+    static double JUCE_CALLTYPE findMinimum (const double* src, int numValues) noexcept;
+
     /** Finds the maximum value in the given array. */
     static float JUCE_CALLTYPE findMaximum (const float* src, int numValues) noexcept;
 
+    /** Finds the maximum value in the given array. */
+    static double JUCE_CALLTYPE findMaximum (const double* src, int numValues) noexcept;
+
     /** On Intel CPUs, this method enables or disables the SSE flush-to-zero mode.
         Effectively, this is a wrapper around a call to _MM_SET_FLUSH_ZERO_MODE
     */
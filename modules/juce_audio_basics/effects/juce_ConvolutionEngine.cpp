@@ -0,0 +1,431 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+/*  A set of equal-sized partitions, covering one section of the impulse response,
+    which are applied using uniformly-partitioned overlap-save convolution.
+
+    The first stage starts one partition into the impulse response, so each block's
+    result is needed straight after the block's input has arrived, and it's calculated
+    on the audio thread. Every later stage starts two partitions in, so its jobs can be
+    posted to the background thread as soon as a block arrives, and must be finished by
+    the time the next block has arrived.
+*/
+class ConvolutionEngine::Stage
+{
+public:
+    Stage (ConvolutionEngine& e, const float* const impulseResponse, const int irLength,
+           const int offset, const int size, const int numParts, const bool deferred)
+        : owner (e),
+          partitionSize (size),
+          numPartitions (numParts),
+          spectrumSize (size * 2 + 2),
+          isDeferred (deferred),
+          forwardFFT (roundToInt (std::log (size * 2.0) / std::log (2.0)), false),
+          inverseFFT (roundToInt (std::log (size * 2.0) / std::log (2.0)), true),
+          irSpectra ((size_t) (numParts * spectrumSize), true),
+          inputSpectra ((size_t) (numParts * spectrumSize), true),
+          accumulator ((size_t) spectrumSize),
+          inputRing ((size_t) (size * 3), true),
+          outputSlots ((size_t) (size * 2), true),
+          position (0), blockNumber (0), readSlot (0), spectrumIndex (0),
+          jobBlock (0), jobSlot (0)
+    {
+        jassert (forwardFFT.getSize() == size * 2);
+
+        for (int i = 0; i < numPartitions; ++i)
+        {
+            float* const spectrum = irSpectra + i * spectrumSize;
+            const int start = offset + i * partitionSize;
+            const int num = jmin (partitionSize, irLength - start);
+
+            if (num > 0)
+                memcpy (spectrum, impulseResponse + start, sizeof (float) * (size_t) num);
+
+            forwardFFT.performRealOnlyForwardTransform (spectrum);
+        }
+    }
+
+    ~Stage()
+    {
+        cancelJob();
+    }
+
+    void reset() noexcept
+    {
+        cancelJob();
+
+        inputSpectra.clear ((size_t) (numPartitions * spectrumSize));
+        inputRing.clear ((size_t) (partitionSize * 3));
+        outputSlots.clear ((size_t) (partitionSize * 2));
+        position = blockNumber = readSlot = spectrumIndex = 0;
+    }
+
+    // Stores some input, and adds the stage's output for the same period to the output buffer.
+    void process (const float* const input, float* const output, const int numSamples) noexcept
+    {
+        jassert (position + numSamples <= partitionSize);
+
+        memcpy (inputRing + (blockNumber % 3) * partitionSize + position, input, sizeof (float) * (size_t) numSamples);
+        FloatVectorOperations::add (output, outputSlots + readSlot * partitionSize + position, numSamples);
+
+        position += numSamples;
+
+        if (position == partitionSize)
+        {
+            position = 0;
+            const int completedBlock = blockNumber++;
+
+            if (isDeferred)
+            {
+                // the job for the previous block produces the output for the next one..
+                if (jobState.get() != idle)
+                {
+                    finishJob();
+                    readSlot ^= 1;
+                }
+
+                // ..and the job for this block can be done any time before the following one
+                jobBlock = completedBlock;
+                jobSlot = readSlot ^ 1;
+                jobState = pending;
+                owner.jobPosted();
+            }
+            else
+            {
+                performJob (completedBlock, readSlot ^ 1);
+                readSlot ^= 1;
+            }
+        }
+    }
+
+    // Called by the background thread, which might get there before or after the
+    // audio thread decides to do the job itself.
+    bool tryToRunJob() noexcept
+    {
+        if (! jobState.compareAndSetBool (running, pending))
+            return false;
+
+        performJob (jobBlock, jobSlot);
+        jobState = finished;
+        return true;
+    }
+
+private:
+    enum JobState { idle, pending, running, finished };
+
+    ConvolutionEngine& owner;
+    const int partitionSize, numPartitions, spectrumSize;
+    const bool isDeferred;
+    FFT forwardFFT, inverseFFT;
+    HeapBlock<float> irSpectra, inputSpectra, accumulator, inputRing, outputSlots;
+    int position, blockNumber, readSlot, spectrumIndex;
+    int jobBlock, jobSlot;
+    Atomic<int> jobState;
+
+    // If the background thread is part-way through the job, this has to wait for it, as
+    // there's nowhere else for the output to come from (see the ConvolutionEngine docs).
+    void finishJob() noexcept
+    {
+        if (! tryToRunJob())
+            while (jobState.get() != finished)
+                Thread::yield();
+
+        jobState = idle;
+    }
+
+    void cancelJob() noexcept
+    {
+        if (! jobState.compareAndSetBool (idle, pending))
+            while (jobState.get() == running)
+                Thread::yield();
+
+        jobState = idle;
+    }
+
+    void performJob (const int block, const int slot) noexcept
+    {
+        float* const spectrum = inputSpectra + spectrumIndex * spectrumSize;
+
+        memcpy (spectrum, inputRing + ((block + 2) % 3) * partitionSize, sizeof (float) * (size_t) partitionSize);
+        memcpy (spectrum + partitionSize, inputRing + (block % 3) * partitionSize, sizeof (float) * (size_t) partitionSize);
+        forwardFFT.performRealOnlyForwardTransform (spectrum);
+
+        zeromem (accumulator, sizeof (float) * (size_t) spectrumSize);
+
+        for (int i = 0; i < numPartitions; ++i)
+        {
+            const int index = (spectrumIndex + numPartitions - i) % numPartitions;
+            multiplyAccumulate (accumulator, inputSpectra + index * spectrumSize, irSpectra + i * spectrumSize, spectrumSize / 2);
+        }
+
+        inverseFFT.performRealOnlyInverseTransform (accumulator);
+
+        // (the first half is the wrapped-around part of the circular convolution)
+        memcpy (outputSlots + slot * partitionSize, accumulator + partitionSize, sizeof (float) * (size_t) partitionSize);
+
+        spectrumIndex = (spectrumIndex + 1) % numPartitions;
+    }
+
+    static void multiplyAccumulate (float* dest, const float* a, const float* b, const int numBins) noexcept
+    {
+        for (int i = 0; i < numBins; ++i)
+        {
+            const int re = i * 2, im = re + 1;
+            dest[re] += a[re] * b[re] - a[im] * b[im];
+            dest[im] += a[re] * b[im] + a[im] * b[re];
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (Stage)
+};
+
+//==============================================================================
+ConvolutionEngine::ConvolutionEngine (const float* const impulseResponse, const int irLength,
+                                      const int headSizeToUse, const int maxPartitionSize,
+                                      TimeSliceThread* const thread)
+    : impulseResponseLength (jmax (0, irLength)),
+      headSize (headSizeToUse),
+      headCoefficients ((size_t) headSizeToUse, true),
+      headHistory ((size_t) headSizeToUse * 2, true),
+      headPosition (0),
+      backgroundThread (thread)
+{
+    // the partition sizes must be powers of two!
+    jassert (isPowerOfTwo (headSize) && isPowerOfTwo (maxPartitionSize) && maxPartitionSize >= headSize);
+
+    memcpy (headCoefficients, impulseResponse, sizeof (float) * (size_t) jmin (headSize, impulseResponseLength));
+
+    // Each stage must start two of its own partitions into the response, so the previous
+    // one is extended to reach that point (the first just has to start one partition in).
+    int offset = headSize, size = headSize;
+
+    while (offset < impulseResponseLength)
+    {
+        const int nextSize = jmin (size * 8, maxPartitionSize);
+        const int end = nextSize > size ? jmin (impulseResponseLength, nextSize * 2) : impulseResponseLength;
+        const int numPartitions = (end - offset + size - 1) / size;
+
+        stages.add (new Stage (*this, impulseResponse, impulseResponseLength,
+                               offset, size, numPartitions, stages.size() > 0));
+
+        offset += numPartitions * size;
+        size = nextSize;
+    }
+
+    if (backgroundThread != nullptr && stages.size() > 1)
+        backgroundThread->addTimeSliceClient (this);
+}
+
+ConvolutionEngine::~ConvolutionEngine()
+{
+    if (backgroundThread != nullptr)
+        backgroundThread->removeTimeSliceClient (this);
+}
+
+//==============================================================================
+void ConvolutionEngine::reset() noexcept
+{
+    headHistory.clear ((size_t) headSize * 2);
+    headPosition = 0;
+
+    for (int i = 0; i < stages.size(); ++i)
+        stages.getUnchecked (i)->reset();
+}
+
+// Called by the audio thread. This mustn't touch the TimeSliceThread, whose lock can be held
+// for as long as another client's time-slice takes, so it just sets a flag for useTimeSlice()
+// to pick up.
+void ConvolutionEngine::jobPosted() noexcept
+{
+    if (backgroundThread != nullptr)
+        jobsArePending = 1;
+}
+
+void ConvolutionEngine::stopUsingBackgroundThread() noexcept
+{
+    hasStoppedUsingThread = 1;
+}
+
+int ConvolutionEngine::useTimeSlice()
+{
+    // (returning -1 makes the TimeSliceThread remove this client. Any jobs that are still
+    // pending will be done by the audio thread when it needs their results)
+    if (hasStoppedUsingThread.get() != 0)
+        return -1;
+
+    if (jobsArePending.get() == 0)
+        return millisecondsBetweenChecks;
+
+    // (this is cleared before running the jobs, so that any posted meanwhile get signalled again)
+    jobsArePending = 0;
+
+    for (int i = 1; i < stages.size(); ++i)
+        stages.getUnchecked (i)->tryToRunJob();
+
+    return 0;
+}
+
+void ConvolutionEngine::processHead (float* const output, const int numSamples) const noexcept
+{
+    const float* const input = headHistory + headSize + headPosition;
+    const int numTaps = jmin (headSize, impulseResponseLength);
+
+    if (numTaps == 0)
+    {
+        FloatVectorOperations::clear (output, numSamples);
+        return;
+    }
+
+    FloatVectorOperations::copyWithMultiply (output, input, headCoefficients[0], numSamples);
+
+    for (int i = 1; i < numTaps; ++i)
+        FloatVectorOperations::addWithMultiply (output, input - i, headCoefficients[i], numSamples);
+}
+
+void ConvolutionEngine::processSamples (const float* input, float* output, int numSamples) noexcept
+{
+    while (numSamples > 0)
+    {
+        const int num = jmin (numSamples, headSize - headPosition);
+        float* const history = headHistory + headSize + headPosition;
+
+        // (the input is copied first, so that it can be the same buffer as the output)
+        memcpy (history, input, sizeof (float) * (size_t) num);
+        processHead (output, num);
+
+        for (int i = 0; i < stages.size(); ++i)
+            stages.getUnchecked (i)->process (history, output, num);
+
+        input += num;
+        output += num;
+        numSamples -= num;
+        headPosition += num;
+
+        if (headPosition == headSize)
+        {
+            memcpy (headHistory, headHistory + headSize, sizeof (float) * (size_t) headSize);
+            headPosition = 0;
+        }
+    }
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class ConvolutionEngineTests  : public UnitTest
+{
+public:
+    ConvolutionEngineTests() : UnitTest ("ConvolutionEngine") {}
+
+    void testAgainstDirectConvolution (const int irLength, TimeSliceThread* const thread,
+                                       const bool stopUsingThreadHalfWay = false)
+    {
+        Random r (getRandom());
+        const int numSamples = 30000;
+        HeapBlock<float> ir ((size_t) irLength), input ((size_t) numSamples), output ((size_t) numSamples);
+
+        for (int i = 0; i < irLength; ++i)
+            ir[i] = (r.nextFloat() * 2.0f - 1.0f) * std::exp (-3.0f * i / irLength);
+
+        for (int i = 0; i < numSamples; ++i)
+            input[i] = r.nextFloat() * 2.0f - 1.0f;
+
+        ConvolutionEngine engine (ir, irLength, 32, 1024, thread);
+        memcpy (output, input, sizeof (float) * (size_t) numSamples);
+
+        for (int pos = 0; pos < numSamples;)
+        {
+            if (stopUsingThreadHalfWay && pos >= numSamples / 2)
+                engine.stopUsingBackgroundThread();
+
+            const int num = jmin (numSamples - pos, 1 + r.nextInt (500));
+            engine.processSamples (output + pos, output + pos, num);
+            pos += num;
+        }
+
+        if (stopUsingThreadHalfWay)
+        {
+            for (int i = 0; i < 100 && thread->getNumClients() > 0; ++i)
+                Thread::sleep (5);
+
+            expectEquals (thread->getNumClients(), 0);
+        }
+
+        float maxError = 0;
+
+        for (int i = 0; i < numSamples; i += 7)
+        {
+            double expected = 0;
+
+            for (int j = jmax (0, i - irLength + 1); j <= i; ++j)
+                expected += input[j] * (double) ir[i - j];
+
+            maxError = jmax (maxError, (float) std::abs (output[i] - expected));
+        }
+
+        expect (maxError < 1.0e-3f, "Error was " + String (maxError) + " for length " + String (irLength)
+                                      + " with " + String (engine.getNumStages()) + " stages");
+    }
+
+    void runTest()
+    {
+        beginTest ("Zero latency");
+        {
+            const float ir[] = { 0.5f, -0.25f, 0.125f };
+            ConvolutionEngine engine (ir, numElementsInArray (ir));
+
+            float data[] = { 1.0f, 0, 0, 0, 2.0f };
+            engine.processSamples (data, data, numElementsInArray (data));
+
+            expectEquals (data[0], 0.5f);
+            expectEquals (data[1], -0.25f);
+            expectEquals (data[2], 0.125f);
+            expectEquals (data[3], 0.0f);
+            expectEquals (data[4], 1.0f);
+        }
+
+        beginTest ("Matches direct convolution");
+
+        const int lengths[] = { 20, 32, 100, 1000, 5000, 20000 };
+
+        for (int i = 0; i < numElementsInArray (lengths); ++i)
+            testAgainstDirectConvolution (lengths[i], nullptr);
+
+        beginTest ("Using a background thread");
+        {
+            TimeSliceThread thread ("convolution test");
+            thread.startThread();
+
+            testAgainstDirectConvolution (5000, &thread);
+            testAgainstDirectConvolution (20000, &thread);
+
+            beginTest ("Stopping the background thread");
+            testAgainstDirectConvolution (20000, &thread, true);
+        }
+    }
+};
+
+static ConvolutionEngineTests convolutionEngineTests;
+
+#endif
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+#ifndef JUCE_CONVOLUTIONENGINE_H_INCLUDED
+#define JUCE_CONVOLUTIONENGINE_H_INCLUDED
+
+
+//==============================================================================
+/**
+    Convolves a single channel of audio with an impulse response, without adding
+    any latency.
+
+    The start of the impulse response is applied directly, sample by sample, and the
+    rest is split into partitions which are applied with FFTs. The partitions get bigger
+    the further they are into the impulse response, which keeps the CPU cost of long
+    impulse responses down: with the default settings the first partitions are 64
+    samples long, and by 8192 samples into the response they've grown to 4096.
+
+    The first set of partitions is processed on the audio thread, but if you supply a
+    TimeSliceThread, the bigger ones are handed over to that. Each of these background
+    jobs has at least one block's worth of time before its result is needed, and if it
+    hasn't been started by then, the audio thread will do the job itself, so the output
+    never depends on how the background thread gets scheduled.
+
+    The audio thread's timing can, though: if the background thread has started a job
+    but not finished it when its result is needed, the audio thread has to spin (calling
+    Thread::yield()) until it's done. The jobs for the bigger partitions can take a while,
+    so if the background thread gets pre-empted part-way through one, the audio thread
+    could miss its deadline - to avoid that, give the background thread a high priority.
+
+    The engine's time-slice never blocks: when there's no job waiting, it just asks to be
+    called again a millisecond later, so the thread can be shared with other clients.
+
+    @see ConvolutionAudioSource, FFT
+*/
+class JUCE_API  ConvolutionEngine  : private TimeSliceClient
+{
+public:
+    //==============================================================================
+    /** Creates an engine for an impulse response.
+
+        @param impulseResponse          the impulse response to use. This is copied, so
+                                        doesn't need to stay valid after the constructor
+        @param impulseResponseLength    the number of samples in the impulse response
+        @param headSize                 the size of the smallest partitions, which must be a
+                                        power of two. The first headSize samples of the response
+                                        are applied directly, so making this smaller reduces the
+                                        cost of that, but increases the cost of the FFTs.
+        @param maxPartitionSize         the size that the partitions are allowed to grow to,
+                                        which must also be a power of two
+        @param backgroundThread         an optional thread on which to process the bigger
+                                        partitions. This must outlive the engine
+    */
+    ConvolutionEngine (const float* impulseResponse,
+                       int impulseResponseLength,
+                       int headSize = 64,
+                       int maxPartitionSize = 4096,
+                       TimeSliceThread* backgroundThread = nullptr);
+
+    /** Destructor. */
+    ~ConvolutionEngine();
+
+    //==============================================================================
+    /** Convolves a block of samples.
+        The input and output pointers may refer to the same data.
+    */
+    void processSamples (const float* input, float* output, int numSamples) noexcept;
+
+    /** Clears all the engine's internal state, ready for a new stream of input.
+        This mustn't be called at the same time as processSamples().
+    */
+    void reset() noexcept;
+
+    /** Returns the length of the impulse response that the engine was created with. */
+    int getImpulseResponseLength() const noexcept       { return impulseResponseLength; }
+
+    /** Returns the number of different partition sizes that the engine is using. */
+    int getNumStages() const noexcept                   { return stages.size(); }
+
+    /** Stops the engine from handing any more work to its background thread.
+
+        The engine will remove itself from the TimeSliceThread the next time that it gets
+        a time-slice, and from then on, processSamples() will do all of the work on the
+        calling thread. This doesn't block or allocate, so it can be called on the audio
+        thread, e.g. when an engine that's being replaced has been faded out.
+    */
+    void stopUsingBackgroundThread() noexcept;
+
+private:
+    //==============================================================================
+    class Stage;
+    friend class Stage;
+
+    const int impulseResponseLength, headSize;
+    HeapBlock<float> headCoefficients, headHistory;
+    int headPosition;
+    OwnedArray<Stage> stages;
+    TimeSliceThread* const backgroundThread;
+    Atomic<int> jobsArePending, hasStoppedUsingThread;
+
+    enum { millisecondsBetweenChecks = 1 };
+
+    void jobPosted() noexcept;
+    int useTimeSlice() override;
+    void processHead (float* output, int numSamples) const noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConvolutionEngine)
+};
+
+
+#endif   // JUCE_CONVOLUTIONENGINE_H_INCLUDED
@@ -0,0 +1,895 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+struct FFT::Kernels
+{
+    static inline Complex multiply (const Complex a, const Complex b) noexcept
+    {
+        const Complex result = { a.r * b.r - a.i * b.i, a.r * b.i + a.i * b.r };
+        return result;
+    }
+
+    //==============================================================================
+    /* These run the radix-2 stages which combine blocks of 'half' points, for each half-size
+       in the range [firstHalf, endHalf). The twiddles for each stage are stored contiguously at
+       stageTwiddles[half], so that the SIMD versions can load several of them at once.
+    */
+    static void stagesScalar (Complex* const data, const int numPoints, const int firstHalf,
+                              const int endHalf, const Complex* const stageTwiddles) noexcept
+    {
+        for (int half = firstHalf; half < endHalf; half *= 2)
+        {
+            const Complex* const w = stageTwiddles + half;
+
+            for (int start = 0; start < numPoints; start += 2 * half)
+            {
+                Complex* const a = data + start;
+                Complex* const b = a + half;
+
+                for (int j = 0; j < half; ++j)
+                {
+                    const Complex t (multiply (w[j], b[j]));
+
+                    b[j].r = a[j].r - t.r;
+                    b[j].i = a[j].i - t.i;
+                    a[j].r += t.r;
+                    a[j].i += t.i;
+                }
+            }
+        }
+    }
+
+   #if JUCE_USE_SSE_INTRINSICS
+    // (this does 2 complex values at a time, so needs half >= 2)
+    static void stagesSSE (Complex* const data, const int numPoints, const int firstHalf,
+                           const int endHalf, const Complex* const stageTwiddles) noexcept
+    {
+        const __m128 signs = _mm_set_ps (1.0f, -1.0f, 1.0f, -1.0f);
+
+        for (int half = firstHalf; half < endHalf; half *= 2)
+        {
+            const float* const w = reinterpret_cast<const float*> (stageTwiddles + half);
+
+            for (int start = 0; start < numPoints; start += 2 * half)
+            {
+                float* const a = reinterpret_cast<float*> (data + start);
+                float* const b = a + 2 * half;
+
+                for (int j = 0; j < 2 * half; j += 4)
+                {
+                    const __m128 tw (_mm_loadu_ps (w + j));
+                    const __m128 x (_mm_loadu_ps (b + j));
+                    const __m128 wr (_mm_shuffle_ps (tw, tw, _MM_SHUFFLE (2, 2, 0, 0)));
+                    const __m128 wi (_mm_shuffle_ps (tw, tw, _MM_SHUFFLE (3, 3, 1, 1)));
+                    const __m128 swapped (_mm_shuffle_ps (x, x, _MM_SHUFFLE (2, 3, 0, 1)));
+                    const __m128 t (_mm_add_ps (_mm_mul_ps (wr, x), _mm_mul_ps (_mm_mul_ps (wi, swapped), signs)));
+                    const __m128 y (_mm_loadu_ps (a + j));
+
+                    _mm_storeu_ps (a + j, _mm_add_ps (y, t));
+                    _mm_storeu_ps (b + j, _mm_sub_ps (y, t));
+                }
+            }
+        }
+    }
+   #endif
+
+   #if JUCE_USE_AVX_INTRINSICS
+    // (this does 4 complex values at a time, so needs half >= 4)
+    JUCE_AVX_TARGET static void stagesAVX (Complex* const data, const int numPoints, const int firstHalf,
+                                           const int endHalf, const Complex* const stageTwiddles) noexcept
+    {
+        for (int half = firstHalf; half < endHalf; half *= 2)
+        {
+            const float* const w = reinterpret_cast<const float*> (stageTwiddles + half);
+
+            for (int start = 0; start < numPoints; start += 2 * half)
+            {
+                float* const a = reinterpret_cast<float*> (data + start);
+                float* const b = a + 2 * half;
+
+                for (int j = 0; j < 2 * half; j += 8)
+                {
+                    const __m256 tw (_mm256_loadu_ps (w + j));
+                    const __m256 x (_mm256_loadu_ps (b + j));
+                    const __m256 swapped (_mm256_permute_ps (x, _MM_SHUFFLE (2, 3, 0, 1)));
+                    const __m256 t (_mm256_addsub_ps (_mm256_mul_ps (_mm256_moveldup_ps (tw), x),
+                                                      _mm256_mul_ps (_mm256_movehdup_ps (tw), swapped)));
+                    const __m256 y (_mm256_loadu_ps (a + j));
+
+                    _mm256_storeu_ps (a + j, _mm256_add_ps (y, t));
+                    _mm256_storeu_ps (b + j, _mm256_sub_ps (y, t));
+                }
+            }
+        }
+
+        _mm256_zeroupper();
+    }
+   #endif
+
+   #if JUCE_USE_ARM_NEON
+    // (this does 4 complex values at a time, so needs half >= 4)
+    static void stagesNEON (Complex* const data, const int numPoints, const int firstHalf,
+                            const int endHalf, const Complex* const stageTwiddles) noexcept
+    {
+        for (int half = firstHalf; half < endHalf; half *= 2)
+        {
+            const float* const w = reinterpret_cast<const float*> (stageTwiddles + half);
+
+            for (int start = 0; start < numPoints; start += 2 * half)
+            {
+                float* const a = reinterpret_cast<float*> (data + start);
+                float* const b = a + 2 * half;
+
+                for (int j = 0; j < 2 * half; j += 8)
+                {
+                    const float32x4x2_t tw (vld2q_f32 (w + j));
+                    const float32x4x2_t x (vld2q_f32 (b + j));
+                    float32x4x2_t y (vld2q_f32 (a + j)), t;
+
+                    t.val[0] = vsubq_f32 (vmulq_f32 (tw.val[0], x.val[0]), vmulq_f32 (tw.val[1], x.val[1]));
+                    t.val[1] = vaddq_f32 (vmulq_f32 (tw.val[0], x.val[1]), vmulq_f32 (tw.val[1], x.val[0]));
+
+                    float32x4x2_t sum, difference;
+                    sum.val[0] = vaddq_f32 (y.val[0], t.val[0]);
+                    sum.val[1] = vaddq_f32 (y.val[1], t.val[1]);
+                    difference.val[0] = vsubq_f32 (y.val[0], t.val[0]);
+                    difference.val[1] = vsubq_f32 (y.val[1], t.val[1]);
+
+                    vst2q_f32 (a + j, sum);
+                    vst2q_f32 (b + j, difference);
+                }
+            }
+        }
+    }
+   #endif
+
+    static void getBestStages (StageFunction& function, int& firstHalf) noexcept
+    {
+       #if JUCE_USE_AVX_INTRINSICS
+        if (FloatVectorHelpers::getAVXSupport() != FloatVectorHelpers::noAVX)
+        {
+            function = stagesAVX;
+            firstHalf = 4;
+            return;
+        }
+       #endif
+
+       #if JUCE_USE_SSE_INTRINSICS
+        if (FloatVectorHelpers::isSSE2Available())
+        {
+            function = stagesSSE;
+            firstHalf = 2;
+            return;
+        }
+       #endif
+
+       #if JUCE_USE_ARM_NEON
+        function = stagesNEON;
+        firstHalf = 4;
+       #else
+        function = stagesScalar;
+        firstHalf = 1;
+       #endif
+    }
+
+    //==============================================================================
+    /* Splits a size into a list of (radix, remaining size) pairs. 4s come first, because
+       they have the cheapest butterflies, then 2s, 3s, 5s and any other primes.
+    */
+    static void factorise (int n, int* dest) noexcept
+    {
+        int p = 4;
+
+        while (n > 1)
+        {
+            while (n % p != 0)
+            {
+                switch (p)
+                {
+                    case 4:   p = 2; break;
+                    case 2:   p = 3; break;
+                    default:  p += 2; break;
+                }
+
+                if (p * p > n)
+                    p = n;
+            }
+
+            n /= p;
+            *dest++ = p;
+            *dest++ = n;
+        }
+    }
+
+    /* The mixed-radix butterflies each combine p blocks of m points, using twiddles from
+       a table for the full size of the FFT.
+    */
+    static void butterfly2 (Complex* const out, const Complex* const tw, const int twiddleStride, const int m) noexcept
+    {
+        for (int k = 0; k < m; ++k)
+        {
+            const Complex t (multiply (out[k + m], tw[k * twiddleStride]));
+
+            out[k + m].r = out[k].r - t.r;
+            out[k + m].i = out[k].i - t.i;
+            out[k].r += t.r;
+            out[k].i += t.i;
+        }
+    }
+
+    static void butterfly3 (Complex* const out, const Complex* const tw, const int twiddleStride, const int m) noexcept
+    {
+        const float sine = tw [twiddleStride * m].i;
+
+        for (int k = 0; k < m; ++k)
+        {
+            const Complex s1 (multiply (out[k + m],     tw[k * twiddleStride]));
+            const Complex s2 (multiply (out[k + 2 * m], tw[2 * k * twiddleStride]));
+
+            const float sumR = s1.r + s2.r,               sumI = s1.i + s2.i;
+            const float diffR = (s1.r - s2.r) * sine,     diffI = (s1.i - s2.i) * sine;
+            const float midR = out[k].r - 0.5f * sumR,    midI = out[k].i - 0.5f * sumI;
+
+            out[k].r += sumR;
+            out[k].i += sumI;
+            out[k + m].r     = midR - diffI;
+            out[k + m].i     = midI + diffR;
+            out[k + 2 * m].r = midR + diffI;
+            out[k + 2 * m].i = midI - diffR;
+        }
+    }
+
+    static void butterfly4 (Complex* const out, const Complex* const tw, const int twiddleStride,
+                            const int m, const bool inverse) noexcept
+    {
+        for (int k = 0; k < m; ++k)
+        {
+            const Complex s0 (multiply (out[k + m],     tw[k * twiddleStride]));
+            const Complex s1 (multiply (out[k + 2 * m], tw[2 * k * twiddleStride]));
+            const Complex s2 (multiply (out[k + 3 * m], tw[3 * k * twiddleStride]));
+
+            const float aR = out[k].r + s1.r,  aI = out[k].i + s1.i;
+            const float bR = out[k].r - s1.r,  bI = out[k].i - s1.i;
+            const float cR = s0.r + s2.r,      cI = s0.i + s2.i;
+            const float dR = s0.r - s2.r,      dI = s0.i - s2.i;
+
+            out[k].r         = aR + cR;
+            out[k].i         = aI + cI;
+            out[k + 2 * m].r = aR - cR;
+            out[k + 2 * m].i = aI - cI;
+
+            if (inverse)
+            {
+                out[k + m].r     = bR - dI;
+                out[k + m].i     = bI + dR;
+                out[k + 3 * m].r = bR + dI;
+                out[k + 3 * m].i = bI - dR;
+            }
+            else
+            {
+                out[k + m].r     = bR + dI;
+                out[k + m].i     = bI - dR;
+                out[k + 3 * m].r = bR - dI;
+                out[k + 3 * m].i = bI + dR;
+            }
+        }
+    }
+
+    static void butterfly5 (Complex* const out, const Complex* const tw, const int twiddleStride, const int m) noexcept
+    {
+        const Complex ya (tw [twiddleStride * m]), yb (tw [twiddleStride * 2 * m]);
+
+        for (int k = 0; k < m; ++k)
+        {
+            const Complex s0 (out[k]);
+            const Complex s1 (multiply (out[k + m],     tw[k * twiddleStride]));
+            const Complex s2 (multiply (out[k + 2 * m], tw[2 * k * twiddleStride]));
+            const Complex s3 (multiply (out[k + 3 * m], tw[3 * k * twiddleStride]));
+            const Complex s4 (multiply (out[k + 4 * m], tw[4 * k * twiddleStride]));
+
+            const float sum14R = s1.r + s4.r,  sum14I = s1.i + s4.i;
+            const float dif14R = s1.r - s4.r,  dif14I = s1.i - s4.i;
+            const float sum23R = s2.r + s3.r,  sum23I = s2.i + s3.i;
+            const float dif23R = s2.r - s3.r,  dif23I = s2.i - s3.i;
+
+            out[k].r = s0.r + sum14R + sum23R;
+            out[k].i = s0.i + sum14I + sum23I;
+
+            const float aR = s0.r + sum14R * ya.r + sum23R * yb.r;
+            const float aI = s0.i + sum14I * ya.r + sum23I * yb.r;
+            const float bR =   dif14I * ya.i + dif23I * yb.i;
+            const float bI = -(dif14R * ya.i + dif23R * yb.i);
+
+            out[k + m].r     = aR - bR;
+            out[k + m].i     = aI - bI;
+            out[k + 4 * m].r = aR + bR;
+            out[k + 4 * m].i = aI + bI;
+
+            const float cR = s0.r + sum14R * yb.r + sum23R * ya.r;
+            const float cI = s0.i + sum14I * yb.r + sum23I * ya.r;
+            const float dR = dif23I * ya.i - dif14I * yb.i;
+            const float dI = dif14R * yb.i - dif23R * ya.i;
+
+            out[k + 2 * m].r = cR + dR;
+            out[k + 2 * m].i = cI + dI;
+            out[k + 3 * m].r = cR - dR;
+            out[k + 3 * m].i = cI - dI;
+        }
+    }
+
+    // (this is O(p^2), so is only used for primes above 5)
+    static void butterflyGeneric (Complex* const out, const Complex* const tw, const int twiddleStride,
+                                  const int m, const int p, const int tableSize, Complex* const temp) noexcept
+    {
+        for (int u = 0; u < m; ++u)
+        {
+            for (int q = 0; q < p; ++q)
+                temp[q] = out[u + q * m];
+
+            for (int q1 = 0; q1 < p; ++q1)
+            {
+                const int k = u + q1 * m;
+                Complex sum (temp[0]);
+                int index = 0;
+
+                for (int q = 1; q < p; ++q)
+                {
+                    index += twiddleStride * k;
+
+                    if (index >= tableSize)
+                        index -= tableSize;
+
+                    const Complex t (multiply (temp[q], tw[index]));
+                    sum.r += t.r;
+                    sum.i += t.i;
+                }
+
+                out[k] = sum;
+            }
+        }
+    }
+};
+
+//==============================================================================
+FFT::FFT (const int order, const bool isInverse)
+    : size (1 << order),
+      inverse (isInverse),
+      isPowerOfTwoSize (true),
+      vectorisedStages (nullptr),
+      firstVectorisedStage (0)
+{
+    jassert (order >= 0 && order < 31);
+    initialise();
+}
+
+FFT::FFT (const int numPoints, const bool isInverse, SizeInPoints)
+    : size (numPoints),
+      inverse (isInverse),
+      isPowerOfTwoSize (isPowerOfTwo (numPoints)),
+      vectorisedStages (nullptr),
+      firstVectorisedStage (0)
+{
+    jassert (numPoints > 0);
+    initialise();
+}
+
+FFT::~FFT() {}
+
+FFT* FFT::createForSize (const int numPoints, const bool isInverse)
+{
+    return new FFT (numPoints, isInverse, sizeInPoints);
+}
+
+void FFT::initialise()
+{
+    const double sign = inverse ? 2.0 * double_Pi : -2.0 * double_Pi;
+
+    realTwiddles.malloc ((size_t) (size / 4 + 1));
+
+    for (int i = 0; i <= size / 4; ++i)
+    {
+        const double phase = sign * i / size;
+        realTwiddles[i].r = (float) std::cos (phase);
+        realTwiddles[i].i = (float) std::sin (phase);
+    }
+
+    if (isPowerOfTwoSize)
+    {
+        stageTwiddles.malloc ((size_t) jmax (2, size));
+
+        for (int half = 1; half < size; half *= 2)
+        {
+            for (int j = 0; j < half; ++j)
+            {
+                const double phase = sign * j / (2 * half);
+                stageTwiddles[half + j].r = (float) std::cos (phase);
+                stageTwiddles[half + j].i = (float) std::sin (phase);
+            }
+        }
+
+        int order = 0;
+        while ((1 << order) < size)
+            ++order;
+
+        bitReversedIndexes.malloc ((size_t) size);
+
+        for (int i = 0; i < size; ++i)
+        {
+            int reversed = 0;
+
+            for (int bit = 0; bit < order; ++bit)
+                if ((i & (1 << bit)) != 0)
+                    reversed |= 1 << (order - 1 - bit);
+
+            bitReversedIndexes[i] = reversed;
+        }
+
+        Kernels::getBestStages (vectorisedStages, firstVectorisedStage);
+    }
+    else
+    {
+        twiddles.malloc ((size_t) size);
+
+        for (int i = 0; i < size; ++i)
+        {
+            const double phase = sign * i / size;
+            twiddles[i].r = (float) std::cos (phase);
+            twiddles[i].i = (float) std::sin (phase);
+        }
+
+        // (a size can't have more than 31 factors, and each one takes 2 ints)
+        factors.calloc (64);
+        halfSizeFactors.calloc (64);
+        Kernels::factorise (size, factors);
+
+        if ((size & 1) == 0)
+            Kernels::factorise (size / 2, halfSizeFactors);
+
+        // the scratch space holds a copy of the input for in-place transforms, plus room
+        // for the generic butterfly to use
+        int largestFactor = 0;
+
+        for (int i = 0; factors[i] != 0; i += 2)
+            largestFactor = jmax (largestFactor, factors[i]);
+
+        scratch.malloc ((size_t) (size + largestFactor));
+    }
+}
+
+//==============================================================================
+void FFT::perform (const Complex* input, Complex* const output, const int numPoints, const int twiddleStride) const noexcept
+{
+    if (isPowerOfTwoSize)
+    {
+        if (input != output)
+            memcpy (output, input, sizeof (Complex) * (size_t) numPoints);
+
+        performRadix2 (output, numPoints);
+    }
+    else
+    {
+        if (input == output)
+        {
+            memcpy (scratch, input, sizeof (Complex) * (size_t) numPoints);
+            input = scratch;
+        }
+
+        performMixedRadix (output, input, 1, twiddleStride, twiddleStride == 1 ? factors : halfSizeFactors);
+    }
+}
+
+void FFT::performRadix2 (Complex* const data, const int numPoints) const noexcept
+{
+    // (the table is for the full size, so when doing a transform of half the size, the
+    // indexes all have an extra zero at the bottom which needs to be shifted out)
+    const int shift = numPoints < size ? 1 : 0;
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        const int j = bitReversedIndexes[i] >> shift;
+
+        if (i < j)
+            std::swap (data[i], data[j]);
+    }
+
+    // the first stages are too small for the SIMD versions, so are done with the scalar one
+    const int firstVectorised = jmin (firstVectorisedStage, numPoints);
+
+    Kernels::stagesScalar (data, numPoints, 1, firstVectorised, stageTwiddles);
+
+    if (firstVectorised < numPoints)
+        vectorisedStages (data, numPoints, firstVectorised, numPoints, stageTwiddles);
+}
+
+void FFT::performMixedRadix (Complex* const output, const Complex* const input, const int inputStride,
+                             const int twiddleStride, const int* const factorList) const noexcept
+{
+    const int p = factorList[0], m = factorList[1];
+
+    if (m == 1)
+    {
+        for (int i = 0; i < p; ++i)
+            output[i] = input[i * inputStride];
+    }
+    else
+    {
+        for (int i = 0; i < p; ++i)
+            performMixedRadix (output + i * m, input + i * inputStride, inputStride * p, twiddleStride * p, factorList + 2);
+    }
+
+    switch (p)
+    {
+        case 2:   Kernels::butterfly2 (output, twiddles, twiddleStride, m); break;
+        case 3:   Kernels::butterfly3 (output, twiddles, twiddleStride, m); break;
+        case 4:   Kernels::butterfly4 (output, twiddles, twiddleStride, m, inverse); break;
+        case 5:   Kernels::butterfly5 (output, twiddles, twiddleStride, m); break;
+        default:  Kernels::butterflyGeneric (output, twiddles, twiddleStride, m, p, size, scratch + size); break;
+    }
+}
+
+void FFT::perform (const Complex* const input, Complex* const output) const noexcept
+{
+    perform (input, output, size, 1);
+}
+
+/*  The real-only transforms treat the N real values as N/2 complex ones, do a complex
+    transform of half the size, and then untangle the spectra of the odd and even samples:
+
+        X[k] = E[k] + W^k O[k],  where E[k] = (Z[k] + Z*[N/2 - k]) / 2
+                                 and   O[k] = (Z[k] - Z*[N/2 - k]) / 2i
+*/
+void FFT::performRealOnlyForwardTransform (float* const d) const noexcept
+{
+    jassert (! inverse && size >= 2 && (size & 1) == 0);
+
+    Complex* const z = reinterpret_cast<Complex*> (d);
+    const int m = size / 2;
+
+    perform (z, z, m, 2);
+
+    const Complex z0 (z[0]);
+    z[0].r = z0.r + z0.i;  z[0].i = 0;
+    z[m].r = z0.r - z0.i;  z[m].i = 0;
+
+    for (int k = 1; k <= m / 2; ++k)
+    {
+        const Complex a (z[k]), b (z[m - k]);
+
+        const float er = 0.5f * (a.r + b.r),  ei = 0.5f * (a.i - b.i);
+        const float orr = 0.5f * (a.i + b.i), oi = 0.5f * (b.r - a.r);
+
+        const Complex& w = realTwiddles[k];
+        const float wor = w.r * orr - w.i * oi;
+        const float woi = w.r * oi + w.i * orr;
+
+        z[k].r = er + wor;
+        z[k].i = ei + woi;
+        z[m - k].r = er - wor;
+        z[m - k].i = woi - ei;
+    }
+}
+
+void FFT::performRealOnlyInverseTransform (float* const d) const noexcept
+{
+    jassert (inverse && size >= 2 && (size & 1) == 0);
+
+    Complex* const z = reinterpret_cast<Complex*> (d);
+    const int m = size / 2;
+
+    const float x0 = z[0].r, xm = z[m].r;
+    z[0].r = 0.5f * (x0 + xm);
+    z[0].i = 0.5f * (x0 - xm);
+
+    for (int k = 1; k <= m / 2; ++k)
+    {
+        const Complex p (z[k]), q (z[m - k]);
+
+        const float er = 0.5f * (p.r + q.r),  ei = 0.5f * (p.i - q.i);
+        const float dr = 0.5f * (p.r - q.r),  di = 0.5f * (p.i + q.i);
+
+        const Complex& w = realTwiddles[k];
+        const float orr = dr * w.r - di * w.i;
+        const float oi  = dr * w.i + di * w.r;
+
+        z[k].r = er - oi;
+        z[k].i = ei + orr;
+        z[m - k].r = er + oi;
+        z[m - k].i = orr - ei;
+    }
+
+    perform (z, z, m, 2);
+
+    FloatVectorOperations::multiply (d, 1.0f / m, size);
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class FFTTests  : public UnitTest
+{
+public:
+    FFTTests() : UnitTest ("FFT") {}
+
+    static void performDFT (const FFT::Complex* input, FFT::Complex* output, const int size, const bool inverse)
+    {
+        for (int k = 0; k < size; ++k)
+        {
+            double re = 0, im = 0;
+
+            for (int n = 0; n < size; ++n)
+            {
+                const double phase = (inverse ? 2.0 : -2.0) * double_Pi * (((int64) k * n) % size) / size;
+                re += input[n].r * std::cos (phase) - input[n].i * std::sin (phase);
+                im += input[n].r * std::sin (phase) + input[n].i * std::cos (phase);
+            }
+
+            output[k].r = (float) re;
+            output[k].i = (float) im;
+        }
+    }
+
+    static float getMaxError (const FFT::Complex* a, const FFT::Complex* b, const int num)
+    {
+        float maxError = 0;
+
+        for (int i = 0; i < num; ++i)
+            maxError = jmax (maxError, std::abs (a[i].r - b[i].r), std::abs (a[i].i - b[i].i));
+
+        return maxError;
+    }
+
+    static float getMaxMagnitude (const FFT::Complex* data, const int num)
+    {
+        float maxMagnitude = 0;
+
+        for (int i = 0; i < num; ++i)
+            maxMagnitude = jmax (maxMagnitude, std::abs (data[i].r), std::abs (data[i].i));
+
+        return maxMagnitude;
+    }
+
+    // The rounding errors of an FFT grow with the number of passes over the data, i.e. with
+    // log2 (size), so errors are measured relative to the size of the values being compared.
+    static float getTolerance (const int size, const float maxMagnitude)
+    {
+        return 1.0e-6f * (1.0f + (float) (std::log ((double) size) / std::log (2.0))) * jmax (1.0f, maxMagnitude);
+    }
+
+    void testComplexTransform (const FFT& fft, const bool isInverse, Random& r)
+    {
+        const int size = fft.getSize();
+        HeapBlock<FFT::Complex> input ((size_t) size, true), output ((size_t) size, true), expected ((size_t) size, true);
+
+        for (int i = 0; i < size; ++i)
+        {
+            input[i].r = r.nextFloat() * 2.0f - 1.0f;
+            input[i].i = r.nextFloat() * 2.0f - 1.0f;
+        }
+
+        performDFT (input, expected, size, isInverse);
+        const float tolerance = getTolerance (size, getMaxMagnitude (expected, size));
+
+        fft.perform (input, output);
+        float maxError = getMaxError (output, expected, size);
+        expect (maxError < tolerance, "Error was " + String (maxError) + " for size " + String (size));
+
+        fft.perform (input, input);
+        maxError = getMaxError (input, expected, size);
+        expect (maxError < tolerance, "In-place error was " + String (maxError) + " for size " + String (size));
+    }
+
+    void testRealTransforms (const FFT& forward, const FFT& inverse, Random& r)
+    {
+        const int size = forward.getSize();
+        HeapBlock<float> data ((size_t) size + 2), original ((size_t) size);
+        HeapBlock<FFT::Complex> complexInput ((size_t) size), expected ((size_t) size);
+
+        for (int i = 0; i < size; ++i)
+        {
+            original[i] = data[i] = r.nextFloat() * 2.0f - 1.0f;
+            complexInput[i].r = original[i];
+            complexInput[i].i = 0;
+        }
+
+        forward.performRealOnlyForwardTransform (data);
+        forward.perform (complexInput, expected);
+
+        float maxError = getMaxError (reinterpret_cast<const FFT::Complex*> (data.getData()), expected, size / 2 + 1);
+        expect (maxError < getTolerance (size, getMaxMagnitude (expected, size)),
+                "Forward error was " + String (maxError) + " for size " + String (size));
+
+        inverse.performRealOnlyInverseTransform (data);
+        maxError = 0;
+
+        for (int i = 0; i < size; ++i)
+            maxError = jmax (maxError, std::abs (data[i] - original[i]));
+
+        expect (maxError < getTolerance (size, 1.0f), "Round-trip error was " + String (maxError) + " for size " + String (size));
+    }
+
+    // Runs the power-of-two transforms with a particular stage function, rather than the
+    // one that the FFT would choose for this machine.
+    void testStageFunction (const FFT::StageFunction function, const int firstHalf, Random& r)
+    {
+        for (int order = 0; order <= 10; ++order)
+        {
+            for (int i = 0; i < 2; ++i)
+            {
+                FFT fft (order, i != 0);
+                fft.vectorisedStages = function;
+                fft.firstVectorisedStage = firstHalf;
+
+                testComplexTransform (fft, i != 0, r);
+            }
+        }
+    }
+
+    // A straightforward O(n^2) transform, using a table of twiddle factors so that the
+    // benchmark's comparison isn't dominated by calls to sin and cos.
+    static void performNaiveDFT (const FFT::Complex* input, FFT::Complex* output,
+                                 const FFT::Complex* twiddles, const int size) noexcept
+    {
+        for (int k = 0; k < size; ++k)
+        {
+            float re = 0, im = 0;
+
+            for (int n = 0, index = 0; n < size; ++n)
+            {
+                const FFT::Complex& w = twiddles[index];
+                re += input[n].r * w.r - input[n].i * w.i;
+                im += input[n].r * w.i + input[n].i * w.r;
+
+                if ((index += k) >= size)
+                    index -= size;
+            }
+
+            output[k].r = re;
+            output[k].i = im;
+        }
+    }
+
+    // Returns the average time in microseconds of each call to the FFT (or to the naive
+    // DFT if useNaiveDFT is true), over enough runs to get a reasonably steady figure.
+    static double timeTransform (const FFT& fft, const bool useNaiveDFT, Random& r)
+    {
+        const int size = fft.getSize();
+        HeapBlock<FFT::Complex> input ((size_t) size), output ((size_t) size), twiddles ((size_t) size);
+
+        for (int i = 0; i < size; ++i)
+        {
+            input[i].r = r.nextFloat() * 2.0f - 1.0f;
+            input[i].i = r.nextFloat() * 2.0f - 1.0f;
+
+            const double phase = -2.0 * double_Pi * i / size;
+            twiddles[i].r = (float) std::cos (phase);
+            twiddles[i].i = (float) std::sin (phase);
+        }
+
+        const double numOperations = useNaiveDFT ? (double) size * size
+                                                 : size * std::log ((double) size) / std::log (2.0);
+        const int numRuns = jmax (2, (int) (5.0e6 / numOperations));
+        double startTime = 0;
+
+        // (the first run isn't timed, so that the caches are warm)
+        for (int i = -1; i < numRuns; ++i)
+        {
+            if (i == 0)
+                startTime = Time::getMillisecondCounterHiRes();
+
+            if (useNaiveDFT)
+                performNaiveDFT (input, output, twiddles, size);
+            else
+                fft.perform (input, output);
+        }
+
+        return 1000.0 * (Time::getMillisecondCounterHiRes() - startTime) / numRuns;
+    }
+
+    void logSpeedComparison (const int size, Random& r)
+    {
+        const ScopedPointer<FFT> fft (FFT::createForSize (size, false));
+        const double fftTime = timeTransform (*fft, false, r);
+        const double dftTime = timeTransform (*fft, true, r);
+
+        logMessage ("Size " + String (size) + ": FFT " + String (fftTime, 2) + "us, naive DFT "
+                      + String (dftTime, 1) + "us (" + String (dftTime / jmax (1.0e-6, fftTime), 1) + "x faster)");
+    }
+
+    void runTest()
+    {
+        Random r (getRandom());
+
+        beginTest ("Complex transforms");
+
+        for (int order = 0; order <= 10; ++order)
+        {
+            testComplexTransform (FFT (order, false), false, r);
+            testComplexTransform (FFT (order, true), true, r);
+        }
+
+        beginTest ("Real transforms");
+
+        for (int order = 1; order <= 12; ++order)
+        {
+            FFT forward (order, false), inverse (order, true);
+            testRealTransforms (forward, inverse, r);
+        }
+
+        beginTest ("Scalar stages");
+        testStageFunction (FFT::Kernels::stagesScalar, 1, r);
+
+       #if JUCE_USE_SSE_INTRINSICS
+        if (FloatVectorHelpers::isSSE2Available())
+        {
+            beginTest ("SSE stages");
+            testStageFunction (FFT::Kernels::stagesSSE, 2, r);
+        }
+       #endif
+
+       #if JUCE_USE_AVX_INTRINSICS
+        if (FloatVectorHelpers::getAVXSupport() != FloatVectorHelpers::noAVX)
+        {
+            beginTest ("AVX stages");
+            testStageFunction (FFT::Kernels::stagesAVX, 4, r);
+        }
+       #endif
+
+       #if JUCE_USE_ARM_NEON
+        beginTest ("NEON stages");
+        testStageFunction (FFT::Kernels::stagesNEON, 4, r);
+       #endif
+
+        beginTest ("Mixed-radix sizes");
+
+        const int sizes[] = { 3, 5, 6, 7, 9, 10, 12, 15, 20, 27, 30, 49, 60, 97, 100, 120, 125, 210, 360, 480, 1000, 1536 };
+
+        for (int i = 0; i < numElementsInArray (sizes); ++i)
+        {
+            const ScopedPointer<FFT> forward (FFT::createForSize (sizes[i], false));
+            const ScopedPointer<FFT> inverse (FFT::createForSize (sizes[i], true));
+
+            testComplexTransform (*forward, false, r);
+            testComplexTransform (*inverse, true, r);
+
+            if ((sizes[i] & 1) == 0)
+                testRealTransforms (*forward, *inverse, r);
+        }
+
+        beginTest ("Speed compared with a naive DFT");
+        {
+            const int powerOfTwoSizes[] = { 64, 256, 1024, 4096 };
+            const int mixedRadixSizes[] = { 60, 480, 1000, 1536, 3000 };
+
+            for (int i = 0; i < numElementsInArray (powerOfTwoSizes); ++i)
+                logSpeedComparison (powerOfTwoSizes[i], r);
+
+            for (int i = 0; i < numElementsInArray (mixedRadixSizes); ++i)
+                logSpeedComparison (mixedRadixSizes[i], r);
+        }
+    }
+};
+
+static FFTTests fftTests;
+
+#endif
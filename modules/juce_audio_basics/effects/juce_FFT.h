@@ -0,0 +1,130 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+#ifndef JUCE_FFT_H_INCLUDED
+#define JUCE_FFT_H_INCLUDED
+
+
+//==============================================================================
+/**
+    Performs fast Fourier transforms of a fixed size.
+
+    Power-of-two sizes use an iterative radix-2 algorithm whose butterflies are vectorised
+    with SSE, AVX or NEON when the CPU supports them. Other sizes can be created with
+    createForSize(), which uses a mixed-radix algorithm: sizes whose factors are all 2, 3 or 5
+    are the fastest, and large prime factors make it much slower.
+
+    All the tables that the transform needs are calculated in the constructor, so
+    performing a transform never allocates any memory, and can be done on an audio thread.
+    Sizes that aren't a power of two also use an internal scratch buffer though, so an FFT
+    of one of those sizes mustn't be used by more than one thread at a time.
+
+    None of the transforms are scaled in the forward direction, but the real-only inverse
+    transform divides by the size, so that it exactly undoes performRealOnlyForwardTransform().
+
+    @see WindowingFunction, STFTProcessor
+*/
+class JUCE_API  FFT
+{
+public:
+    //==============================================================================
+    /** Initialises an object for performing either a forward or inverse FFT with the given size.
+        The number of points the FFT will operate on will be 2 ^ order.
+    */
+    FFT (int order, bool isInverse);
+
+    /** Creates an object for performing either a forward or inverse FFT of any size.
+
+        The size must be at least 1, and for the real-only transforms it must be even.
+        The caller is responsible for deleting the object that is returned.
+    */
+    static FFT* createForSize (int numPoints, bool isInverse);
+
+    /** Destructor. */
+    ~FFT();
+
+    //==============================================================================
+    /** A complex number, for the purposes of the FFT class. */
+    struct Complex
+    {
+        float r;  /**< Real part. */
+        float i;  /**< Imaginary part. */
+    };
+
+    /** Performs a complex transform.
+        The input and output arrays must contain getSize() elements, and may be the same array.
+    */
+    void perform (const Complex* input, Complex* output) const noexcept;
+
+    /** Performs an in-place forward transform on a block of real data.
+
+        The array must contain getSize() + 2 floats. On entry, the first getSize() should hold
+        the real input data. On return, it will contain (getSize() / 2) + 1 complex values,
+        (as pairs of real and imaginary parts), for the frequencies from 0 up to the Nyquist
+        frequency. The other half of the spectrum isn't included, because for a real input it's
+        just the complex conjugate of this half.
+    */
+    void performRealOnlyForwardTransform (float* inputOutputData) const noexcept;
+
+    /** Performs a reverse operation to data created in performRealOnlyForwardTransform().
+
+        The array must contain getSize() + 2 floats, holding (getSize() / 2) + 1 complex values
+        on entry. On return, the first getSize() floats will contain the real output, scaled
+        so that a forward transform followed by an inverse one gives back the original data.
+    */
+    void performRealOnlyInverseTransform (float* inputOutputData) const noexcept;
+
+    /** Returns the number of data points that this FFT was created to work with. */
+    int getSize() const noexcept            { return size; }
+
+private:
+    //==============================================================================
+    struct Kernels;
+    friend class FFTTests;
+
+    typedef void (*StageFunction) (Complex*, int, int, int, const Complex*);
+
+    enum SizeInPoints { sizeInPoints };
+
+    const int size;
+    const bool inverse, isPowerOfTwoSize;
+    HeapBlock<Complex> twiddles, stageTwiddles, realTwiddles;
+    mutable HeapBlock<Complex> scratch;
+    HeapBlock<int> bitReversedIndexes, factors, halfSizeFactors;
+    StageFunction vectorisedStages;
+    int firstVectorisedStage;
+
+    FFT (int numPoints, bool isInverse, SizeInPoints);
+
+    void initialise();
+    void perform (const Complex* input, Complex* output, int numPoints, int twiddleStride) const noexcept;
+    void performRadix2 (Complex* data, int numPoints) const noexcept;
+    void performMixedRadix (Complex* output, const Complex* input, int inputStride,
+                            int twiddleStride, const int* factors) const noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FFT)
+};
+
+
+#endif   // JUCE_FFT_H_INCLUDED
@@ -164,15 +164,16 @@ IIRCoefficients IIRCoefficients::makePeakFilter (const double sampleRate,
 
 //==============================================================================
 IIRFilter::IIRFilter() noexcept
-    : v1 (0), v2 (0), active (false)
+    : v1 (0), v2 (0), active (false), processingActive (false), resetPending (false)
 {
 }
 
 IIRFilter::IIRFilter (const IIRFilter& other) noexcept
-    : v1 (0), v2 (0), active (other.active)
+    : v1 (0), v2 (0), active (other.active), processingActive (other.active), resetPending (false)
 {
     const SpinLock::ScopedLockType sl (other.processLock);
     coefficients = other.coefficients;
+    processingCoefficients = coefficients;
 }
 
 IIRFilter::~IIRFilter() noexcept
@@ -197,12 +198,19 @@ void IIRFilter::setCoefficients (const IIRCoefficients& newCoefficients) noexcep
 //==============================================================================
 void IIRFilter::reset() noexcept
 {
+    // (the state belongs to the thread that's processing, so it gets cleared there)
     const SpinLock::ScopedLockType sl (processLock);
-    v1 = v2 = 0;
+    resetPending = true;
 }
 
 float IIRFilter::processSingleSampleRaw (const float in) noexcept
 {
+    if (resetPending)
+    {
+        v1 = v2 = 0;
+        resetPending = false;
+    }
+
     float out = coefficients.coefficients[0] * in + v1;
 
     JUCE_SNAP_TO_ZERO (out);
@@ -215,15 +223,31 @@ float IIRFilter::processSingleSampleRaw (const float in) noexcept
 
 void IIRFilter::processSamples (float* const samples, const int numSamples) noexcept
 {
-    const SpinLock::ScopedLockType sl (processLock);
+    {
+        // The audio thread never waits for the lock: if another thread is in the middle
+        // of changing the settings, this block just uses the ones from the last block.
+        const GenericScopedTryLock<SpinLock> sl (processLock);
+
+        if (sl.isLocked())
+        {
+            processingCoefficients = coefficients;
+            processingActive = active;
+
+            if (resetPending)
+            {
+                v1 = v2 = 0;
+                resetPending = false;
+            }
+        }
+    }
 
-    if (active)
+    if (processingActive)
     {
-        const float c0 = coefficients.coefficients[0];
-        const float c1 = coefficients.coefficients[1];
-        const float c2 = coefficients.coefficients[2];
-        const float c3 = coefficients.coefficients[3];
-        const float c4 = coefficients.coefficients[4];
+        const float c0 = processingCoefficients.coefficients[0];
+        const float c1 = processingCoefficients.coefficients[1];
+        const float c2 = processingCoefficients.coefficients[2];
+        const float c3 = processingCoefficients.coefficients[3];
+        const float c4 = processingCoefficients.coefficients[4];
         float lv1 = v1, lv2 = v2;
 
         for (int i = 0; i < numSamples; ++i)
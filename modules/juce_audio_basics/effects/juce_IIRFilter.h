@@ -134,7 +134,12 @@ public:
     /** Clears the filter so that any incoming data passes through unchanged. */
     void makeInactive() noexcept;
 
-    /** Applies a set of coefficients to this filter. */
+    /** Applies a set of coefficients to this filter.
+
+        This can be called from a different thread to the one calling processSamples(),
+        and processSamples() will never be blocked by it. The new coefficients are picked up
+        at the start of the next block that gets processed.
+    */
     void setCoefficients (const IIRCoefficients& newCoefficients) noexcept;
 
     /** Returns the coefficients that this filter is using. */
@@ -146,10 +151,17 @@ public:
         Note that this clears the processing state, but the type of filter and
         its coefficients aren't changed. To put a filter into an inactive state, use
         the makeInactive() method.
+
+        This can be called from any thread: the state is actually cleared by the
+        processing thread, at the start of the next block (or sample) it processes.
     */
     void reset() noexcept;
 
-    /** Performs the filter operation on the given set of samples. */
+    /** Performs the filter operation on the given set of samples.
+
+        This doesn't wait for any locks, so it's safe to call on an audio thread while
+        other threads are changing the filter's settings.
+    */
     void processSamples (float* samples, int numSamples) noexcept;
 
     /** Processes a single sample, without any locking or checking.
@@ -162,9 +174,9 @@ public:
 protected:
     //==============================================================================
     SpinLock processLock;
-    IIRCoefficients coefficients;
+    IIRCoefficients coefficients, processingCoefficients;
     float v1, v2;
-    bool active;
+    bool active, processingActive, resetPending;
 
     IIRFilter& operator= (const IIRFilter&);
     JUCE_LEAK_DETECTOR (IIRFilter)
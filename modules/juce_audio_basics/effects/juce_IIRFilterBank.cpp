@@ -0,0 +1,601 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+struct IIRFilterBank::Section
+{
+    enum { numLanes = 8 };
+
+    // the coefficients are in the same order as in IIRCoefficients, and each
+    // row holds the values for the 8 channels in a group
+    float coeffs[5][numLanes], deltas[5][numLanes], targets[5][numLanes];
+    float state[2][numLanes];
+};
+
+//==============================================================================
+/* Each kernel runs one section over a block of interleaved frames of 8 channels,
+   using a transposed direct form II biquad, exactly like IIRFilter::processSamples().
+*/
+#define JUCE_IIR_BANK_KERNEL_STEP(Vec, load, store, add, sub, mul) \
+    const Vec in (load (f)); \
+    const Vec out (add (mul (c0, in), v1)); \
+    v1 = add (sub (mul (c1, in), mul (c3, out)), v2); \
+    v2 = sub (mul (c2, in), mul (c4, out)); \
+    store (f, out);
+
+#define JUCE_IIR_BANK_KERNEL(functionName, functionAttributes, Vec, laneWidth, load, store, add, sub, mul) \
+    functionAttributes static void functionName (Section& s, float* const frames, const int numFrames, const bool isRamping) noexcept \
+    { \
+        for (int lane = 0; lane < Section::numLanes; lane += laneWidth) \
+        { \
+            Vec c0 (load (s.coeffs[0] + lane)), c1 (load (s.coeffs[1] + lane)), c2 (load (s.coeffs[2] + lane)); \
+            Vec c3 (load (s.coeffs[3] + lane)), c4 (load (s.coeffs[4] + lane)); \
+            Vec v1 (load (s.state[0] + lane)), v2 (load (s.state[1] + lane)); \
+            float* f = frames + lane; \
+\
+            if (isRamping) \
+            { \
+                const Vec d0 (load (s.deltas[0] + lane)), d1 (load (s.deltas[1] + lane)), d2 (load (s.deltas[2] + lane)); \
+                const Vec d3 (load (s.deltas[3] + lane)), d4 (load (s.deltas[4] + lane)); \
+\
+                for (int i = 0; i < numFrames; ++i, f += Section::numLanes) \
+                { \
+                    JUCE_IIR_BANK_KERNEL_STEP (Vec, load, store, add, sub, mul) \
+                    c0 = add (c0, d0);  c1 = add (c1, d1);  c2 = add (c2, d2); \
+                    c3 = add (c3, d3);  c4 = add (c4, d4); \
+                } \
+\
+                store (s.coeffs[0] + lane, c0);  store (s.coeffs[1] + lane, c1);  store (s.coeffs[2] + lane, c2); \
+                store (s.coeffs[3] + lane, c3);  store (s.coeffs[4] + lane, c4); \
+            } \
+            else \
+            { \
+                for (int i = 0; i < numFrames; ++i, f += Section::numLanes) \
+                { \
+                    JUCE_IIR_BANK_KERNEL_STEP (Vec, load, store, add, sub, mul) \
+                } \
+            } \
+\
+            store (s.state[0] + lane, v1); \
+            store (s.state[1] + lane, v2); \
+        } \
+    }
+
+#define JUCE_IIR_BANK_SCALAR_LOAD(p)         (*(p))
+#define JUCE_IIR_BANK_SCALAR_STORE(p, v)     (*(p) = (v))
+#define JUCE_IIR_BANK_SCALAR_ADD(a, b)       ((a) + (b))
+#define JUCE_IIR_BANK_SCALAR_SUB(a, b)       ((a) - (b))
+#define JUCE_IIR_BANK_SCALAR_MUL(a, b)       ((a) * (b))
+
+struct IIRFilterBank::Kernels
+{
+    JUCE_IIR_BANK_KERNEL (processScalar, , float, 1,
+                          JUCE_IIR_BANK_SCALAR_LOAD, JUCE_IIR_BANK_SCALAR_STORE,
+                          JUCE_IIR_BANK_SCALAR_ADD, JUCE_IIR_BANK_SCALAR_SUB, JUCE_IIR_BANK_SCALAR_MUL)
+
+   #if JUCE_USE_SSE_INTRINSICS
+    JUCE_IIR_BANK_KERNEL (processSSE, , __m128, 4,
+                          _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, _mm_sub_ps, _mm_mul_ps)
+   #endif
+
+   #if JUCE_USE_AVX_INTRINSICS
+    JUCE_IIR_BANK_KERNEL (processAVX, JUCE_AVX_TARGET, __m256, 8,
+                          _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps, _mm256_sub_ps, _mm256_mul_ps)
+   #endif
+
+   #if JUCE_USE_ARM_NEON
+    JUCE_IIR_BANK_KERNEL (processNEON, , float32x4_t, 4,
+                          vld1q_f32, vst1q_f32, vaddq_f32, vsubq_f32, vmulq_f32)
+   #endif
+
+    static KernelFunction getBestKernel() noexcept
+    {
+       #if JUCE_USE_AVX_INTRINSICS
+        if (FloatVectorHelpers::getAVXSupport() != FloatVectorHelpers::noAVX)
+            return processAVX;
+       #endif
+
+       #if JUCE_USE_SSE_INTRINSICS
+        if (FloatVectorHelpers::isSSE2Available())
+            return processSSE;
+       #endif
+
+       #if JUCE_USE_ARM_NEON
+        return processNEON;
+       #else
+        return processScalar;
+       #endif
+    }
+
+    static void interleave (const float* const* channels, const int numChannels, const int startSample,
+                            float* const frames, const int numFrames) noexcept
+    {
+        for (int lane = 0; lane < Section::numLanes; ++lane)
+        {
+            float* dest = frames + lane;
+
+            if (lane < numChannels)
+            {
+                const float* const src = channels[lane] + startSample;
+
+                for (int i = 0; i < numFrames; ++i, dest += Section::numLanes)
+                    *dest = src[i];
+            }
+            else
+            {
+                for (int i = 0; i < numFrames; ++i, dest += Section::numLanes)
+                    *dest = 0;
+            }
+        }
+    }
+
+    static void deinterleave (float* const* channels, const int numChannels, const int startSample,
+                              const float* const frames, const int numFrames) noexcept
+    {
+        for (int lane = 0; lane < numChannels; ++lane)
+        {
+            const float* src = frames + lane;
+            float* const dest = channels[lane] + startSample;
+
+            for (int i = 0; i < numFrames; ++i, src += Section::numLanes)
+                dest[i] = *src;
+        }
+    }
+};
+
+#undef JUCE_IIR_BANK_KERNEL
+#undef JUCE_IIR_BANK_KERNEL_STEP
+#undef JUCE_IIR_BANK_SCALAR_LOAD
+#undef JUCE_IIR_BANK_SCALAR_STORE
+#undef JUCE_IIR_BANK_SCALAR_ADD
+#undef JUCE_IIR_BANK_SCALAR_SUB
+#undef JUCE_IIR_BANK_SCALAR_MUL
+
+//==============================================================================
+IIRFilterBank::IIRFilterBank (const int numChans, const int numSectionsPerChannel)
+    : numChannels (jmax (0, numChans)),
+      numSections (jmax (1, numSectionsPerChannel)),
+      numGroups ((numChannels + Section::numLanes - 1) / Section::numLanes),
+      sections ((size_t) (numGroups * numSections), true),
+      rampSamplesRemaining ((size_t) numGroups, true),
+      pendingCoefficients ((size_t) (numChannels * numSections * 5), true),
+      pendingChanges ((size_t) (numChannels * numSections), true),
+      channelPointers ((size_t) numChannels),
+      numPendingChanges (0),
+      smoothingLength (0),
+      resetPending (false),
+      kernel (Kernels::getBestKernel())
+{
+    for (int i = 0; i < numGroups * numSections; ++i)
+    {
+        Section& s = sections[i];
+
+        for (int lane = 0; lane < Section::numLanes; ++lane)
+            s.coeffs[0][lane] = s.targets[0][lane] = 1.0f;
+    }
+
+    for (int i = 0; i < numChannels * numSections; ++i)
+        pendingCoefficients [i * 5] = 1.0f;
+}
+
+IIRFilterBank::~IIRFilterBank() {}
+
+//==============================================================================
+void IIRFilterBank::setCoefficients (const int channel, const int section, const IIRCoefficients& newCoefficients) noexcept
+{
+    jassert (isPositiveAndBelow (channel, numChannels) && isPositiveAndBelow (section, numSections));
+
+    if (isPositiveAndBelow (channel, numChannels) && isPositiveAndBelow (section, numSections))
+    {
+        const SpinLock::ScopedLockType sl (lock);
+        const int index = channel * numSections + section;
+
+        memcpy (pendingCoefficients + index * 5, newCoefficients.coefficients, sizeof (newCoefficients.coefficients));
+
+        if (! pendingChanges[index])
+        {
+            pendingChanges[index] = true;
+            ++numPendingChanges;
+        }
+    }
+}
+
+void IIRFilterBank::setCoefficientsForAllChannels (const int section, const IIRCoefficients& newCoefficients) noexcept
+{
+    for (int i = 0; i < numChannels; ++i)
+        setCoefficients (i, section, newCoefficients);
+}
+
+IIRCoefficients IIRFilterBank::getCoefficients (const int channel, const int section) const noexcept
+{
+    IIRCoefficients c;
+
+    if (isPositiveAndBelow (channel, numChannels) && isPositiveAndBelow (section, numSections))
+    {
+        const SpinLock::ScopedLockType sl (lock);
+        memcpy (c.coefficients, pendingCoefficients + (channel * numSections + section) * 5, sizeof (c.coefficients));
+    }
+
+    return c;
+}
+
+void IIRFilterBank::setSmoothingLength (const int numSamples) noexcept
+{
+    const SpinLock::ScopedLockType sl (lock);
+    smoothingLength = jmax (0, numSamples);
+}
+
+void IIRFilterBank::reset() noexcept
+{
+    // (the state belongs to the processing thread, so it gets cleared there)
+    const SpinLock::ScopedLockType sl (lock);
+    resetPending = true;
+}
+
+void IIRFilterBank::clearState() noexcept
+{
+    for (int i = 0; i < numGroups * numSections; ++i)
+    {
+        Section& s = sections[i];
+        zerostruct (s.state);
+        memcpy (s.coeffs, s.targets, sizeof (s.coeffs));
+    }
+
+    zeromem (rampSamplesRemaining, sizeof (int) * (size_t) numGroups);
+}
+
+void IIRFilterBank::applyPendingChanges() noexcept
+{
+    for (int group = 0; group < numGroups; ++group)
+    {
+        bool groupChanged = false;
+
+        for (int lane = 0; lane < Section::numLanes; ++lane)
+        {
+            const int channel = group * Section::numLanes + lane;
+
+            if (channel >= numChannels)
+                break;
+
+            for (int i = 0; i < numSections; ++i)
+            {
+                const int index = channel * numSections + i;
+
+                if (pendingChanges[index])
+                {
+                    pendingChanges[index] = false;
+                    groupChanged = true;
+
+                    Section& s = sections [group * numSections + i];
+
+                    for (int j = 0; j < 5; ++j)
+                        s.targets[j][lane] = pendingCoefficients [index * 5 + j];
+                }
+            }
+        }
+
+        if (groupChanged)
+        {
+            // all the sections in a group ramp together, so any that were already
+            // on their way somewhere get a new slope to reach it at the same time
+            Section* const groupSections = sections + group * numSections;
+
+            for (int i = 0; i < numSections; ++i)
+            {
+                Section& s = groupSections[i];
+
+                if (smoothingLength > 0)
+                {
+                    for (int j = 0; j < 5; ++j)
+                        for (int lane = 0; lane < Section::numLanes; ++lane)
+                            s.deltas[j][lane] = (s.targets[j][lane] - s.coeffs[j][lane]) / (float) smoothingLength;
+                }
+                else
+                {
+                    memcpy (s.coeffs, s.targets, sizeof (s.coeffs));
+                }
+            }
+
+            rampSamplesRemaining[group] = smoothingLength;
+        }
+    }
+
+    numPendingChanges = 0;
+}
+
+//==============================================================================
+void IIRFilterBank::processGroup (const int group, float* const frames, const int numFrames) noexcept
+{
+    Section* const groupSections = sections + group * numSections;
+    int& rampRemaining = rampSamplesRemaining[group];
+    int numDone = 0;
+
+    if (rampRemaining > 0)
+    {
+        numDone = jmin (rampRemaining, numFrames);
+
+        for (int i = 0; i < numSections; ++i)
+            kernel (groupSections[i], frames, numDone, true);
+
+        rampRemaining -= numDone;
+
+        // snap to the exact targets, rather than leaving any rounding errors from the ramp
+        if (rampRemaining == 0)
+            for (int i = 0; i < numSections; ++i)
+                memcpy (groupSections[i].coeffs, groupSections[i].targets, sizeof (groupSections[i].coeffs));
+    }
+
+    if (numDone < numFrames)
+        for (int i = 0; i < numSections; ++i)
+            kernel (groupSections[i], frames + numDone * Section::numLanes, numFrames - numDone, false);
+}
+
+void IIRFilterBank::processSamples (float* const* const channels, int numChans, const int numSamples) noexcept
+{
+    {
+        // The processing never waits for the lock: if another thread happens to be
+        // changing some coefficients, they'll be picked up in the next block instead.
+        const GenericScopedTryLock<SpinLock> sl (lock);
+
+        if (sl.isLocked())
+        {
+            if (resetPending)
+            {
+                clearState();
+                resetPending = false;
+            }
+
+            if (numPendingChanges > 0)
+                applyPendingChanges();
+        }
+    }
+
+    numChans = jmin (numChans, numChannels);
+
+    enum { framesPerBlock = 64 };
+    float frames [framesPerBlock * Section::numLanes];
+
+    for (int group = 0; group * Section::numLanes < numChans; ++group)
+    {
+        const float* const* const groupChannels = channels + group * Section::numLanes;
+        const int numLanes = jmin ((int) Section::numLanes, numChans - group * Section::numLanes);
+
+        for (int pos = 0; pos < numSamples; pos += framesPerBlock)
+        {
+            const int numFrames = jmin ((int) framesPerBlock, numSamples - pos);
+
+            Kernels::interleave (groupChannels, numLanes, pos, frames, numFrames);
+            processGroup (group, frames, numFrames);
+            Kernels::deinterleave (channels + group * Section::numLanes, numLanes, pos, frames, numFrames);
+        }
+
+        // To avoid denormals, flush any state that has decayed to a negligible level.
+        Section* const groupSections = sections + group * numSections;
+
+        for (int i = 0; i < numSections; ++i)
+        {
+            float* const state = groupSections[i].state[0];
+
+            for (int j = 0; j < 2 * Section::numLanes; ++j)
+                if (! (state[j] < -1.0e-8f || state[j] > 1.0e-8f))
+                    state[j] = 0;
+        }
+    }
+}
+
+void IIRFilterBank::processSamples (AudioSampleBuffer& buffer, const int startSample, const int numSamples) noexcept
+{
+    jassert (startSample >= 0 && startSample + numSamples <= buffer.getNumSamples());
+
+    const int numChans = jmin (numChannels, buffer.getNumChannels());
+
+    for (int i = 0; i < numChans; ++i)
+        channelPointers[i] = buffer.getSampleData (i, startSample);
+
+    processSamples (channelPointers, numChans, numSamples);
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class IIRFilterBankTests  : public UnitTest
+{
+public:
+    IIRFilterBankTests() : UnitTest ("IIRFilterBank") {}
+
+    static IIRCoefficients makeRandomCoefficients (Random& r)
+    {
+        const double frequency = 50.0 + r.nextDouble() * 15000.0;
+
+        switch (r.nextInt (4))
+        {
+            case 0:   return IIRCoefficients::makeLowPass (44100.0, frequency);
+            case 1:   return IIRCoefficients::makeHighPass (44100.0, frequency);
+            case 2:   return IIRCoefficients::makeLowShelf (44100.0, frequency, 0.7, 0.1f + r.nextFloat() * 4.0f);
+            default:  return IIRCoefficients::makePeakFilter (44100.0, frequency, 0.3 + r.nextDouble() * 5.0, 0.1f + r.nextFloat() * 4.0f);
+        }
+    }
+
+    static void fillWithNoise (AudioSampleBuffer& buffer, Random& r)
+    {
+        for (int i = 0; i < buffer.getNumChannels(); ++i)
+            for (int j = 0; j < buffer.getNumSamples(); ++j)
+                *buffer.getSampleData (i, j) = r.nextFloat() * 2.0f - 1.0f;
+    }
+
+    void runTest()
+    {
+        beginTest ("Matches a cascade of IIRFilters");
+        {
+            Random r (getRandom());
+            const int numChannels = 13, numSections = 3, numSamples = 3000;
+
+            IIRFilterBank bank (numChannels, numSections);
+            OwnedArray<IIRFilter> filters;
+
+            for (int i = 0; i < numChannels * numSections; ++i)
+            {
+                const IIRCoefficients c (makeRandomCoefficients (r));
+                filters.add (new IIRFilter())->setCoefficients (c);
+                bank.setCoefficients (i / numSections, i % numSections, c);
+            }
+
+            AudioSampleBuffer input (numChannels, numSamples);
+            fillWithNoise (input, r);
+
+            AudioSampleBuffer expected (input), output (input);
+
+            for (int i = 0; i < numChannels * numSections; ++i)
+                filters.getUnchecked (i)->processSamples (expected.getSampleData (i / numSections), numSamples);
+
+            for (int pos = 0; pos < numSamples;)
+            {
+                const int num = jmin (numSamples - pos, 1 + r.nextInt (300));
+                bank.processSamples (output, pos, num);
+                pos += num;
+            }
+
+            float maxError = 0;
+
+            for (int i = 0; i < numChannels; ++i)
+                for (int j = 0; j < numSamples; ++j)
+                    maxError = jmax (maxError, std::abs (*output.getSampleData (i, j) - *expected.getSampleData (i, j)));
+
+            expect (maxError < 1.0e-4f, "Error was " + String (maxError));
+        }
+
+        beginTest ("Coefficient smoothing");
+        {
+            // a section that's just a gain, ramping from 0 to 1 over 100 samples
+            IIRFilterBank bank (3, 2);
+            bank.setCoefficientsForAllChannels (1, IIRCoefficients (0, 0, 0, 1.0, 0, 0));
+
+            AudioSampleBuffer buffer (3, 300);
+            buffer.clear();
+            bank.processSamples (buffer, 0, 300);
+
+            bank.setSmoothingLength (100);
+            bank.setCoefficientsForAllChannels (1, IIRCoefficients (1.0, 0, 0, 1.0, 0, 0));
+
+            for (int i = 0; i < 3; ++i)
+                FloatVectorOperations::fill (buffer.getSampleData (i), 1.0f, 300);
+
+            bank.processSamples (buffer, 0, 50);
+            bank.processSamples (buffer, 50, 250);
+
+            for (int i = 0; i < 300; ++i)
+                expect (std::abs (*buffer.getSampleData (2, i) - jmin (1.0f, i / 100.0f)) < 1.0e-5f, "Sample " + String (i));
+        }
+
+        beginTest ("Resetting");
+        {
+            IIRFilterBank bank (2, 2);
+            bank.setCoefficientsForAllChannels (0, IIRCoefficients::makeLowPass (44100.0, 500.0));
+
+            AudioSampleBuffer buffer (2, 512);
+            buffer.clear();
+            buffer.getSampleData (0)[0] = buffer.getSampleData (1)[0] = 1.0f;
+            bank.processSamples (buffer, 0, 512);
+
+            bank.reset();
+            buffer.clear();
+            bank.processSamples (buffer, 0, 512);
+
+            expectEquals (buffer.getMagnitude (0, 512), 0.0f);
+        }
+
+        beginTest ("Decaying to silence");
+        {
+            IIRFilterBank bank (1, 1);
+            bank.setCoefficients (0, 0, IIRCoefficients::makePeakFilter (44100.0, 1000.0, 10.0, 4.0f));
+
+            AudioSampleBuffer buffer (1, 512);
+            buffer.clear();
+            buffer.getSampleData (0)[0] = 1.0f;
+
+            for (int i = 0; i < 100; ++i)
+            {
+                bank.processSamples (buffer, 0, 512);
+                buffer.clear();
+            }
+
+            bank.processSamples (buffer, 0, 512);
+            expectEquals (buffer.getMagnitude (0, 512), 0.0f);
+        }
+
+        beginTest ("Speed compared with IIRFilter");
+        {
+            Random r (getRandom());
+            const int numChannels = 128, numSections = 4, blockSize = 512, numBlocks = 200;
+
+            IIRFilterBank bank (numChannels, numSections);
+            OwnedArray<IIRFilter> filters;
+
+            for (int i = 0; i < numChannels * numSections; ++i)
+            {
+                const IIRCoefficients c (makeRandomCoefficients (r));
+                filters.add (new IIRFilter())->setCoefficients (c);
+                bank.setCoefficients (i / numSections, i % numSections, c);
+            }
+
+            AudioSampleBuffer buffer (numChannels, blockSize);
+            fillWithNoise (buffer, r);
+
+            // (the signal is kept going through both sets of filters, so that neither of
+            // them is timed while it's decaying into denormals or silence)
+            double filterTime = 0, bankTime = 0;
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                const double start = Time::getMillisecondCounterHiRes();
+
+                for (int i = 0; i < numChannels * numSections; ++i)
+                    filters.getUnchecked (i)->processSamples (buffer.getSampleData (i / numSections), blockSize);
+
+                const double middle = Time::getMillisecondCounterHiRes();
+                bank.processSamples (buffer, 0, blockSize);
+                const double end = Time::getMillisecondCounterHiRes();
+
+                if (block > 0)
+                {
+                    filterTime += middle - start;
+                    bankTime += end - middle;
+                }
+
+                fillWithNoise (buffer, r);
+            }
+
+            const double blockMs = 1000.0 * blockSize / 44100.0;
+
+            logMessage (String (numChannels) + " channels x " + String (numSections) + " sections, per "
+                          + String (blockSize) + "-sample block: IIRFilters " + String (1000.0 * filterTime / (numBlocks - 1), 1)
+                          + "us, IIRFilterBank " + String (1000.0 * bankTime / (numBlocks - 1), 1) + "us ("
+                          + String (filterTime / jmax (1.0e-9, bankTime), 1) + "x faster, "
+                          + String (100.0 * bankTime / ((numBlocks - 1) * blockMs), 2) + "% of a block at 44.1KHz)");
+        }
+    }
+};
+
+static IIRFilterBankTests iirFilterBankTests;
+
+#endif
@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+#ifndef JUCE_IIRFILTERBANK_H_INCLUDED
+#define JUCE_IIRFILTERBANK_H_INCLUDED
+
+
+//==============================================================================
+/**
+    A set of cascaded biquad filters for a large number of channels, processed
+    several channels at a time using SIMD instructions.
+
+    Each channel has the same number of second-order sections, which are applied one
+    after the other, so for example a 4-section bank can do a 4-band EQ, or an 8th-order
+    low-pass on every channel. Every section of every channel can have its own coefficients,
+    and all sections start off passing their input through unchanged.
+
+    Internally the channels are grouped in blocks of 8, which are processed with AVX
+    where it's available, or as pairs of 4 with SSE or NEON. For many channels this is
+    several times faster than running an IIRFilter on each one.
+
+    Like IIRFilter, the coefficients can be changed from another thread without the
+    processing thread ever having to wait for a lock. The changes can be smoothed by
+    calling setSmoothingLength(), in which case the coefficients are ramped linearly
+    to their new values.
+
+    @see IIRFilter, IIRCoefficients
+*/
+class JUCE_API  IIRFilterBank
+{
+public:
+    //==============================================================================
+    /** Creates a filter bank for a given number of channels and sections per channel. */
+    IIRFilterBank (int numChannels, int numSectionsPerChannel);
+
+    /** Destructor. */
+    ~IIRFilterBank();
+
+    //==============================================================================
+    /** Returns the number of channels that the bank was created for. */
+    int getNumChannels() const noexcept                     { return numChannels; }
+
+    /** Returns the number of sections that are cascaded on each channel. */
+    int getNumSectionsPerChannel() const noexcept           { return numSections; }
+
+    /** Changes the coefficients of one section of one channel.
+        The change will take effect at the start of the next block to be processed.
+    */
+    void setCoefficients (int channel, int section, const IIRCoefficients& newCoefficients) noexcept;
+
+    /** Gives one section of every channel the same coefficients. */
+    void setCoefficientsForAllChannels (int section, const IIRCoefficients& newCoefficients) noexcept;
+
+    /** Returns the coefficients that were last given to a section. */
+    IIRCoefficients getCoefficients (int channel, int section) const noexcept;
+
+    /** Sets the number of samples over which coefficient changes are ramped.
+        A length of 0 (the default) makes any changes happen instantly.
+    */
+    void setSmoothingLength (int numSamples) noexcept;
+
+    //==============================================================================
+    /** Clears the state of all the filters, and completes any coefficient changes
+        that are currently being ramped.
+
+        This can be called from any thread: the processing thread does the actual
+        clearing, at the start of the next block that it processes.
+    */
+    void reset() noexcept;
+
+    /** Filters a set of channels in-place.
+
+        The number of channels may be less than the bank was created for, in which case
+        the rest are left alone, but if any more are supplied they will be ignored.
+    */
+    void processSamples (float* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** Filters a section of an AudioSampleBuffer in-place. */
+    void processSamples (AudioSampleBuffer& buffer, int startSample, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    struct Section;
+    struct Kernels;
+
+    typedef void (*KernelFunction) (Section&, float*, int, bool);
+
+    const int numChannels, numSections, numGroups;
+    HeapBlock<Section> sections;
+    HeapBlock<int> rampSamplesRemaining;
+    HeapBlock<float> pendingCoefficients;
+    HeapBlock<bool> pendingChanges;
+    HeapBlock<float*> channelPointers;
+    int numPendingChanges, smoothingLength;
+    bool resetPending;
+    SpinLock lock;
+    KernelFunction kernel;
+
+    void applyPendingChanges() noexcept;
+    void clearState() noexcept;
+    void processGroup (int group, float* frames, int numFrames) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IIRFilterBank)
+};
+
+
+#endif   // JUCE_IIRFILTERBANK_H_INCLUDED
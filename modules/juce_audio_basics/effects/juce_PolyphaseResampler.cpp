@@ -0,0 +1,609 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+
+namespace PolyphaseResamplerHelpers
+{
+    struct QualitySettings
+    {
+        int numTaps, numPhases;
+        double kaiserBeta;
+    };
+
+    static const QualitySettings qualitySettings[] =
+    {
+        { 16,  64,  6.0 },
+        { 32,  128, 8.0 },
+        { 64,  256, 10.0 },
+        { 160, 512, 12.5 }
+    };
+
+    enum { maxTapScaling = 16 };
+
+    static double besselI0 (const double x) noexcept
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 100; ++k)
+        {
+            const double t = x / (2.0 * k);
+            term *= t * t;
+            sum += term;
+
+            if (term < sum * 1.0e-14)
+                break;
+        }
+
+        return sum;
+    }
+
+    static double sinc (const double x) noexcept
+    {
+        return std::abs (x) < 1.0e-9 ? 1.0 : std::sin (double_Pi * x) / (double_Pi * x);
+    }
+
+    // Each row of the table holds the coefficients for one phase, followed by the
+    // differences between them and the next phase's, so that the result for an
+    // in-between position is dot (c, x) + fraction * dot (d, x).
+    static float dotProductScalar (const float* const x, const float* const c, const float fraction, const int num) noexcept
+    {
+        const float* const d = c + num;
+        float a = 0, b = 0;
+
+        for (int i = 0; i < num; ++i)
+        {
+            a += c[i] * x[i];
+            b += d[i] * x[i];
+        }
+
+        return a + fraction * b;
+    }
+
+   #if JUCE_USE_SSE_INTRINSICS
+    static inline float horizontalSum (__m128 v) noexcept
+    {
+        v = _mm_add_ps (v, _mm_movehl_ps (v, v));
+        v = _mm_add_ss (v, _mm_shuffle_ps (v, v, 1));
+        return _mm_cvtss_f32 (v);
+    }
+
+    static float dotProductSSE (const float* const x, const float* const c, const float fraction, const int num) noexcept
+    {
+        const float* const d = c + num;
+        __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+        __m128 b0 = _mm_setzero_ps(), b1 = _mm_setzero_ps();
+
+        for (int i = 0; i < num; i += 8)
+        {
+            const __m128 x0 = _mm_loadu_ps (x + i);
+            const __m128 x1 = _mm_loadu_ps (x + i + 4);
+
+            a0 = _mm_add_ps (a0, _mm_mul_ps (_mm_loadu_ps (c + i),     x0));
+            a1 = _mm_add_ps (a1, _mm_mul_ps (_mm_loadu_ps (c + i + 4), x1));
+            b0 = _mm_add_ps (b0, _mm_mul_ps (_mm_loadu_ps (d + i),     x0));
+            b1 = _mm_add_ps (b1, _mm_mul_ps (_mm_loadu_ps (d + i + 4), x1));
+        }
+
+        return horizontalSum (_mm_add_ps (a0, a1)) + fraction * horizontalSum (_mm_add_ps (b0, b1));
+    }
+   #endif
+
+   #if JUCE_USE_AVX_INTRINSICS
+    JUCE_FMA_TARGET static float dotProductFMA (const float* const x, const float* const c, const float fraction, const int num) noexcept
+    {
+        const float* const d = c + num;
+        __m256 a = _mm256_setzero_ps(), b = _mm256_setzero_ps();
+
+        for (int i = 0; i < num; i += 8)
+        {
+            const __m256 xs = _mm256_loadu_ps (x + i);
+            a = _mm256_fmadd_ps (_mm256_loadu_ps (c + i), xs, a);
+            b = _mm256_fmadd_ps (_mm256_loadu_ps (d + i), xs, b);
+        }
+
+        const __m256 sum = _mm256_fmadd_ps (b, _mm256_set1_ps (fraction), a);
+        return horizontalSum (_mm_add_ps (_mm256_castps256_ps128 (sum), _mm256_extractf128_ps (sum, 1)));
+    }
+   #endif
+
+   #if JUCE_USE_ARM_NEON
+    static float dotProductNEON (const float* const x, const float* const c, const float fraction, const int num) noexcept
+    {
+        const float* const d = c + num;
+        float32x4_t a = vdupq_n_f32 (0), b = vdupq_n_f32 (0);
+
+        for (int i = 0; i < num; i += 4)
+        {
+            const float32x4_t xs = vld1q_f32 (x + i);
+            a = vmlaq_f32 (a, vld1q_f32 (c + i), xs);
+            b = vmlaq_f32 (b, vld1q_f32 (d + i), xs);
+        }
+
+        const float32x4_t sum = vmlaq_n_f32 (a, b, fraction);
+        const float32x2_t half = vadd_f32 (vget_low_f32 (sum), vget_high_f32 (sum));
+        return vget_lane_f32 (vpadd_f32 (half, half), 0);
+    }
+   #endif
+
+    typedef float (*DotProductFunction) (const float*, const float*, float, int);
+
+    static DotProductFunction getDotProductFunction() noexcept
+    {
+       #if JUCE_USE_AVX_INTRINSICS
+        if (FloatVectorHelpers::getAVXSupport() == FloatVectorHelpers::avxWithFMA)
+            return dotProductFMA;
+       #endif
+
+       #if JUCE_USE_SSE_INTRINSICS
+        if (FloatVectorHelpers::isSSE2Available())
+            return dotProductSSE;
+       #endif
+
+       #if JUCE_USE_ARM_NEON
+        return dotProductNEON;
+       #else
+        return dotProductScalar;
+       #endif
+    }
+}
+
+//==============================================================================
+/*  The filter coefficients for one speed ratio. These are never changed once they've
+    been created, so a table can be built on one thread and then handed to another.
+*/
+struct PolyphaseResampler::Table
+{
+    Table (const Quality quality, const double speedRatio)
+        : nextRetiredTable (nullptr)
+    {
+        using namespace PolyphaseResamplerHelpers;
+
+        const QualitySettings& settings = qualitySettings [quality];
+
+        scale = jmax (1.0, speedRatio);
+        numTaps = getNumTaps (settings, scale);
+        numPhases = settings.numPhases;
+
+        const double attenuation = settings.kaiserBeta / 0.1102 + 8.7;
+        const double transitionWidth = (attenuation - 7.95) / (14.36 * settings.numTaps);
+        const double cutoff = (0.5 - transitionWidth * 0.5) / scale;  // (in cycles per input sample)
+
+        const int halfTaps = numTaps / 2;
+        const double windowScale = 1.0 / besselI0 (settings.kaiserBeta);
+
+        coefficients.malloc ((size_t) (numPhases * numTaps * 2));
+
+        HeapBlock<double> row ((size_t) numTaps), lastRow ((size_t) numTaps);
+
+        for (int phase = numPhases + 1; --phase >= 0;)
+        {
+            const double fraction = phase / (double) numPhases;
+            double total = 0;
+
+            for (int i = 0; i < numTaps; ++i)
+            {
+                const double distance = i - halfTaps + 1 - fraction;
+                const double x = jlimit (-1.0, 1.0, distance / halfTaps);
+
+                row[i] = 2.0 * cutoff * sinc (2.0 * cutoff * distance)
+                            * besselI0 (settings.kaiserBeta * std::sqrt (1.0 - x * x)) * windowScale;
+                total += row[i];
+            }
+
+            for (int i = 0; i < numTaps; ++i)
+                row[i] /= total;
+
+            if (phase < numPhases)
+            {
+                float* const dest = coefficients + phase * numTaps * 2;
+
+                for (int i = 0; i < numTaps; ++i)
+                {
+                    dest[i] = (float) row[i];
+                    dest[i + numTaps] = (float) (lastRow[i] - row[i]);
+                }
+            }
+
+            row.swapWith (lastRow);
+        }
+    }
+
+    // When down-sampling, both the cutoff and the transition band have to shrink by
+    // the ratio, so the filter needs proportionally more taps to keep the same quality.
+    static int getNumTaps (const PolyphaseResamplerHelpers::QualitySettings& settings, const double scale) noexcept
+    {
+        using namespace PolyphaseResamplerHelpers;
+        return (roundToInt (std::ceil (settings.numTaps * jmin (scale, (double) maxTapScaling))) + 7) & ~7;
+    }
+
+    HeapBlock<float> coefficients;
+    int numTaps, numPhases;
+    double scale;
+    Table* nextRetiredTable;
+
+    JUCE_DECLARE_NON_COPYABLE (Table)
+};
+
+//==============================================================================
+PolyphaseResampler::PolyphaseResampler (const Quality q)
+    : quality (q), preparedScale (0), numTaps (0), historyIndex (0), subSamplePos (1.0)
+{
+    jassert (isPositiveAndBelow ((int) quality, numElementsInArray (PolyphaseResamplerHelpers::qualitySettings)));
+
+    // (the history is allocated for the longest filter, so that switching tables never needs to allocate)
+    const int maxNumTaps = Table::getNumTaps (PolyphaseResamplerHelpers::qualitySettings [quality],
+                                              (double) PolyphaseResamplerHelpers::maxTapScaling);
+    history.calloc ((size_t) maxNumTaps * 2);
+    spareHistory.calloc ((size_t) maxNumTaps * 2);
+
+    setTable (new Table (quality, 1.0));
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+    delete nextTable.exchange (nullptr);
+    deleteRetiredTables();
+}
+
+void PolyphaseResampler::reset() noexcept
+{
+    history.clear ((size_t) numTaps * 2);
+    historyIndex = 0;
+    subSamplePos = 1.0;
+}
+
+void PolyphaseResampler::prepareForRatio (const double speedRatio)
+{
+    jassert (speedRatio > 0);
+
+    const double scale = jmax (1.0, speedRatio);
+
+    if (scale != preparedScale)
+    {
+        preparedScale = scale;
+        usesPreparedTables = 1;
+        delete nextTable.exchange (new Table (quality, scale));
+    }
+
+    deleteRetiredTables();
+}
+
+void PolyphaseResampler::setTable (Table* const newTable) noexcept
+{
+    if (newTable->numTaps != numTaps)
+        resizeHistory (newTable->numTaps);
+
+    table = newTable;
+}
+
+void PolyphaseResampler::retireTable (Table* const oldTable) noexcept
+{
+    for (;;)
+    {
+        Table* const head = retiredTables.get();
+        oldTable->nextRetiredTable = head;
+
+        if (retiredTables.compareAndSetBool (oldTable, head))
+            break;
+    }
+}
+
+void PolyphaseResampler::deleteRetiredTables()
+{
+    for (Table* t = retiredTables.exchange (nullptr); t != nullptr;)
+    {
+        Table* const next = t->nextRetiredTable;
+        delete t;
+        t = next;
+    }
+}
+
+void PolyphaseResampler::resizeHistory (const int newNumTaps) noexcept
+{
+    spareHistory.clear ((size_t) newNumTaps * 2);
+
+    // keep the most recent samples, so that the stream continues as smoothly as it can
+    const int numToKeep = jmin (numTaps, newNumTaps);
+    const float* const oldSamples = history + historyIndex + (numTaps - numToKeep);
+
+    for (int i = 0; i < numToKeep; ++i)
+        spareHistory [newNumTaps - numToKeep + i] = spareHistory [2 * newNumTaps - numToKeep + i] = oldSamples[i];
+
+    history.swapWith (spareHistory);
+    historyIndex = 0;
+    numTaps = newNumTaps;
+}
+
+int PolyphaseResampler::process (const double speedRatio, const float* in,
+                                 float* out, const int numOut)
+{
+    jassert (speedRatio > 0);
+
+    if (Table* const newTable = nextTable.exchange (nullptr))
+    {
+        // the old table can't be deleted on this thread, so it's left for
+        // prepareForRatio() or the destructor to clean up
+        retireTable (table.release());
+        setTable (newTable);
+    }
+    else if (usesPreparedTables.get() == 0 && jmax (1.0, speedRatio) != table->scale)
+    {
+        setTable (new Table (quality, speedRatio));
+    }
+
+    const PolyphaseResamplerHelpers::DotProductFunction dotProduct = PolyphaseResamplerHelpers::getDotProductFunction();
+    const float* const originalIn = in;
+    const float* const coefficients = table->coefficients;
+    const int numPhases = table->numPhases;
+    const int rowSize = numTaps * 2;
+    double pos = subSamplePos;
+
+    for (int i = numOut; --i >= 0;)
+    {
+        while (pos >= 1.0)
+        {
+            // each sample is written twice, so the last numTaps of them are always contiguous
+            history [historyIndex] = history [historyIndex + numTaps] = *in++;
+
+            if (++historyIndex >= numTaps)
+                historyIndex = 0;
+
+            pos -= 1.0;
+        }
+
+        const double phasePos = pos * numPhases;
+        const int phase = (int) phasePos;
+
+        *out++ = dotProduct (history + historyIndex, coefficients + phase * rowSize,
+                             (float) (phasePos - phase), numTaps);
+        pos += speedRatio;
+    }
+
+    subSamplePos = pos;
+    return (int) (in - originalIn);
+}
+
+int PolyphaseResampler::getNumInputSamplesNeeded (const double speedRatio, const int numOut) const noexcept
+{
+    return numOut > 0 ? (int) (subSamplePos + (numOut - 1) * speedRatio) + 1 : 0;
+}
+
+double PolyphaseResampler::getLatencyInInputSamples() const noexcept
+{
+    return numTaps / 2;
+}
+
+//==============================================================================
+void PolyphaseResampler::resampleBuffer (const AudioSampleBuffer& source, const double sourceSampleRate,
+                                         AudioSampleBuffer& dest, const double destSampleRate,
+                                         const Quality quality)
+{
+    jassert (sourceSampleRate > 0 && destSampleRate > 0);
+
+    const double ratio = sourceSampleRate / destSampleRate;
+    const int numSourceSamples = source.getNumSamples();
+    const int numDestSamples = (int) std::ceil (numSourceSamples / ratio);
+
+    dest.setSize (source.getNumChannels(), numDestSamples, false, false, true);
+
+    PolyphaseResampler resampler (quality);
+    resampler.setTable (new Table (quality, ratio));
+
+    // Output number n is produced from input time (n * ratio + subSamplePos - 1 - latency), so
+    // by discarding the first few outputs and choosing the starting position, the remaining
+    // ones land exactly on the source's sample grid.
+    const double latency = resampler.getLatencyInInputSamples();
+    const int numToDiscard = (int) (latency / ratio);
+    const double startPos = 1.0 + latency - numToDiscard * ratio;
+
+    const int numOutputs = numToDiscard + numDestSamples;
+    resampler.subSamplePos = startPos;
+    const int numInputs = jmax (numSourceSamples, resampler.getNumInputSamplesNeeded (ratio, numOutputs));
+
+    HeapBlock<float> input ((size_t) numInputs, true), output ((size_t) numOutputs);
+
+    for (int chan = 0; chan < source.getNumChannels(); ++chan)
+    {
+        resampler.reset();
+        resampler.subSamplePos = startPos;
+
+        memcpy (input, source.getSampleData (chan), sizeof (float) * (size_t) numSourceSamples);
+        resampler.process (ratio, input, output, numOutputs);
+        memcpy (dest.getSampleData (chan), output + numToDiscard, sizeof (float) * (size_t) numDestSamples);
+    }
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class PolyphaseResamplerTests  : public UnitTest
+{
+public:
+    PolyphaseResamplerTests() : UnitTest ("PolyphaseResampler") {}
+
+    // Returns the level of everything in the resampled sine apart from the sine itself, in dB
+    static double measureTHDPlusNoise (const double frequency, const double sourceRate,
+                                       const double destRate, const PolyphaseResampler::Quality quality)
+    {
+        const int numSamples = 20000;
+        AudioSampleBuffer source (1, numSamples), dest (1, 1);
+
+        for (int i = 0; i < numSamples; ++i)
+            *source.getSampleData (0, i) = (float) (0.5 * std::sin (2.0 * double_Pi * frequency * i / sourceRate));
+
+        PolyphaseResampler::resampleBuffer (source, sourceRate, dest, destRate, quality);
+
+        // ignore the ends, where the filter is ramping up or down
+        const int margin = 1000;
+        double signal = 0, error = 0;
+
+        for (int i = margin; i < dest.getNumSamples() - margin; ++i)
+        {
+            const double expected = 0.5 * std::sin (2.0 * double_Pi * frequency * i / destRate);
+            const double diff = *dest.getSampleData (0, i) - expected;
+            signal += expected * expected;
+            error += diff * diff;
+        }
+
+        return 10.0 * std::log10 (error / signal + 1.0e-30);
+    }
+
+    void expectTHDPlusNoiseBelow (const double maxLevel, const double frequency, const double sourceRate,
+                                  const double destRate, const PolyphaseResampler::Quality quality)
+    {
+        const double level = measureTHDPlusNoise (frequency, sourceRate, destRate, quality);
+
+        expect (level < maxLevel, "THD+N was " + String (level, 1) + "dB for " + String (frequency) + "Hz at "
+                                    + String (sourceRate) + " -> " + String (destRate));
+    }
+
+    void runTest()
+    {
+        beginTest ("Resampled sines");
+
+        const double limits[] = { -60.0, -80.0, -105.0, -120.0 };
+        const double rates[][2] = { { 44100.0, 48000.0 }, { 48000.0, 44100.0 }, { 44100.0, 96000.0 }, { 96000.0, 44100.0 } };
+
+        for (int quality = PolyphaseResampler::fastQuality; quality <= PolyphaseResampler::bestQuality; ++quality)
+        {
+            for (int i = 0; i < numElementsInArray (rates); ++i)
+            {
+                expectTHDPlusNoiseBelow (limits [quality], 1000.0, rates[i][0], rates[i][1], (PolyphaseResampler::Quality) quality);
+                expectTHDPlusNoiseBelow (limits [quality], 8000.0, rates[i][0], rates[i][1], (PolyphaseResampler::Quality) quality);
+            }
+        }
+
+        beginTest ("Anti-aliasing");
+        {
+            // a tone above the destination's Nyquist frequency should be removed
+            const int numSamples = 20000;
+            AudioSampleBuffer source (1, numSamples), dest (1, 1);
+
+            for (int i = 0; i < numSamples; ++i)
+                *source.getSampleData (0, i) = (float) (0.5 * std::sin (2.0 * double_Pi * 30000.0 * i / 96000.0));
+
+            PolyphaseResampler::resampleBuffer (source, 96000.0, dest, 44100.0, PolyphaseResampler::highQuality);
+
+            expect (dest.getMagnitude (0, 1000, dest.getNumSamples() - 2000) < 0.0001f);
+        }
+
+        beginTest ("Streaming in blocks");
+        {
+            Random r (getRandom());
+
+            for (int test = 0; test < 4; ++test)
+            {
+                const double ratio = test == 0 ? 44100.0 / 48000.0 : 0.5 + 2.0 * r.nextDouble();
+                const int numOut = 5000;
+
+                // generate enough of the tone to produce the whole output in one go..
+                ToneGeneratorAudioSource tone;
+                tone.setFrequency (1000.0);
+                tone.prepareToPlay (512, 44100.0);
+
+                PolyphaseResampler reference (PolyphaseResampler::normalQuality);
+                const int numIn = reference.getNumInputSamplesNeeded (ratio, numOut);
+                AudioSampleBuffer input (1, numIn), expected (1, numOut), output (1, numOut);
+                tone.getNextAudioBlock (AudioSourceChannelInfo (&input, 0, numIn));
+
+                expect (reference.process (ratio, input.getSampleData (0), expected.getSampleData (0), numOut) <= numIn);
+
+                // ..and then compare that with a ResamplingAudioSource doing it in random-sized blocks
+                ResamplingAudioSource resampler (new ToneGeneratorAudioSource(), true, 1);
+                resampler.setResamplingRatio (ratio);
+                resampler.setPolyphaseResampling (true, PolyphaseResampler::normalQuality);
+                expect (resampler.isUsingPolyphaseResampling());
+
+                resampler.prepareToPlay (512, 44100.0);
+
+                for (int pos = 0; pos < numOut;)
+                {
+                    const int num = jmin (numOut - pos, 1 + r.nextInt (700));
+                    resampler.getNextAudioBlock (AudioSourceChannelInfo (&output, pos, num));
+                    pos += num;
+                }
+
+                for (int i = 0; i < numOut; ++i)
+                    if (std::abs (*output.getSampleData (0, i) - *expected.getSampleData (0, i)) > 1.0e-6f)
+                        expect (false, "Mismatch at sample " + String (i));
+            }
+        }
+
+        beginTest ("Prepared ratios");
+        {
+            // switching to tables that were prepared in advance should give the same
+            // results as letting process() create them when the ratio changes
+            Random r (getRandom());
+            HeapBlock<float> input (20000), output1 (500), output2 (500);
+
+            for (int i = 0; i < 20000; ++i)
+                input[i] = r.nextFloat() - 0.5f;
+
+            PolyphaseResampler unprepared (PolyphaseResampler::normalQuality), prepared (PolyphaseResampler::normalQuality);
+            const double ratios[] = { 1.0, 1.7, 0.8, 2.5, 2.5, 1.3 };
+            int pos1 = 0, pos2 = 0;
+            bool outputsMatch = true;
+
+            for (int i = 0; i < numElementsInArray (ratios); ++i)
+            {
+                prepared.prepareForRatio (ratios[i]);
+
+                pos1 += unprepared.process (ratios[i], input + pos1, output1, 500);
+                pos2 += prepared.process (ratios[i], input + pos2, output2, 500);
+
+                if (pos1 != pos2 || memcmp (output1, output2, 500 * sizeof (float)) != 0)
+                    outputsMatch = false;
+            }
+
+            expect (outputsMatch);
+            expectEquals (prepared.getLatencyInInputSamples(), unprepared.getLatencyInInputSamples());
+        }
+
+        beginTest ("Changing ratios");
+        {
+            PolyphaseResampler resampler (PolyphaseResampler::highQuality);
+            HeapBlock<float> input (20000, true), output (1000);
+            double total = 0, ratio = 1.0;
+            int totalUsed = 0;
+
+            for (int i = 0; i < 20; ++i)
+            {
+                ratio = i % 3 == 0 ? 0.7 : 1.0 + i * 0.1;
+                const int needed = resampler.getNumInputSamplesNeeded (ratio, 500);
+                const int used = resampler.process (ratio, input, output, 500);
+
+                expect (used <= needed && used >= needed - 2);
+                total += ratio * 500;
+                totalUsed += used;
+            }
+
+            // (the position moves on after each output, but the input is only used before the next one)
+            expect (std::abs (total - ratio - totalUsed) < 1.5);
+        }
+    }
+};
+
+static PolyphaseResamplerTests polyphaseResamplerTests;
+
+#endif
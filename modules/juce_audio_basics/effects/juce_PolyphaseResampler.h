@@ -0,0 +1,169 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+
+#ifndef JUCE_POLYPHASERESAMPLER_H_INCLUDED
+#define JUCE_POLYPHASERESAMPLER_H_INCLUDED
+
+
+//==============================================================================
+/**
+    Resamples a stream of floats using a polyphase windowed-sinc FIR filter.
+
+    This is much more accurate than LagrangeInterpolator or the default mode of
+    ResamplingAudioSource, and is suitable for sample-rate conversion of finished
+    material, at the cost of more CPU and some latency.
+
+    The filter's coefficients are precomputed into a table of phases, and the output
+    is interpolated between the two phases either side of each output sample's position.
+    When down-sampling, the filter's cutoff is lowered to remove anything that would
+    alias, so changing between different down-sampling ratios means recalculating
+    the table. For up-sampling, the same table is used for all ratios.
+
+    By default, process() recalculates the table itself when it's given a new ratio.
+    That involves allocating memory and a fair amount of maths, so if you're calling it
+    on an audio thread with a ratio that can change, call prepareForRatio() on another
+    thread whenever the ratio changes instead, and process() will switch to the new table
+    without allocating.
+
+    Like LagrangeInterpolator, the resampler is stateful, so if there's a break in
+    the continuity of the input stream you should call reset(), and each channel
+    needs its own PolyphaseResampler object.
+
+    To convert a whole buffer in one go, see resampleBuffer().
+
+    @see LagrangeInterpolator, ResamplingAudioSource
+*/
+class JUCE_API  PolyphaseResampler
+{
+public:
+    //==============================================================================
+    /** The quality settings that a PolyphaseResampler can use. */
+    enum Quality
+    {
+        fastQuality = 0,    /**< 16 taps, with a stopband attenuation of about 60dB. */
+        normalQuality,      /**< 32 taps, with a stopband attenuation of about 80dB. */
+        highQuality,        /**< 64 taps, with a stopband attenuation of about 100dB. */
+        bestQuality         /**< 160 taps, with a stopband attenuation of about 120dB. */
+    };
+
+    /** Creates a resampler. */
+    explicit PolyphaseResampler (Quality quality = highQuality);
+
+    /** Destructor. */
+    ~PolyphaseResampler();
+
+    //==============================================================================
+    /** Resets the state of the resampler.
+        Call this when there's a break in the continuity of the input data stream.
+    */
+    void reset() noexcept;
+
+    /** Resamples a stream of samples.
+
+        Unless prepareForRatio() has been called, this will recalculate the filter table
+        (and allocate memory) if it's given a down-sampling ratio that differs from the
+        last one.
+
+        @param speedRatio       the number of input samples to use for each output sample
+        @param inputSamples     the source data to read from. This must contain at least
+                                getNumInputSamplesNeeded (speedRatio, numOutputSamplesToProduce)
+                                samples.
+        @param outputSamples    the buffer to write the results into
+        @param numOutputSamplesToProduce    the number of output samples that should be created
+
+        @returns the actual number of input samples that were used
+    */
+    int process (double speedRatio,
+                 const float* inputSamples,
+                 float* outputSamples,
+                 int numOutputSamplesToProduce);
+
+    /** Returns the number of input samples that the next call to process() may use
+        to produce the given number of output samples.
+    */
+    int getNumInputSamplesNeeded (double speedRatio, int numOutputSamplesToProduce) const noexcept;
+
+    /** Calculates the filter table for a new speed ratio, ready for process() to use.
+
+        Once this has been called, process() stops creating tables itself: it always uses
+        the table for the ratio that was most recently prepared, switching to it at the start
+        of its next call. It's safe to call this on one thread while another is inside
+        process(), but it mustn't be called by more than one thread at a time.
+
+        Tables that process() has finished with are deleted here, or by the destructor.
+    */
+    void prepareForRatio (double speedRatio);
+
+    /** Returns the delay that the filter introduces, in input samples.
+
+        This depends on the quality and, when down-sampling, on the ratio that was last used.
+    */
+    double getLatencyInInputSamples() const noexcept;
+
+    /** Returns the quality that this resampler was created with. */
+    Quality getQuality() const noexcept                         { return quality; }
+
+    //==============================================================================
+    /** Converts a whole buffer to a different sample rate.
+
+        Unlike process(), this compensates for the filter's latency, so the result is
+        time-aligned with the source, and it includes the tail of the filter's output.
+
+        @param source           the audio to convert
+        @param sourceSampleRate the sample rate of the source audio
+        @param dest             the buffer to put the result in. This will be resized to the
+                                same number of channels as the source, and to the length of the
+                                source at the new rate, rounded up
+        @param destSampleRate   the sample rate to convert to
+        @param quality          the quality of resampling to use
+    */
+    static void resampleBuffer (const AudioSampleBuffer& source, double sourceSampleRate,
+                                AudioSampleBuffer& dest, double destSampleRate,
+                                Quality quality = bestQuality);
+
+private:
+    //==============================================================================
+    struct Table;
+    friend struct ContainerDeletePolicy<Table>;
+
+    const Quality quality;
+    ScopedPointer<Table> table;
+    Atomic<Table*> nextTable, retiredTables;
+    Atomic<int> usesPreparedTables;
+    double preparedScale;
+    HeapBlock<float> history, spareHistory;
+    int numTaps, historyIndex;
+    double subSamplePos;
+
+    void setTable (Table*) noexcept;
+    void retireTable (Table*) noexcept;
+    void deleteRetiredTables();
+    void resizeHistory (int newNumTaps) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PolyphaseResampler)
+};
+
+
+#endif   // JUCE_POLYPHASERESAMPLER_H_INCLUDED
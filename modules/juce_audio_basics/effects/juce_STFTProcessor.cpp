@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+STFTProcessor::STFTProcessor (const int fftOrder, const int overlap, const int numChans,
+                              const WindowingFunction::WindowingMethod windowType)
+    : forwardFFT (fftOrder, false),
+      inverseFFT (fftOrder, true),
+      fftSize (1 << fftOrder),
+      hopSize (jmax (1, fftSize / jmax (1, overlap))),
+      numChannels (jmax (1, numChans)),
+      analysisWindow ((size_t) fftSize),
+      synthesisWindow ((size_t) fftSize),
+      frame ((size_t) fftSize + 2),
+      inputFrames (numChannels, fftSize),
+      outputFrames (numChannels, fftSize),
+      hopPosition (0)
+{
+    jassert (fftOrder >= 1 && isPowerOfTwo (overlap) && overlap <= fftSize);
+
+    WindowingFunction::fillWindowingTables (analysisWindow, fftSize, windowType, true);
+
+    // The window gets applied twice, so the frames are scaled by the average of the
+    // overlapped squares of it, to make them add back up to the original level.
+    double sum = 0;
+
+    for (int i = 0; i < fftSize; ++i)
+        sum += analysisWindow[i] * (double) analysisWindow[i];
+
+    const double scale = sum > 0 ? hopSize / sum : 1.0;
+
+    for (int i = 0; i < fftSize; ++i)
+        synthesisWindow[i] = (float) (analysisWindow[i] * scale);
+
+    reset();
+}
+
+STFTProcessor::~STFTProcessor() {}
+
+void STFTProcessor::reset() noexcept
+{
+    inputFrames.clear();
+    outputFrames.clear();
+    hopPosition = 0;
+}
+
+//==============================================================================
+void STFTProcessor::processSamples (AudioSampleBuffer& buffer, const int startSample, const int numSamples) noexcept
+{
+    jassert (startSample >= 0 && startSample + numSamples <= buffer.getNumSamples());
+
+    const int numChannelsToProcess = jmin (numChannels, buffer.getNumChannels());
+
+    for (int pos = 0; pos < numSamples;)
+    {
+        const int num = jmin (numSamples - pos, hopSize - hopPosition);
+
+        // the new input goes on the end of the next frame, and the output comes from the
+        // start of the frames that have already been added together
+        for (int i = 0; i < numChannelsToProcess; ++i)
+        {
+            float* const data = buffer.getSampleData (i, startSample + pos);
+
+            FloatVectorOperations::copy (inputFrames.getSampleData (i, fftSize - hopSize + hopPosition), data, num);
+            FloatVectorOperations::copy (data, outputFrames.getSampleData (i, hopPosition), num);
+        }
+
+        pos += num;
+        hopPosition += num;
+
+        if (hopPosition == hopSize)
+        {
+            hopPosition = 0;
+            processHop (numChannelsToProcess);
+        }
+    }
+}
+
+void STFTProcessor::processHop (const int numChannelsToProcess) noexcept
+{
+    const int numToKeep = fftSize - hopSize;
+
+    for (int i = 0; i < numChannelsToProcess; ++i)
+    {
+        float* const input  = inputFrames.getSampleData (i);
+        float* const output = outputFrames.getSampleData (i);
+
+        FloatVectorOperations::copy (frame, input, fftSize);
+        FloatVectorOperations::multiply (frame, analysisWindow, fftSize);
+
+        forwardFFT.performRealOnlyForwardTransform (frame);
+        processFrame (reinterpret_cast<FFT::Complex*> (frame.getData()), getNumBins(), i);
+        inverseFFT.performRealOnlyInverseTransform (frame);
+
+        FloatVectorOperations::multiply (frame, synthesisWindow, fftSize);
+
+        memmove (input,  input  + hopSize, sizeof (float) * (size_t) numToKeep);
+        memmove (output, output + hopSize, sizeof (float) * (size_t) numToKeep);
+        FloatVectorOperations::clear (output + numToKeep, hopSize);
+        FloatVectorOperations::add (output, frame, fftSize);
+    }
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class STFTProcessorTests  : public UnitTest
+{
+public:
+    STFTProcessorTests() : UnitTest ("STFTProcessor") {}
+
+    struct PassThrough  : public STFTProcessor
+    {
+        PassThrough (int overlap) : STFTProcessor (9, overlap, 2) {}
+        void processFrame (FFT::Complex*, int, int) override {}
+    };
+
+    struct LowPass  : public STFTProcessor
+    {
+        LowPass() : STFTProcessor (10, 4, 1) {}
+
+        void processFrame (FFT::Complex* spectrum, int numBins, int) override
+        {
+            for (int i = numBins / 4; i < numBins; ++i)
+                spectrum[i].r = spectrum[i].i = 0;
+        }
+    };
+
+    static double getRMS (const float* data, const int num)
+    {
+        double sum = 0;
+
+        for (int i = 0; i < num; ++i)
+            sum += data[i] * (double) data[i];
+
+        return std::sqrt (sum / num);
+    }
+
+    void runTest()
+    {
+        Random r (getRandom());
+
+        beginTest ("Reconstruction");
+
+        for (int overlap = 4; overlap <= 8; overlap *= 2)
+        {
+            PassThrough processor (overlap);
+            const int latency = processor.getLatencyInSamples();
+            const int totalLength = 8000;
+
+            AudioSampleBuffer original (2, totalLength), processed (2, totalLength);
+
+            for (int chan = 0; chan < 2; ++chan)
+                for (int i = 0; i < totalLength; ++i)
+                    original.getSampleData (chan)[i] = r.nextFloat() * 2.0f - 1.0f;
+
+            processed.copyFrom (0, 0, original, 0, 0, totalLength);
+            processed.copyFrom (1, 0, original, 1, 0, totalLength);
+
+            // (use blocks of awkward sizes to check the buffering)
+            for (int pos = 0; pos < totalLength;)
+            {
+                const int num = jmin (totalLength - pos, 1 + r.nextInt (700));
+                processor.processSamples (processed, pos, num);
+                pos += num;
+            }
+
+            float maxError = 0;
+
+            for (int chan = 0; chan < 2; ++chan)
+                for (int i = latency; i < totalLength; ++i)
+                    maxError = jmax (maxError, std::abs (processed.getSampleData (chan)[i] - original.getSampleData (chan)[i - latency]));
+
+            expect (maxError < 1.0e-4f, "Error was " + String (maxError) + " with an overlap of " + String (overlap));
+        }
+
+        beginTest ("Processing the spectrum");
+
+        {
+            LowPass processor;
+            const int blockSize = 16384;
+
+            for (int bin = 16; bin <= 384; bin += 368)
+            {
+                AudioSampleBuffer buffer (1, blockSize);
+
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.getSampleData (0)[i] = (float) std::sin (2.0 * double_Pi * bin * i / processor.getFFTSize());
+
+                processor.reset();
+                processor.processSamples (buffer, 0, blockSize);
+
+                const double rms = getRMS (buffer.getSampleData (0, 4096), blockSize - 4096);
+
+                if (bin < processor.getNumBins() / 4)
+                    expect (std::abs (rms - std::sqrt (0.5)) < 0.01, "Pass-band level was " + String (rms));
+                else
+                    expect (rms < 0.001, "Stop-band level was " + String (rms));
+            }
+        }
+    }
+};
+
+static STFTProcessorTests stftProcessorTests;
+
+#endif
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+#ifndef JUCE_STFTPROCESSOR_H_INCLUDED
+#define JUCE_STFTPROCESSOR_H_INCLUDED
+
+
+//==============================================================================
+/**
+    A base class for effects which work on the spectrum of a signal, using a
+    short-time Fourier transform.
+
+    The audio is cut into overlapping frames, each of which is windowed and transformed
+    with an FFT, and the spectrum of each frame is passed to your processFrame() method.
+    The modified frames are then transformed back, windowed again, and added together.
+    If processFrame() leaves the spectrum alone, the output is the same as the input,
+    delayed by getLatencyInSamples().
+
+    All the buffers are allocated in the constructor, so processSamples() can be called
+    on an audio thread.
+
+    To use it, create a subclass which implements processFrame(), e.g.
+    @code
+    class SpectralGate  : public STFTProcessor
+    {
+    public:
+        SpectralGate() : STFTProcessor (11, 4, 2) {}
+
+        void processFrame (FFT::Complex* spectrum, int numBins, int) override
+        {
+            for (int i = 0; i < numBins; ++i)
+                if (spectrum[i].r * spectrum[i].r + spectrum[i].i * spectrum[i].i < threshold)
+                    spectrum[i].r = spectrum[i].i = 0;
+        }
+    };
+    @endcode
+
+    @see FFT, WindowingFunction
+*/
+class JUCE_API  STFTProcessor
+{
+public:
+    //==============================================================================
+    /** Creates a processor.
+
+        @param fftOrder         the size of each frame will be 2 ^ fftOrder
+        @param overlap          the number of frames that each sample is part of. This must
+                                be a power of two, and no bigger than the frame size
+        @param numChannels      the number of channels to process
+        @param windowType       the window to apply to the frames, which is used both before
+                                and after processing them. The output is only an exact copy of
+                                the input if the square of the window adds up to a constant when
+                                overlapped, which is the case for a hann window with an overlap
+                                of 4 or more
+    */
+    STFTProcessor (int fftOrder, int overlap, int numChannels,
+                   WindowingFunction::WindowingMethod windowType = WindowingFunction::hann);
+
+    /** Destructor. */
+    virtual ~STFTProcessor();
+
+    //==============================================================================
+    /** Processes a section of an AudioSampleBuffer in-place.
+        Any channels in the buffer above the number that this object was created with
+        are left unchanged.
+    */
+    void processSamples (AudioSampleBuffer& buffer, int startSample, int numSamples) noexcept;
+
+    /** Clears all the stored audio. */
+    void reset() noexcept;
+
+    /** Returns the number of samples by which the output is delayed. */
+    int getLatencyInSamples() const noexcept    { return fftSize; }
+
+    /** Returns the number of samples in each frame. */
+    int getFFTSize() const noexcept             { return fftSize; }
+
+    /** Returns the number of samples between the starts of successive frames. */
+    int getHopSize() const noexcept             { return hopSize; }
+
+    /** Returns the number of frequency bins that are passed to processFrame(). */
+    int getNumBins() const noexcept             { return fftSize / 2 + 1; }
+
+protected:
+    //==============================================================================
+    /** This is called with the spectrum of each frame, which it can modify.
+
+        The spectrum contains getNumBins() values, for frequencies from 0 up to the
+        Nyquist frequency, in the format produced by FFT::performRealOnlyForwardTransform().
+        This is called on the thread that calls processSamples(), so mustn't block.
+    */
+    virtual void processFrame (FFT::Complex* spectrum, int numBins, int channel) = 0;
+
+private:
+    //==============================================================================
+    FFT forwardFFT, inverseFFT;
+    const int fftSize, hopSize, numChannels;
+    HeapBlock<float> analysisWindow, synthesisWindow, frame;
+    AudioSampleBuffer inputFrames, outputFrames;
+    int hopPosition;
+
+    void processHop (int numChannelsToProcess) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (STFTProcessor)
+};
+
+
+#endif   // JUCE_STFTPROCESSOR_H_INCLUDED
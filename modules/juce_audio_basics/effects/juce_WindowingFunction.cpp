@@ -0,0 +1,195 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+WindowingFunction::WindowingFunction (const int numSamples, const WindowingMethod method,
+                                      const bool periodic, const bool normalise, const double beta)
+    : size (numSamples), table ((size_t) jmax (1, numSamples))
+{
+    jassert (numSamples > 0);
+    fillWindowingTables (table, size, method, periodic, normalise, beta);
+}
+
+WindowingFunction::~WindowingFunction() {}
+
+void WindowingFunction::multiplyWithWindowingTable (float* const samples, const int numSamples) const noexcept
+{
+    jassert (numSamples <= size);
+    FloatVectorOperations::multiply (samples, table, jmin (numSamples, size));
+}
+
+//==============================================================================
+namespace WindowingHelpers
+{
+    // the zeroth-order modified Bessel function of the first kind, which is needed by the kaiser window
+    static double besselI0 (const double x) noexcept
+    {
+        const double halfX = x * 0.5;
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 50; ++k)
+        {
+            const double t = halfX / k;
+            term *= t * t;
+            sum += term;
+
+            if (term < sum * 1.0e-12)
+                break;
+        }
+
+        return sum;
+    }
+
+    static double cosineSum (const double position, const double a0, const double a1,
+                             const double a2, const double a3, const double a4) noexcept
+    {
+        const double phase = 2.0 * double_Pi * position;
+
+        return a0 - a1 * std::cos (phase) + a2 * std::cos (2.0 * phase)
+                  - a3 * std::cos (3.0 * phase) + a4 * std::cos (4.0 * phase);
+    }
+}
+
+void WindowingFunction::fillWindowingTables (float* const samples, const int numSamples, const WindowingMethod method,
+                                             const bool periodic, const bool normalise, const double beta) noexcept
+{
+    if (numSamples <= 1)
+    {
+        if (numSamples == 1)
+            samples[0] = 1.0f;
+
+        return;
+    }
+
+    // (a periodic window is the same as a symmetric one with an extra sample on the end)
+    const double length = periodic ? (double) numSamples : (double) (numSamples - 1);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const double position = i / length;
+        double value = 1.0;
+
+        switch (method)
+        {
+            case rectangular:     value = 1.0; break;
+            case triangular:      value = 1.0 - std::abs (2.0 * position - 1.0); break;
+            case hann:            value = WindowingHelpers::cosineSum (position, 0.5, 0.5, 0, 0, 0); break;
+            case hamming:         value = WindowingHelpers::cosineSum (position, 0.54, 0.46, 0, 0, 0); break;
+            case blackman:        value = WindowingHelpers::cosineSum (position, 0.42, 0.5, 0.08, 0, 0); break;
+            case blackmanHarris:  value = WindowingHelpers::cosineSum (position, 0.35875, 0.48829, 0.14128, 0.01168, 0); break;
+            case flatTop:         value = WindowingHelpers::cosineSum (position, 0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368); break;
+
+            case kaiser:
+            {
+                const double x = 2.0 * position - 1.0;
+                value = WindowingHelpers::besselI0 (beta * std::sqrt (jmax (0.0, 1.0 - x * x))) / WindowingHelpers::besselI0 (beta);
+                break;
+            }
+
+            default:              jassertfalse; break;
+        }
+
+        samples[i] = (float) value;
+    }
+
+    if (normalise)
+    {
+        double sum = 0;
+
+        for (int i = 0; i < numSamples; ++i)
+            sum += samples[i];
+
+        if (sum > 0)
+            FloatVectorOperations::multiply (samples, (float) (numSamples / sum), numSamples);
+    }
+}
+
+const char* WindowingFunction::getWindowingMethodName (const WindowingMethod method) noexcept
+{
+    switch (method)
+    {
+        case rectangular:     return "Rectangular";
+        case triangular:      return "Triangular";
+        case hann:            return "Hann";
+        case hamming:         return "Hamming";
+        case blackman:        return "Blackman";
+        case blackmanHarris:  return "Blackman-Harris";
+        case flatTop:         return "Flat Top";
+        case kaiser:          return "Kaiser";
+        default:              jassertfalse; break;
+    }
+
+    return "";
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class WindowingFunctionTests  : public UnitTest
+{
+public:
+    WindowingFunctionTests() : UnitTest ("WindowingFunction") {}
+
+    void runTest()
+    {
+        beginTest ("Symmetric windows");
+
+        for (int method = WindowingFunction::rectangular; method <= WindowingFunction::kaiser; ++method)
+        {
+            const WindowingFunction window (255, (WindowingFunction::WindowingMethod) method, false, false, 6.0);
+            const float* const table = window.getTable();
+
+            for (int i = 0; i < 127; ++i)
+                expect (std::abs (table[i] - table[254 - i]) < 1.0e-6f);
+
+            expect (std::abs (table[127] - 1.0f) < 1.0e-5f,
+                    String (WindowingFunction::getWindowingMethodName ((WindowingFunction::WindowingMethod) method)) + " peak was " + String (table[127]));
+        }
+
+        beginTest ("Periodic hann windows overlap-add to a constant");
+
+        {
+            const int size = 256;
+            const WindowingFunction window (size, WindowingFunction::hann, true);
+
+            for (int i = 0; i < size / 2; ++i)
+                expect (std::abs (window.getTable()[i] + window.getTable()[i + size / 2] - 1.0f) < 1.0e-6f);
+        }
+
+        beginTest ("Normalisation");
+
+        {
+            const WindowingFunction window (100, WindowingFunction::blackman, false, true);
+            double sum = 0;
+
+            for (int i = 0; i < window.getSize(); ++i)
+                sum += window.getTable()[i];
+
+            expect (std::abs (sum - 100.0) < 1.0e-3);
+        }
+    }
+};
+
+static WindowingFunctionTests windowingFunctionTests;
+
+#endif
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+#ifndef JUCE_WINDOWINGFUNCTION_H_INCLUDED
+#define JUCE_WINDOWINGFUNCTION_H_INCLUDED
+
+
+//==============================================================================
+/**
+    A table of windowing function values, for shaping blocks of samples before they're
+    passed to an FFT.
+
+    The table is calculated when the object is created, so multiplyWithWindowingTable()
+    is cheap enough to call on an audio thread. If you just need the values, the static
+    fillWindowingTables() method will write them into an array.
+
+    @see FFT, STFTProcessor
+*/
+class JUCE_API  WindowingFunction
+{
+public:
+    //==============================================================================
+    /** The shapes of window that are available. */
+    enum WindowingMethod
+    {
+        rectangular = 0,
+        triangular,
+        hann,
+        hamming,
+        blackman,
+        blackmanHarris,
+        flatTop,
+        kaiser
+    };
+
+    //==============================================================================
+    /** Creates a table of a window's values.
+
+        @param size         the number of samples in the window
+        @param method       the shape of window to use
+        @param periodic     if false, the window is symmetric, so that its first and last samples
+                            are the same. If true, it's calculated as if it had one more sample,
+                            which is then dropped, so that overlapping copies of it add up exactly
+                            - use this when analysing a signal in overlapping frames
+        @param normalise    if true, the values are scaled so that their average is 1, which means
+                            that windowing a block doesn't change the level of the spectrum
+        @param beta         the shape parameter for a kaiser window. It's ignored by the other types
+    */
+    WindowingFunction (int size, WindowingMethod method, bool periodic = false,
+                       bool normalise = false, double beta = 0);
+
+    /** Destructor. */
+    ~WindowingFunction();
+
+    //==============================================================================
+    /** Multiplies a block of samples by the window.
+        The number of samples must be no more than the size of the table.
+    */
+    void multiplyWithWindowingTable (float* samples, int numSamples) const noexcept;
+
+    /** Returns the table of values. */
+    const float* getTable() const noexcept      { return table; }
+
+    /** Returns the number of values in the table. */
+    int getSize() const noexcept                { return size; }
+
+    //==============================================================================
+    /** Writes the values of a window into an array.
+        See the constructor for a description of the parameters.
+    */
+    static void fillWindowingTables (float* samples, int size, WindowingMethod method,
+                                     bool periodic = false, bool normalise = false, double beta = 0) noexcept;
+
+    /** Returns the name of one of the windowing methods. */
+    static const char* getWindowingMethodName (WindowingMethod method) noexcept;
+
+private:
+    //==============================================================================
+    const int size;
+    HeapBlock<float> table;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WindowingFunction)
+};
+
+
+#endif   // JUCE_WINDOWINGFUNCTION_H_INCLUDED
@@ -48,6 +48,36 @@
  #include <emmintrin.h>
 #endif
 
+/* The AVX code is compiled for the newer instruction sets function-by-function,
+   and is only called if the CPU turns out to support it at runtime, so the rest
+   of the module can still be built for plain SSE2.
+*/
+#ifndef JUCE_USE_AVX_INTRINSICS
+ #if JUCE_MSVC
+  #define JUCE_USE_AVX_INTRINSICS (_MSC_VER >= 1700)
+ #elif JUCE_CLANG
+  #define JUCE_USE_AVX_INTRINSICS (__clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 8))
+ #elif JUCE_GCC
+  #define JUCE_USE_AVX_INTRINSICS (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+ #endif
+#endif
+
+#if ! JUCE_USE_SSE_INTRINSICS
+ #undef JUCE_USE_AVX_INTRINSICS
+#endif
+
+#if JUCE_USE_AVX_INTRINSICS
+ #include <immintrin.h>
+
+ #if JUCE_MSVC
+  #define JUCE_AVX_TARGET
+  #define JUCE_FMA_TARGET
+ #else
+  #define JUCE_AVX_TARGET  __attribute__ ((target ("avx")))
+  #define JUCE_FMA_TARGET  __attribute__ ((target ("avx,fma")))
+ #endif
+#endif
+
 #ifndef JUCE_USE_VDSP_FRAMEWORK
  #define JUCE_USE_VDSP_FRAMEWORK 1
 #endif
@@ -69,8 +99,14 @@ namespace juce
 #include "buffers/juce_AudioDataConverters.cpp"
 #include "buffers/juce_AudioSampleBuffer.cpp"
 #include "buffers/juce_FloatVectorOperations.cpp"
+#include "effects/juce_FFT.cpp"
+#include "effects/juce_ConvolutionEngine.cpp"
 #include "effects/juce_IIRFilter.cpp"
+#include "effects/juce_IIRFilterBank.cpp"
 #include "effects/juce_LagrangeInterpolator.cpp"
+#include "effects/juce_PolyphaseResampler.cpp"
+#include "effects/juce_STFTProcessor.cpp"
+#include "effects/juce_WindowingFunction.cpp"
 #include "midi/juce_MidiBuffer.cpp"
 #include "midi/juce_MidiFile.cpp"
 #include "midi/juce_MidiKeyboardState.cpp"
@@ -78,6 +114,7 @@ namespace juce
 #include "midi/juce_MidiMessageSequence.cpp"
 #include "sources/juce_BufferingAudioSource.cpp"
 #include "sources/juce_ChannelRemappingAudioSource.cpp"
+#include "sources/juce_ConvolutionAudioSource.cpp"
 #include "sources/juce_IIRFilterAudioSource.cpp"
 #include "sources/juce_MixerAudioSource.cpp"
 #include "sources/juce_ResamplingAudioSource.cpp"
@@ -35,9 +35,15 @@ namespace juce
 #include "buffers/juce_AudioSampleBuffer.h"
 #include "buffers/juce_FloatVectorOperations.h"
 #include "effects/juce_Decibels.h"
+#include "effects/juce_FFT.h"
+#include "effects/juce_ConvolutionEngine.h"
 #include "effects/juce_IIRFilter.h"
+#include "effects/juce_IIRFilterBank.h"
 #include "effects/juce_LagrangeInterpolator.h"
+#include "effects/juce_PolyphaseResampler.h"
 #include "effects/juce_Reverb.h"
+#include "effects/juce_WindowingFunction.h"
+#include "effects/juce_STFTProcessor.h"
 #include "midi/juce_MidiMessage.h"
 #include "midi/juce_MidiBuffer.h"
 #include "midi/juce_MidiMessageSequence.h"
@@ -47,6 +53,7 @@ namespace juce
 #include "sources/juce_PositionableAudioSource.h"
 #include "sources/juce_BufferingAudioSource.h"
 #include "sources/juce_ChannelRemappingAudioSource.h"
+#include "sources/juce_ConvolutionAudioSource.h"
 #include "sources/juce_IIRFilterAudioSource.h"
 #include "sources/juce_MixerAudioSource.h"
 #include "sources/juce_ResamplingAudioSource.h"
@@ -75,36 +75,155 @@ namespace MidiBufferHelpers
 
         return d;
     }
+
+    static void writeEvent (uint8* const d, const int sampleNumber, const void* const newData, const int numBytes) noexcept
+    {
+        *reinterpret_cast<int32*> (d) = sampleNumber;
+        *reinterpret_cast<uint16*> (d + 4) = (uint16) numBytes;
+        memcpy (d + 6, newData, (size_t) numBytes);
+    }
+
+    //==============================================================================
+    struct EventPosition
+    {
+        int time, offset;
+    };
+
+    struct EventPositionComparator
+    {
+        // (the offsets break any ties, so that the sort is stable)
+        static int compareElements (const EventPosition& first, const EventPosition& second) noexcept
+        {
+            if (first.time != second.time)
+                return first.time < second.time ? -1 : 1;
+
+            return first.offset - second.offset;
+        }
+    };
+
+    // The smallest event is a 1-byte message plus its header
+    enum { minimumEventSize = sizeof (int32) + sizeof (uint16) + 1 };
+
+    static size_t getSortingSpaceNeeded (const size_t numBytesOfEvents) noexcept
+    {
+        return (numBytesOfEvents / minimumEventSize + 1) * sizeof (EventPosition) + numBytesOfEvents;
+    }
 }
 
 //==============================================================================
-MidiBuffer::MidiBuffer() noexcept {}
+MidiBuffer::MidiBuffer() noexcept  : fixedCapacity (0), numDroppedEvents (0) {}
 MidiBuffer::~MidiBuffer() {}
 
-MidiBuffer::MidiBuffer (const MidiBuffer& other) noexcept  : data (other.data) {}
+MidiBuffer::MidiBuffer (const MidiBuffer& other) noexcept
+    : data (other.data), fixedCapacity (0), numDroppedEvents (0)
+{
+}
 
 MidiBuffer& MidiBuffer::operator= (const MidiBuffer& other) noexcept
 {
-    data = other.data;
+    if (this != &other)
+    {
+        if (fixedCapacity > 0)
+        {
+            clear();
+            addEvents (other, 0, -1, 0);
+        }
+        else
+        {
+            data = other.data;
+        }
+    }
+
     return *this;
 }
 
 MidiBuffer::MidiBuffer (const MidiMessage& message) noexcept
+    : fixedCapacity (0), numDroppedEvents (0)
 {
     addEvent (message, 0);
 }
 
-void MidiBuffer::swapWith (MidiBuffer& other) noexcept      { data.swapWith (other.data); }
-void MidiBuffer::clear() noexcept                           { data.clearQuick(); }
+void MidiBuffer::swapWith (MidiBuffer& other) noexcept
+{
+    data.swapWith (other.data);
+    sortingSpace.swapWith (other.sortingSpace);
+    std::swap (fixedCapacity, other.fixedCapacity);
+    std::swap (numDroppedEvents, other.numDroppedEvents);
+}
+
+void MidiBuffer::clear() noexcept
+{
+    data.clearQuick();
+    numDroppedEvents = 0;
+}
+
 void MidiBuffer::ensureSize (size_t minimumNumBytes)        { data.ensureStorageAllocated ((int) minimumNumBytes); }
 bool MidiBuffer::isEmpty() const noexcept                   { return data.size() == 0; }
 
+void MidiBuffer::setFixedCapacity (const size_t maxNumBytes)
+{
+    fixedCapacity = maxNumBytes;
+
+    if (maxNumBytes > 0)
+    {
+        // if there's already more data than will fit, the last events have to go
+        if ((size_t) data.size() > maxNumBytes)
+        {
+            const uint8* d = data.begin();
+
+            while ((size_t) (d + MidiBufferHelpers::getEventTotalSize (d) - data.begin()) <= maxNumBytes)
+                d += MidiBufferHelpers::getEventTotalSize (d);
+
+            removeRange ((int) (d - data.begin()), data.size());
+        }
+
+        data.ensureStorageAllocated ((int) maxNumBytes);
+        sortingSpace.malloc (MidiBufferHelpers::getSortingSpaceNeeded (maxNumBytes));
+    }
+    else
+    {
+        sortingSpace.free();
+    }
+}
+
 void MidiBuffer::clear (const int startSample, const int numSamples)
 {
     uint8* const start = MidiBufferHelpers::findEventAfter (data.begin(), data.end(), startSample - 1);
     uint8* const end   = MidiBufferHelpers::findEventAfter (start,        data.end(), startSample + numSamples - 1);
 
-    data.removeRange ((int) (start - data.begin()), (int) (end - data.begin()));
+    removeRange ((int) (start - data.begin()), (int) (end - data.begin()));
+}
+
+uint8* MidiBuffer::insertSpace (const int offset, const int numBytes)
+{
+    if (fixedCapacity > 0 && (size_t) (data.size() + numBytes) > fixedCapacity)
+    {
+        ++numDroppedEvents;
+        return nullptr;
+    }
+
+    data.insertMultiple (offset, 0, numBytes);
+    return data.begin() + offset;
+}
+
+void MidiBuffer::removeRange (const int startOffset, const int endOffset)
+{
+    if (fixedCapacity > 0)
+    {
+        // Array::removeRange() may shrink its storage, so this moves the data down and then
+        // resets the size by hand - clearQuick() leaves the storage alone, so re-adding the
+        // data in-place doesn't need to allocate.
+        uint8* const d = data.begin();
+        const int newSize = data.size() - (endOffset - startOffset);
+
+        memmove (d + startOffset, d + endOffset, (size_t) (data.size() - endOffset));
+        data.clearQuick();
+        data.addArray (static_cast<const uint8*> (d), newSize);
+    }
+    else
+    {
+        data.removeRange (startOffset, endOffset - startOffset);
+    }
 }
 
 void MidiBuffer::addEvent (const MidiMessage& m, const int sampleNumber)
@@ -118,18 +237,96 @@ void MidiBuffer::addEvent (const void* const newData, const int maxBytes, const
 
     if (numBytes > 0)
     {
-        const size_t newItemSize = (size_t) numBytes + sizeof (int32) + sizeof (uint16);
+        const int newItemSize = numBytes + (int) (sizeof (int32) + sizeof (uint16));
         const int offset = (int) (MidiBufferHelpers::findEventAfter (data.begin(), data.end(), sampleNumber) - data.begin());
 
-        data.insertMultiple (offset, 0, (int) newItemSize);
+        if (uint8* const d = insertSpace (offset, newItemSize))
+            MidiBufferHelpers::writeEvent (d, sampleNumber, newData, numBytes);
+    }
+}
 
-        uint8* const d = data.begin() + offset;
-        *reinterpret_cast<int32*> (d) = sampleNumber;
-        *reinterpret_cast<uint16*> (d + 4) = (uint16) numBytes;
-        memcpy (d + 6, newData, (size_t) numBytes);
+void MidiBuffer::addEventAtEnd (const MidiMessage& m, const int sampleNumber)
+{
+    addEventAtEnd (m.getRawData(), m.getRawDataSize(), sampleNumber);
+}
+
+void MidiBuffer::addEventAtEnd (const void* const newData, const int maxBytes, const int sampleNumber)
+{
+    const int numBytes = MidiBufferHelpers::findActualEventLength (static_cast<const uint8*> (newData), maxBytes);
+
+    if (numBytes > 0)
+    {
+        const int newItemSize = numBytes + (int) (sizeof (int32) + sizeof (uint16));
+
+        if (uint8* const d = insertSpace (data.size(), newItemSize))
+            MidiBufferHelpers::writeEvent (d, sampleNumber, newData, numBytes);
     }
 }
 
+void MidiBuffer::sortEvents()
+{
+    using namespace MidiBufferHelpers;
+
+    // First, see whether they're already in order, which is usually the case..
+    const uint8* const endData = data.end();
+    int numEvents = 0, lastTime = 0;
+    bool isSorted = true;
+
+    for (const uint8* d = data.begin(); d < endData; d += getEventTotalSize (d))
+    {
+        const int time = getEventTime (d);
+
+        if (numEvents++ > 0 && time < lastTime)
+            isSorted = false;
+
+        lastTime = time;
+    }
+
+    if (isSorted)
+        return;
+
+    // ..if not, make a list of where each one is, sort that, and copy the events back in
+    // their new order.
+    HeapBlock<uint8> tempSpace;
+    uint8* space = sortingSpace;
+
+    if (fixedCapacity == 0)
+    {
+        tempSpace.malloc ((size_t) numEvents * sizeof (EventPosition) + (size_t) data.size());
+        space = tempSpace;
+    }
+
+    EventPosition* const positions = reinterpret_cast<EventPosition*> (space);
+    uint8* const sortedData = space + (size_t) numEvents * sizeof (EventPosition);
+
+    {
+        EventPosition* p = positions;
+
+        for (const uint8* d = data.begin(); d < endData; d += getEventTotalSize (d))
+        {
+            p->time = getEventTime (d);
+            p->offset = (int) (d - data.begin());
+            ++p;
+        }
+    }
+
+    EventPositionComparator comparator;
+    sortArray (comparator, positions, 0, numEvents - 1, false);
+
+    uint8* dest = sortedData;
+
+    for (int i = 0; i < numEvents; ++i)
+    {
+        const uint8* const src = data.begin() + positions[i].offset;
+        const int size = getEventTotalSize (src);
+
+        memcpy (dest, src, (size_t) size);
+        dest += size;
+    }
+
+    memcpy (data.begin(), sortedData, (size_t) data.size());
+}
+
 void MidiBuffer::addEvents (const MidiBuffer& otherBuffer,
                             const int startSample,
                             const int numSamples,
@@ -141,10 +338,18 @@ void MidiBuffer::addEvents (const MidiBuffer& otherBuffer,
     const uint8* eventData;
     int eventSize, position;
 
+    // If all the new events will go after the ones that are already here, which is the
+    // usual case, there's no need to search for the position of each one.
+    const bool canAppend = isEmpty()
+                            || otherBuffer.getFirstEventTime() + sampleDeltaToAdd >= getLastEventTime();
+
     while (i.getNextEvent (eventData, eventSize, position)
             && (position < startSample + numSamples || numSamples < 0))
     {
-        addEvent (eventData, eventSize, position + sampleDeltaToAdd);
+        if (canAppend)
+            addEventAtEnd (eventData, eventSize, position + sampleDeltaToAdd);
+        else
+            addEvent (eventData, eventSize, position + sampleDeltaToAdd);
     }
 }
 
@@ -227,3 +432,71 @@ bool MidiBuffer::Iterator::getNextEvent (MidiMessage& result, int& samplePositio
 
     return true;
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class MidiBufferTests  : public UnitTest
+{
+public:
+    MidiBufferTests() : UnitTest ("MidiBuffer") {}
+
+    void runTest()
+    {
+        beginTest ("Sorting");
+
+        {
+            Random random (getRandom());
+            MidiBuffer sorted, appended;
+
+            for (int i = 0; i < 500; ++i)
+            {
+                const int time = random.nextInt (100);
+                const MidiMessage m (MidiMessage::noteOn (1, i % 128, (uint8) 100));
+
+                sorted.addEvent (m, time);
+                appended.addEventAtEnd (m, time);
+            }
+
+            appended.sortEvents();
+            expect (sorted.data == appended.data);
+        }
+
+        beginTest ("Fixed capacity");
+
+        {
+            MidiBuffer buffer;
+            buffer.setFixedCapacity (90);
+
+            const uint8* const storage = buffer.data.begin();
+
+            for (int i = 0; i < 12; ++i)
+                buffer.addEventAtEnd (MidiMessage::noteOn (1, 60, (uint8) 100), 12 - i);
+
+            expectEquals (buffer.getNumEvents(), 10);
+            expectEquals (buffer.getNumDroppedEvents(), 2);
+
+            buffer.sortEvents();
+            expectEquals (buffer.getFirstEventTime(), 3);
+            expectEquals (buffer.getLastEventTime(), 12);
+
+            buffer.clear (0, 11);
+            expectEquals (buffer.getNumEvents(), 2);
+
+            MidiBuffer other;
+
+            for (int i = 0; i < 20; ++i)
+                other.addEvent (MidiMessage::noteOff (1, 60), i);
+
+            buffer = other;
+            expectEquals (buffer.getNumEvents(), 10);
+            expectEquals (buffer.getNumDroppedEvents(), 10);
+
+            expect (buffer.data.begin() == storage);
+        }
+    }
+};
+
+static MidiBufferTests midiBufferTests;
+
+#endif
@@ -116,6 +116,41 @@ public:
                    int maxBytesOfMidiData,
                    int sampleNumber);
 
+    /** Adds an event to the end of the buffer, without searching for its position.
+
+        This is much quicker than addEvent(), which has to search through the buffer to find
+        where the new event should go, but it's up to the caller to make sure that the sample
+        number isn't less than that of the last event in the buffer.
+
+        If you have a batch of events which aren't in order, you can add them all with this
+        method and then call sortEvents() once afterwards, which is much quicker than calling
+        addEvent() for each of them.
+
+        @see addEvent, sortEvents
+    */
+    void addEventAtEnd (const MidiMessage& midiMessage, int sampleNumber);
+
+    /** Adds an event to the end of the buffer from raw midi data, without searching for its
+        position.
+
+        @see addEventAtEnd, addEvent
+    */
+    void addEventAtEnd (const void* rawMidiData,
+                        int maxBytesOfMidiData,
+                        int sampleNumber);
+
+    /** Sorts the events in the buffer by their sample positions.
+
+        You only need to call this if you've added events with addEventAtEnd() without
+        keeping them in order. Events with the same position will be left in the order in
+        which they were added.
+
+        If the buffer has a fixed capacity, this won't allocate any memory.
+
+        @see addEventAtEnd
+    */
+    void sortEvents();
+
     /** Adds some events from another buffer to this one.
 
         @param otherBuffer          the buffer containing the events you want to add
@@ -159,6 +194,39 @@ public:
     */
     void ensureSize (size_t minimumNumBytes);
 
+    //==============================================================================
+    /** Gives the buffer a fixed capacity, after which it will never allocate any memory.
+
+        This preallocates space for the given number of bytes of event data, plus the space
+        that sortEvents() needs to do its work, so that the buffer can be used safely on
+        the audio thread. Once the buffer is full, any more events that are added will be
+        discarded, and you can find out how many were lost with getNumDroppedEvents().
+
+        Each event takes up 6 bytes plus the length of its midi data, so e.g. a note-on
+        message uses 9 bytes.
+
+        Assigning another buffer to a buffer with a fixed capacity will copy as many of its
+        events as will fit. Copies of a buffer made with the copy constructor don't have a
+        fixed capacity.
+
+        Passing 0 puts the buffer back into its normal mode, where it grows as needed.
+
+        @see getFixedCapacity, getNumDroppedEvents
+    */
+    void setFixedCapacity (size_t maxNumBytes);
+
+    /** Returns the fixed capacity that was set with setFixedCapacity(), or 0 if the buffer
+        doesn't have one.
+    */
+    size_t getFixedCapacity() const noexcept                { return fixedCapacity; }
+
+    /** Returns the number of events that have been discarded since the buffer was last
+        cleared, because there wasn't room for them in a buffer with a fixed capacity.
+
+        @see setFixedCapacity
+    */
+    int getNumDroppedEvents() const noexcept                { return numDroppedEvents; }
+
     //==============================================================================
     /**
         Used to iterate through the events in a MidiBuffer.
@@ -226,6 +294,13 @@ public:
     Array<uint8> data;
 
 private:
+    size_t fixedCapacity;
+    int numDroppedEvents;
+    HeapBlock<uint8> sortingSpace;
+
+    uint8* insertSpace (int offset, int numBytes);
+    void removeRange (int startOffset, int endOffset);
+
     JUCE_LEAK_DETECTOR (MidiBuffer)
 };
 
@@ -0,0 +1,257 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+ConvolutionAudioSource::ConvolutionAudioSource (AudioSource* const inputSource,
+                                                const bool deleteInputWhenDeleted,
+                                                TimeSliceThread* const thread,
+                                                const int numChannels)
+   : input (inputSource, deleteInputWhenDeleted),
+     backgroundThread (thread),
+     numChannelsToProcess (jmax (1, numChannels)),
+     impulseResponse (new AudioSampleBuffer (1, 0)),
+     wetBuffer (2, 0),
+     impulseResponseSampleRate (44100.0),
+     currentSampleRate (0),
+     wetLevel (1.0f),
+     dryLevel (0),
+     isCrossfading (false)
+{
+    jassert (inputSource != nullptr);
+}
+
+ConvolutionAudioSource::~ConvolutionAudioSource() {}
+
+//==============================================================================
+void ConvolutionAudioSource::setImpulseResponse (const AudioSampleBuffer& newResponse,
+                                                 const double sampleRate,
+                                                 const bool normalise)
+{
+    jassert (sampleRate > 0);
+
+    ScopedPointer<AudioSampleBuffer> newImpulseResponse (new AudioSampleBuffer (newResponse));
+
+    if (normalise && newImpulseResponse->getNumSamples() > 0)
+    {
+        double energy = 0;
+
+        for (int i = 0; i < newImpulseResponse->getNumChannels(); ++i)
+        {
+            const float* const data = newImpulseResponse->getSampleData (i);
+
+            for (int j = 0; j < newImpulseResponse->getNumSamples(); ++j)
+                energy += data[j] * (double) data[j];
+        }
+
+        energy /= newImpulseResponse->getNumChannels();
+
+        if (energy > 0)
+            newImpulseResponse->applyGain (0, newImpulseResponse->getNumSamples(), (float) (1.0 / std::sqrt (energy)));
+    }
+
+    double rate;
+
+    {
+        const ScopedLock sl (lock);
+        rate = currentSampleRate;
+    }
+
+    // the engines can take a while to build, so this is done without holding the lock..
+    OwnedArray<ConvolutionEngine> newEngines;
+    createEngines (newEngines, *newImpulseResponse, sampleRate, rate);
+
+    {
+        const ScopedLock sl (lock);
+
+        // ..unless prepareToPlay() has changed the sample rate in the meantime
+        if (rate != currentSampleRate)
+        {
+            newEngines.clear();
+            createEngines (newEngines, *newImpulseResponse, sampleRate, currentSampleRate);
+        }
+
+        impulseResponse.swapWith (newImpulseResponse);
+        impulseResponseSampleRate = sampleRate;
+
+        // The old engines are faded out over the next block, to avoid a click. (Any that were
+        // kept for an earlier change end up in newEngines, to be deleted outside the lock, having
+        // already stopped using the background thread once their crossfade was done).
+        engines.swapWith (newEngines);
+        oldEngines.swapWith (newEngines);
+        isCrossfading = true;
+    }
+}
+
+void ConvolutionAudioSource::setLevels (const float newWetLevel, const float newDryLevel) noexcept
+{
+    const ScopedLock sl (lock);
+    wetLevel = newWetLevel;
+    dryLevel = newDryLevel;
+}
+
+void ConvolutionAudioSource::createEngines (OwnedArray<ConvolutionEngine>& newEngines, const AudioSampleBuffer& response,
+                                            const double responseSampleRate, const double playbackSampleRate)
+{
+    if (response.getNumSamples() == 0 || playbackSampleRate <= 0)
+        return;
+
+    const AudioSampleBuffer* source = &response;
+    AudioSampleBuffer resampled (1, 0);
+
+    if (std::abs (responseSampleRate - playbackSampleRate) > 0.01)
+    {
+        PolyphaseResampler::resampleBuffer (response, responseSampleRate, resampled, playbackSampleRate);
+
+        // (there are more samples per second afterwards, so they need to be scaled
+        // down to keep the same frequency response)
+        resampled.applyGain (0, resampled.getNumSamples(), (float) (responseSampleRate / playbackSampleRate));
+        source = &resampled;
+    }
+
+    for (int i = 0; i < numChannelsToProcess; ++i)
+        newEngines.add (new ConvolutionEngine (source->getSampleData (i % source->getNumChannels()),
+                                               source->getNumSamples(), 64, 4096, backgroundThread));
+}
+
+//==============================================================================
+void ConvolutionAudioSource::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+{
+    input->prepareToPlay (samplesPerBlockExpected, sampleRate);
+
+    const ScopedLock sl (lock);
+
+    wetBuffer.setSize (2, jmax (samplesPerBlockExpected, 256));
+    oldEngines.clear();
+    isCrossfading = false;
+
+    if (sampleRate != currentSampleRate)
+    {
+        currentSampleRate = sampleRate;
+        engines.clear();
+        createEngines (engines, *impulseResponse, impulseResponseSampleRate, sampleRate);
+    }
+    else
+    {
+        for (int i = 0; i < engines.size(); ++i)
+            engines.getUnchecked (i)->reset();
+    }
+}
+
+void ConvolutionAudioSource::releaseResources()
+{
+    input->releaseResources();
+}
+
+void ConvolutionAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
+{
+    const ScopedLock sl (lock);
+
+    input->getNextAudioBlock (bufferToFill);
+
+    if (isCrossfading)
+    {
+        crossfadeEngines (bufferToFill);
+        isCrossfading = false;
+
+        // (they can't be deleted on this thread, but can stop taking up the background thread)
+        for (int i = 0; i < oldEngines.size(); ++i)
+            oldEngines.getUnchecked (i)->stopUsingBackgroundThread();
+
+        return;
+    }
+
+    const int numChannels = jmin (engines.size(), bufferToFill.buffer->getNumChannels());
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        ConvolutionEngine& engine = *engines.getUnchecked (i);
+        float* const data = bufferToFill.buffer->getSampleData (i, bufferToFill.startSample);
+
+        if (dryLevel == 0)
+        {
+            engine.processSamples (data, data, bufferToFill.numSamples);
+
+            if (wetLevel != 1.0f)
+                FloatVectorOperations::multiply (data, wetLevel, bufferToFill.numSamples);
+        }
+        else
+        {
+            float* const wet = wetBuffer.getSampleData (0);
+
+            for (int pos = 0; pos < bufferToFill.numSamples;)
+            {
+                const int num = jmin (bufferToFill.numSamples - pos, wetBuffer.getNumSamples());
+
+                engine.processSamples (data + pos, wet, num);
+                FloatVectorOperations::multiply (data + pos, dryLevel, num);
+                FloatVectorOperations::addWithMultiply (data + pos, wet, wetLevel, num);
+
+                pos += num;
+            }
+        }
+    }
+}
+
+// Mixes the output of the old engines (or the unprocessed input, if there were none) into
+// the output of the new ones, with a linear crossfade across the whole block.
+void ConvolutionAudioSource::crossfadeEngines (const AudioSourceChannelInfo& bufferToFill)
+{
+    const int numChannels = jmin (jmax (engines.size(), oldEngines.size()), bufferToFill.buffer->getNumChannels());
+    const float fadeStep = 1.0f / jmax (1, bufferToFill.numSamples);
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        float* const data = bufferToFill.buffer->getSampleData (i, bufferToFill.startSample);
+
+        for (int pos = 0; pos < bufferToFill.numSamples;)
+        {
+            const int num = jmin (bufferToFill.numSamples - pos, wetBuffer.getNumSamples());
+
+            applyEngine (engines[i], data + pos, wetBuffer.getSampleData (0), num);
+            applyEngine (oldEngines[i], data + pos, wetBuffer.getSampleData (1), num);
+
+            wetBuffer.applyGainRamp (0, 0, num, pos * fadeStep, (pos + num) * fadeStep);
+            wetBuffer.applyGainRamp (1, 0, num, 1.0f - pos * fadeStep, 1.0f - (pos + num) * fadeStep);
+
+            FloatVectorOperations::copy (data + pos, wetBuffer.getSampleData (0), num);
+            FloatVectorOperations::add (data + pos, wetBuffer.getSampleData (1), num);
+
+            pos += num;
+        }
+    }
+}
+
+void ConvolutionAudioSource::applyEngine (ConvolutionEngine* const engine, const float* const input,
+                                          float* const output, const int numSamples) noexcept
+{
+    if (engine == nullptr)
+    {
+        FloatVectorOperations::copy (output, input, numSamples);
+    }
+    else
+    {
+        engine->processSamples (input, output, numSamples);
+        FloatVectorOperations::multiply (output, wetLevel, numSamples);
+        FloatVectorOperations::addWithMultiply (output, input, dryLevel, numSamples);
+    }
+}
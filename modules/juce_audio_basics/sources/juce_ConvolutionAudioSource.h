@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+#ifndef JUCE_CONVOLUTIONAUDIOSOURCE_H_INCLUDED
+#define JUCE_CONVOLUTIONAUDIOSOURCE_H_INCLUDED
+
+
+//==============================================================================
+/**
+    An AudioSource that convolves the output of another source with an impulse
+    response, e.g. to apply a sampled reverb.
+
+    The convolution is done by ConvolutionEngine objects, so it adds no latency. If
+    you give it a TimeSliceThread, the later parts of long impulse responses will be
+    processed on that thread, and many of these sources can share the same one.
+
+    Each channel of the impulse response is applied to the corresponding channel of
+    the audio, and if the impulse response has fewer channels than that, its channels
+    are re-used, so a mono response will be applied to both channels of a stereo source.
+
+    To load an impulse response from a file, you can use AudioFormatManager::readIntoBuffer().
+
+    @see ConvolutionEngine, ReverbAudioSource
+*/
+class JUCE_API  ConvolutionAudioSource   : public AudioSource
+{
+public:
+    /** Creates a ConvolutionAudioSource to process a given input source.
+
+        @param inputSource              the input source to read from - this must not be null
+        @param deleteInputWhenDeleted   if true, the input source will be deleted when
+                                        this object is deleted
+        @param backgroundThread         an optional thread for the convolution engines to use.
+                                        This must outlive the ConvolutionAudioSource
+        @param numChannels              the number of channels to process. Any channels above
+                                        this will be left unchanged
+    */
+    ConvolutionAudioSource (AudioSource* inputSource,
+                            bool deleteInputWhenDeleted,
+                            TimeSliceThread* backgroundThread = nullptr,
+                            int numChannels = 2);
+
+    /** Destructor. */
+    ~ConvolutionAudioSource();
+
+    //==============================================================================
+    /** Sets the impulse response to use.
+
+        The buffer is copied, and if its sample rate is different from the rate that the
+        source is playing at, it'll be resampled to match. This can be called while the
+        source is playing: the new convolution engines are created on the calling thread,
+        and then swapped in, with the output crossfading from the old engines to the new
+        ones over the next block. After that block, the old engines stop using the background
+        thread, and they're deleted by the next call to this method or to prepareToPlay().
+
+        @param impulseResponse      the impulse response. Pass an empty buffer to turn off the effect
+        @param sampleRate           the sample rate of the impulse response
+        @param normalise            if true, the response is scaled so that its total energy is the
+                                    same as that of a single impulse, which stops long responses
+                                    from making things much louder
+    */
+    void setImpulseResponse (const AudioSampleBuffer& impulseResponse,
+                             double sampleRate,
+                             bool normalise);
+
+    /** Sets the levels at which the convolved and original signals are mixed into the output.
+        By default the wet level is 1 and the dry level is 0.
+    */
+    void setLevels (float wetLevel, float dryLevel) noexcept;
+
+    //==============================================================================
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock (const AudioSourceChannelInfo&) override;
+
+private:
+    //==============================================================================
+    CriticalSection lock;
+    OptionalScopedPointer<AudioSource> input;
+    TimeSliceThread* const backgroundThread;
+    const int numChannelsToProcess;
+
+    ScopedPointer<AudioSampleBuffer> impulseResponse;
+    AudioSampleBuffer wetBuffer;
+    double impulseResponseSampleRate, currentSampleRate;
+    OwnedArray<ConvolutionEngine> engines, oldEngines;
+    float wetLevel, dryLevel;
+    bool isCrossfading;
+
+    void createEngines (OwnedArray<ConvolutionEngine>&, const AudioSampleBuffer&, double responseSampleRate, double playbackSampleRate);
+    void crossfadeEngines (const AudioSourceChannelInfo&);
+    void applyEngine (ConvolutionEngine*, const float* input, float* output, int numSamples) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConvolutionAudioSource)
+};
+
+
+#endif   // JUCE_CONVOLUTIONAUDIOSOURCE_H_INCLUDED
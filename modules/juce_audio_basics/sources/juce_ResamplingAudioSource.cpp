@@ -32,7 +32,9 @@ ResamplingAudioSource::ResamplingAudioSource (AudioSource* const inputSource,
       bufferPos (0),
       sampsInBuffer (0),
       subSampleOffset (0),
-      numChannels (numChannels_)
+      numChannels (numChannels_),
+      usePolyphaseResampling (false),
+      polyphaseQuality (PolyphaseResampler::highQuality)
 {
     jassert (input != nullptr);
 
@@ -45,10 +47,26 @@ void ResamplingAudioSource::setResamplingRatio (const double samplesInPerOutputS
 {
     jassert (samplesInPerOutputSample > 0);
 
+    if (samplesInPerOutputSample > 0)
+    {
+        // (the polyphase filter tables are built here, so that the audio thread doesn't have to)
+        const ScopedLock sl (polyphaseLock);
+
+        for (int i = polyphaseResamplers.size(); --i >= 0;)
+            polyphaseResamplers.getUnchecked (i)->prepareForRatio (samplesInPerOutputSample);
+    }
+
     const SpinLock::ScopedLockType sl (ratioLock);
     ratio = jmax (0.0, samplesInPerOutputSample);
 }
 
+void ResamplingAudioSource::setPolyphaseResampling (const bool shouldUsePolyphaseResampling,
+                                                    const PolyphaseResampler::Quality quality)
+{
+    usePolyphaseResampling = shouldUsePolyphaseResampling;
+    polyphaseQuality = quality;
+}
+
 void ResamplingAudioSource::prepareToPlay (int samplesPerBlockExpected,
                                            double sampleRate)
 {
@@ -67,6 +85,21 @@ void ResamplingAudioSource::prepareToPlay (int samplesPerBlockExpected,
     destBuffers.calloc ((size_t) numChannels);
     createLowPass (ratio);
     resetFilters();
+
+    const ScopedLock psl (polyphaseLock);
+    polyphaseResamplers.clear();
+
+    if (usePolyphaseResampling)
+    {
+        for (int i = 0; i < numChannels; ++i)
+        {
+            PolyphaseResampler* const resampler = new PolyphaseResampler (polyphaseQuality);
+            polyphaseResamplers.add (resampler);
+
+            if (ratio > 0)
+                resampler->prepareForRatio (ratio);
+        }
+    }
 }
 
 void ResamplingAudioSource::releaseResources()
@@ -84,6 +117,12 @@ void ResamplingAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& inf
         localRatio = ratio;
     }
 
+    if (polyphaseResamplers.size() > 0)
+    {
+        getNextPolyphaseBlock (info, localRatio);
+        return;
+    }
+
     if (lastRatio != localRatio)
     {
         createLowPass (localRatio);
@@ -190,6 +229,38 @@ void ResamplingAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& inf
     jassert (sampsInBuffer >= 0);
 }
 
+void ResamplingAudioSource::getNextPolyphaseBlock (const AudioSourceChannelInfo& info, const double localRatio)
+{
+    // (in this mode, the buffer just holds the input that hasn't been used yet, starting at index 0)
+    const int sampsNeeded = polyphaseResamplers.getUnchecked (0)->getNumInputSamplesNeeded (localRatio, info.numSamples);
+
+    if (buffer.getNumSamples() < sampsNeeded)
+        buffer.setSize (buffer.getNumChannels(), sampsNeeded + 32, true, true);
+
+    if (sampsInBuffer < sampsNeeded)
+    {
+        AudioSourceChannelInfo readInfo (&buffer, sampsInBuffer, sampsNeeded - sampsInBuffer);
+        input->getNextAudioBlock (readInfo);
+        sampsInBuffer = sampsNeeded;
+    }
+
+    const int channelsToProcess = jmin (numChannels, info.buffer->getNumChannels());
+    int numUsed = 0;
+
+    for (int channel = 0; channel < channelsToProcess; ++channel)
+        numUsed = polyphaseResamplers.getUnchecked (channel)->process (localRatio, buffer.getSampleData (channel),
+                                                                      info.buffer->getSampleData (channel, info.startSample),
+                                                                      info.numSamples);
+
+    jassert (numUsed <= sampsInBuffer);
+    sampsInBuffer -= numUsed;
+
+    if (numUsed > 0)
+        for (int channel = 0; channel < numChannels; ++channel)
+            memmove (buffer.getSampleData (channel), buffer.getSampleData (channel, numUsed),
+                     sizeof (float) * (size_t) sampsInBuffer);
+}
+
 void ResamplingAudioSource::createLowPass (const double frequencyRatio)
 {
     const double proportionalRate = (frequencyRatio > 1.0) ? 0.5 / frequencyRatio
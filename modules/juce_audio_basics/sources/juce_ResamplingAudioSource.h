@@ -54,6 +54,9 @@ public:
 
         (This value can be changed at any time, even while the source is running).
 
+        When polyphase resampling is being used, this calculates new filter tables for
+        the resamplers, so it's best not to call it from the audio thread.
+
         @param samplesInPerOutputSample     if set to 1.0, the input is passed through; higher
                                             values will speed it up; lower values will slow it
                                             down. The ratio must be greater than 0
@@ -66,6 +69,25 @@ public:
     */
     double getResamplingRatio() const noexcept                  { return ratio; }
 
+    /** Makes the source use a PolyphaseResampler for each channel, instead of its
+        default linear interpolation and IIR filter.
+
+        This is far more accurate, but uses more CPU, and delays the output by the
+        resampler's latency. Changing a down-sampling ratio in this mode means that the
+        resamplers' filter tables have to be recalculated. That's done by
+        setResamplingRatio(), rather than on the audio thread, but it takes a while, so
+        this mode is best suited to a ratio that doesn't change very often, such as when
+        converting between sample rates.
+
+        This takes effect the next time prepareToPlay() is called.
+        @see PolyphaseResampler
+    */
+    void setPolyphaseResampling (bool shouldUsePolyphaseResampling,
+                                 PolyphaseResampler::Quality quality = PolyphaseResampler::highQuality);
+
+    /** Returns true if setPolyphaseResampling() has been used to enable polyphase resampling. */
+    bool isUsingPolyphaseResampling() const noexcept            { return usePolyphaseResampling; }
+
     //==============================================================================
     void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
     void releaseResources() override;
@@ -80,8 +102,12 @@ private:
     double subSampleOffset;
     double coefficients[6];
     SpinLock ratioLock;
+    CriticalSection polyphaseLock;
     const int numChannels;
     HeapBlock<float*> destBuffers, srcBuffers;
+    bool usePolyphaseResampling;
+    PolyphaseResampler::Quality polyphaseQuality;
+    OwnedArray<PolyphaseResampler> polyphaseResamplers;
 
     void setFilterCoefficients (double c1, double c2, double c3, double c4, double c5, double c6);
     void createLowPass (double proportionalRate);
@@ -95,6 +121,7 @@ private:
     void resetFilters();
 
     void applyFilter (float* samples, int num, FilterState& fs);
+    void getNextPolyphaseBlock (const AudioSourceChannelInfo&, double localRatio);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResamplingAudioSource)
 };
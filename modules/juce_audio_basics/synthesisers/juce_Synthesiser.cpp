@@ -25,13 +25,31 @@
 SynthesiserSound::SynthesiserSound() {}
 SynthesiserSound::~SynthesiserSound() {}
 
+//==============================================================================
+namespace SynthesiserHelpers
+{
+    // These say which of its synth's lists a voice is in
+    enum
+    {
+        notInList = 0,
+        inFreeList,
+        inPlayingList
+    };
+}
+
 //==============================================================================
 SynthesiserVoice::SynthesiserVoice()
     : currentSampleRate (44100.0),
       currentlyPlayingNote (-1),
       noteOnTime (0),
       keyIsDown (false),
-      sostenutoPedalDown (false)
+      sostenutoPedalDown (false),
+      owner (nullptr),
+      previousInList (nullptr), nextInList (nullptr),
+      previousOnNote (nullptr), nextOnNote (nullptr),
+      listType (SynthesiserHelpers::notInList),
+      noteInList (-1),
+      snapshotGeneration (-1)
 {
 }
 
@@ -52,24 +70,254 @@ void SynthesiserVoice::setCurrentPlaybackSampleRate (const double newRate)
 
 void SynthesiserVoice::clearCurrentNote()
 {
+    // While the voices are being rendered on several threads, the synth's lists can't be
+    // changed, so it moves any voices that have finished once they're all done.
+    const bool isInSynthLists = owner != nullptr && listType != SynthesiserHelpers::notInList
+                                  && ! owner->isRenderingInParallel;
+
+    if (isInSynthLists)
+        owner->removeFromVoiceList (this);
+
     currentlyPlayingNote = -1;
     currentlyPlayingSound = nullptr;
+
+    if (isInSynthLists)
+        owner->addToVoiceList (this); // (this will now put it into the free list)
 }
 
 void SynthesiserVoice::aftertouchChanged (int) {}
 
+//==============================================================================
+/** Owns the worker threads used by a Synthesiser when it's rendering its voices in
+    parallel.
+*/
+class Synthesiser::ParallelRenderer
+{
+public:
+    ParallelRenderer (const int numThreads)
+        : currentNumChannels (0), currentNumSamples (0)
+    {
+        for (int i = 0; i < numThreads; ++i)
+        {
+            WorkerThread* const t = new WorkerThread (*this, i);
+            workers.add (t);
+            t->startThread (10);
+        }
+    }
+
+    ~ParallelRenderer()
+    {
+        for (int i = workers.size(); --i >= 0;)
+        {
+            workers.getUnchecked(i)->signalThreadShouldExit();
+            workers.getUnchecked(i)->notify();
+        }
+
+        for (int i = workers.size(); --i >= 0;)
+            workers.getUnchecked(i)->stopThread (4000);
+    }
+
+    int getNumThreads() const noexcept      { return workers.size(); }
+
+    void perform (Synthesiser& synth, AudioSampleBuffer& outputBuffer,
+                  const int startSample, const int numSamples)
+    {
+        activeVoices.clearQuick();
+
+        for (SynthesiserVoice* voice = synth.firstPlayingVoice; voice != nullptr; voice = voice->nextInList)
+            activeVoices.add (voice);
+
+        currentNumChannels = outputBuffer.getNumChannels();
+        currentNumSamples = numSamples;
+        nextVoiceIndex = 0;
+        synth.isRenderingInParallel = true;
+        blockIsRunning = 1;
+
+        for (int i = workers.size(); --i >= 0;)
+            workers.getUnchecked(i)->notify();
+
+        // The audio thread renders its share of the voices straight into the output..
+        for (;;)
+        {
+            SynthesiserVoice* const voice = getNextVoice();
+
+            if (voice == nullptr)
+                break;
+
+            voice->renderNextBlock (outputBuffer, startSample, numSamples);
+        }
+
+        // ..and before going any further, it needs to be sure that all the workers are done.
+        blockIsRunning = 0;
+
+        while (numWorkersActive.get() != 0)
+        {}
+
+        synth.isRenderingInParallel = false;
+
+        for (int i = workers.size(); --i >= 0;)
+        {
+            WorkerThread& worker = *workers.getUnchecked(i);
+
+            if (worker.hasRenderedVoices)
+            {
+                worker.hasRenderedVoices = false;
+
+                for (int chan = 0; chan < currentNumChannels; ++chan)
+                    FloatVectorOperations::add (outputBuffer.getSampleData (chan, startSample),
+                                                worker.buffer.getSampleData (chan), numSamples);
+            }
+        }
+
+        // Any voices that finished while they were rendering can now go back in the free list.
+        for (int i = 0; i < activeVoices.size(); ++i)
+        {
+            SynthesiserVoice* const voice = activeVoices.getUnchecked (i);
+
+            if (voice->currentlyPlayingNote < 0 && voice->listType == SynthesiserHelpers::inPlayingList)
+            {
+                synth.removeFromVoiceList (voice);
+                synth.addToVoiceList (voice);
+            }
+        }
+    }
+
+private:
+    //==============================================================================
+    class WorkerThread  : public Thread
+    {
+    public:
+        WorkerThread (ParallelRenderer& owner_, const int index)
+            : Thread ("Synth render thread " + String (index + 1)),
+              buffer (1, 1),
+              hasRenderedVoices (false),
+              owner (owner_)
+        {
+        }
+
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                wait (-1);
+                owner.performWorkerTasks (*this);
+            }
+        }
+
+        AudioSampleBuffer buffer;
+        bool hasRenderedVoices;
+
+    private:
+        ParallelRenderer& owner;
+
+        JUCE_DECLARE_NON_COPYABLE (WorkerThread)
+    };
+
+    OwnedArray<WorkerThread> workers;
+    Array<SynthesiserVoice*> activeVoices;
+    Atomic<int> nextVoiceIndex, blockIsRunning, numWorkersActive;
+    int currentNumChannels, currentNumSamples;
+
+    SynthesiserVoice* getNextVoice() noexcept
+    {
+        const int index = (++nextVoiceIndex) - 1;
+        return index < activeVoices.size() ? activeVoices.getUnchecked (index) : nullptr;
+    }
+
+    void performWorkerTasks (WorkerThread& worker)
+    {
+        ++numWorkersActive;
+
+        // If a worker wakes up late, the block that it was woken for may already be
+        // finished, in which case it mustn't touch anything.
+        if (blockIsRunning.get() != 0)
+        {
+            for (;;)
+            {
+                SynthesiserVoice* const voice = getNextVoice();
+
+                if (voice == nullptr)
+                    break;
+
+                if (! worker.hasRenderedVoices)
+                {
+                    worker.hasRenderedVoices = true;
+                    worker.buffer.setSize (currentNumChannels, currentNumSamples, false, false, true);
+                    worker.buffer.clear();
+                }
+
+                voice->renderNextBlock (worker.buffer, 0, currentNumSamples);
+            }
+        }
+
+        --numWorkersActive;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParallelRenderer)
+};
+
+//==============================================================================
+/** An unchanging copy of the synth's voices and sounds, for the audio thread to use.
+
+    Each time the voices or sounds change, a new one of these is published. The audio
+    thread picks up the latest one before handling each block or event, and then tells
+    the other threads which generation it's using, so that they can tell when older
+    snapshots, and any voices that were removed, are no longer needed.
+*/
+class Synthesiser::VoiceSnapshot
+{
+public:
+    VoiceSnapshot (const OwnedArray<SynthesiserVoice>& voices_,
+                   const ReferenceCountedArray<SynthesiserSound>& sounds_,
+                   const int generation_)
+        : sounds (sounds_), renderer (nullptr), generation (generation_)
+    {
+        voices.ensureStorageAllocated (voices_.size());
+
+        for (int i = 0; i < voices_.size(); ++i)
+            voices.add (voices_.getUnchecked (i));
+    }
+
+    Array<SynthesiserVoice*> voices;
+    ReferenceCountedArray<SynthesiserSound> sounds;
+    ParallelRenderer* renderer;
+    const int generation;
+
+    // Any voices or renderer that were removed when this snapshot was made. They get
+    // deleted once the audio thread has moved on to this snapshot or a later one.
+    OwnedArray<SynthesiserVoice> removedVoices;
+    ScopedPointer<ParallelRenderer> removedRenderer;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (VoiceSnapshot)
+};
+
 //==============================================================================
 Synthesiser::Synthesiser()
     : sampleRate (0),
       lastNoteOnCounter (0),
-      shouldStealNotes (true)
+      shouldStealNotes (true),
+      sustainPedalsDown (0),
+      renderingSnapshot (nullptr),
+      firstFreeVoice (nullptr),
+      firstPlayingVoice (nullptr),
+      lastPlayingVoice (nullptr),
+      isRenderingInParallel (false)
 {
     for (int i = 0; i < numElementsInArray (lastPitchWheelValues); ++i)
         lastPitchWheelValues[i] = 0x2000;
+
+    for (int i = 0; i < numElementsInArray (firstVoiceOnNote); ++i)
+        firstVoiceOnNote[i] = nullptr;
+
+    publishSnapshot (nullptr);
+    updateRenderingSnapshot();
 }
 
 Synthesiser::~Synthesiser()
 {
+    // the snapshots must go before the voices, as they may refer to them
+    publishedSnapshots.clear();
 }
 
 //==============================================================================
@@ -82,37 +330,53 @@ SynthesiserVoice* Synthesiser::getVoice (const int index) const
 void Synthesiser::clearVoices()
 {
     const ScopedLock sl (lock);
-    voices.clear();
+
+    OwnedArray<SynthesiserVoice> voicesToDelete;
+    voicesToDelete.swapWith (voices);
+    publishSnapshot (&voicesToDelete);
 }
 
 void Synthesiser::addVoice (SynthesiserVoice* const newVoice)
 {
+    jassert (newVoice != nullptr && newVoice->owner == nullptr);
+
     const ScopedLock sl (lock);
+    newVoice->owner = this;
     voices.add (newVoice);
+    publishSnapshot (nullptr);
 }
 
 void Synthesiser::removeVoice (const int index)
 {
     const ScopedLock sl (lock);
-    voices.remove (index);
+
+    if (isPositiveAndBelow (index, voices.size()))
+    {
+        OwnedArray<SynthesiserVoice> voicesToDelete;
+        voicesToDelete.add (voices.removeAndReturn (index));
+        publishSnapshot (&voicesToDelete);
+    }
 }
 
 void Synthesiser::clearSounds()
 {
     const ScopedLock sl (lock);
     sounds.clear();
+    publishSnapshot (nullptr);
 }
 
 void Synthesiser::addSound (const SynthesiserSound::Ptr& newSound)
 {
     const ScopedLock sl (lock);
     sounds.add (newSound);
+    publishSnapshot (nullptr);
 }
 
 void Synthesiser::removeSound (const int index)
 {
     const ScopedLock sl (lock);
     sounds.remove (index);
+    publishSnapshot (nullptr);
 }
 
 void Synthesiser::setNoteStealingEnabled (const bool shouldSteal)
@@ -120,6 +384,174 @@ void Synthesiser::setNoteStealingEnabled (const bool shouldSteal)
     shouldStealNotes = shouldSteal;
 }
 
+//==============================================================================
+void Synthesiser::publishSnapshot (OwnedArray<SynthesiserVoice>* const voicesToDelete,
+                                   ParallelRenderer* const rendererToDelete)
+{
+    // (must be called with the lock held)
+    const int generation = publishedSnapshots.size() > 0 ? publishedSnapshots.getLast()->generation + 1 : 0;
+
+    VoiceSnapshot* const snapshot = new VoiceSnapshot (voices, sounds, generation);
+
+    snapshot->renderer = parallelRenderer;
+    snapshot->removedRenderer = rendererToDelete;
+
+    if (voicesToDelete != nullptr)
+        snapshot->removedVoices.swapWith (*voicesToDelete);
+
+    publishedSnapshots.add (snapshot);
+    latestSnapshot = snapshot;
+
+    // Now get rid of anything that the audio thread has finished with..
+    const int generationInUse = renderingGeneration.get();
+
+    for (int i = publishedSnapshots.size(); --i >= 0;)
+    {
+        VoiceSnapshot* const s = publishedSnapshots.getUnchecked (i);
+
+        if (s->generation <= generationInUse)
+        {
+            s->removedVoices.clear();
+            s->removedRenderer = nullptr;
+        }
+
+        if (s->generation < generationInUse)
+            publishedSnapshots.remove (i);
+    }
+}
+
+void Synthesiser::updateRenderingSnapshot() noexcept
+{
+    VoiceSnapshot* const latest = latestSnapshot.get();
+
+    if (latest != renderingSnapshot)
+    {
+        // Any voices that aren't marked as belonging to the new snapshot have been removed..
+        for (int i = latest->voices.size(); --i >= 0;)
+            latest->voices.getUnchecked (i)->snapshotGeneration = latest->generation;
+
+        if (renderingSnapshot != nullptr)
+        {
+            for (int i = renderingSnapshot->voices.size(); --i >= 0;)
+            {
+                SynthesiserVoice* const voice = renderingSnapshot->voices.getUnchecked (i);
+
+                if (voice->snapshotGeneration != latest->generation)
+                    removeFromVoiceList (voice);
+            }
+        }
+
+        // ..and any that aren't in a list yet are new.
+        for (int i = 0; i < latest->voices.size(); ++i)
+        {
+            SynthesiserVoice* const voice = latest->voices.getUnchecked (i);
+
+            if (voice->listType == SynthesiserHelpers::notInList)
+                addToVoiceList (voice);
+        }
+
+        renderingSnapshot = latest;
+        renderingGeneration = latest->generation;
+    }
+}
+
+const Array<SynthesiserVoice*>& Synthesiser::getRenderingVoices() const noexcept
+{
+    return renderingSnapshot->voices;
+}
+
+void Synthesiser::addToVoiceList (SynthesiserVoice* const voice) noexcept
+{
+    jassert (voice->listType == SynthesiserHelpers::notInList);
+
+    const int note = voice->currentlyPlayingNote;
+
+    if (note < 0)
+    {
+        // free voices are just pushed onto the front of a list..
+        voice->listType = SynthesiserHelpers::inFreeList;
+        voice->noteInList = -1;
+        voice->previousInList = nullptr;
+        voice->nextInList = firstFreeVoice;
+
+        if (firstFreeVoice != nullptr)
+            firstFreeVoice->previousInList = voice;
+
+        firstFreeVoice = voice;
+    }
+    else
+    {
+        // ..but playing ones go on the end of theirs, so that it's in the order that they started..
+        voice->listType = SynthesiserHelpers::inPlayingList;
+        voice->noteInList = note;
+        voice->previousInList = lastPlayingVoice;
+        voice->nextInList = nullptr;
+
+        if (lastPlayingVoice != nullptr)
+            lastPlayingVoice->nextInList = voice;
+        else
+            firstPlayingVoice = voice;
+
+        lastPlayingVoice = voice;
+
+        // ..and also go into a list of the voices for their note, so that note-offs can find them quickly
+        if (isPositiveAndBelow (note, numElementsInArray (firstVoiceOnNote)))
+        {
+            voice->previousOnNote = nullptr;
+            voice->nextOnNote = firstVoiceOnNote [note];
+
+            if (firstVoiceOnNote [note] != nullptr)
+                firstVoiceOnNote [note]->previousOnNote = voice;
+
+            firstVoiceOnNote [note] = voice;
+        }
+    }
+}
+
+void Synthesiser::removeFromVoiceList (SynthesiserVoice* const voice) noexcept
+{
+    if (voice->listType == SynthesiserHelpers::inFreeList)
+    {
+        if (voice->previousInList != nullptr)
+            voice->previousInList->nextInList = voice->nextInList;
+        else
+            firstFreeVoice = voice->nextInList;
+
+        if (voice->nextInList != nullptr)
+            voice->nextInList->previousInList = voice->previousInList;
+    }
+    else if (voice->listType == SynthesiserHelpers::inPlayingList)
+    {
+        if (voice->previousInList != nullptr)
+            voice->previousInList->nextInList = voice->nextInList;
+        else
+            firstPlayingVoice = voice->nextInList;
+
+        if (voice->nextInList != nullptr)
+            voice->nextInList->previousInList = voice->previousInList;
+        else
+            lastPlayingVoice = voice->previousInList;
+
+        const int note = voice->noteInList;
+
+        if (isPositiveAndBelow (note, numElementsInArray (firstVoiceOnNote)))
+        {
+            if (voice->previousOnNote != nullptr)
+                voice->previousOnNote->nextOnNote = voice->nextOnNote;
+            else
+                firstVoiceOnNote [note] = voice->nextOnNote;
+
+            if (voice->nextOnNote != nullptr)
+                voice->nextOnNote->previousOnNote = voice->previousOnNote;
+        }
+    }
+
+    voice->listType = SynthesiserHelpers::notInList;
+    voice->noteInList = -1;
+    voice->previousInList = voice->nextInList = nullptr;
+    voice->previousOnNote = voice->nextOnNote = nullptr;
+}
+
 //==============================================================================
 void Synthesiser::setCurrentPlaybackSampleRate (const double newRate)
 {
@@ -142,7 +574,7 @@ void Synthesiser::renderNextBlock (AudioSampleBuffer& outputBuffer, const MidiBu
     // must set the sample rate before using this!
     jassert (sampleRate != 0);
 
-    const ScopedLock sl (lock);
+    updateRenderingSnapshot();
 
     MidiBuffer::Iterator midiIterator (midiData);
     midiIterator.setNextSamplePosition (startSample);
@@ -158,10 +590,7 @@ void Synthesiser::renderNextBlock (AudioSampleBuffer& outputBuffer, const MidiBu
                                          : numSamples;
 
         if (numThisTime > 0)
-        {
-            for (int i = voices.size(); --i >= 0;)
-                voices.getUnchecked (i)->renderNextBlock (outputBuffer, startSample, numThisTime);
-        }
+            renderVoices (outputBuffer, startSample, numThisTime);
 
         if (useEvent)
             handleMidiEvent (m);
@@ -203,29 +632,80 @@ void Synthesiser::handleMidiEvent (const MidiMessage& m)
     }
 }
 
+void Synthesiser::renderVoices (AudioSampleBuffer& outputBuffer, const int startSample, const int numSamples)
+{
+    ParallelRenderer* const renderer = renderingSnapshot->renderer;
+
+    if (renderer != nullptr && firstPlayingVoice != nullptr && firstPlayingVoice->nextInList != nullptr)
+    {
+        renderer->perform (*this, outputBuffer, startSample, numSamples);
+    }
+    else
+    {
+        // (a voice may finish and move itself into the free list while it's rendering)
+        for (SynthesiserVoice* voice = firstPlayingVoice; voice != nullptr;)
+        {
+            SynthesiserVoice* const next = voice->nextInList;
+            voice->renderNextBlock (outputBuffer, startSample, numSamples);
+            voice = next;
+        }
+    }
+}
+
+void Synthesiser::setNumRenderingThreads (int numThreads)
+{
+    numThreads = jmax (0, numThreads);
+
+    if (numThreads != getNumRenderingThreads())
+    {
+        ScopedPointer<ParallelRenderer> newRenderer;
+
+        if (numThreads > 0)
+            newRenderer = new ParallelRenderer (numThreads);
+
+        const ScopedLock sl (lock);
+        parallelRenderer.swapWith (newRenderer);
+
+        // the old renderer may still be in use, so it only gets deleted once the audio
+        // thread has picked up the new snapshot
+        publishSnapshot (nullptr, newRenderer.release());
+    }
+}
+
+int Synthesiser::getNumRenderingThreads() const noexcept
+{
+    return parallelRenderer != nullptr ? parallelRenderer->getNumThreads() : 0;
+}
+
 //==============================================================================
 void Synthesiser::noteOn (const int midiChannel,
                           const int midiNoteNumber,
                           const float velocity)
 {
-    const ScopedLock sl (lock);
+    updateRenderingSnapshot();
+
+    const ReferenceCountedArray<SynthesiserSound>& renderingSounds = renderingSnapshot->sounds;
 
-    for (int i = sounds.size(); --i >= 0;)
+    for (int i = renderingSounds.size(); --i >= 0;)
     {
-        SynthesiserSound* const sound = sounds.getUnchecked(i);
+        SynthesiserSound* const sound = renderingSounds.getUnchecked(i);
 
         if (sound->appliesToNote (midiNoteNumber)
              && sound->appliesToChannel (midiChannel))
         {
             // If hitting a note that's still ringing, stop it first (it could be
             // still playing because of the sustain or sostenuto pedal).
-            for (int j = voices.size(); --j >= 0;)
+            if (isPositiveAndBelow (midiNoteNumber, numElementsInArray (firstVoiceOnNote)))
             {
-                SynthesiserVoice* const voice = voices.getUnchecked (j);
+                for (SynthesiserVoice* voice = firstVoiceOnNote [midiNoteNumber]; voice != nullptr;)
+                {
+                    SynthesiserVoice* const next = voice->nextOnNote;
+
+                    if (voice->isPlayingChannel (midiChannel))
+                        stopVoice (voice, true);
 
-                if (voice->getCurrentlyPlayingNote() == midiNoteNumber
-                     && voice->isPlayingChannel (midiChannel))
-                    stopVoice (voice, true);
+                    voice = next;
+                }
             }
 
             startVoice (findFreeVoice (sound, shouldStealNotes),
@@ -245,6 +725,8 @@ void Synthesiser::startVoice (SynthesiserVoice* const voice,
         if (voice->currentlyPlayingSound != nullptr)
             voice->stopNote (false);
 
+        removeFromVoiceList (voice);
+
         voice->startNote (midiNoteNumber, velocity, sound,
                           lastPitchWheelValues [midiChannel - 1]);
 
@@ -253,6 +735,8 @@ void Synthesiser::startVoice (SynthesiserVoice* const voice,
         voice->currentlyPlayingSound = sound;
         voice->keyIsDown = true;
         voice->sostenutoPedalDown = false;
+
+        addToVoiceList (voice);
     }
 }
 
@@ -270,55 +754,55 @@ void Synthesiser::noteOff (const int midiChannel,
                            const int midiNoteNumber,
                            const bool allowTailOff)
 {
-    const ScopedLock sl (lock);
+    updateRenderingSnapshot();
+
+    if (! isPositiveAndBelow (midiNoteNumber, numElementsInArray (firstVoiceOnNote)))
+        return;
 
-    for (int i = voices.size(); --i >= 0;)
+    for (SynthesiserVoice* voice = firstVoiceOnNote [midiNoteNumber]; voice != nullptr;)
     {
-        SynthesiserVoice* const voice = voices.getUnchecked (i);
+        SynthesiserVoice* const next = voice->nextOnNote;
 
-        if (voice->getCurrentlyPlayingNote() == midiNoteNumber)
+        if (SynthesiserSound* const sound = voice->getCurrentlyPlayingSound())
         {
-            if (SynthesiserSound* const sound = voice->getCurrentlyPlayingSound())
+            if (sound->appliesToNote (midiNoteNumber)
+                 && sound->appliesToChannel (midiChannel))
             {
-                if (sound->appliesToNote (midiNoteNumber)
-                     && sound->appliesToChannel (midiChannel))
-                {
-                    voice->keyIsDown = false;
+                voice->keyIsDown = false;
 
-                    if (! (sustainPedalsDown [midiChannel] || voice->sostenutoPedalDown))
-                        stopVoice (voice, allowTailOff);
-                }
+                if (! (isSustainPedalDown (midiChannel) || voice->sostenutoPedalDown))
+                    stopVoice (voice, allowTailOff);
             }
         }
+
+        voice = next;
     }
 }
 
 void Synthesiser::allNotesOff (const int midiChannel, const bool allowTailOff)
 {
-    const ScopedLock sl (lock);
+    updateRenderingSnapshot();
 
-    for (int i = voices.size(); --i >= 0;)
+    for (SynthesiserVoice* voice = firstPlayingVoice; voice != nullptr;)
     {
-        SynthesiserVoice* const voice = voices.getUnchecked (i);
+        SynthesiserVoice* const next = voice->nextInList;
 
         if (midiChannel <= 0 || voice->isPlayingChannel (midiChannel))
             voice->stopNote (allowTailOff);
+
+        voice = next;
     }
 
-    sustainPedalsDown.clear();
+    sustainPedalsDown = 0;
 }
 
 void Synthesiser::handlePitchWheel (const int midiChannel, const int wheelValue)
 {
-    const ScopedLock sl (lock);
-
-    for (int i = voices.size(); --i >= 0;)
-    {
-        SynthesiserVoice* const voice = voices.getUnchecked (i);
+    updateRenderingSnapshot();
 
+    for (SynthesiserVoice* voice = firstPlayingVoice; voice != nullptr; voice = voice->nextInList)
         if (midiChannel <= 0 || voice->isPlayingChannel (midiChannel))
             voice->pitchWheelMoved (wheelValue);
-    }
 }
 
 void Synthesiser::handleController (const int midiChannel,
@@ -333,62 +817,56 @@ void Synthesiser::handleController (const int midiChannel,
         default:    break;
     }
 
-    const ScopedLock sl (lock);
-
-    for (int i = voices.size(); --i >= 0;)
-    {
-        SynthesiserVoice* const voice = voices.getUnchecked (i);
+    updateRenderingSnapshot();
 
+    for (SynthesiserVoice* voice = firstPlayingVoice; voice != nullptr; voice = voice->nextInList)
         if (midiChannel <= 0 || voice->isPlayingChannel (midiChannel))
             voice->controllerMoved (controllerNumber, controllerValue);
-    }
 }
 
 void Synthesiser::handleAftertouch (int midiChannel, int midiNoteNumber, int aftertouchValue)
 {
-    const ScopedLock sl (lock);
-
-    for (int i = voices.size(); --i >= 0;)
-    {
-        SynthesiserVoice* const voice = voices.getUnchecked (i);
+    updateRenderingSnapshot();
 
-        if (voice->getCurrentlyPlayingNote() == midiNoteNumber
-              && (midiChannel <= 0 || voice->isPlayingChannel (midiChannel)))
-            voice->aftertouchChanged (aftertouchValue);
-    }
+    if (isPositiveAndBelow (midiNoteNumber, numElementsInArray (firstVoiceOnNote)))
+        for (SynthesiserVoice* voice = firstVoiceOnNote [midiNoteNumber]; voice != nullptr; voice = voice->nextOnNote)
+            if (midiChannel <= 0 || voice->isPlayingChannel (midiChannel))
+                voice->aftertouchChanged (aftertouchValue);
 }
 
 void Synthesiser::handleSustainPedal (int midiChannel, bool isDown)
 {
     jassert (midiChannel > 0 && midiChannel <= 16);
-    const ScopedLock sl (lock);
+    updateRenderingSnapshot();
 
     if (isDown)
     {
-        sustainPedalsDown.setBit (midiChannel);
+        sustainPedalsDown |= (1u << midiChannel);
     }
     else
     {
-        for (int i = voices.size(); --i >= 0;)
+        for (SynthesiserVoice* voice = firstPlayingVoice; voice != nullptr;)
         {
-            SynthesiserVoice* const voice = voices.getUnchecked (i);
+            SynthesiserVoice* const next = voice->nextInList;
 
             if (voice->isPlayingChannel (midiChannel) && ! voice->keyIsDown)
                 stopVoice (voice, true);
+
+            voice = next;
         }
 
-        sustainPedalsDown.clearBit (midiChannel);
+        sustainPedalsDown &= ~(1u << midiChannel);
     }
 }
 
 void Synthesiser::handleSostenutoPedal (int midiChannel, bool isDown)
 {
     jassert (midiChannel > 0 && midiChannel <= 16);
-    const ScopedLock sl (lock);
+    updateRenderingSnapshot();
 
-    for (int i = voices.size(); --i >= 0;)
+    for (SynthesiserVoice* voice = firstPlayingVoice; voice != nullptr;)
     {
-        SynthesiserVoice* const voice = voices.getUnchecked (i);
+        SynthesiserVoice* const next = voice->nextInList;
 
         if (voice->isPlayingChannel (midiChannel))
         {
@@ -397,6 +875,8 @@ void Synthesiser::handleSostenutoPedal (int midiChannel, bool isDown)
             else if (voice->sostenutoPedalDown)
                 stopVoice (voice, true);
         }
+
+        voice = next;
     }
 }
 
@@ -406,37 +886,257 @@ void Synthesiser::handleSoftPedal (int midiChannel, bool /*isDown*/)
     jassert (midiChannel > 0 && midiChannel <= 16);
 }
 
+bool Synthesiser::isSustainPedalDown (const int midiChannel) const noexcept
+{
+    return isPositiveAndBelow (midiChannel, 32)
+            && (sustainPedalsDown & (1u << midiChannel)) != 0;
+}
+
 //==============================================================================
 SynthesiserVoice* Synthesiser::findFreeVoice (SynthesiserSound* soundToPlay,
                                               const bool stealIfNoneAvailable) const
 {
-    const ScopedLock sl (lock);
+    for (SynthesiserVoice* voice = firstFreeVoice; voice != nullptr; voice = voice->nextInList)
+        if (voice->canPlaySound (soundToPlay))
+            return voice;
 
-    for (int i = voices.size(); --i >= 0;)
+    if (stealIfNoneAvailable)
     {
-        SynthesiserVoice* const voice = voices.getUnchecked (i);
+        // The playing voices are kept in the order they were started, so the first one
+        // that can play this sound is the one that's been playing the longest.
+        for (SynthesiserVoice* voice = firstPlayingVoice; voice != nullptr; voice = voice->nextInList)
+            if (voice->canPlaySound (soundToPlay))
+                return voice;
 
-        if (voice->getCurrentlyPlayingNote() < 0  && voice->canPlaySound (soundToPlay))
-            return voice;
+        jassertfalse;
     }
 
-    if (stealIfNoneAvailable)
+    return nullptr;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class SynthesiserTests  : public UnitTest
+{
+public:
+    SynthesiserTests() : UnitTest ("Synthesiser") {}
+
+    void runTest()
     {
-        // currently this just steals the one that's been playing the longest, but could be made a bit smarter..
-        SynthesiserVoice* oldest = nullptr;
+        beginTest ("Voice stealing");
 
-        for (int i = voices.size(); --i >= 0;)
         {
-            SynthesiserVoice* const voice = voices.getUnchecked (i);
+            Synthesiser synth;
+            createTestSynth (synth, 4, 0);
+
+            AudioSampleBuffer output (2, testBlockSize);
+            MidiBuffer midi;
+
+            for (int note = 60; note < 66; ++note)
+                midi.addEvent (MidiMessage::noteOn (1, note, 1.0f), note);
+
+            output.clear();
+            synth.renderNextBlock (output, midi, 0, testBlockSize);
+
+            // the two oldest notes should have been stolen
+            Array<int> notesPlaying;
+
+            for (int i = 0; i < synth.getNumVoices(); ++i)
+                notesPlaying.add (synth.getVoice (i)->getCurrentlyPlayingNote());
+
+            for (int note = 62; note < 66; ++note)
+                expect (notesPlaying.contains (note));
+        }
+
+        beginTest ("Parallel rendering matches serial rendering");
+
+        for (int numVoices = 8; numVoices <= 64; numVoices *= 2)
+        {
+            Synthesiser serialSynth, parallelSynth;
+            createTestSynth (serialSynth, numVoices, 0);
+            createTestSynth (parallelSynth, numVoices, 3);
 
-            if (voice->canPlaySound (soundToPlay)
-                 && (oldest == nullptr || oldest->noteOnTime > voice->noteOnTime))
-                oldest = voice;
+            AudioSampleBuffer serialOutput (2, testBlockSize), parallelOutput (2, testBlockSize);
+            Random random (getRandom());
+
+            for (int block = 0; block < 50; ++block)
+            {
+                MidiBuffer midi;
+                createRandomMidi (random, midi, numVoices);
+
+                serialOutput.clear();
+                parallelOutput.clear();
+                serialSynth.renderNextBlock (serialOutput, midi, 0, testBlockSize);
+                parallelSynth.renderNextBlock (parallelOutput, midi, 0, testBlockSize);
+
+                // (the voices get summed in a different order, so allow some rounding error)
+                for (int chan = 0; chan < 2; ++chan)
+                    for (int i = 0; i < testBlockSize; ++i)
+                        expect (std::abs (serialOutput.getSampleData (chan)[i] - parallelOutput.getSampleData (chan)[i])
+                                  < 1.0e-4f * (float) numVoices);
+            }
         }
 
-        jassert (oldest != nullptr);
-        return oldest;
+        beginTest ("Parallel rendering speed");
+
+        const int numThreads = jmax (1, SystemStats::getNumCpus() - 1);
+        const int voiceCounts[] = { 64, 128, 512 };
+
+        for (int i = 0; i < numElementsInArray (voiceCounts); ++i)
+        {
+            const double serialTime   = timeSynth (voiceCounts[i], 0);
+            const double parallelTime = timeSynth (voiceCounts[i], numThreads);
+
+            logMessage (String (voiceCounts[i]) + " voices: serial " + String (serialTime, 2) + "ms, "
+                          + String (numThreads) + " extra threads " + String (parallelTime, 2) + "ms");
+        }
     }
 
-    return nullptr;
-}
+private:
+    enum { testBlockSize = 256 };
+
+    //==============================================================================
+    struct TestSound  : public SynthesiserSound
+    {
+        TestSound (int channel_) : channel (channel_) {}
+
+        bool appliesToNote (int)            { return true; }
+        bool appliesToChannel (int c)       { return c == channel; }
+
+        const int channel;
+    };
+
+    // A sine voice with a short release, which uses a few harmonics so that
+    // there's a realistic amount of work to do for each sample
+    struct TestVoice  : public SynthesiserVoice
+    {
+        TestVoice() : angle (0), angleDelta (0), level (0), tailOff (0) {}
+
+        bool canPlaySound (SynthesiserSound*)   { return true; }
+
+        void startNote (int midiNoteNumber, float velocity, SynthesiserSound*, int)
+        {
+            angle = 0;
+            angleDelta = 2.0 * double_Pi * MidiMessage::getMidiNoteInHertz (midiNoteNumber) / getSampleRate();
+            level = velocity * 0.1;
+            tailOff = 0;
+        }
+
+        void stopNote (bool allowTailOff)
+        {
+            if (allowTailOff)
+            {
+                if (tailOff == 0)
+                    tailOff = 1.0;
+            }
+            else
+            {
+                clearCurrentNote();
+                angleDelta = 0;
+            }
+        }
+
+        void pitchWheelMoved (int)              {}
+        void controllerMoved (int, int)         {}
+
+        void renderNextBlock (AudioSampleBuffer& outputBuffer, int startSample, int numSamples)
+        {
+            if (angleDelta == 0)
+                return;
+
+            while (--numSamples >= 0)
+            {
+                double sample = 0;
+
+                for (int harmonic = 1; harmonic <= 4; ++harmonic)
+                    sample += std::sin (angle * harmonic) / harmonic;
+
+                sample *= level;
+
+                if (tailOff > 0)
+                {
+                    sample *= tailOff;
+                    tailOff *= 0.995;
+
+                    if (tailOff <= 0.005)
+                    {
+                        clearCurrentNote();
+                        angleDelta = 0;
+                        break;
+                    }
+                }
+
+                for (int chan = outputBuffer.getNumChannels(); --chan >= 0;)
+                    *outputBuffer.getSampleData (chan, startSample) += (float) sample;
+
+                angle += angleDelta;
+                ++startSample;
+            }
+        }
+
+        double angle, angleDelta, level, tailOff;
+    };
+
+    static void createTestSynth (Synthesiser& synth, const int numVoices, const int numThreads)
+    {
+        for (int i = 0; i < numVoices; ++i)
+            synth.addVoice (new TestVoice());
+
+        for (int channel = 1; channel <= 4; ++channel)
+            synth.addSound (new TestSound (channel));
+        synth.setCurrentPlaybackSampleRate (44100.0);
+        synth.setNumRenderingThreads (numThreads);
+    }
+
+    static void createRandomMidi (Random& random, MidiBuffer& midi, const int numVoices)
+    {
+        for (int i = random.nextInt (numVoices / 2); --i >= 0;)
+        {
+            const int channel = 1 + random.nextInt (4);
+            const int note = 24 + random.nextInt (72);
+            const int time = random.nextInt (testBlockSize);
+
+            if (random.nextBool())
+                midi.addEvent (MidiMessage::noteOn (channel, note, random.nextFloat()), time);
+            else
+                midi.addEvent (MidiMessage::noteOff (channel, note), time);
+        }
+    }
+
+    static double timeSynth (const int numVoices, const int numThreads)
+    {
+        Synthesiser synth;
+        createTestSynth (synth, numVoices, numThreads);
+
+        AudioSampleBuffer output (2, testBlockSize);
+        MidiBuffer midi;
+
+        // start all the voices, on a few different channels..
+        for (int i = 0; i < numVoices; ++i)
+            midi.addEvent (MidiMessage::noteOn (1 + i / 128, i % 128, 0.5f), (i * 7) % testBlockSize);
+
+        output.clear();
+        synth.renderNextBlock (output, midi, 0, testBlockSize);
+
+        // ..and then render a few blocks with some events in them
+        midi.clear();
+
+        for (int i = 0; i < 8; ++i)
+            midi.addEvent (MidiMessage::controllerEvent (1, 1, i), i * testBlockSize / 8);
+
+        const double startTime = Time::getMillisecondCounterHiRes();
+
+        for (int block = 0; block < 20; ++block)
+        {
+            output.clear();
+            synth.renderNextBlock (output, midi, 0, testBlockSize);
+        }
+
+        return Time::getMillisecondCounterHiRes() - startTime;
+    }
+};
+
+static SynthesiserTests synthesiserTests;
+
+#endif
@@ -25,6 +25,7 @@
 #ifndef JUCE_SYNTHESISER_H_INCLUDED
 #define JUCE_SYNTHESISER_H_INCLUDED
 
+class Synthesiser;
 
 //==============================================================================
 /**
@@ -168,6 +169,12 @@ public:
         The size of the blocks that are rendered can change each time it is called, and may
         involve rendering as little as 1 sample at a time. In between rendering callbacks,
         the voice's methods will be called to tell it about note and controller events.
+
+        If the synth has been told to use more than one rendering thread, this may be called
+        from one of its worker threads, at the same time as other voices are being rendered,
+        so it mustn't touch anything that the voices share without protecting it.
+
+        @see Synthesiser::setNumRenderingThreads
     */
     virtual void renderNextBlock (AudioSampleBuffer& outputBuffer,
                                   int startSample,
@@ -232,6 +239,14 @@ private:
     SynthesiserSound::Ptr currentlyPlayingSound;
     bool keyIsDown, sostenutoPedalDown;
 
+    // These are used by the synth that owns this voice to keep track of it on the audio thread
+    Synthesiser* owner;
+    SynthesiserVoice* previousInList;
+    SynthesiserVoice* nextInList;
+    SynthesiserVoice* previousOnNote;
+    SynthesiserVoice* nextOnNote;
+    int listType, noteInList, snapshotGeneration;
+
     JUCE_LEAK_DETECTOR (SynthesiserVoice)
 };
 
@@ -277,7 +292,11 @@ public:
     /** Deletes all voices. */
     void clearVoices();
 
-    /** Returns the number of voices that have been added. */
+    /** Returns the number of voices that have been added.
+        Like the other methods for adding and removing voices and sounds, this refers to the
+        synth's own list of voices, which might be a few moments ahead of the one that the
+        audio thread is using.
+    */
     int getNumVoices() const noexcept                               { return voices.size(); }
 
     /** Returns one of the voices that have been added. */
@@ -293,7 +312,9 @@ public:
     */
     void addVoice (SynthesiserVoice* newVoice);
 
-    /** Deletes one of the voices. */
+    /** Deletes one of the voices.
+        The voice isn't deleted immediately, but once the audio thread has stopped using it.
+    */
     void removeVoice (int index);
 
     //==============================================================================
@@ -445,6 +466,12 @@ public:
 
     /** Creates the next block of audio output.
 
+        None of the rendering or note-handling methods ever take a lock, so they can run
+        safely on the audio thread while other threads are adding or removing voices and
+        sounds. But that means that they must all be called from the same thread, and not
+        concurrently - to trigger notes from another thread, pass the events in through
+        the inputMidi buffer, e.g. by using a MidiMessageCollector.
+
         This will process the next numSamples of data from all the voices, and add that output
         to the audio block supplied, starting from the offset specified. Note that the
         data will be added to the current contents of the buffer, so you should clear it
@@ -460,22 +487,65 @@ public:
                           int startSample,
                           int numSamples);
 
+    //==============================================================================
+    /** Sets the number of extra threads that the synth can use to render its voices.
+
+        By default this is zero, and renderNextBlock() renders each playing voice in turn.
+        If you set it to a higher number, the synth will start that many high-priority
+        worker threads, and the playing voices will be shared out between these and the
+        thread that calls renderNextBlock(). Each thread renders its voices into a buffer
+        of its own, and these are then added to the output.
+
+        The block is still split up at the position of each midi event, so the timing is
+        the same as when rendering on a single thread. But as it takes some time to hand
+        the work over to the other threads, this is only worth doing when there are lots
+        of voices playing, or the voices are expensive to render.
+
+        Bear in mind that SynthesiserVoice::renderNextBlock() may now be called from one of
+        the worker threads, at the same time as other voices are rendering.
+
+        @see getNumRenderingThreads
+    */
+    void setNumRenderingThreads (int numThreads);
+
+    /** Returns the number of extra threads that the synth is using to render its voices.
+        @see setNumRenderingThreads
+    */
+    int getNumRenderingThreads() const noexcept;
+
 protected:
     //==============================================================================
-    /** This is used to control access to the rendering callback and the note trigger methods. */
+    /** This is used to control access to the voices and sounds arrays by the threads that
+        change them. The audio thread never needs to take it, as it only uses snapshots of
+        these arrays.
+    */
     CriticalSection lock;
 
+    /** The synth's current voices and sounds.
+        These can only safely be used while holding the lock. To look at the voices from the
+        rendering and note methods, use getRenderingVoices() instead.
+    */
     OwnedArray<SynthesiserVoice> voices;
     ReferenceCountedArray<SynthesiserSound> sounds;
 
     /** The last pitch-wheel values for each midi channel. */
     int lastPitchWheelValues [16];
 
+    /** Returns the voices that the audio thread is currently using.
+        This is only safe to call from the rendering and note-handling methods.
+    */
+    const Array<SynthesiserVoice*>& getRenderingVoices() const noexcept;
+
     /** Searches through the voices to find one that's not currently playing, and which
         can play the given sound.
 
         Returns nullptr if all voices are busy and stealing isn't enabled.
 
+        The default implementation keeps its free voices in a list, and its playing ones
+        in the order in which they were started, so it doesn't need to search through all
+        the voices. If there's no free voice, it'll steal the one that has been playing
+        for the longest.
+
         This can be overridden to implement custom voice-stealing algorithms.
     */
     virtual SynthesiserVoice* findFreeVoice (SynthesiserSound* soundToPlay,
@@ -500,9 +570,35 @@ private:
     double sampleRate;
     uint32 lastNoteOnCounter;
     bool shouldStealNotes;
-    BigInteger sustainPedalsDown;
-
+    uint32 sustainPedalsDown;
+
+    // The voices and sounds are passed to the audio thread in read-only snapshots
+    class VoiceSnapshot;
+    friend struct ContainerDeletePolicy<VoiceSnapshot>;
+    OwnedArray<VoiceSnapshot> publishedSnapshots;
+    Atomic<VoiceSnapshot*> latestSnapshot;
+    Atomic<int> renderingGeneration;
+    VoiceSnapshot* renderingSnapshot;
+
+    // These lists are only used by the audio thread
+    SynthesiserVoice* firstFreeVoice;
+    SynthesiserVoice* firstPlayingVoice;
+    SynthesiserVoice* lastPlayingVoice;
+    SynthesiserVoice* firstVoiceOnNote [128];
+
+    class ParallelRenderer;
+    friend struct ContainerDeletePolicy<ParallelRenderer>;
+    ScopedPointer<ParallelRenderer> parallelRenderer;
+    bool isRenderingInParallel;
+
+    friend class SynthesiserVoice;
+    void publishSnapshot (OwnedArray<SynthesiserVoice>* voicesToDelete, ParallelRenderer* rendererToDelete = nullptr);
+    void renderVoices (AudioSampleBuffer&, int startSample, int numSamples);
+    void updateRenderingSnapshot() noexcept;
+    void addToVoiceList (SynthesiserVoice*) noexcept;
+    void removeFromVoiceList (SynthesiserVoice*) noexcept;
     void stopVoice (SynthesiserVoice*, bool allowTailOff);
+    bool isSustainPedalDown (int midiChannel) const noexcept;
 
    #if JUCE_CATCH_DEPRECATED_CODE_MISUSE
     // Note the new parameters for this method.
@@ -44,5 +44,15 @@ bool AudioIODevice::showControlPanel()
     return false;
 }
 
+int AudioIODevice::getXRunCount() const noexcept
+{
+    return -1;
+}
+
+bool AudioIODevice::getCallbackTimingHistograms (Array<int>&, Array<int>&)
+{
+    return false;
+}
+
 //==============================================================================
 void AudioIODeviceCallback::audioDeviceError (const String&) {}
@@ -290,6 +290,26 @@ public:
     virtual bool showControlPanel();
 
 
+    //==============================================================================
+    /** Returns the number of buffer under- or overruns that the device has reported
+        since it was last opened, or -1 if this device doesn't keep track of them.
+    */
+    virtual int getXRunCount() const noexcept;
+
+    /** Retrieves histograms of the time spent inside the audio callback, and of the
+        time between the starts of successive callbacks, since the device was last opened.
+
+        Each array holds counts for 40 buckets, each covering 1/20th of the duration of
+        one buffer at the current sample rate, so together they span two buffers. Anything
+        longer than that is counted in the last bucket, so for the interval histogram a
+        well-behaved device will show a peak around bucket 20 and nothing in the last one.
+
+        Returns false if the device doesn't gather this information.
+    */
+    virtual bool getCallbackTimingHistograms (Array<int>& callbackDurations,
+                                              Array<int>& callbackIntervals);
+
+
     //==============================================================================
 protected:
     /** Creates a device, setting its name and type member variables. */
@@ -22,10 +22,55 @@
   ==============================================================================
 */
 
+/*  The queue is a ring of fixed-size slots, each with a sequence number that says whether it's
+    free or full, which lets several threads add messages while the audio thread removes them,
+    without any locks. A writer claims a run of slots by bumping enqueuePosition, fills them,
+    and then marks them as full; the reader takes full slots in order, and marks them as free
+    again for the writers on the next lap of the ring.
+
+    Most messages fit into one slot, but longer ones (e.g. sysex) are split across several
+    consecutive ones.
+*/
+struct MidiMessageCollector::QueuedMessage
+{
+    enum
+    {
+        queueSize = 2048,
+        bytesPerSlot = 16,
+        maxMessageSize = queueSize * bytesPerSlot / 2
+    };
+
+    static int getNumSlotsNeeded (const int numBytes) noexcept
+    {
+        return jmax (1, (numBytes + bytesPerSlot - 1) / bytesPerSlot);
+    }
+
+    Atomic<uint32> sequence;
+    int numBytes;
+    double timeStamp;
+    uint8 data [bytesPerSlot];
+};
+
+//==============================================================================
 MidiMessageCollector::MidiMessageCollector()
     : lastCallbackTime (0),
-      sampleRate (44100.0001)
+      sampleRate (44100.0001),
+      queue ((size_t) QueuedMessage::queueSize),
+      messageData ((size_t) QueuedMessage::maxMessageSize),
+      dequeuePosition (0),
+      numMessagesMeasured (0),
+      latencySum (0),
+      latencySumOfSquares (0),
+      minLatency (0),
+      maxLatency (0)
 {
+    for (uint32 i = 0; i < (uint32) QueuedMessage::queueSize; ++i)
+        queue[i].sequence = i;
+
+    // (this makes sure that a full queue can be copied into the buffer without allocating)
+    incomingMessages.ensureSize ((size_t) QueuedMessage::queueSize * (QueuedMessage::bytesPerSlot + 8));
+
+    resetJitterStatistics();
 }
 
 MidiMessageCollector::~MidiMessageCollector()
@@ -37,8 +82,8 @@ void MidiMessageCollector::reset (const double sampleRate_)
 {
     jassert (sampleRate_ > 0);
 
-    const ScopedLock sl (midiCallbackLock);
     sampleRate = sampleRate_;
+    readQueuedMessages();
     incomingMessages.clear();
     lastCallbackTime = Time::getMillisecondCounterHiRes();
 }
@@ -52,17 +97,92 @@ void MidiMessageCollector::addMessageToQueue (const MidiMessage& message)
     // for details of what the number should be.
     jassert (message.getTimeStamp() != 0);
 
-    const ScopedLock sl (midiCallbackLock);
+    const int numBytes = message.getRawDataSize();
+    const int numSlots = QueuedMessage::getNumSlotsNeeded (numBytes);
+    const uint32 mask = QueuedMessage::queueSize - 1;
+
+    if (numBytes > QueuedMessage::maxMessageSize)
+    {
+        ++numMessagesDropped;
+        return;
+    }
+
+    // Claim a run of slots. Because the reader frees them in order, they're all free
+    // if the last one is, and if it isn't, the queue is full.
+    uint32 start = enqueuePosition.get();
+
+    for (;;)
+    {
+        const uint32 last = start + (uint32) numSlots - 1;
+        const int difference = (int) (queue [last & mask].sequence.get() - last);
+
+        if (difference < 0)
+        {
+            ++numMessagesDropped;
+            return;
+        }
+
+        if (difference == 0 && enqueuePosition.compareAndSetBool (start + (uint32) numSlots, start))
+            break;
+
+        start = enqueuePosition.get();
+    }
+
+    QueuedMessage& first = queue [start & mask];
+    first.numBytes = numBytes;
+    first.timeStamp = message.getTimeStamp();
+
+    const uint8* source = message.getRawData();
+
+    for (int i = 0; i < numSlots; ++i)
+        memcpy (queue [(start + (uint32) i) & mask].data,
+                source + i * QueuedMessage::bytesPerSlot,
+                (size_t) jmin ((int) QueuedMessage::bytesPerSlot, numBytes - i * QueuedMessage::bytesPerSlot));
+
+    // the first slot is marked as full last, so the reader can't see the message until it's complete
+    for (int i = numSlots; --i >= 0;)
+        queue [(start + (uint32) i) & mask].sequence = start + (uint32) i + 1;
+}
+
+void MidiMessageCollector::readQueuedMessages()
+{
+    const uint32 mask = QueuedMessage::queueSize - 1;
+
+    // Only the messages that had been claimed when this started are read, so that writers
+    // which keep adding messages can't keep the audio thread here indefinitely.
+    const uint32 end = enqueuePosition.get();
+
+    while ((int) (end - dequeuePosition) > 0)
+    {
+        QueuedMessage& first = queue [dequeuePosition & mask];
+
+        if (first.sequence.get() != dequeuePosition + 1)
+            break;
 
-    const int sampleNumber
-        = (int) ((message.getTimeStamp() - 0.001 * lastCallbackTime) * sampleRate);
+        const int numBytes = first.numBytes;
+        const int numSlots = QueuedMessage::getNumSlotsNeeded (numBytes);
+        const uint8* data = first.data;
 
-    incomingMessages.addEvent (message, sampleNumber);
+        if (numSlots > 1)
+        {
+            for (int i = 0; i < numSlots; ++i)
+                memcpy (messageData + i * QueuedMessage::bytesPerSlot,
+                        queue [(dequeuePosition + (uint32) i) & mask].data,
+                        (size_t) jmin ((int) QueuedMessage::bytesPerSlot, numBytes - i * QueuedMessage::bytesPerSlot));
+
+            data = messageData;
+        }
+
+        const int sampleNumber
+            = (int) ((first.timeStamp - 0.001 * lastCallbackTime) * sampleRate);
+
+        incomingMessages.addEvent (data, numBytes, sampleNumber);
 
-    // if the messages don't get used for over a second, we'd better
-    // get rid of any old ones to avoid the queue getting too big
-    if (sampleNumber > sampleRate)
-        incomingMessages.clear (0, sampleNumber - (int) sampleRate);
+        for (int i = 0; i < numSlots; ++i)
+            queue [(dequeuePosition + (uint32) i) & mask].sequence = dequeuePosition + (uint32) (i + QueuedMessage::queueSize);
+
+        dequeuePosition += (uint32) numSlots;
+    }
 }
 
 void MidiMessageCollector::removeNextBlockOfMessages (MidiBuffer& destBuffer,
@@ -75,9 +195,17 @@ void MidiMessageCollector::removeNextBlockOfMessages (MidiBuffer& destBuffer,
     const double timeNow = Time::getMillisecondCounterHiRes();
     const double msElapsed = timeNow - lastCallbackTime;
 
-    const ScopedLock sl (midiCallbackLock);
+    // (the timestamps are converted relative to the previous callback, so this has to
+    // happen before lastCallbackTime is updated)
+    readQueuedMessages();
     lastCallbackTime = timeNow;
 
+    if (statisticsResetPending.compareAndSetBool (0, 1))
+    {
+        numMessagesMeasured = 0;
+        latencySum = latencySumOfSquares = minLatency = maxLatency = 0;
+    }
+
     if (! incomingMessages.isEmpty())
     {
         int numSourceSamples = jmax (1, roundToInt (msElapsed * 0.001 * sampleRate));
@@ -107,10 +235,10 @@ void MidiMessageCollector::removeNextBlockOfMessages (MidiBuffer& destBuffer,
 
             while (iter.getNextEvent (midiData, numBytes, samplePosition))
             {
-                samplePosition = ((samplePosition - startSample) * scale) >> 10;
+                const int destPosition = jlimit (0, numSamples - 1, ((samplePosition - startSample) * scale) >> 10);
 
-                destBuffer.addEvent (midiData, numBytes,
-                                     jlimit (0, numSamples - 1, samplePosition));
+                destBuffer.addEvent (midiData, numBytes, destPosition);
+                addLatencyMeasurement (msElapsed + (destPosition - samplePosition) * 1000.0 / sampleRate);
             }
         }
         else
@@ -121,13 +249,83 @@ void MidiMessageCollector::removeNextBlockOfMessages (MidiBuffer& destBuffer,
 
             while (iter.getNextEvent (midiData, numBytes, samplePosition))
             {
-                destBuffer.addEvent (midiData, numBytes,
-                                     jlimit (0, numSamples - 1, samplePosition + startSample));
+                const int destPosition = jlimit (0, numSamples - 1, samplePosition + startSample);
+
+                destBuffer.addEvent (midiData, numBytes, destPosition);
+                addLatencyMeasurement (msElapsed + (destPosition - samplePosition) * 1000.0 / sampleRate);
             }
         }
 
         incomingMessages.clear();
     }
+
+    publishStatistics();
+}
+
+//==============================================================================
+void MidiMessageCollector::addLatencyMeasurement (const double latencyMs) noexcept
+{
+    if (numMessagesMeasured == 0)
+    {
+        minLatency = maxLatency = latencyMs;
+    }
+    else
+    {
+        minLatency = jmin (minLatency, latencyMs);
+        maxLatency = jmax (maxLatency, latencyMs);
+    }
+
+    ++numMessagesMeasured;
+    latencySum += latencyMs;
+    latencySumOfSquares += latencyMs * latencyMs;
+}
+
+void MidiMessageCollector::publishStatistics() noexcept
+{
+    // (if another thread is reading the statistics, they'll just be published next time)
+    const GenericScopedTryLock<SpinLock> sl (statisticsLock);
+
+    if (sl.isLocked())
+    {
+        JitterStatistics& s = publishedStatistics;
+        s.numMessages = numMessagesMeasured;
+
+        if (numMessagesMeasured > 0)
+        {
+            s.averageLatencyMs = latencySum / numMessagesMeasured;
+            s.minLatencyMs = minLatency;
+            s.maxLatencyMs = maxLatency;
+            s.jitterMs = std::sqrt (jmax (0.0, latencySumOfSquares / numMessagesMeasured
+                                                 - s.averageLatencyMs * s.averageLatencyMs));
+        }
+        else
+        {
+            // (otherwise the figures from before a reset would still be reported)
+            s.averageLatencyMs = s.minLatencyMs = s.maxLatencyMs = s.jitterMs = 0;
+        }
+    }
+}
+
+MidiMessageCollector::JitterStatistics MidiMessageCollector::getJitterStatistics() const
+{
+    JitterStatistics s;
+
+    {
+        const SpinLock::ScopedLockType sl (statisticsLock);
+        s = publishedStatistics;
+    }
+
+    s.numMessagesDropped = numMessagesDropped.get();
+    return s;
+}
+
+void MidiMessageCollector::resetJitterStatistics()
+{
+    const SpinLock::ScopedLockType sl (statisticsLock);
+
+    zerostruct (publishedStatistics);
+    numMessagesDropped = 0;
+    statisticsResetPending = 1;
 }
 
 //==============================================================================
@@ -151,3 +349,222 @@ void MidiMessageCollector::handleIncomingMidiMessage (MidiInput*, const MidiMess
 {
     addMessageToQueue (message);
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class MidiMessageCollectorTests  : public UnitTest
+{
+public:
+    MidiMessageCollectorTests() : UnitTest ("MidiMessageCollector") {}
+
+    void runTest()
+    {
+        beginTest ("Several threads adding messages");
+
+        {
+            MidiMessageCollector collector;
+            collector.reset (48000.0);
+            collector.resetJitterStatistics();
+
+            OwnedArray<Producer> producers;
+
+            for (int i = 0; i < numProducers; ++i)
+                producers.add (new Producer (collector, i));
+
+            for (int i = 0; i < numProducers; ++i)
+                producers.getUnchecked (i)->startThread();
+
+            int lastReceived [numProducers];
+            int numReceived = 0, numSysexReceived = 0;
+            bool inOrder = true, sysexIntact = true;
+
+            for (int i = 0; i < numProducers; ++i)
+                lastReceived[i] = -1;
+
+            for (bool producersRunning = true; producersRunning;)
+            {
+                // (this is checked before reading the block, so the last one gets everything)
+                producersRunning = false;
+
+                for (int i = 0; i < numProducers; ++i)
+                    if (producers.getUnchecked (i)->isThreadRunning())
+                        producersRunning = true;
+
+                Thread::sleep (2);
+
+                MidiBuffer block;
+                collector.removeNextBlockOfMessages (block, 96);
+
+                MidiBuffer::Iterator iter (block);
+                MidiMessage message;
+                int samplePosition;
+
+                while (iter.getNextEvent (message, samplePosition))
+                {
+                    int producer, index;
+
+                    if (message.isSysEx())
+                    {
+                        ++numSysexReceived;
+
+                        if (! decodeSysex (message, producer, index))
+                        {
+                            sysexIntact = false;
+                            continue;
+                        }
+                    }
+                    else
+                    {
+                        const uint8* const data = message.getRawData();
+                        producer = data[0] & 0x0f;
+                        index = ((data[0] & 0xf0) == 0xa0 ? 0x4000 : 0) + (data[1] << 7) + data[2];
+                    }
+
+                    if (! isPositiveAndBelow (producer, (int) numProducers) || index <= lastReceived [producer])
+                        inOrder = false;
+                    else
+                        lastReceived [producer] = index;
+
+                    ++numReceived;
+                }
+            }
+
+            const int numDropped = collector.getJitterStatistics().numMessagesDropped;
+            logMessage (String (numReceived) + " messages received, " + String (numDropped) + " dropped");
+
+            expect (inOrder);
+            expect (sysexIntact);
+            expect (numSysexReceived > 0);
+            expectEquals (numReceived + numDropped, (int) (numProducers * messagesPerProducer));
+        }
+
+        beginTest ("Overflowing the queue");
+
+        {
+            MidiMessageCollector collector;
+            collector.reset (48000.0);
+            collector.resetJitterStatistics();
+
+            const int numToSend = 3000;
+
+            for (int i = 0; i < numToSend; ++i)
+                collector.addMessageToQueue (MidiMessage (0x90, i >> 7, i & 0x7f, Time::getMillisecondCounterHiRes() * 0.001));
+
+            MidiBuffer block;
+            collector.removeNextBlockOfMessages (block, 512);
+
+            const int numDropped = collector.getJitterStatistics().numMessagesDropped;
+            expect (numDropped > 0);
+            expectEquals (block.getNumEvents() + numDropped, numToSend);
+
+            // the newest messages are the ones that get dropped
+            MidiBuffer::Iterator iter (block);
+            MidiMessage message;
+            int samplePosition;
+            bool keptOldest = true;
+
+            for (int i = 0; iter.getNextEvent (message, samplePosition); ++i)
+                if (((message.getRawData()[1] << 7) | message.getRawData()[2]) != i)
+                    keptOldest = false;
+
+            expect (keptOldest);
+        }
+
+        beginTest ("Resetting the statistics");
+
+        {
+            MidiMessageCollector collector;
+            collector.reset (48000.0);
+
+            MidiBuffer block;
+            collector.addMessageToQueue (MidiMessage (0x90, 60, 100, Time::getMillisecondCounterHiRes() * 0.001));
+            collector.removeNextBlockOfMessages (block, 512);
+            expectEquals (collector.getJitterStatistics().numMessages, 1);
+
+            collector.resetJitterStatistics();
+            collector.removeNextBlockOfMessages (block, 512);
+
+            const MidiMessageCollector::JitterStatistics s (collector.getJitterStatistics());
+            expectEquals (s.numMessages, 0);
+            expectEquals (s.averageLatencyMs, 0.0);
+            expectEquals (s.minLatencyMs, 0.0);
+            expectEquals (s.maxLatencyMs, 0.0);
+            expectEquals (s.jitterMs, 0.0);
+        }
+    }
+
+private:
+    enum { numProducers = 4, messagesPerProducer = 20000 };
+
+    // Sends a numbered sequence of messages, with a sysex of varying length every so often.
+    // (the note-ons' 14 data bits aren't enough for the numbers, so the top bit is sent by
+    // switching to aftertouch messages)
+    struct Producer  : public Thread
+    {
+        Producer (MidiMessageCollector& c, const int index)
+            : Thread ("MIDI producer"), collector (c), producerIndex (index) {}
+
+        void run() override
+        {
+            for (int i = 0; i < messagesPerProducer; ++i)
+            {
+                const double timeStamp = Time::getMillisecondCounterHiRes() * 0.001;
+
+                if (i % 50 == 49)
+                {
+                    uint8 data [256];
+                    const int size = createSysex (data, producerIndex, i);
+                    collector.addMessageToQueue (MidiMessage (data, size, timeStamp));
+                }
+                else
+                {
+                    collector.addMessageToQueue (MidiMessage ((i >= 0x4000 ? 0xa0 : 0x90) | producerIndex,
+                                                              (i >> 7) & 0x7f, i & 0x7f, timeStamp));
+                }
+
+                if ((i & 15) == 0)
+                    Thread::sleep (1);
+            }
+        }
+
+        MidiMessageCollector& collector;
+        const int producerIndex;
+    };
+
+    static int createSysex (uint8* const data, const int producer, const int index) noexcept
+    {
+        const int size = 8 + (index * 7) % 240;
+
+        data[0] = 0xf0;
+        data[1] = (uint8) producer;
+        data[2] = (uint8) (index >> 14);
+        data[3] = (uint8) ((index >> 7) & 0x7f);
+        data[4] = (uint8) (index & 0x7f);
+
+        for (int i = 5; i < size - 1; ++i)
+            data[i] = (uint8) ((producer * 31 + index + i) & 0x7f);
+
+        data[size - 1] = 0xf7;
+        return size;
+    }
+
+    static bool decodeSysex (const MidiMessage& message, int& producer, int& index)
+    {
+        const uint8* const data = message.getRawData();
+
+        if (message.getRawDataSize() < 8)
+            return false;
+
+        producer = data[1];
+        index = (data[2] << 14) + (data[3] << 7) + data[4];
+
+        uint8 expected [256];
+        return createSysex (expected, producer, index) == message.getRawDataSize()
+                && memcmp (expected, data, (size_t) message.getRawDataSize()) == 0;
+    }
+};
+
+static MidiMessageCollectorTests midiMessageCollectorTests;
+
+#endif
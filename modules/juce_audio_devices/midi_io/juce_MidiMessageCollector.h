@@ -34,6 +34,11 @@
     The class can also be used as either a MidiKeyboardStateListener or a MidiInputCallback
     so it can easily use a midi input or keyboard component as its source.
 
+    Messages are passed to the audio thread through a lock-free queue, so any number of
+    MidiInputs and keyboard states can feed the same collector at once without ever blocking
+    the audio callback. The conversion of their timestamps into sample positions is done by
+    removeNextBlockOfMessages(), on the audio thread.
+
     @see MidiMessage, MidiInput
 */
 class JUCE_API  MidiMessageCollector    : public MidiKeyboardStateListener,
@@ -51,7 +56,8 @@ public:
     /** Clears any messages from the queue.
 
         You need to call this method before starting to use the collector, so that
-        it knows the correct sample rate to use.
+        it knows the correct sample rate to use. It mustn't be called while another
+        thread is calling removeNextBlockOfMessages().
     */
     void reset (double sampleRate);
 
@@ -60,8 +66,15 @@ public:
         The message's timestamp is taken, and it will be ready for retrieval as part
         of the block returned by the next call to removeNextBlockOfMessages().
 
-        This method is fully thread-safe when overlapping calls are made with
-        removeNextBlockOfMessages().
+        Any number of threads can call this at the same time, and it never blocks.
+
+        The queue holds up to 2048 short messages. If it's full because
+        removeNextBlockOfMessages() isn't being called often enough, the message being added
+        is dropped, and counted in the JitterStatistics. So after an overflow it's the newest
+        messages that are lost, not the oldest: only the audio thread ever frees space in the
+        queue, which is what keeps it lock-free. This means that e.g. a note-off can be lost
+        while its note-on gets through, so if numMessagesDropped goes up, you might want to
+        send some all-notes-off messages.
     */
     void addMessageToQueue (const MidiMessage& message);
 
@@ -74,13 +87,41 @@ public:
         callback, because the time that it happens is used in calculating the
         midi event positions.
 
-        This method is fully thread-safe when overlapping calls are made with
-        addMessageToQueue().
+        This never blocks, so it's safe to call while other threads are calling
+        addMessageToQueue(), but only one thread at a time may call it.
 
         Precondition: numSamples must be greater than 0.
     */
     void removeNextBlockOfMessages (MidiBuffer& destBuffer, int numSamples);
 
+    //==============================================================================
+    /** Some statistics about the timing of the messages that have been collected.
+        @see getJitterStatistics
+    */
+    struct JitterStatistics
+    {
+        int numMessages;            /**< The number of messages that have been passed to removeNextBlockOfMessages(). */
+        int numMessagesDropped;     /**< The number of messages that were lost because the queue was full. */
+        double averageLatencyMs;    /**< The average latency of the messages, in milliseconds. */
+        double minLatencyMs;        /**< The smallest latency of any message, in milliseconds. */
+        double maxLatencyMs;        /**< The largest latency of any message, in milliseconds. */
+        double jitterMs;            /**< The standard deviation of the latency, in milliseconds. */
+    };
+
+    /** Returns statistics about the messages since the last call to resetJitterStatistics().
+
+        A message's latency is the time from its timestamp to the sample position that it's
+        been given in the block, assuming that the block starts to play when
+        removeNextBlockOfMessages() is called. With a steady audio callback, it'll be about the
+        length of one block, and any variation in it is timing jitter that will be audible.
+
+        The figures are updated by removeNextBlockOfMessages(), so may be a block out of date.
+    */
+    JitterStatistics getJitterStatistics() const;
+
+    /** Clears the statistics that getJitterStatistics() returns. */
+    void resetJitterStatistics();
+
 
     //==============================================================================
     /** @internal */
@@ -92,11 +133,27 @@ public:
 
 private:
     //==============================================================================
+    struct QueuedMessage;
+
     double lastCallbackTime;
-    CriticalSection midiCallbackLock;
     MidiBuffer incomingMessages;
     double sampleRate;
 
+    HeapBlock<QueuedMessage> queue;
+    HeapBlock<uint8> messageData;
+    Atomic<uint32> enqueuePosition;
+    uint32 dequeuePosition;
+
+    Atomic<int> numMessagesDropped, statisticsResetPending;
+    int numMessagesMeasured;
+    double latencySum, latencySumOfSquares, minLatency, maxLatency;
+    JitterStatistics publishedStatistics;
+    SpinLock statisticsLock;
+
+    void readQueuedMessages();
+    void addLatencyMeasurement (double latencyMs) noexcept;
+    void publishStatistics() noexcept;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiMessageCollector)
 };
 
@@ -148,14 +148,16 @@ static void silentErrorHandler (const char*, int, const char*, int, const char*,
 class ALSADevice
 {
 public:
-    ALSADevice (const String& devID, bool forInput)
+    ALSADevice (const String& devID, bool forInput, int wakeUpFileDescriptor)
         : handle (0),
           bitDepth (16),
           numChannelsRunning (0),
           latency (0),
           deviceID (devID),
           isInput (forInput),
-          isInterleaved (true)
+          isInterleaved (true),
+          wakeUpFd (wakeUpFileDescriptor),
+          numPollFds (0)
     {
         JUCE_ALSA_LOG ("snd_pcm_open (" << deviceID.toUTF8().getAddress() << ", forInput=" << forInput << ")");
 
@@ -304,9 +306,61 @@ public:
 
         numChannelsRunning = numChannels;
 
+        // (the extra slot at the end is for the thread's wake-up pipe)
+        numPollFds = jmax (0, snd_pcm_poll_descriptors_count (handle));
+        pollFds.calloc ((size_t) numPollFds + 1);
+        numPollFds = jmax (0, snd_pcm_poll_descriptors (handle, pollFds, (unsigned int) numPollFds));
+
+        JUCE_ALSA_LOG ("access: " << (isInterleaved ? "interleaved" : "non-interleaved")
+                         << ", poll descriptors: " << numPollFds);
+
         return true;
     }
 
+    //==============================================================================
+    /** Blocks until the device is ready for more data, the timeout expires, or something
+        is written to the wake-up pipe.
+        Returns 1 if the device is ready, 0 on a timeout, or -1 if it was woken up or failed.
+    */
+    int waitUntilReady (const int timeoutMs)
+    {
+        if (numPollFds == 0)
+            return JUCE_ALSA_FAILED (snd_pcm_wait (handle, timeoutMs)) ? -1 : 1;
+
+        struct pollfd& wakeUp = pollFds [numPollFds];
+        wakeUp.fd = wakeUpFd;
+        wakeUp.events = POLLIN;
+
+        for (;;)
+        {
+            wakeUp.revents = 0;
+            const int result = poll (pollFds, (nfds_t) numPollFds + 1, timeoutMs);
+
+            if (result == 0)
+                return 0;
+
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                return -1;
+            }
+
+            if (wakeUp.revents != 0)
+                return -1;
+
+            unsigned short revents = 0;
+
+            if (JUCE_ALSA_FAILED (snd_pcm_poll_descriptors_revents (handle, pollFds, (unsigned int) numPollFds, &revents)))
+                return -1;
+
+            // (an error event usually means an xrun, which the next transfer will recover from)
+            if ((revents & (POLLERR | (isInput ? POLLIN : POLLOUT))) != 0)
+                return 1;
+        }
+    }
+
     //==============================================================================
     bool writeToOutputDevice (AudioSampleBuffer& outputChannelBuffer, const int numSamples)
     {
@@ -331,7 +385,7 @@ public:
             numDone = snd_pcm_writen (handle, (void**) data, numSamples);
         }
 
-        if (numDone < 0 && JUCE_ALSA_FAILED (snd_pcm_recover (handle, numDone, 1 /* silent */)))
+        if (numDone < 0 && ! recover ((int) numDone))
             return false;
 
         if (numDone < numSamples)
@@ -352,7 +406,7 @@ public:
 
             snd_pcm_sframes_t num = snd_pcm_readi (handle, scratch.getData(), numSamples);
 
-            if (num < 0 && JUCE_ALSA_FAILED (snd_pcm_recover (handle, num, 1 /* silent */)))
+            if (num < 0 && ! recover ((int) num))
                 return false;
 
             if (num < numSamples)
@@ -365,7 +419,7 @@ public:
         {
             snd_pcm_sframes_t num = snd_pcm_readn (handle, (void**) data, numSamples);
 
-            if (num < 0 && JUCE_ALSA_FAILED (snd_pcm_recover (handle, num, 1 /* silent */)))
+            if (num < 0 && ! recover ((int) num))
                 return false;
 
             if (num < numSamples)
@@ -378,18 +432,30 @@ public:
         return true;
     }
 
+    bool recover (const int errorNum)
+    {
+        if (errorNum == -EPIPE || errorNum == -ESTRPIPE)
+            ++numXRuns;
+
+        return ! JUCE_ALSA_FAILED (snd_pcm_recover (handle, errorNum, 1 /* silent */));
+    }
+
     //==============================================================================
     snd_pcm_t* handle;
     String error;
     int bitDepth, numChannelsRunning, latency;
+    Atomic<int> numXRuns;
 
 private:
     //==============================================================================
     String deviceID;
     const bool isInput;
     bool isInterleaved;
+    const int wakeUpFd;
     MemoryBlock scratch;
     ScopedPointer<AudioData::Converter> converter;
+    HeapBlock<struct pollfd> pollFds;
+    int numPollFds;
 
     //==============================================================================
     template <class SampleType>
@@ -465,14 +531,32 @@ public:
           numCallbacks (0),
           audioIoInProgress (false),
           inputChannelBuffer (1, 1),
-          outputChannelBuffer (1, 1)
+          outputChannelBuffer (1, 1),
+          ticksPerBuffer (1),
+          lastCallbackStartTicks (0)
     {
         initialiseRatesAndChannels();
+
+        if (pipe (wakeUpPipe) == 0)
+        {
+            fcntl (wakeUpPipe[0], F_SETFL, O_NONBLOCK);
+            fcntl (wakeUpPipe[1], F_SETFL, O_NONBLOCK);
+        }
+        else
+        {
+            wakeUpPipe[0] = wakeUpPipe[1] = -1;
+        }
     }
 
     ~ALSAThread()
     {
         close();
+
+        if (wakeUpPipe[0] >= 0)
+        {
+            ::close (wakeUpPipe[0]);
+            ::close (wakeUpPipe[1]);
+        }
     }
 
     void open (BigInteger inputChannels,
@@ -486,6 +570,9 @@ public:
         sampleRate = newSampleRate;
         bufferSize = newBufferSize;
 
+        resetTimingHistograms();
+        drainWakeUpPipe();
+
         inputChannelBuffer.setSize (jmax ((int) minChansIn, inputChannels.getHighestBit()) + 1, bufferSize);
         inputChannelBuffer.clear();
         inputChannelDataForCallback.clear();
@@ -524,12 +611,12 @@ public:
 
         if (outputChannelDataForCallback.size() > 0 && outputId.isNotEmpty())
         {
-            outputDevice = new ALSADevice (outputId, false);
+            setDevice (outputDevice, new ALSADevice (outputId, false, wakeUpPipe[0]));
 
             if (outputDevice->error.isNotEmpty())
             {
                 error = outputDevice->error;
-                outputDevice = nullptr;
+                setDevice (outputDevice, nullptr);
                 return;
             }
 
@@ -539,7 +626,7 @@ public:
                                                bufferSize))
             {
                 error = outputDevice->error;
-                outputDevice = nullptr;
+                setDevice (outputDevice, nullptr);
                 return;
             }
 
@@ -548,12 +635,12 @@ public:
 
         if (inputChannelDataForCallback.size() > 0 && inputId.isNotEmpty())
         {
-            inputDevice = new ALSADevice (inputId, true);
+            setDevice (inputDevice, new ALSADevice (inputId, true, wakeUpPipe[0]));
 
             if (inputDevice->error.isNotEmpty())
             {
                 error = inputDevice->error;
-                inputDevice = nullptr;
+                setDevice (inputDevice, nullptr);
                 return;
             }
 
@@ -564,7 +651,7 @@ public:
                                               bufferSize))
             {
                 error = inputDevice->error;
-                inputDevice = nullptr;
+                setDevice (inputDevice, nullptr);
                 return;
             }
 
@@ -612,6 +699,13 @@ public:
             // here which will cause the thread to resume, and exit
             signalThreadShouldExit();
 
+            // this will break the thread out of any poll() that it's waiting in
+            if (wakeUpPipe[1] >= 0)
+            {
+                const char c = 0;
+                (void) ::write (wakeUpPipe[1], &c, 1);
+            }
+
             const int callbacksToStop = numCallbacks;
 
             if ((! waitForThreadToExit (400)) && audioIoInProgress && numCallbacks == callbacksToStop)
@@ -625,8 +719,8 @@ public:
 
         stopThread (6000);
 
-        inputDevice = nullptr;
-        outputDevice = nullptr;
+        setDevice (inputDevice, nullptr);
+        setDevice (outputDevice, nullptr);
 
         inputChannelBuffer.setSize (1, 1);
         outputChannelBuffer.setSize (1, 1);
@@ -642,6 +736,8 @@ public:
 
     void run() override
     {
+        setRealtimeScheduling();
+
         while (! threadShouldExit())
         {
             if (inputDevice != nullptr && inputDevice->handle)
@@ -661,6 +757,13 @@ public:
                 break;
 
             {
+                const int64 callbackStartTicks = Time::getHighResolutionTicks();
+
+                if (lastCallbackStartTicks != 0)
+                    addToHistogram (intervalHistogram, callbackStartTicks - lastCallbackStartTicks);
+
+                lastCallbackStartTicks = callbackStartTicks;
+
                 const ScopedLock sl (callbackLock);
                 ++numCallbacks;
 
@@ -677,11 +780,13 @@ public:
                     for (int i = 0; i < outputChannelDataForCallback.size(); ++i)
                         zeromem (outputChannelDataForCallback[i], sizeof (float) * bufferSize);
                 }
+
+                addToHistogram (durationHistogram, Time::getHighResolutionTicks() - callbackStartTicks);
             }
 
             if (outputDevice != nullptr && outputDevice->handle)
             {
-                JUCE_ALSA_FAILED (snd_pcm_wait (outputDevice->handle, 2000));
+                outputDevice->waitUntilReady (2000);
 
                 if (threadShouldExit())
                     break;
@@ -689,7 +794,7 @@ public:
                 snd_pcm_sframes_t avail = snd_pcm_avail_update (outputDevice->handle);
 
                 if (avail < 0)
-                    JUCE_ALSA_FAILED (snd_pcm_recover (outputDevice->handle, avail, 0));
+                    outputDevice->recover ((int) avail);
 
                 audioIoInProgress = true;
 
@@ -716,6 +821,29 @@ public:
         return 16;
     }
 
+    int getXRunCount() const noexcept
+    {
+        const ScopedLock sl (deviceLock);
+        int total = 0;
+
+        if (outputDevice != nullptr)  total += outputDevice->numXRuns.get();
+        if (inputDevice != nullptr)   total += inputDevice->numXRuns.get();
+
+        return total;
+    }
+
+    void getCallbackTimingHistograms (Array<int>& callbackDurations, Array<int>& callbackIntervals) const
+    {
+        callbackDurations.clearQuick();
+        callbackIntervals.clearQuick();
+
+        for (int i = 0; i < numTimingBuckets; ++i)
+        {
+            callbackDurations.add (durationHistogram[i].get());
+            callbackIntervals.add (intervalHistogram[i].get());
+        }
+    }
+
     //==============================================================================
     String error;
     double sampleRate;
@@ -733,7 +861,7 @@ private:
     int numCallbacks;
     bool audioIoInProgress;
 
-    CriticalSection callbackLock;
+    CriticalSection callbackLock, deviceLock;
 
     AudioSampleBuffer inputChannelBuffer, outputChannelBuffer;
     Array<float*> inputChannelDataForCallback, outputChannelDataForCallback;
@@ -741,6 +869,56 @@ private:
     unsigned int minChansOut, maxChansOut;
     unsigned int minChansIn, maxChansIn;
 
+    int wakeUpPipe[2];
+
+    enum { numTimingBuckets = 40 };
+    Atomic<int> durationHistogram [numTimingBuckets], intervalHistogram [numTimingBuckets];
+    int64 ticksPerBuffer, lastCallbackStartTicks;
+
+    void setRealtimeScheduling()
+    {
+        // SCHED_FIFO needs the right privileges (e.g. an rtprio entry in limits.conf), so if
+        // this fails we just carry on at the normal priority that the thread was started with.
+        struct sched_param param;
+        param.sched_priority = jmin (70, sched_get_priority_max (SCHED_FIFO));
+
+        if (pthread_setschedparam (pthread_self(), SCHED_FIFO, &param) != 0)
+            JUCE_ALSA_LOG ("Couldn't set SCHED_FIFO priority for the audio thread");
+    }
+
+    void resetTimingHistograms()
+    {
+        for (int i = 0; i < numTimingBuckets; ++i)
+        {
+            durationHistogram[i] = 0;
+            intervalHistogram[i] = 0;
+        }
+
+        ticksPerBuffer = jmax ((int64) 1, Time::secondsToHighResolutionTicks (bufferSize / jmax (1.0, sampleRate)));
+        lastCallbackStartTicks = 0;
+    }
+
+    void addToHistogram (Atomic<int>* const histogram, const int64 ticks) noexcept
+    {
+        ++histogram [(int) jlimit ((int64) 0, (int64) numTimingBuckets - 1, (ticks * 20) / ticksPerBuffer)];
+    }
+
+    // (the lock stops getXRunCount() from reading a device that's being deleted)
+    void setDevice (ScopedPointer<ALSADevice>& device, ALSADevice* const newDevice)
+    {
+        const ScopedLock sl (deviceLock);
+        device = newDevice;
+    }
+
+    void drainWakeUpPipe()
+    {
+        char buffer[16];
+
+        if (wakeUpPipe[0] >= 0)
+            while (::read (wakeUpPipe[0], buffer, sizeof (buffer)) > 0)
+            {}
+    }
+
     bool failed (const int errorNum)
     {
         if (errorNum >= 0)
@@ -874,6 +1052,14 @@ public:
     int getOutputLatencyInSamples() override         { return internal.outputLatency; }
     int getInputLatencyInSamples() override          { return internal.inputLatency; }
 
+    int getXRunCount() const noexcept override       { return internal.getXRunCount(); }
+
+    bool getCallbackTimingHistograms (Array<int>& callbackDurations, Array<int>& callbackIntervals) override
+    {
+        internal.getCallbackTimingHistograms (callbackDurations, callbackIntervals);
+        return true;
+    }
+
     void start (AudioIODeviceCallback* callback) override
     {
         if (! isOpen_)
@@ -162,7 +162,7 @@ private:
                                 if (numBytes > 0)
                                 {
                                     const MidiMessage message ((const uint8*) buffer, numBytes,
-                                                               Time::getMillisecondCounter() * 0.001);
+                                                               Time::getMillisecondCounterHiRes() * 0.001);
 
                                     client.handleIncomingMidiMessage (message, inputEvent->dest.port);
                                 }
@@ -153,9 +153,21 @@ public:
         reservoir.setSize ((int) numChannels, 2 * (int) info.max_blocksize, false, false, true);
     }
 
-    // returns the number of samples read
     bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
                       int64 startSampleInFile, int numSamples) override
+    {
+        return readSampleData (destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
+    }
+
+    bool readFloatSamples (float** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                           int64 startSampleInFile, int numSamples) override
+    {
+        return readSampleData (destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
+    }
+
+    template <typename SampleType>
+    bool readSampleData (SampleType** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                         int64 startSampleInFile, int numSamples)
     {
         using namespace FlacNamespace;
 
@@ -174,9 +186,9 @@ public:
 
                 for (int i = jmin (numDestChannels, reservoir.getNumChannels()); --i >= 0;)
                     if (destSamples[i] != nullptr)
-                        memcpy (destSamples[i] + startOffsetInDestBuffer,
-                                reservoir.getSampleData (i, (int) (startSampleInFile - reservoirStart)),
-                                sizeof (int) * (size_t) num);
+                        copyFromReservoir (destSamples[i] + startOffsetInDestBuffer,
+                                           reinterpret_cast<const int*> (reservoir.getSampleData (i, (int) (startSampleInFile - reservoirStart))),
+                                           num);
 
                 startOffsetInDestBuffer += num;
                 startSampleInFile += num;
@@ -184,9 +196,11 @@ public:
             }
             else
             {
+                // (the reservoir is left alone at the end of the file, so that a later read of
+                // the last few samples can still find them there)
                 if (startSampleInFile >= (int) lengthInSamples)
                 {
-                    samplesInReservoir = 0;
+                    break;
                 }
                 else if (startSampleInFile < reservoirStart
                           || startSampleInFile > reservoirStart + jmax (samplesInReservoir, 511))
@@ -213,12 +227,22 @@ public:
         {
             for (int i = numDestChannels; --i >= 0;)
                 if (destSamples[i] != nullptr)
-                    zeromem (destSamples[i] + startOffsetInDestBuffer, sizeof (int) * (size_t) numSamples);
+                    zeromem (destSamples[i] + startOffsetInDestBuffer, sizeof (SampleType) * (size_t) numSamples);
         }
 
         return true;
     }
 
+    static void copyFromReservoir (int* dest, const int* src, int num) noexcept
+    {
+        memcpy (dest, src, sizeof (int) * (size_t) num);
+    }
+
+    static void copyFromReservoir (float* dest, const int* src, int num) noexcept
+    {
+        FloatVectorOperations::convertFixedToFloat (dest, src, 1.0f / 0x7fffffff, num);
+    }
+
     void useSamples (const FlacNamespace::FLAC__int32* const buffer[], int numSamples)
     {
         if (scanningForLength)
@@ -327,17 +351,7 @@ public:
     {
         using namespace FlacNamespace;
         encoder = FLAC__stream_encoder_new();
-
-        if (qualityOptionIndex > 0)
-            FLAC__stream_encoder_set_compression_level (encoder, (uint32) jmin (8, qualityOptionIndex));
-
-        FLAC__stream_encoder_set_do_mid_side_stereo (encoder, numChannels == 2);
-        FLAC__stream_encoder_set_loose_mid_side_stereo (encoder, numChannels == 2);
-        FLAC__stream_encoder_set_channels (encoder, numChannels);
-        FLAC__stream_encoder_set_bits_per_sample (encoder, jmin ((unsigned int) 24, bitsPerSample));
-        FLAC__stream_encoder_set_sample_rate (encoder, (unsigned int) sampleRate);
-        FLAC__stream_encoder_set_blocksize (encoder, 0);
-        FLAC__stream_encoder_set_do_escape_coding (encoder, true);
+        configureEncoder (encoder, sampleRate, numChannels, bitsPerSample, qualityOptionIndex);
 
         ok = FLAC__stream_encoder_init_stream (encoder,
                                                encodeWriteCallback, encodeSeekCallback,
@@ -412,9 +426,30 @@ public:
     }
 
     void writeMetaData (const FlacNamespace::FLAC__StreamMetadata* metadata)
+    {
+        writeStreamInfo (*output, metadata->data.stream_info);
+    }
+
+    static void configureEncoder (FlacNamespace::FLAC__StreamEncoder* encoder, double rate,
+                                  uint32 numChans, uint32 bits, int qualityOptionIndex)
+    {
+        using namespace FlacNamespace;
+
+        if (qualityOptionIndex > 0)
+            FLAC__stream_encoder_set_compression_level (encoder, (uint32) jmin (8, qualityOptionIndex));
+
+        FLAC__stream_encoder_set_do_mid_side_stereo (encoder, numChans == 2);
+        FLAC__stream_encoder_set_loose_mid_side_stereo (encoder, numChans == 2);
+        FLAC__stream_encoder_set_channels (encoder, numChans);
+        FLAC__stream_encoder_set_bits_per_sample (encoder, jmin ((unsigned int) 24, bits));
+        FLAC__stream_encoder_set_sample_rate (encoder, (unsigned int) rate);
+        FLAC__stream_encoder_set_blocksize (encoder, 0);
+        FLAC__stream_encoder_set_do_escape_coding (encoder, true);
+    }
+
+    static void writeStreamInfo (OutputStream& out, const FlacNamespace::FLAC__StreamMetadata_StreamInfo& info)
     {
         using namespace FlacNamespace;
-        const FLAC__StreamMetadata_StreamInfo& info = metadata->data.stream_info;
 
         unsigned char buffer [FLAC__STREAM_METADATA_STREAMINFO_LENGTH];
         const unsigned int channelsMinus1 = info.channels - 1;
@@ -431,15 +466,15 @@ public:
         packUint32 ((FLAC__uint32) info.total_samples, buffer + 14, 4);
         memcpy (buffer + 18, info.md5sum, 16);
 
-        const bool seekOk = output->setPosition (4);
+        const bool seekOk = out.setPosition (4);
         (void) seekOk;
 
         // if this fails, you've given it an output stream that can't seek! It needs
         // to be able to seek back to write the header
         jassert (seekOk);
 
-        output->writeIntBigEndian (FLAC__STREAM_METADATA_STREAMINFO_LENGTH);
-        output->write (buffer, FLAC__STREAM_METADATA_STREAMINFO_LENGTH);
+        out.writeIntBigEndian (FLAC__STREAM_METADATA_STREAMINFO_LENGTH);
+        out.write (buffer, FLAC__STREAM_METADATA_STREAMINFO_LENGTH);
     }
 
     //==============================================================================
@@ -485,6 +520,360 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FlacWriter)
 };
 
+//==============================================================================
+#if JUCE_INCLUDE_FLAC_CODE || ! defined (JUCE_INCLUDE_FLAC_CODE)
+
+/*  Encodes the stream as a series of independent runs of frames, each one by its own
+    libFLAC encoder on a thread-pool. Because every encoder starts counting frames from
+    zero, each frame's header is re-written with its position in the whole stream (and
+    its CRCs updated) before the runs are written out in order.
+*/
+class MultiThreadedFlacWriter  : public AudioFormatWriter
+{
+public:
+    MultiThreadedFlacWriter (OutputStream* const out, double rate, uint32 numChans, uint32 bits,
+                             int quality, int numThreads)
+        : AudioFormatWriter (out, flacFormatName, rate, numChans, bits),
+          ok (false),
+          openedOk (false),
+          qualityOptionIndex (quality),
+          blockSize (0),
+          nextFrameNumber (0),
+          totalSamplesWritten (0),
+          minFrameSize (0xffffff),
+          maxFrameSize (0),
+          maxPendingRuns (2 * numThreads),
+          pool (numThreads)
+    {
+        using namespace FlacNamespace;
+
+        // Use a throwaway encoder to find out the block size and to write the stream's
+        // metadata blocks, which are then patched with the real STREAMINFO when finished.
+        FLAC__StreamEncoder* const encoder = FLAC__stream_encoder_new();
+        FlacWriter::configureEncoder (encoder, sampleRate, numChannels, bitsPerSample, qualityOptionIndex);
+
+        ok = openedOk = FLAC__stream_encoder_init_stream (encoder, headerWriteCallback, nullptr, nullptr, nullptr, this)
+                          == FLAC__STREAM_ENCODER_INIT_STATUS_OK;
+
+        if (ok)
+        {
+            blockSize = (int) FLAC__stream_encoder_get_blocksize (encoder);
+            FLAC__stream_encoder_finish (encoder);
+        }
+
+        FLAC__stream_encoder_delete (encoder);
+
+        FLAC__MD5Init (&md5);
+    }
+
+    ~MultiThreadedFlacWriter()
+    {
+        using namespace FlacNamespace;
+
+        if (ok)
+        {
+            if (currentRun != nullptr && currentRun->numSamples > 0)
+                startEncodingCurrentRun();
+
+            writeFinishedRuns (true);
+
+            FLAC__StreamMetadata_StreamInfo info;
+            zerostruct (info);
+            info.min_blocksize = info.max_blocksize = (unsigned int) blockSize;
+            info.min_framesize = minFrameSize;
+            info.max_framesize = maxFrameSize;
+            info.sample_rate = (unsigned int) sampleRate;
+            info.channels = numChannels;
+            info.bits_per_sample = bitsPerSample;
+            info.total_samples = (FLAC__uint64) totalSamplesWritten;
+            FLAC__MD5Final (info.md5sum, &md5);
+
+            FlacWriter::writeStreamInfo (*output, info);
+            output->flush();
+        }
+        else
+        {
+            FLAC__byte unusedDigest[16];
+            FLAC__MD5Final (unusedDigest, &md5);
+
+            // If the constructor failed, createWriter() returns null and the stream still belongs
+            // to its caller, so this stops the base class deleting it. After a write error the
+            // writer owns the stream, so it gets deleted as usual.
+            if (! openedOk)
+                output = nullptr;
+        }
+
+        pool.removeAllJobs (true, -1);
+    }
+
+    //==============================================================================
+    bool write (const int** samplesToWrite, int numSamples) override
+    {
+        if (! ok)
+            return false;
+
+        const int bitsToShift = 32 - (int) bitsPerSample;
+        int startSample = 0;
+
+        while (numSamples > 0)
+        {
+            if (currentRun == nullptr)
+                currentRun = new EncoderRun (*this, blockSize * framesPerRun, nextFrameNumber);
+
+            const int numToCopy = jmin (numSamples, currentRun->getSpaceAvailable());
+
+            for (unsigned int i = 0; i < numChannels; ++i)
+            {
+                int* const dest = currentRun->getChannel ((int) i) + currentRun->numSamples;
+
+                if (samplesToWrite[i] == nullptr)
+                {
+                    zeromem (dest, sizeof (int) * (size_t) numToCopy);
+                }
+                else
+                {
+                    const int* const src = samplesToWrite[i] + startSample;
+
+                    for (int j = 0; j < numToCopy; ++j)
+                        dest[j] = src[j] >> bitsToShift;
+                }
+            }
+
+            currentRun->numSamples += numToCopy;
+            startSample += numToCopy;
+            numSamples -= numToCopy;
+
+            if (currentRun->getSpaceAvailable() == 0)
+                startEncodingCurrentRun();
+
+            if (! writeFinishedRuns (false))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool ok;
+
+private:
+    //==============================================================================
+    class EncoderRun  : public ThreadPoolJob
+    {
+    public:
+        EncoderRun (const MultiThreadedFlacWriter& w, int maxSamples, uint32 firstFrame)
+            : ThreadPoolJob ("FLAC encoder"),
+              numSamples (0),
+              firstFrameNumber (firstFrame),
+              minFrameSize (0xffffff),
+              maxFrameSize (0),
+              succeeded (false),
+              writer (w),
+              capacity (maxSamples),
+              samples (w.numChannels * (size_t) maxSamples),
+              channels (w.numChannels)
+        {
+            for (unsigned int i = 0; i < w.numChannels; ++i)
+                channels[i] = samples + i * (size_t) maxSamples;
+        }
+
+        int* getChannel (int channel) const noexcept    { return channels[channel]; }
+        int getSpaceAvailable() const noexcept          { return capacity - numSamples; }
+
+        const int* const* getChannels() const noexcept  { return channels; }
+
+        JobStatus runJob() override
+        {
+            using namespace FlacNamespace;
+
+            FLAC__StreamEncoder* const encoder = FLAC__stream_encoder_new();
+            FlacWriter::configureEncoder (encoder, writer.sampleRate, writer.numChannels,
+                                          writer.bitsPerSample, writer.qualityOptionIndex);
+            FLAC__stream_encoder_set_do_md5 (encoder, false);
+
+            if (FLAC__stream_encoder_init_stream (encoder, frameWriteCallback, nullptr, nullptr, nullptr, this)
+                    == FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+            {
+                succeeded = FLAC__stream_encoder_process (encoder, (const FLAC__int32**) channels.getData(), (unsigned) numSamples) != 0;
+                succeeded = (FLAC__stream_encoder_finish (encoder) != 0) && succeeded;
+            }
+
+            FLAC__stream_encoder_delete (encoder);
+            return jobHasFinished;
+        }
+
+        int numSamples;
+        const uint32 firstFrameNumber;
+        MemoryOutputStream encodedData;
+        uint32 minFrameSize, maxFrameSize;
+        bool succeeded;
+
+    private:
+        const MultiThreadedFlacWriter& writer;
+        const int capacity;
+        HeapBlock<int> samples;
+        HeapBlock<int*> channels;
+
+        void addFrame (const uint8* frame, size_t frameSize, uint32 frameNumberInRun)
+        {
+            using namespace FlacNamespace;
+
+            // The frame number follows the 4 fixed header bytes, in the same variable-length
+            // coding as UTF-8. After it come the optional block size and sample rate fields,
+            // then a CRC-8 of the header. The frame ends with a CRC-16 of everything before it.
+            int oldNumberSize = 1;
+
+            if (frame[4] >= 0x80)
+                while (oldNumberSize < 7 && (frame[4] & (0x80 >> oldNumberSize)) != 0)
+                    ++oldNumberSize;
+
+            const int blockSizeCode = frame[2] >> 4;
+            const int sampleRateCode = frame[2] & 0x0f;
+            const int extraHeaderBytes = (blockSizeCode == 6 ? 1 : (blockSizeCode == 7 ? 2 : 0))
+                                       + (sampleRateCode == 12 ? 1 : (sampleRateCode == 13 || sampleRateCode == 14 ? 2 : 0));
+
+            const size_t oldHeaderSize = (size_t) (4 + oldNumberSize + extraHeaderBytes);
+            jassert (frameSize > oldHeaderSize + 3);
+
+            FLAC__byte header [16];
+            memcpy (header, frame, 4);
+            const int newNumberSize = writeCodedNumber (header + 4, firstFrameNumber + frameNumberInRun);
+            memcpy (header + 4 + newNumberSize, frame + 4 + oldNumberSize, (size_t) extraHeaderBytes);
+
+            const unsigned int newHeaderSize = (unsigned int) (4 + newNumberSize + extraHeaderBytes);
+            header[newHeaderSize] = FLAC__crc8 (header, newHeaderSize);
+
+            const uint8* const body = frame + oldHeaderSize + 1;
+            const size_t bodySize = frameSize - oldHeaderSize - 3;
+
+            unsigned int crc = FLAC__crc16 (header, newHeaderSize + 1);
+
+            for (size_t i = 0; i < bodySize; ++i)
+                crc = FLAC__CRC16_UPDATE (body[i], crc);
+
+            const uint8 crcBytes[] = { (uint8) (crc >> 8), (uint8) crc };
+
+            encodedData.write (header, newHeaderSize + 1);
+            encodedData.write (body, bodySize);
+            encodedData.write (crcBytes, 2);
+
+            const uint32 newFrameSize = (uint32) (newHeaderSize + 1 + bodySize + 2);
+            minFrameSize = jmin (minFrameSize, newFrameSize);
+            maxFrameSize = jmax (maxFrameSize, newFrameSize);
+        }
+
+        static int writeCodedNumber (uint8* dest, const uint32 value) noexcept
+        {
+            if (value < 0x80)
+            {
+                dest[0] = (uint8) value;
+                return 1;
+            }
+
+            int numExtraBytes = 1;
+
+            while (numExtraBytes < 5 && value >= (1u << (6 + 5 * numExtraBytes)))
+                ++numExtraBytes;
+
+            dest[0] = (uint8) ((0xff00 >> (numExtraBytes + 1)) | (value >> (6 * numExtraBytes)));
+
+            for (int i = 1; i <= numExtraBytes; ++i)
+                dest[i] = (uint8) (0x80 | ((value >> (6 * (numExtraBytes - i))) & 0x3f));
+
+            return numExtraBytes + 1;
+        }
+
+        static FlacNamespace::FLAC__StreamEncoderWriteStatus frameWriteCallback (const FlacNamespace::FLAC__StreamEncoder*,
+                                                                                 const FlacNamespace::FLAC__byte buffer[],
+                                                                                 size_t bytes,
+                                                                                 unsigned int samples,
+                                                                                 unsigned int currentFrame,
+                                                                                 void* client_data)
+        {
+            using namespace FlacNamespace;
+
+            // (metadata blocks are written with a sample count of zero, and are ignored here)
+            if (samples > 0)
+                static_cast<EncoderRun*> (client_data)->addFrame (buffer, bytes, currentFrame);
+
+            return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (EncoderRun)
+    };
+
+    //==============================================================================
+    enum { framesPerRun = 32 };
+
+    bool openedOk;
+    const int qualityOptionIndex;
+    int blockSize;
+    uint32 nextFrameNumber;
+    int64 totalSamplesWritten;
+    uint32 minFrameSize, maxFrameSize;
+    const int maxPendingRuns;
+    FlacNamespace::FLAC__MD5Context md5;
+
+    ThreadPool pool;
+    ScopedPointer<EncoderRun> currentRun;
+    OwnedArray<EncoderRun> pendingRuns;
+
+    void startEncodingCurrentRun()
+    {
+        using namespace FlacNamespace;
+
+        EncoderRun* const run = currentRun.release();
+
+        FLAC__MD5Accumulate (&md5, (const FLAC__int32* const*) run->getChannels(), numChannels,
+                             (unsigned int) run->numSamples, (bitsPerSample + 7) / 8);
+
+        nextFrameNumber += (uint32) ((run->numSamples + blockSize - 1) / blockSize);
+        totalSamplesWritten += run->numSamples;
+
+        pendingRuns.add (run);
+        pool.addJob (run, false);
+    }
+
+    bool writeFinishedRuns (const bool waitForAll)
+    {
+        while (pendingRuns.size() > 0)
+        {
+            EncoderRun* const run = pendingRuns.getFirst();
+
+            if (waitForAll || pendingRuns.size() > maxPendingRuns)
+                pool.waitForJobToFinish (run, -1);
+            else if (pool.contains (run))
+                break;
+
+            if (! (run->succeeded && output->write (run->encodedData.getData(), run->encodedData.getDataSize())))
+                ok = false;
+
+            minFrameSize = jmin (minFrameSize, run->minFrameSize);
+            maxFrameSize = jmax (maxFrameSize, run->maxFrameSize);
+
+            pendingRuns.remove (0);
+        }
+
+        return ok;
+    }
+
+    static FlacNamespace::FLAC__StreamEncoderWriteStatus headerWriteCallback (const FlacNamespace::FLAC__StreamEncoder*,
+                                                                              const FlacNamespace::FLAC__byte buffer[],
+                                                                              size_t bytes,
+                                                                              unsigned int /*samples*/,
+                                                                              unsigned int /*current_frame*/,
+                                                                              void* client_data)
+    {
+        using namespace FlacNamespace;
+        return static_cast<MultiThreadedFlacWriter*> (client_data)->output->write (buffer, bytes)
+                ? FLAC__STREAM_ENCODER_WRITE_STATUS_OK
+                : FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiThreadedFlacWriter)
+};
+
+#endif
+
 
 //==============================================================================
 FlacAudioFormat::FlacAudioFormat()
@@ -546,10 +935,225 @@ AudioFormatWriter* FlacAudioFormat::createWriterFor (OutputStream* out,
     return nullptr;
 }
 
+AudioFormatWriter* FlacAudioFormat::createMultiThreadedWriterFor (OutputStream* out,
+                                                                  double sampleRate,
+                                                                  unsigned int numberOfChannels,
+                                                                  int bitsPerSample,
+                                                                  int qualityOptionIndex,
+                                                                  int numThreads)
+{
+   #if JUCE_INCLUDE_FLAC_CODE || ! defined (JUCE_INCLUDE_FLAC_CODE)
+    if (numThreads > 1 && getPossibleBitDepths().contains (bitsPerSample))
+    {
+        ScopedPointer<MultiThreadedFlacWriter> w (new MultiThreadedFlacWriter (out, sampleRate, numberOfChannels,
+                                                                               (uint32) bitsPerSample, qualityOptionIndex,
+                                                                               numThreads));
+        if (w->ok)
+            return w.release();
+
+        return nullptr;
+    }
+   #endif
+
+    return createWriterFor (out, sampleRate, numberOfChannels, bitsPerSample, StringPairArray(), qualityOptionIndex);
+}
+
 StringArray FlacAudioFormat::getQualityOptions()
 {
     static const char* options[] = { "0 (Fastest)", "1", "2", "3", "4", "5 (Default)","6", "7", "8 (Highest quality)", 0 };
     return StringArray (options);
 }
 
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class FlacAudioFormatTests  : public UnitTest
+{
+public:
+    FlacAudioFormatTests() : UnitTest ("FlacAudioFormat") {}
+
+    void runTest()
+    {
+        beginTest ("Multi-threaded encoding");
+
+        Random random (getRandom());
+        const int lengths[] = { 0, 100, 4096, 4097, 300000, 1000000 };
+
+        for (int i = 0; i < numElementsInArray (lengths); ++i)
+        {
+            testMultiThreadedWriter (random, 1, 16, lengths[i]);
+            testMultiThreadedWriter (random, 2, (i & 1) != 0 ? 24 : 16, lengths[i]);
+        }
+
+        beginTest ("Encoding speed");
+
+        const int numSamples = 44100 * 60;
+        TestSignal signal (random, 2, 16, numSamples);
+        const int numThreads = jmax (2, SystemStats::getNumCpus());
+
+        MemoryBlock singleThreaded, multiThreaded;
+
+        {
+            // (encodes a few seconds both ways first, so that neither of the timed runs has
+            // to pay for setting up the pool threads or paging in the code and buffers)
+            const TestSignal warmUpSignal (random, 2, 16, 44100 * 5);
+            encode (warmUpSignal, singleThreaded, 0);
+            encode (warmUpSignal, multiThreaded, numThreads);
+        }
+
+        const double singleTime = encode (signal, singleThreaded, 0);
+        const double multiTime  = encode (signal, multiThreaded, numThreads);
+
+        logMessage ("Encoded " + String (numSamples / 44100) + " seconds of stereo audio: 1 thread "
+                      + String (singleTime * 1000.0, 1) + "ms, " + String (numThreads) + " threads "
+                      + String (multiTime * 1000.0, 1) + "ms");
+
+        beginTest ("Write errors");
+
+        {
+            bool streamWasDeleted = false;
+
+            {
+                FlacAudioFormat format;
+                ScopedPointer<AudioFormatWriter> writer (format.createMultiThreadedWriterFor (new FailingOutputStream (100000, streamWasDeleted),
+                                                                                              44100.0, 2, 16, 5, 3));
+                expect (writer != nullptr);
+
+                if (writer != nullptr)
+                {
+                    bool writeFailed = false;
+
+                    for (int pos = 0; pos < signal.numSamples && ! writeFailed; pos += 4096)
+                    {
+                        const int* chans[] = { signal.channels[0] + pos, signal.channels[1] + pos };
+                        writeFailed = ! writer->write (chans, jmin (4096, signal.numSamples - pos));
+                    }
+
+                    expect (writeFailed);
+                }
+            }
+
+            expect (streamWasDeleted);
+        }
+    }
+
+private:
+    // Fails every write once a given number of bytes has been written.
+    struct FailingOutputStream  : public OutputStream
+    {
+        FailingOutputStream (const int64 maxBytes_, bool& wasDeleted_)
+            : maxBytes (maxBytes_), position (0), wasDeleted (wasDeleted_) {}
+
+        ~FailingOutputStream()                          { wasDeleted = true; }
+
+        void flush() override                           {}
+        bool setPosition (int64) override               { return false; }
+        int64 getPosition() override                    { return position; }
+
+        bool write (const void*, size_t numBytes) override
+        {
+            if (position + (int64) numBytes > maxBytes)
+                return false;
+
+            position += (int64) numBytes;
+            return true;
+        }
+
+        const int64 maxBytes;
+        int64 position;
+        bool& wasDeleted;
+    };
+
+    struct TestSignal
+    {
+        TestSignal (Random& random, int numChans, int bits, int length)
+            : numChannels (numChans), bitsPerSample (bits), numSamples (length),
+              data ((size_t) (numChans * jmax (1, length))), channels ((size_t) numChans)
+        {
+            const double amplitude = (1 << (bits - 2)) * 0.9;
+
+            for (int chan = 0; chan < numChannels; ++chan)
+            {
+                channels[chan] = data + chan * jmax (1, length);
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const int sample = roundToInt (amplitude * std::sin (i * 0.01 * (chan + 1)))
+                                         + random.nextInt (64) - 32;
+                    channels[chan][i] = sample << (32 - bits);
+                }
+            }
+        }
+
+        const int numChannels, bitsPerSample, numSamples;
+        HeapBlock<int> data;
+        HeapBlock<int*> channels;
+    };
+
+    static double encode (const TestSignal& signal, MemoryBlock& dest, int numThreads)
+    {
+        const double startTime = Time::getMillisecondCounterHiRes();
+
+        {
+            FlacAudioFormat format;
+            ScopedPointer<AudioFormatWriter> writer (format.createMultiThreadedWriterFor (new MemoryOutputStream (dest, false),
+                                                                                          44100.0, (unsigned int) signal.numChannels,
+                                                                                          signal.bitsPerSample, 5, numThreads));
+            HeapBlock<const int*> chans ((size_t) signal.numChannels);
+
+            for (int pos = 0; pos < signal.numSamples;)
+            {
+                const int num = jmin (signal.numSamples - pos, 1000 + (pos % 17) * 997);
+
+                for (int chan = 0; chan < signal.numChannels; ++chan)
+                    chans[chan] = signal.channels[chan] + pos;
+
+                writer->write (chans, num);
+                pos += num;
+            }
+        }
+
+        return (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    }
+
+    void testMultiThreadedWriter (Random& random, int numChannels, int bitsPerSample, int numSamples)
+    {
+        TestSignal signal (random, numChannels, bitsPerSample, numSamples);
+
+        MemoryBlock singleThreaded, multiThreaded;
+        encode (signal, singleThreaded, 0);
+        encode (signal, multiThreaded, 3);
+
+        // the STREAMINFO sample rate, format, length and MD5 fields should all be identical
+        expect (singleThreaded.getSize() > 42 && multiThreaded.getSize() > 42);
+        expect (memcmp (addBytesToPointer (singleThreaded.getData(), 18),
+                        addBytesToPointer (multiThreaded.getData(), 18), 24) == 0);
+
+        FlacAudioFormat format;
+        ScopedPointer<AudioFormatReader> reader (format.createReaderFor (new MemoryInputStream (multiThreaded, false), true));
+        expect (reader != nullptr);
+
+        if (reader != nullptr)
+        {
+            expectEquals (reader->lengthInSamples, (int64) numSamples);
+            expectEquals ((int) reader->numChannels, numChannels);
+
+            AudioSampleBuffer decoded (numChannels, jmax (1, numSamples));
+            reader->read (reinterpret_cast<int* const*> (decoded.getArrayOfChannels()), numChannels, 0, numSamples, false);
+
+            bool dataMatches = true;
+
+            for (int chan = 0; chan < numChannels; ++chan)
+                if (memcmp (decoded.getSampleData (chan), signal.channels[chan], sizeof (int) * (size_t) numSamples) != 0)
+                    dataMatches = false;
+
+            expect (dataMatches);
+        }
+    }
+};
+
+static FlacAudioFormatTests flacAudioFormatTests;
+
+#endif
+
 #endif
@@ -57,6 +57,27 @@ public:
                                         int bitsPerSample,
                                         const StringPairArray& metadataValues,
                                         int qualityOptionIndex) override;
+
+    /** Creates a writer that spreads the work of encoding across several threads.
+
+        The stream is divided into runs of frames which are compressed concurrently by
+        a set of background threads, and then written out in order, so the result is a
+        normal FLAC file that any decoder can read. The writer's destructor waits for any
+        runs that are still being encoded, and like the normal writer, it needs an
+        output stream that can seek back to the start to update the header.
+
+        If numThreads is less than 2, or if JUCE is using an external copy of libFLAC
+        rather than its own, this just returns a normal writer.
+
+        @see createWriterFor
+    */
+    AudioFormatWriter* createMultiThreadedWriterFor (OutputStream* streamToWriteTo,
+                                                     double sampleRateToUse,
+                                                     unsigned int numberOfChannels,
+                                                     int bitsPerSample,
+                                                     int qualityOptionIndex,
+                                                     int numThreads);
+
 private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FlacAudioFormat)
 };
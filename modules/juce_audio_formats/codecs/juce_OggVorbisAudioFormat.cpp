@@ -159,6 +159,14 @@ public:
     //==============================================================================
     bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
                       int64 startSampleInFile, int numSamples) override
+    {
+        // (this format is floating-point, so the int buffers are just filled with floats)
+        return readFloatSamples (reinterpret_cast<float**> (destSamples), numDestChannels,
+                                 startOffsetInDestBuffer, startSampleInFile, numSamples);
+    }
+
+    bool readFloatSamples (float** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                           int64 startSampleInFile, int numSamples) override
     {
         while (numSamples > 0)
         {
@@ -229,7 +237,7 @@ public:
         {
             for (int i = numDestChannels; --i >= 0;)
                 if (destSamples[i] != nullptr)
-                    zeromem (destSamples[i] + startOffsetInDestBuffer, sizeof (int) * (size_t) numSamples);
+                    zeromem (destSamples[i] + startOffsetInDestBuffer, sizeof (float) * (size_t) numSamples);
         }
 
         return true;
@@ -0,0 +1,498 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+static const char* const rawPCMFormatName = "Raw PCM file";
+
+//==============================================================================
+class RawPCMAudioFormatReader  : public AudioFormatReader
+{
+public:
+    RawPCMAudioFormatReader (InputStream* const in, const RawPCMAudioFormat& format)
+        : AudioFormatReader (in, rawPCMFormatName),
+          dataStart (format.dataStartOffset),
+          littleEndian (format.littleEndian)
+    {
+        sampleRate = format.sampleRate;
+        numChannels = (unsigned int) format.numChannels;
+        bitsPerSample = (unsigned int) format.bitsPerSample;
+        usesFloatingPointData = format.floatingPoint;
+        bytesPerFrame = (int) (numChannels * bitsPerSample / 8);
+
+        const int64 totalLength = input->getTotalLength();
+
+        if (bytesPerFrame > 0 && totalLength > dataStart)
+            lengthInSamples = (totalLength - dataStart) / bytesPerFrame;
+    }
+
+    //==============================================================================
+    bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                      int64 startSampleInFile, int numSamples) override
+    {
+        return readSampleData (destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
+    }
+
+    bool readFloatSamples (float** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                           int64 startSampleInFile, int numSamples) override
+    {
+        return readSampleData (destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
+    }
+
+    template <typename SampleType>
+    bool readSampleData (SampleType** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                         int64 startSampleInFile, int numSamples)
+    {
+        clearSamplesBeyondAvailableLength (destSamples, numDestChannels, startOffsetInDestBuffer,
+                                           startSampleInFile, numSamples, lengthInSamples);
+
+        if (numSamples <= 0)
+            return true;
+
+        input->setPosition (dataStart + startSampleInFile * bytesPerFrame);
+
+        while (numSamples > 0)
+        {
+            const int tempBufSize = 480 * 3 * 4; // (keep this a multiple of 3)
+            char tempBuffer [tempBufSize];
+
+            const int numThisTime = jmin (tempBufSize / bytesPerFrame, numSamples);
+            const int bytesRead = input->read (tempBuffer, numThisTime * bytesPerFrame);
+
+            if (bytesRead < numThisTime * bytesPerFrame)
+            {
+                jassert (bytesRead >= 0);
+                zeromem (tempBuffer + bytesRead, (size_t) (numThisTime * bytesPerFrame - bytesRead));
+            }
+
+            RawPCMAudioFormatReader::copySampleData (littleEndian, bitsPerSample, usesFloatingPointData,
+                                           destSamples, startOffsetInDestBuffer, numDestChannels,
+                                           tempBuffer, (int) numChannels, numThisTime);
+
+            startOffsetInDestBuffer += numThisTime;
+            numSamples -= numThisTime;
+        }
+
+        return true;
+    }
+
+    const int64 dataStart;
+    const bool littleEndian;
+    int bytesPerFrame;
+
+    //==============================================================================
+    template <typename Endianness>
+    static void copySampleData (unsigned int bitsPerSample, const bool usesFloatingPointData,
+                                int* const* destSamples, int startOffsetInDestBuffer, int numDestChannels,
+                                const void* sourceData, int numChannels, int numSamples) noexcept
+    {
+        switch (bitsPerSample)
+        {
+            case 8:     ReadHelper<AudioData::Int32, AudioData::Int8,  Endianness>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples); break;
+            case 16:    ReadHelper<AudioData::Int32, AudioData::Int16, Endianness>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples); break;
+            case 24:    ReadHelper<AudioData::Int32, AudioData::Int24, Endianness>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples); break;
+            case 32:    if (usesFloatingPointData) ReadHelper<AudioData::Float32, AudioData::Float32, Endianness>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples);
+                        else                       ReadHelper<AudioData::Int32,   AudioData::Int32,   Endianness>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples);
+                        break;
+            default:    jassertfalse; break;
+        }
+    }
+
+    template <typename Endianness>
+    static void copySampleData (unsigned int bitsPerSample, const bool usesFloatingPointData,
+                                float* const* destSamples, int startOffsetInDestBuffer, int numDestChannels,
+                                const void* sourceData, int numChannels, int numSamples) noexcept
+    {
+        switch (bitsPerSample)
+        {
+            case 8:     ReadHelper<AudioData::Float32, AudioData::Int8,  Endianness>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples); break;
+            case 16:    ReadHelper<AudioData::Float32, AudioData::Int16, Endianness>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples); break;
+            case 24:    ReadHelper<AudioData::Float32, AudioData::Int24, Endianness>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples); break;
+            case 32:    if (usesFloatingPointData) ReadHelper<AudioData::Float32, AudioData::Float32, Endianness>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples);
+                        else                       ReadHelper<AudioData::Float32, AudioData::Int32,   Endianness>::read (destSamples, startOffsetInDestBuffer, numDestChannels, sourceData, numChannels, numSamples);
+                        break;
+            default:    jassertfalse; break;
+        }
+    }
+
+    template <typename SampleType>
+    static void copySampleData (const bool isLittleEndian, unsigned int bitsPerSample, const bool usesFloatingPointData,
+                                SampleType* const* destSamples, int startOffsetInDestBuffer, int numDestChannels,
+                                const void* sourceData, int numChannels, int numSamples) noexcept
+    {
+        if (isLittleEndian)
+            copySampleData<AudioData::LittleEndian> (bitsPerSample, usesFloatingPointData, destSamples, startOffsetInDestBuffer,
+                                                     numDestChannels, sourceData, numChannels, numSamples);
+        else
+            copySampleData<AudioData::BigEndian> (bitsPerSample, usesFloatingPointData, destSamples, startOffsetInDestBuffer,
+                                                  numDestChannels, sourceData, numChannels, numSamples);
+    }
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RawPCMAudioFormatReader)
+};
+
+//==============================================================================
+class RawPCMAudioFormatWriter  : public AudioFormatWriter
+{
+public:
+    RawPCMAudioFormatWriter (OutputStream* const out, const RawPCMAudioFormat& format)
+        : AudioFormatWriter (out, rawPCMFormatName, format.sampleRate,
+                             (unsigned int) format.numChannels, (unsigned int) format.bitsPerSample),
+          littleEndian (format.littleEndian),
+          writeFailed (false)
+    {
+        usesFloatingPointData = format.floatingPoint;
+    }
+
+    //==============================================================================
+    bool write (const int** data, int numSamples) override
+    {
+        jassert (numSamples >= 0);
+        jassert (data != nullptr && *data != nullptr); // the input must contain at least one channel!
+
+        if (writeFailed)
+            return false;
+
+        const size_t bytes = numChannels * (unsigned int) numSamples * bitsPerSample / 8;
+        tempBlock.ensureSize (bytes, false);
+
+        if (littleEndian)
+            convertSamples<AudioData::LittleEndian> (data, numSamples);
+        else
+            convertSamples<AudioData::BigEndian> (data, numSamples);
+
+        if (! output->write (tempBlock.getData(), bytes))
+        {
+            writeFailed = true;
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    MemoryBlock tempBlock;
+    const bool littleEndian;
+    bool writeFailed;
+
+    template <typename Endianness>
+    void convertSamples (const int** data, int numSamples)
+    {
+        void* const dest = tempBlock.getData();
+        const int numChans = (int) numChannels;
+
+        switch (bitsPerSample)
+        {
+            case 8:     WriteHelper<AudioData::Int8,  AudioData::Int32, Endianness>::write (dest, numChans, data, numSamples); break;
+            case 16:    WriteHelper<AudioData::Int16, AudioData::Int32, Endianness>::write (dest, numChans, data, numSamples); break;
+            case 24:    WriteHelper<AudioData::Int24, AudioData::Int32, Endianness>::write (dest, numChans, data, numSamples); break;
+            case 32:    if (usesFloatingPointData) WriteHelper<AudioData::Float32, AudioData::Float32, Endianness>::write (dest, numChans, data, numSamples);
+                        else                       WriteHelper<AudioData::Int32,   AudioData::Int32,   Endianness>::write (dest, numChans, data, numSamples);
+                        break;
+            default:    jassertfalse; break;
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RawPCMAudioFormatWriter)
+};
+
+//==============================================================================
+class MemoryMappedRawPCMReader   : public MemoryMappedAudioFormatReader
+{
+public:
+    MemoryMappedRawPCMReader (const File& f, const RawPCMAudioFormatReader& reader)
+        : MemoryMappedAudioFormatReader (f, reader, reader.dataStart,
+                                         reader.bytesPerFrame * reader.lengthInSamples, reader.bytesPerFrame),
+          littleEndian (reader.littleEndian)
+    {
+    }
+
+    bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                      int64 startSampleInFile, int numSamples) override
+    {
+        return readSampleData (destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
+    }
+
+    bool readFloatSamples (float** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                           int64 startSampleInFile, int numSamples) override
+    {
+        return readSampleData (destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
+    }
+
+    template <typename SampleType>
+    bool readSampleData (SampleType** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                         int64 startSampleInFile, int numSamples)
+    {
+        clearSamplesBeyondAvailableLength (destSamples, numDestChannels, startOffsetInDestBuffer,
+                                           startSampleInFile, numSamples, lengthInSamples);
+
+        if (map == nullptr || ! mappedSection.contains (Range<int64> (startSampleInFile, startSampleInFile + numSamples)))
+        {
+            jassertfalse; // you must make sure that the window contains all the samples you're going to attempt to read.
+            return false;
+        }
+
+        RawPCMAudioFormatReader::copySampleData (littleEndian, bitsPerSample, usesFloatingPointData,
+                                       destSamples, startOffsetInDestBuffer, numDestChannels,
+                                       sampleToPointer (startSampleInFile), (int) numChannels, numSamples);
+        return true;
+    }
+
+    void readMaxLevels (int64 startSampleInFile, int64 numSamples,
+                        float& min0, float& max0, float& min1, float& max1) override
+    {
+        if (numSamples <= 0)
+        {
+            min0 = max0 = min1 = max1 = 0;
+            return;
+        }
+
+        if (map == nullptr || ! mappedSection.contains (Range<int64> (startSampleInFile, startSampleInFile + numSamples)))
+        {
+            jassertfalse; // you must make sure that the window contains all the samples you're going to attempt to read.
+
+            min0 = max0 = min1 = max1 = 0;
+            return;
+        }
+
+        switch (bitsPerSample)
+        {
+            case 8:     scanMinAndMax<AudioData::Int8>  (startSampleInFile, numSamples, min0, max0, min1, max1); break;
+            case 16:    scanMinAndMax<AudioData::Int16> (startSampleInFile, numSamples, min0, max0, min1, max1); break;
+            case 24:    scanMinAndMax<AudioData::Int24> (startSampleInFile, numSamples, min0, max0, min1, max1); break;
+            case 32:    if (usesFloatingPointData) scanMinAndMax<AudioData::Float32> (startSampleInFile, numSamples, min0, max0, min1, max1);
+                        else                       scanMinAndMax<AudioData::Int32>   (startSampleInFile, numSamples, min0, max0, min1, max1);
+                        break;
+            default:    jassertfalse; break;
+        }
+    }
+
+private:
+    const bool littleEndian;
+
+    template <typename SampleType>
+    void scanMinAndMax (int64 startSampleInFile, int64 numSamples,
+                        float& min0, float& max0, float& min1, float& max1) const noexcept
+    {
+        scanMinAndMax2<SampleType> (0, startSampleInFile, numSamples, min0, max0);
+
+        if (numChannels > 1)
+            scanMinAndMax2<SampleType> (1, startSampleInFile, numSamples, min1, max1);
+        else
+            min1 = max1 = 0;
+    }
+
+    template <typename SampleType>
+    void scanMinAndMax2 (int channel, int64 startSampleInFile, int64 numSamples, float& mn, float& mx) const noexcept
+    {
+        if (littleEndian)
+            scanMinAndMaxInterleaved<SampleType, AudioData::LittleEndian> (channel, startSampleInFile, numSamples, mn, mx);
+        else
+            scanMinAndMaxInterleaved<SampleType, AudioData::BigEndian>    (channel, startSampleInFile, numSamples, mn, mx);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MemoryMappedRawPCMReader)
+};
+
+//==============================================================================
+RawPCMAudioFormat::RawPCMAudioFormat (const double rate, const int numChans, const int bits,
+                                      const bool isLittleEndian, const bool isFloatingPoint,
+                                      const int64 dataStart)
+    : AudioFormat (rawPCMFormatName, ".raw .pcm"),
+      sampleRate (rate), numChannels (numChans), bitsPerSample (bits),
+      littleEndian (isLittleEndian), floatingPoint (isFloatingPoint),
+      dataStartOffset (dataStart)
+{
+    jassert (numChans > 0);
+    jassert (bits == 8 || bits == 16 || bits == 24 || bits == 32);
+    jassert (bits == 32 || ! isFloatingPoint); // floating-point data must be 32-bit
+}
+
+RawPCMAudioFormat::~RawPCMAudioFormat()
+{
+}
+
+Array<int> RawPCMAudioFormat::getPossibleSampleRates()
+{
+    Array<int> rates;
+    rates.add (roundToInt (sampleRate));
+    return rates;
+}
+
+Array<int> RawPCMAudioFormat::getPossibleBitDepths()
+{
+    Array<int> depths;
+    depths.add (bitsPerSample);
+    return depths;
+}
+
+bool RawPCMAudioFormat::canDoStereo()   { return numChannels == 2; }
+bool RawPCMAudioFormat::canDoMono()     { return numChannels == 1; }
+
+AudioFormatReader* RawPCMAudioFormat::createReaderFor (InputStream* sourceStream, const bool deleteStreamIfOpeningFails)
+{
+    ScopedPointer<RawPCMAudioFormatReader> r (new RawPCMAudioFormatReader (sourceStream, *this));
+
+    if (r->sampleRate > 0 && r->numChannels > 0 && r->bytesPerFrame > 0)
+        return r.release();
+
+    if (! deleteStreamIfOpeningFails)
+        r->input = nullptr;
+
+    return nullptr;
+}
+
+MemoryMappedAudioFormatReader* RawPCMAudioFormat::createMemoryMappedReader (const File& file)
+{
+    if (FileInputStream* fin = file.createInputStream())
+    {
+        RawPCMAudioFormatReader reader (fin, *this);
+
+        if (reader.lengthInSamples > 0)
+            return new MemoryMappedRawPCMReader (file, reader);
+    }
+
+    return nullptr;
+}
+
+AudioFormatWriter* RawPCMAudioFormat::createWriterFor (OutputStream* out,
+                                                       double rate,
+                                                       unsigned int numberOfChannels,
+                                                       int bits,
+                                                       const StringPairArray& /*metadataValues*/,
+                                                       int /*qualityOptionIndex*/)
+{
+    if (out != nullptr && bits == bitsPerSample && (int) numberOfChannels == numChannels
+         && roundToInt (rate) == roundToInt (sampleRate))
+        return new RawPCMAudioFormatWriter (out, *this);
+
+    return nullptr;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class RawPCMAudioFormatTests  : public UnitTest
+{
+public:
+    RawPCMAudioFormatTests() : UnitTest ("RawPCMAudioFormat") {}
+
+    void runTest()
+    {
+        beginTest ("Stream and memory-mapped readers match the written data");
+
+        Random random (getRandom());
+
+        testFormat (random, 44100.0, 2, 16, true,  false);
+        testFormat (random, 44100.0, 2, 16, false, false);
+        testFormat (random, 48000.0, 1, 24, false, false);
+        testFormat (random, 48000.0, 3, 8,  true,  false);
+        testFormat (random, 96000.0, 2, 32, true,  true);
+        testFormat (random, 96000.0, 2, 32, false, true);
+    }
+
+private:
+    static bool writeTestFile (Random& random, RawPCMAudioFormat& format, const File& file,
+                               AudioSampleBuffer& buffer)
+    {
+        file.deleteFile();
+
+        const int numChannels = buffer.getNumChannels();
+        const int numSamples = buffer.getNumSamples();
+
+        for (int chan = 0; chan < numChannels; ++chan)
+            for (int i = 0; i < numSamples; ++i)
+                *buffer.getSampleData (chan, i) = random.nextFloat() * 1.8f - 0.9f;
+
+        ScopedPointer<AudioFormatWriter> writer (format.createWriterFor (file.createOutputStream(),
+                                                                         format.getPossibleSampleRates()[0],
+                                                                         (unsigned int) numChannels,
+                                                                         format.getPossibleBitDepths()[0],
+                                                                         StringPairArray(), 0));
+
+        return writer != nullptr && writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+    }
+
+    void testFormat (Random& random, double sampleRate, int numChannels, int bitsPerSample,
+                     bool isLittleEndian, bool isFloatingPoint)
+    {
+        RawPCMAudioFormat format (sampleRate, numChannels, bitsPerSample, isLittleEndian, isFloatingPoint);
+
+        const int numSamples = 5000 + random.nextInt (20000);
+        AudioSampleBuffer written (numChannels, numSamples);
+        TemporaryFile tempFile (".raw");
+        expect (writeTestFile (random, format, tempFile.getFile(), written));
+
+        // (the written data gets quantised to the file's bit depth, so allow for a
+        // couple of steps of rounding error, or float precision for 32-bit ints)
+        const float tolerance = isFloatingPoint ? 0.0f
+                                                : jmax (1.0e-7f, 2.0f / (float) ((int64) 1 << (bitsPerSample - 1)));
+
+        ScopedPointer<AudioFormatReader> streamReader (format.createReaderFor (tempFile.getFile().createInputStream(), true));
+        ScopedPointer<MemoryMappedAudioFormatReader> mappedReader (format.createMemoryMappedReader (tempFile.getFile()));
+
+        expect (streamReader != nullptr && mappedReader != nullptr);
+
+        if (streamReader == nullptr || mappedReader == nullptr)
+            return;
+
+        expectEquals (streamReader->lengthInSamples, (int64) numSamples);
+        expectEquals (mappedReader->lengthInSamples, (int64) numSamples);
+        expect (mappedReader->mapEntireFile());
+
+        AudioSampleBuffer streamData (numChannels, numSamples), mappedData (numChannels, numSamples);
+
+        for (int i = 0; i < 20; ++i)
+        {
+            const int start = random.nextInt (numSamples);
+            const int num = random.nextInt (numSamples - start) + 1;
+
+            mappedReader->prefetchSamples (Range<int64> (start, start + num));
+
+            streamReader->read (&streamData, 0, num, start, true, true);
+            mappedReader->read (&mappedData, 0, num, start, true, true);
+
+            bool readersMatch = true;
+            float maxError = 0;
+
+            for (int chan = 0; chan < numChannels; ++chan)
+            {
+                const float* const streamed = streamData.getSampleData (chan);
+                const float* const expected = written.getSampleData (chan, start);
+
+                if (memcmp (streamed, mappedData.getSampleData (chan), sizeof (float) * (size_t) num) != 0)
+                    readersMatch = false;
+
+                for (int j = 0; j < num; ++j)
+                    maxError = jmax (maxError, std::abs (streamed[j] - expected[j]));
+            }
+
+            expect (readersMatch);
+            expect (maxError <= tolerance, "error " + String (maxError) + " at " + String (bitsPerSample) + " bits");
+        }
+    }
+};
+
+static RawPCMAudioFormatTests rawPCMAudioFormatTests;
+
+#endif
@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+//==============================================================================
+/**
+    Reads and writes headerless files of interleaved PCM samples.
+
+    A raw file has no header to describe its contents, so the layout of the data is
+    given to the format object's constructor instead, and all readers and writers that
+    it creates will use that layout.
+
+    Because it will try to read any stream that it's given, this format shouldn't be
+    registered with an AudioFormatManager alongside other formats.
+
+    @see AudioFormat
+*/
+class JUCE_API  RawPCMAudioFormat  : public AudioFormat
+{
+public:
+    //==============================================================================
+    /** Creates a format object for a particular data layout.
+
+        @param sampleRate       the sample rate to report for files that are read
+        @param numChannels      the number of interleaved channels in each frame
+        @param bitsPerSample    the size of each sample - 8, 16, 24 or 32. 8-bit data is signed
+        @param isLittleEndian   the byte order of the samples
+        @param isFloatingPoint  if true, the data is 32-bit IEEE floating point
+        @param dataStartOffset  the number of bytes to skip at the start of the file, e.g. to
+                                step over a header that the format doesn't understand
+    */
+    RawPCMAudioFormat (double sampleRate,
+                       int numChannels,
+                       int bitsPerSample,
+                       bool isLittleEndian = true,
+                       bool isFloatingPoint = false,
+                       int64 dataStartOffset = 0);
+
+    /** Destructor. */
+    ~RawPCMAudioFormat();
+
+    //==============================================================================
+    Array<int> getPossibleSampleRates() override;
+    Array<int> getPossibleBitDepths() override;
+    bool canDoStereo() override;
+    bool canDoMono() override;
+
+    //==============================================================================
+    AudioFormatReader* createReaderFor (InputStream* sourceStream,
+                                        bool deleteStreamIfOpeningFails) override;
+
+    MemoryMappedAudioFormatReader* createMemoryMappedReader (const File&) override;
+
+    /** Creates a writer which writes samples using this format's layout.
+        The sample rate and number of channels must match the ones given to the constructor.
+    */
+    AudioFormatWriter* createWriterFor (OutputStream* streamToWriteTo,
+                                        double sampleRateToUse,
+                                        unsigned int numberOfChannels,
+                                        int bitsPerSample,
+                                        const StringPairArray& metadataValues,
+                                        int qualityOptionIndex) override;
+
+private:
+    const double sampleRate;
+    const int numChannels, bitsPerSample;
+    const bool littleEndian, floatingPoint;
+    const int64 dataStartOffset;
+
+    friend class RawPCMAudioFormatReader;
+    friend class RawPCMAudioFormatWriter;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RawPCMAudioFormat)
+};
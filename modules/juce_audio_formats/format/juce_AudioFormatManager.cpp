@@ -145,6 +145,24 @@ AudioFormatReader* AudioFormatManager::createReaderFor (const File& file)
     return nullptr;
 }
 
+bool AudioFormatManager::readIntoBuffer (const File& file, AudioSampleBuffer& destBuffer,
+                                         double& sampleRate, const int maxNumSamples)
+{
+    const ScopedPointer<AudioFormatReader> reader (createReaderFor (file));
+
+    if (reader == nullptr || reader->numChannels == 0)
+        return false;
+
+    const int numSamples = (int) jlimit ((int64) 0, (int64) maxNumSamples, reader->lengthInSamples);
+    destBuffer.setSize ((int) reader->numChannels, numSamples);
+
+    if (! reader->read (destBuffer.getArrayOfChannels(), destBuffer.getNumChannels(), 0, numSamples, false))
+        return false;
+
+    sampleRate = reader->sampleRate;
+    return true;
+}
+
 AudioFormatReader* AudioFormatManager::createReaderFor (InputStream* audioFileStream)
 {
     // you need to actually register some formats before the manager can
@@ -131,6 +131,18 @@ public:
     */
     AudioFormatReader* createReaderFor (InputStream* audioFileStream);
 
+    /** Reads the whole of an audio file into a buffer.
+
+        This is handy for short files such as impulse responses (see ConvolutionAudioSource).
+        The buffer will be resized to match the file's number of channels and length, but
+        no more than maxNumSamples will be read.
+
+        @returns true if the file could be opened and read, in which case sampleRate
+                 will be set to the file's sample rate
+    */
+    bool readIntoBuffer (const File& audioFile, AudioSampleBuffer& destBuffer,
+                         double& sampleRate, int maxNumSamples = 0x7fffffff);
+
 private:
     //==============================================================================
     OwnedArray<AudioFormat> knownFormats;
@@ -38,75 +38,130 @@ AudioFormatReader::~AudioFormatReader()
     delete input;
 }
 
-bool AudioFormatReader::read (int* const* destSamples,
-                              int numDestChannels,
-                              int64 startSampleInSource,
-                              int numSamplesToRead,
-                              const bool fillLeftoverChannelsWithCopies)
+namespace AudioFormatReaderHelpers
 {
-    jassert (numDestChannels > 0); // you have to actually give this some channels to work with!
+    static bool readSamples (AudioFormatReader& reader, int** destSamples, int numDestChannels,
+                             int startOffsetInDestBuffer, int64 startSampleInFile, int numSamples)
+    {
+        return reader.readSamples (destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
+    }
 
-    int startOffsetInDestBuffer = 0;
+    static bool readSamples (AudioFormatReader& reader, float** destSamples, int numDestChannels,
+                             int startOffsetInDestBuffer, int64 startSampleInFile, int numSamples)
+    {
+        return reader.readFloatSamples (destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
+    }
 
-    if (startSampleInSource < 0)
+    template <typename SampleType>
+    static bool read (AudioFormatReader& reader,
+                      SampleType* const* destSamples,
+                      int numDestChannels,
+                      int64 startSampleInSource,
+                      int numSamplesToRead,
+                      const bool fillLeftoverChannelsWithCopies)
     {
-        const int silence = (int) jmin (-startSampleInSource, (int64) numSamplesToRead);
+        jassert (numDestChannels > 0); // you have to actually give this some channels to work with!
 
-        for (int i = numDestChannels; --i >= 0;)
-            if (destSamples[i] != nullptr)
-                zeromem (destSamples[i], sizeof (int) * (size_t) silence);
+        const int numChannels = (int) reader.numChannels;
+        int startOffsetInDestBuffer = 0;
 
-        startOffsetInDestBuffer += silence;
-        numSamplesToRead -= silence;
-        startSampleInSource = 0;
-    }
+        if (startSampleInSource < 0)
+        {
+            const int silence = (int) jmin (-startSampleInSource, (int64) numSamplesToRead);
 
-    if (numSamplesToRead <= 0)
-        return true;
+            for (int i = numDestChannels; --i >= 0;)
+                if (destSamples[i] != nullptr)
+                    zeromem (destSamples[i], sizeof (SampleType) * (size_t) silence);
 
-    if (! readSamples (const_cast <int**> (destSamples),
-                       jmin ((int) numChannels, numDestChannels), startOffsetInDestBuffer,
-                       startSampleInSource, numSamplesToRead))
-        return false;
+            startOffsetInDestBuffer += silence;
+            numSamplesToRead -= silence;
+            startSampleInSource = 0;
+        }
 
-    if (numDestChannels > (int) numChannels)
-    {
-        if (fillLeftoverChannelsWithCopies)
-        {
-            int* lastFullChannel = destSamples[0];
+        if (numSamplesToRead <= 0)
+            return true;
+
+        if (! readSamples (reader, const_cast <SampleType**> (destSamples),
+                           jmin (numChannels, numDestChannels), startOffsetInDestBuffer,
+                           startSampleInSource, numSamplesToRead))
+            return false;
 
-            for (int i = (int) numChannels; --i > 0;)
+        if (numDestChannels > numChannels)
+        {
+            if (fillLeftoverChannelsWithCopies)
             {
-                if (destSamples[i] != nullptr)
+                SampleType* lastFullChannel = destSamples[0];
+
+                for (int i = numChannels; --i > 0;)
                 {
-                    lastFullChannel = destSamples[i];
-                    break;
+                    if (destSamples[i] != nullptr)
+                    {
+                        lastFullChannel = destSamples[i];
+                        break;
+                    }
                 }
-            }
 
-            if (lastFullChannel != nullptr)
-                for (int i = (int) numChannels; i < numDestChannels; ++i)
+                if (lastFullChannel != nullptr)
+                    for (int i = numChannels; i < numDestChannels; ++i)
+                        if (destSamples[i] != nullptr)
+                            memcpy (destSamples[i], lastFullChannel, sizeof (SampleType) * (size_t) numSamplesToRead);
+            }
+            else
+            {
+                for (int i = numChannels; i < numDestChannels; ++i)
                     if (destSamples[i] != nullptr)
-                        memcpy (destSamples[i], lastFullChannel, sizeof (int) * (size_t) numSamplesToRead);
-        }
-        else
-        {
-            for (int i = (int) numChannels; i < numDestChannels; ++i)
-                if (destSamples[i] != nullptr)
-                    zeromem (destSamples[i], sizeof (int) * (size_t) numSamplesToRead);
+                        zeromem (destSamples[i], sizeof (SampleType) * (size_t) numSamplesToRead);
+            }
         }
+
+        return true;
     }
+}
+
+bool AudioFormatReader::read (int* const* destSamples,
+                              int numDestChannels,
+                              int64 startSampleInSource,
+                              int numSamplesToRead,
+                              const bool fillLeftoverChannelsWithCopies)
+{
+    return AudioFormatReaderHelpers::read (*this, destSamples, numDestChannels, startSampleInSource,
+                                           numSamplesToRead, fillLeftoverChannelsWithCopies);
+}
+
+bool AudioFormatReader::read (float* const* destSamples,
+                              int numDestChannels,
+                              int64 startSampleInSource,
+                              int numSamplesToRead,
+                              const bool fillLeftoverChannelsWithCopies)
+{
+    return AudioFormatReaderHelpers::read (*this, destSamples, numDestChannels, startSampleInSource,
+                                           numSamplesToRead, fillLeftoverChannelsWithCopies);
+}
+
+bool AudioFormatReader::readFloatSamples (float** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                                          int64 startSampleInFile, int numSamples)
+{
+    if (! readSamples (reinterpret_cast<int**> (destSamples), numDestChannels,
+                       startOffsetInDestBuffer, startSampleInFile, numSamples))
+        return false;
+
+    if (! usesFloatingPointData)
+        for (int i = numDestChannels; --i >= 0;)
+            if (float* const d = destSamples[i])
+                FloatVectorOperations::convertFixedToFloat (d + startOffsetInDestBuffer,
+                                                            reinterpret_cast<const int*> (d + startOffsetInDestBuffer),
+                                                            1.0f / 0x7fffffff, numSamples);
 
     return true;
 }
 
 static void readChannels (AudioFormatReader& reader,
-                          int** const chans, AudioSampleBuffer* const buffer,
+                          float** const chans, AudioSampleBuffer* const buffer,
                           const int startSample, const int numSamples,
                           const int64 readerStartSample, const int numTargetChannels)
 {
     for (int j = 0; j < numTargetChannels; ++j)
-        chans[j] = reinterpret_cast<int*> (buffer->getSampleData (j, startSample));
+        chans[j] = buffer->getSampleData (j, startSample);
 
     chans[numTargetChannels] = nullptr;
     reader.read (chans, numTargetChannels, readerStartSample, numSamples, true);
@@ -128,9 +183,9 @@ void AudioFormatReader::read (AudioSampleBuffer* buffer,
 
         if (numTargetChannels <= 2)
         {
-            int* const dest0 = reinterpret_cast<int*> (buffer->getSampleData (0, startSample));
-            int* const dest1 = reinterpret_cast<int*> (numTargetChannels > 1 ? buffer->getSampleData (1, startSample) : nullptr);
-            int* chans[3];
+            float* const dest0 = buffer->getSampleData (0, startSample);
+            float* const dest1 = numTargetChannels > 1 ? buffer->getSampleData (1, startSample) : nullptr;
+            float* chans[3];
 
             if (useReaderLeftChan == useReaderRightChan)
             {
@@ -157,19 +212,14 @@ void AudioFormatReader::read (AudioSampleBuffer* buffer,
         }
         else if (numTargetChannels <= 64)
         {
-            int* chans[65];
+            float* chans[65];
             readChannels (*this, chans, buffer, startSample, numSamples, readerStartSample, numTargetChannels);
         }
         else
         {
-            HeapBlock<int*> chans (numTargetChannels);
+            HeapBlock<float*> chans (numTargetChannels + 1);
             readChannels (*this, chans, buffer, startSample, numSamples, readerStartSample, numTargetChannels);
         }
-
-        if (! usesFloatingPointData)
-            for (int j = 0; j < numTargetChannels; ++j)
-                if (float* const d = buffer->getSampleData (j, startSample))
-                    FloatVectorOperations::convertFixedToFloat (d, reinterpret_cast<const int*> (d), 1.0f / 0x7fffffff, numSamples);
     }
 }
 
@@ -393,7 +443,8 @@ int64 AudioFormatReader::searchForLevel (int64 startSample,
 MemoryMappedAudioFormatReader::MemoryMappedAudioFormatReader (const File& f, const AudioFormatReader& reader,
                                                               int64 start, int64 length, int frameSize)
     : AudioFormatReader (nullptr, reader.getFormatName()), file (f),
-      dataChunkStart (start), dataLength (length), bytesPerFrame (frameSize)
+      dataChunkStart (start), dataLength (length), bytesPerFrame (frameSize),
+      accessPattern (MemoryMappedFile::normalAccess)
 {
     sampleRate      = reader.sampleRate;
     bitsPerSample   = reader.bitsPerSample;
@@ -420,15 +471,38 @@ bool MemoryMappedAudioFormatReader::mapSectionOfFile (Range<int64> samplesToMap)
         map = new MemoryMappedFile (file, fileRange, MemoryMappedFile::readOnly);
 
         if (map->getData() == nullptr)
+        {
             map = nullptr;
+        }
         else
+        {
             mappedSection = Range<int64> (jmax ((int64) 0, filePosToSample (map->getRange().getStart() + (bytesPerFrame - 1))),
                                           jmin (lengthInSamples, filePosToSample (map->getRange().getEnd())));
+
+            map->setAccessPattern (accessPattern);
+        }
     }
 
     return map != nullptr;
 }
 
+void MemoryMappedAudioFormatReader::setAccessPattern (const MemoryMappedFile::AccessPattern pattern) noexcept
+{
+    accessPattern = pattern;
+
+    if (map != nullptr)
+        map->setAccessPattern (pattern);
+}
+
+void MemoryMappedAudioFormatReader::prefetchSamples (Range<int64> samplesToPrefetch) const noexcept
+{
+    samplesToPrefetch = samplesToPrefetch.getIntersectionWith (mappedSection);
+
+    if (map != nullptr && ! samplesToPrefetch.isEmpty())
+        map->prefetch (Range<int64> (sampleToFilePos (samplesToPrefetch.getStart()),
+                                     sampleToFilePos (samplesToPrefetch.getEnd())));
+}
+
 static int memoryReadDummyVariable; // used to force the compiler not to optimise-away the read operation
 
 void MemoryMappedAudioFormatReader::touchSample (int64 sample) const noexcept
@@ -438,3 +512,85 @@ void MemoryMappedAudioFormatReader::touchSample (int64 sample) const noexcept
     else
         jassertfalse; // you must make sure that the window contains all the samples you're going to attempt to read.
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AudioFormatReaderTests  : public UnitTest
+{
+public:
+    AudioFormatReaderTests() : UnitTest ("AudioFormatReader") {}
+
+    void runTest()
+    {
+        beginTest ("Floating-point and integer reads match");
+
+        enum { numChannels = 2, numSamples = 20000, maxBlockSize = 3000 };
+
+        Random r (getRandom());
+        AudioSampleBuffer source (numChannels, numSamples);
+
+        for (int chan = 0; chan < numChannels; ++chan)
+            for (int i = 0; i < numSamples; ++i)
+                source.getSampleData (chan)[i] = 0.8f * (float) std::sin (i * (chan + 1) * 0.01) + 0.1f * (r.nextFloat() - 0.5f);
+
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        HeapBlock<int> intData ((size_t) (numChannels * maxBlockSize));
+        AudioSampleBuffer expected (numChannels, maxBlockSize), actual (numChannels, maxBlockSize);
+
+        for (int i = 0; i < formatManager.getNumKnownFormats(); ++i)
+        {
+            AudioFormat* const format = formatManager.getKnownFormat (i);
+            const Array<int> bitDepths (format->getPossibleBitDepths());
+
+            for (int j = 0; j < bitDepths.size(); ++j)
+            {
+                MemoryBlock data;
+
+                {
+                    ScopedPointer<AudioFormatWriter> writer (format->createWriterFor (new MemoryOutputStream (data, false), 44100.0,
+                                                                                      numChannels, bitDepths.getUnchecked (j),
+                                                                                      StringPairArray(), 0));
+                    if (writer == nullptr)
+                        continue;
+
+                    writer->writeFromAudioSampleBuffer (source, 0, numSamples);
+                }
+
+                ScopedPointer<AudioFormatReader> reader (format->createReaderFor (new MemoryInputStream (data, false), true));
+                expect (reader != nullptr);
+
+                if (reader == nullptr)
+                    continue;
+
+                // read some random blocks, including some that run off either end of the file..
+                for (int block = 0; block < 30; ++block)
+                {
+                    const int64 start = r.nextInt (numSamples + maxBlockSize) - maxBlockSize / 2;
+                    const int num = 1 + r.nextInt (maxBlockSize);
+
+                    int* const intChans[] = { intData, intData + maxBlockSize };
+                    reader->read (intChans, numChannels, start, num, false);
+                    reader->read (actual.getArrayOfChannels(), numChannels, start, num, false);
+
+                    for (int chan = 0; chan < numChannels; ++chan)
+                    {
+                        if (reader->usesFloatingPointData)
+                            memcpy (expected.getSampleData (chan), intChans[chan], sizeof (float) * (size_t) num);
+                        else
+                            FloatVectorOperations::convertFixedToFloat (expected.getSampleData (chan), intChans[chan], 1.0f / 0x7fffffff, num);
+
+                        expect (memcmp (expected.getSampleData (chan), actual.getSampleData (chan), sizeof (float) * (size_t) num) == 0,
+                                format->getFormatName() + ", " + String (bitDepths.getUnchecked (j)) + " bit");
+                    }
+                }
+            }
+        }
+    }
+};
+
+static AudioFormatReaderTests audioFormatReaderTests;
+
+#endif
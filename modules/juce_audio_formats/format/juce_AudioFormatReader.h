@@ -107,6 +107,22 @@ public:
                int numSamplesToRead,
                bool fillLeftoverChannelsWithCopies);
 
+    /** Reads samples from the stream as floating-point data.
+
+        This works in the same way as the other read() method, except that the
+        buffers are always filled with floating-point values in the range -1.0 to 1.0
+        (or beyond), whatever format the source uses. Readers which are able to will
+        decode directly into these buffers, so this avoids the extra pass that's needed
+        to convert the results of the fixed-point read() method.
+
+        @see readFloatSamples
+    */
+    bool read (float* const* destSamples,
+               int numDestChannels,
+               int64 startSampleInSource,
+               int numSamplesToRead,
+               bool fillLeftoverChannelsWithCopies);
+
     /** Fills a section of an AudioSampleBuffer from this reader.
 
         This will convert the reader's fixed- or floating-point data to
@@ -224,6 +240,21 @@ public:
                               int64 startSampleInFile,
                               int numSamples) = 0;
 
+    /** Performs a low-level read operation into floating-point buffers.
+
+        Callers should use read() instead of calling this directly.
+
+        The parameters are the same as for readSamples(), but the destination buffers
+        must always be filled with floating-point data. The default implementation calls
+        readSamples() and then converts any fixed-point results in-place, so subclasses
+        that can decode straight to floats should override this to avoid the second pass.
+    */
+    virtual bool readFloatSamples (float** destSamples,
+                                   int numDestChannels,
+                                   int startOffsetInDestBuffer,
+                                   int64 startSampleInFile,
+                                   int numSamples);
+
 
 protected:
     //==============================================================================
@@ -246,18 +277,51 @@ protected:
                     dest += destOffset;
 
                     if (i < numSourceChannels)
-                        dest.convertSamples (SourceType (addBytesToPointer (sourceData, i * SourceType::getBytesPerSample()), numSourceChannels), numSamples);
+                    {
+                        SourceType source (addBytesToPointer (sourceData, i * SourceType::getBytesPerSample()), numSourceChannels);
+
+                        if (DestType::isFloatingPoint() && ! SourceType::isFloatingPoint())
+                            convertFixedToFloat (static_cast<float*> (targetChan) + destOffset, source, numSamples);
+                        else
+                            dest.convertSamples (source, numSamples);
+                    }
                     else
+                    {
                         dest.clearSamples (numSamples);
+                    }
                 }
             }
         }
+
+        // Unpacks the samples into a small block of ints first, so that the int-to-float
+        // step can use FloatVectorOperations, while the destination is only written once.
+        // (This deliberately avoids AudioData::BlockConversions, which scale 16- and 24-bit
+        // data by a power of two, so that float reads give exactly the same values as
+        // converting the results of an int read).
+        static void convertFixedToFloat (float* dest, SourceType source, int numSamples) noexcept
+        {
+            typedef AudioData::Pointer <AudioData::Int32, AudioData::NativeEndian, AudioData::NonInterleaved, AudioData::NonConst> TempType;
+            int32 temp [256];
+
+            while (numSamples > 0)
+            {
+                const int numThisTime = jmin (numSamples, (int) numElementsInArray (temp));
+
+                TempType (temp).convertSamples (source, numThisTime);
+                FloatVectorOperations::convertFixedToFloat (dest, temp, 1.0f / 0x7fffffff, numThisTime);
+
+                source += numThisTime;
+                dest += numThisTime;
+                numSamples -= numThisTime;
+            }
+        }
     };
 
     /** Used by AudioFormatReader subclasses to clear any parts of the data blocks that lie
         beyond the end of their available length.
     */
-    static void clearSamplesBeyondAvailableLength (int** destSamples, int numDestChannels,
+    template <typename SampleType>
+    static void clearSamplesBeyondAvailableLength (SampleType** destSamples, int numDestChannels,
                                                    int startOffsetInDestBuffer, int64 startSampleInFile,
                                                    int& numSamples, int64 fileLengthInSamples)
     {
@@ -268,7 +332,7 @@ protected:
         {
             for (int i = numDestChannels; --i >= 0;)
                 if (destSamples[i] != nullptr)
-                    zeromem (destSamples[i] + startOffsetInDestBuffer, sizeof (int) * (size_t) numSamples);
+                    zeromem (destSamples[i] + startOffsetInDestBuffer, sizeof (SampleType) * (size_t) numSamples);
 
             numSamples = (int) samplesAvailable;
         }
@@ -188,8 +188,9 @@ class AudioFormatWriter::ThreadedWriter::Buffer   : private TimeSliceClient
 {
 public:
     Buffer (TimeSliceThread& tst, AudioFormatWriter* w, int channels, int numSamples)
-        : fifo (numSamples),
-          buffer (channels, numSamples),
+        : blockSize (chooseBlockSize (numSamples)),
+          fifo (blockSize * ((numSamples + blockSize - 1) / blockSize + 1)),
+          buffer (channels, fifo.getTotalSize()),
           timeSliceThread (tst),
           writer (w),
           receiver (nullptr),
@@ -204,7 +205,7 @@ public:
         isRunning = false;
         timeSliceThread.removeTimeSliceClient (this);
 
-        while (writePendingData() == 0)
+        while (writePendingData (true) == 0)
         {}
     }
 
@@ -219,7 +220,10 @@ public:
         fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
 
         if (size1 + size2 < numSamples)
+        {
+            ++numOverflows;
             return false;
+        }
 
         for (int i = buffer.getNumChannels(); --i >= 0;)
         {
@@ -227,22 +231,38 @@ public:
             buffer.copyFrom (i, start2, data[i] + size1, size2);
         }
 
+        // (the background thread polls for new data rather than being woken up
+        // from here, as that could involve taking a lock)
         fifo.finishedWrite (size1 + size2);
-        timeSliceThread.notify();
         return true;
     }
 
+    int getNumOverflows() const noexcept    { return numOverflows.get(); }
+    void resetOverflowCount() noexcept      { numOverflows = 0; }
+
     int useTimeSlice() override
     {
-        return writePendingData();
+        if (writePendingData (false) == 0)
+            return 0;
+
+        // Check again after about a quarter of the time it takes to fill a block.
+        const double rate = writer->getSampleRate();
+        return rate > 0 ? jlimit (1, 20, (int) (blockSize * 250.0 / rate)) : 10;
     }
 
-    int writePendingData()
+    /*  The data is only ever written out in whole blocks, which always start at a
+        multiple of the block size within the FIFO, so each block goes to the writer
+        in a single call, and never straddles the end of the buffer.
+    */
+    int writePendingData (const bool flushPartialBlock)
     {
-        const int numToDo = fifo.getTotalSize() / 4;
+        int numToDo = fifo.getNumReady();
+
+        if (! flushPartialBlock)
+            numToDo -= numToDo % blockSize;
 
         int start1, size1, start2, size2;
-        fifo.prepareToRead (numToDo, start1, size1, start2, size2);
+        fifo.prepareToRead (jmin (numToDo, blockSize), start1, size1, start2, size2);
 
         if (size1 <= 0)
             return 10;
@@ -280,6 +300,7 @@ public:
     }
 
 private:
+    const int blockSize;
     AbstractFifo fifo;
     AudioSampleBuffer buffer;
     TimeSliceThread& timeSliceThread;
@@ -288,6 +309,17 @@ private:
     IncomingDataReceiver* receiver;
     int64 samplesWritten;
     volatile bool isRunning;
+    Atomic<int> numOverflows;
+
+    static int chooseBlockSize (const int numSamplesToBuffer) noexcept
+    {
+        int size = 1;
+
+        while (size < 65536 && size * 8 <= numSamplesToBuffer)
+            size *= 2;
+
+        return size;
+    }
 
     JUCE_DECLARE_NON_COPYABLE (Buffer)
 };
@@ -310,3 +342,96 @@ void AudioFormatWriter::ThreadedWriter::setDataReceiver (AudioFormatWriter::Thre
 {
     buffer->setDataReceiver (receiver);
 }
+
+int AudioFormatWriter::ThreadedWriter::getNumOverflows() const noexcept
+{
+    return buffer->getNumOverflows();
+}
+
+void AudioFormatWriter::ThreadedWriter::resetOverflowCount() noexcept
+{
+    buffer->resetOverflowCount();
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class ThreadedWriterTests  : public UnitTest
+{
+public:
+    ThreadedWriterTests() : UnitTest ("AudioFormatWriter::ThreadedWriter") {}
+
+    void runTest()
+    {
+        beginTest ("Overflows are counted and accepted data is written intact");
+
+        TimeSliceThread thread ("ThreadedWriter test");
+        thread.startThread();
+
+        const int numBlocks = 200, blockSize = 512;
+        MemoryBlock fileData;
+        WavAudioFormat wav;
+        AudioSampleBuffer block (2, blockSize), expected (2, numBlocks * blockSize);
+        int numAccepted = 0, numRejected = 0;
+
+        {
+            AudioFormatWriter::ThreadedWriter threadedWriter (wav.createWriterFor (new MemoryOutputStream (fileData, false),
+                                                                                   44100.0, 2, 16, StringPairArray(), 0),
+                                                              thread, 8192);
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                for (int chan = 0; chan < 2; ++chan)
+                    for (int j = 0; j < blockSize; ++j)
+                        *block.getSampleData (chan, j) = (((i * blockSize + j) * 7 + chan * 1000) % 2000 - 1000) / 32768.0f;
+
+                if (threadedWriter.write (block.getArrayOfChannels(), blockSize))
+                {
+                    for (int chan = 0; chan < 2; ++chan)
+                        expected.copyFrom (chan, numAccepted * blockSize, block, chan, 0, blockSize);
+
+                    ++numAccepted;
+                }
+                else
+                {
+                    ++numRejected;
+                }
+
+                // push the first half as fast as possible, then give the thread time to keep up
+                if (i >= numBlocks / 2)
+                    Thread::sleep (2);
+            }
+
+            expectEquals (threadedWriter.getNumOverflows(), numRejected);
+            threadedWriter.resetOverflowCount();
+            expectEquals (threadedWriter.getNumOverflows(), 0);
+
+            logMessage (String (numRejected) + " of " + String (numBlocks) + " blocks were rejected");
+        }
+
+        thread.stopThread (1000);
+
+        ScopedPointer<AudioFormatReader> reader (wav.createReaderFor (new MemoryInputStream (fileData, false), true));
+        expect (reader != nullptr);
+
+        if (reader != nullptr)
+        {
+            expectEquals (reader->lengthInSamples, (int64) (numAccepted * blockSize));
+
+            AudioSampleBuffer written (2, numAccepted * blockSize + 1);
+            reader->read (&written, 0, numAccepted * blockSize, 0, true, true);
+
+            float maxError = 0;
+
+            for (int chan = 0; chan < 2; ++chan)
+                for (int i = 0; i < numAccepted * blockSize; ++i)
+                    maxError = jmax (maxError, std::abs (*written.getSampleData (chan, i) - *expected.getSampleData (chan, i)));
+
+            expect (maxError < 1.5f / 32768.0f);
+        }
+    }
+};
+
+static ThreadedWriterTests threadedWriterTests;
+
+#endif
@@ -156,6 +156,10 @@ public:
             The writer object which is passed in here will be owned and deleted by
             the ThreadedWriter when it is no longer needed.
 
+            The FIFO is allocated here, and the background thread takes the data out of it
+            and passes it to the writer in large blocks, so that write() can safely be called
+            from a real-time thread.
+
             To stop the writer and flush the buffer to disk, simply delete this object.
         */
         ThreadedWriter (AudioFormatWriter* writer,
@@ -176,9 +180,23 @@ public:
 
             The data must be an array containing the same number of channels as the
             AudioFormatWriter object is using. None of these channels can be null.
+
+            This never blocks, allocates or takes a lock, so it's safe to call from an
+            audio callback.
+
+            @see getNumOverflows
         */
         bool write (const float* const* data, int numSamples);
 
+        /** Returns the number of times that write() has had to reject a block of data
+            because the FIFO was full.
+            @see resetOverflowCount
+        */
+        int getNumOverflows() const noexcept;
+
+        /** Resets the counter returned by getNumOverflows(). */
+        void resetOverflowCount() noexcept;
+
         class JUCE_API  IncomingDataReceiver
         {
         public:
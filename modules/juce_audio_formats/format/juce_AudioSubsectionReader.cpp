@@ -57,6 +57,16 @@ bool AudioSubsectionReader::readSamples (int** destSamples, int numDestChannels,
                                 startSampleInFile + startSample, numSamples);
 }
 
+bool AudioSubsectionReader::readFloatSamples (float** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                                              int64 startSampleInFile, int numSamples)
+{
+    clearSamplesBeyondAvailableLength (destSamples, numDestChannels, startOffsetInDestBuffer,
+                                       startSampleInFile, numSamples, length);
+
+    return source->readFloatSamples (destSamples, numDestChannels, startOffsetInDestBuffer,
+                                     startSampleInFile + startSample, numSamples);
+}
+
 void AudioSubsectionReader::readMaxLevels (int64 startSampleInFile,
                                            int64 numSamples,
                                            float& lowestLeft,
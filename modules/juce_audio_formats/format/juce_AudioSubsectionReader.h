@@ -67,6 +67,9 @@ public:
     bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
                       int64 startSampleInFile, int numSamples) override;
 
+    bool readFloatSamples (float** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                           int64 startSampleInFile, int numSamples) override;
+
     void readMaxLevels (int64 startSample, int64 numSamples,
                         float& lowestLeft,  float& highestLeft,
                         float& lowestRight, float& highestRight) override;
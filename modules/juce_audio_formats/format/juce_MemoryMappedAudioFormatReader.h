@@ -70,6 +70,21 @@ public:
     /** Touches the memory for the given sample, to force it to be loaded into active memory. */
     void touchSample (int64 sample) const noexcept;
 
+    /** Tells the OS how the mapped data is going to be read.
+        By default no particular pattern is assumed. If you're going to stream through the data
+        in order, MemoryMappedFile::sequentialAccess makes the OS read further ahead of the
+        position being accessed; if you're going to jump around a large file, e.g. while scrubbing,
+        MemoryMappedFile::randomAccess avoids loading data that won't be used.
+        The pattern is applied to the current mapping, and to any that are made later.
+    */
+    void setAccessPattern (MemoryMappedFile::AccessPattern pattern) noexcept;
+
+    /** Asks the OS to start loading a range of samples in the background, so that reading them
+        later won't have to wait for the disk. The range is clipped to the mapped section.
+        @see mapSectionOfFile
+    */
+    void prefetchSamples (Range<int64> samplesToPrefetch) const noexcept;
+
     /** Returns the number of bytes currently being mapped */
     size_t getNumBytesUsed() const                          { return map != nullptr ? map->getSize() : 0; }
 
@@ -79,6 +94,7 @@ protected:
     ScopedPointer<MemoryMappedFile> map;
     int64 dataChunkStart, dataLength;
     int bytesPerFrame;
+    MemoryMappedFile::AccessPattern accessPattern;
 
     /** Converts a sample index to a byte position in the file. */
     inline int64 sampleToFilePos (int64 sample) const noexcept       { return dataChunkStart + sample * bytesPerFrame; }
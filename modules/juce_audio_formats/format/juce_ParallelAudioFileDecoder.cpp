@@ -0,0 +1,485 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+ParallelAudioFileDecoder::ParallelAudioFileDecoder (AudioFormatManager& fm,
+                                                    const int numThreads,
+                                                    const int blockSize,
+                                                    const int numBlocks)
+    : formatManager (fm),
+      pool (jmax (1, numThreads)),
+      samplesPerBlock (jmax (1, blockSize)),
+      numBlocksPerFile (jmax (1, numBlocks)),
+      maxFilesInProgress (2 * jmax (1, numThreads)),
+      numFilesInProgress (0),
+      nextFileToStart (0)
+{
+}
+
+ParallelAudioFileDecoder::~ParallelAudioFileDecoder()
+{
+    // (the jobs are the DecodedFile objects, so this has to wait for any that are
+    // running to stop, however long that takes, before the files can be deleted)
+    pool.removeAllJobs (true, -1);
+}
+
+int ParallelAudioFileDecoder::addFile (const File& file)
+{
+    const ScopedLock sl (lock);
+
+    files.add (new DecodedFile (*this, file));
+    startMoreFiles();
+    return files.size() - 1;
+}
+
+void ParallelAudioFileDecoder::addFiles (const Array<File>& filesToAdd)
+{
+    const ScopedLock sl (lock);
+
+    for (int i = 0; i < filesToAdd.size(); ++i)
+        files.add (new DecodedFile (*this, filesToAdd.getReference (i)));
+
+    startMoreFiles();
+}
+
+int ParallelAudioFileDecoder::getNumFiles() const
+{
+    const ScopedLock sl (lock);
+    return files.size();
+}
+
+ParallelAudioFileDecoder::DecodedFile* ParallelAudioFileDecoder::getFile (const int index) const
+{
+    const ScopedLock sl (lock);
+    return files [index];
+}
+
+int64 ParallelAudioFileDecoder::getTotalNumSamplesDecoded() const
+{
+    const ScopedLock sl (lock);
+    int64 total = 0;
+
+    for (int i = files.size(); --i >= 0;)
+        total += files.getUnchecked(i)->getNumSamplesDecoded();
+
+    return total;
+}
+
+void ParallelAudioFileDecoder::startMoreFiles()
+{
+    while (numFilesInProgress < maxFilesInProgress && nextFileToStart < files.size())
+    {
+        ++numFilesInProgress;
+        pool.addJob (files.getUnchecked (nextFileToStart++), false);
+    }
+}
+
+bool ParallelAudioFileDecoder::areAllFilesWaitingForSpace() const
+{
+    const ScopedLock sl (lock);
+    return numFilesWaitingForSpace.get() >= numFilesInProgress;
+}
+
+void ParallelAudioFileDecoder::fileReleased()
+{
+    const ScopedLock sl (lock);
+
+    --numFilesInProgress;
+    startMoreFiles();
+}
+
+//==============================================================================
+ParallelAudioFileDecoder::DecodedFile::DecodedFile (ParallelAudioFileDecoder& o, const File& f)
+    : ThreadPoolJob ("Decoder: " + f.getFileName()),
+      owner (o), file (f),
+      status ((int) waitingToStart), hasBeenReleased (0), isWaitingForSpace (0),
+      sampleRate (0), numChannels (0),
+      lengthInSamples (0), nextSampleToDecode (0),
+      fifo (o.numBlocksPerFile + 1)
+{
+}
+
+ParallelAudioFileDecoder::DecodedFile::~DecodedFile()
+{
+}
+
+bool ParallelAudioFileDecoder::DecodedFile::isFinished() const noexcept
+{
+    // (if a read fails part-way through, the blocks decoded before it can still be read)
+    const Status s = getStatus();
+    return (s == failed || s == finishedDecoding) && fifo.getNumReady() == 0;
+}
+
+double ParallelAudioFileDecoder::DecodedFile::getDecodingTime() const noexcept
+{
+    return Time::highResolutionTicksToSeconds (decodingTicks.get());
+}
+
+double ParallelAudioFileDecoder::DecodedFile::getDecodingSpeed() const noexcept
+{
+    const double time = getDecodingTime();
+    return time > 0 ? getNumSamplesDecoded() / time : 0.0;
+}
+
+ThreadPoolJob::JobStatus ParallelAudioFileDecoder::DecodedFile::runJob()
+{
+    if (getStatus() == waitingToStart && ! open())
+    {
+        setFinished (failed);
+        return jobHasFinished;
+    }
+
+    while (! shouldExit())
+    {
+        if (nextSampleToDecode >= lengthInSamples)
+        {
+            setFinished (finishedDecoding);
+            return jobHasFinished;
+        }
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 == 0)
+        {
+            // The queue is full, so give the other files a turn. Only if every file that's in
+            // progress is in the same state is there nothing else for this thread to do, and
+            // then it waits for some space rather than spinning.
+            if (isWaitingForSpace.compareAndSetBool (1, 0))
+                ++owner.numFilesWaitingForSpace;
+
+            if (owner.areAllFilesWaitingForSpace())
+                owner.spaceAvailable.wait (10);
+
+            return jobNeedsRunningAgain;
+        }
+
+        if (! decodeNextBlock (start1))
+        {
+            setFinished (failed);
+            return jobHasFinished;
+        }
+
+        fifo.finishedWrite (1);
+        dataAvailable.signal();
+    }
+
+    return jobNeedsRunningAgain;
+}
+
+bool ParallelAudioFileDecoder::DecodedFile::open()
+{
+    reader = owner.formatManager.createReaderFor (file);
+
+    if (reader == nullptr || reader->numChannels <= 0)
+        return false;
+
+    sampleRate = reader->sampleRate;
+    numChannels = (int) reader->numChannels;
+    lengthInSamples = reader->lengthInSamples;
+
+    for (int i = fifo.getTotalSize(); --i >= 0;)
+        blocks.add (new AudioSampleBuffer (numChannels, owner.samplesPerBlock));
+
+    blockLengths.calloc ((size_t) fifo.getTotalSize());
+
+    status = (int) decoding;
+    return true;
+}
+
+bool ParallelAudioFileDecoder::DecodedFile::decodeNextBlock (const int blockIndex)
+{
+    AudioSampleBuffer& block = *blocks.getUnchecked (blockIndex);
+    const int numSamples = (int) jmin ((int64) owner.samplesPerBlock, lengthInSamples - nextSampleToDecode);
+
+    const int64 startTicks = Time::getHighResolutionTicks();
+
+    const bool ok = reader->read (block.getArrayOfChannels(), numChannels, nextSampleToDecode, numSamples, false);
+
+    decodingTicks += Time::getHighResolutionTicks() - startTicks;
+
+    if (! ok)
+        return false;
+
+    blockLengths [blockIndex] = numSamples;
+    nextSampleToDecode += numSamples;
+    numSamplesDecoded += numSamples;
+    return true;
+}
+
+void ParallelAudioFileDecoder::DecodedFile::setFinished (const Status newStatus)
+{
+    reader = nullptr;
+    status = (int) newStatus;
+    dataAvailable.signal();
+
+    releaseIfFinished();
+}
+
+int ParallelAudioFileDecoder::DecodedFile::readNextBlock (AudioSampleBuffer& destBuffer, const int timeOutMilliseconds)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (1, start1, size1, start2, size2);
+
+    if (size1 == 0 && timeOutMilliseconds != 0 && ! isFinished())
+    {
+        dataAvailable.wait (timeOutMilliseconds);
+        fifo.prepareToRead (1, start1, size1, start2, size2);
+    }
+
+    if (size1 == 0)
+    {
+        releaseIfFinished();
+        return 0;
+    }
+
+    const AudioSampleBuffer& block = *blocks.getUnchecked (start1);
+    const int numSamples = blockLengths [start1];
+
+    destBuffer.setSize (numChannels, numSamples, false, false, true);
+
+    for (int i = 0; i < numChannels; ++i)
+        destBuffer.copyFrom (i, 0, block, i, 0, numSamples);
+
+    fifo.finishedRead (1);
+
+    if (isWaitingForSpace.compareAndSetBool (0, 1))
+        --owner.numFilesWaitingForSpace;
+
+    owner.spaceAvailable.signal();
+
+    releaseIfFinished();
+    return numSamples;
+}
+
+void ParallelAudioFileDecoder::DecodedFile::releaseIfFinished()
+{
+    // Once all the data has gone, the blocks can be freed and the next file started.
+    // (This can be reached by both the decoding and the reading threads, so the flag
+    // makes sure that it only happens once).
+    if (isFinished() && hasBeenReleased.compareAndSetBool (1, 0))
+    {
+        blocks.clear();
+        blockLengths.free();
+        owner.fileReleased();
+    }
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class ParallelAudioFileDecoderTests  : public UnitTest
+{
+public:
+    ParallelAudioFileDecoderTests() : UnitTest ("ParallelAudioFileDecoder") {}
+
+    void runTest()
+    {
+        beginTest ("Decoded data matches a normal reader");
+
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        OwnedArray<TemporaryFile> tempFiles;
+        Random random (getRandom());
+
+        for (int i = 0; i < 12; ++i)
+        {
+            TemporaryFile* const f = tempFiles.add (new TemporaryFile (".wav"));
+
+            if (i == 5)
+                f->getFile().replaceWithText ("not an audio file");
+            else
+                expect (writeTestFile (random, f->getFile(), 1 + (i & 1), (i & 2) != 0 ? 24 : 16,
+                                       1000 + random.nextInt (100000)));
+        }
+
+        ParallelAudioFileDecoder decoder (formatManager, 3, 4096, 3);
+
+        for (int i = 0; i < tempFiles.size(); ++i)
+            decoder.addFile (tempFiles.getUnchecked(i)->getFile());
+
+        AudioSampleBuffer block (2, 4096);
+        int64 totalLength = 0;
+
+        for (int i = 0; i < decoder.getNumFiles(); ++i)
+        {
+            ParallelAudioFileDecoder::DecodedFile& decodedFile = *decoder.getFile (i);
+            ScopedPointer<AudioFormatReader> reader (formatManager.createReaderFor (decodedFile.getFile()));
+
+            int64 position = 0;
+            bool dataMatches = true;
+
+            while (! decodedFile.isFinished())
+            {
+                const int numSamples = decodedFile.readNextBlock (block, -1);
+
+                if (numSamples > 0)
+                {
+                    AudioSampleBuffer expected ((int) reader->numChannels, numSamples);
+                    reader->read (&expected, 0, numSamples, position, true, true);
+
+                    for (int chan = 0; chan < expected.getNumChannels(); ++chan)
+                        if (memcmp (expected.getSampleData (chan), block.getSampleData (chan),
+                                    sizeof (float) * (size_t) numSamples) != 0)
+                            dataMatches = false;
+
+                    position += numSamples;
+                }
+            }
+
+            if (reader == nullptr)
+            {
+                expect (decodedFile.getStatus() == ParallelAudioFileDecoder::DecodedFile::failed);
+            }
+            else
+            {
+                expect (decodedFile.getStatus() == ParallelAudioFileDecoder::DecodedFile::finishedDecoding);
+                expect (dataMatches);
+                expectEquals (position, reader->lengthInSamples);
+                expectEquals (decodedFile.getNumSamplesDecoded(), reader->lengthInSamples);
+                totalLength += reader->lengthInSamples;
+            }
+        }
+
+        expectEquals (decoder.getTotalNumSamplesDecoded(), totalLength);
+
+        beginTest ("A read error stops the file");
+
+        {
+            TemporaryFile failingFile (".wav");
+            expect (writeTestFile (random, failingFile.getFile(), 2, 16, 50000));
+
+            AudioFormatManager failingFormatManager;
+            failingFormatManager.registerFormat (new FailingWavFormat (20000), true);
+
+            ParallelAudioFileDecoder failingDecoder (failingFormatManager, 1, 4096, 3);
+            failingDecoder.addFile (failingFile.getFile());
+
+            ParallelAudioFileDecoder::DecodedFile& decodedFile = *failingDecoder.getFile (0);
+            int64 position = 0;
+
+            while (! decodedFile.isFinished())
+                position += decodedFile.readNextBlock (block, -1);
+
+            // the blocks before the one that failed should still have been delivered
+            expect (decodedFile.getStatus() == ParallelAudioFileDecoder::DecodedFile::failed);
+            expectEquals (position, (int64) 4 * 4096);
+        }
+
+        beginTest ("Decoding speed");
+
+        for (int numThreads = 1; numThreads <= SystemStats::getNumCpus(); numThreads *= 2)
+        {
+            ParallelAudioFileDecoder speedTestDecoder (formatManager, numThreads);
+
+            for (int i = 0; i < tempFiles.size(); ++i)
+                speedTestDecoder.addFile (tempFiles.getUnchecked(i)->getFile());
+
+            const double startTime = Time::getMillisecondCounterHiRes();
+            double fileSpeeds = 0;
+
+            for (int i = 0; i < speedTestDecoder.getNumFiles(); ++i)
+            {
+                ParallelAudioFileDecoder::DecodedFile& decodedFile = *speedTestDecoder.getFile (i);
+
+                while (! decodedFile.isFinished())
+                    decodedFile.readNextBlock (block, -1);
+
+                fileSpeeds += decodedFile.getDecodingSpeed();
+            }
+
+            const double elapsedSecs = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+            logMessage (String (numThreads) + " threads: "
+                          + String (speedTestDecoder.getTotalNumSamplesDecoded() / (elapsedSecs * 1.0e6), 1)
+                          + "M samples/sec overall, average per-file speed "
+                          + String (fileSpeeds / (speedTestDecoder.getNumFiles() * 1.0e6), 1) + "M samples/sec");
+        }
+    }
+
+private:
+    // A WAV format whose readers fail when asked for any samples beyond a given position.
+    class FailingWavFormat  : public WavAudioFormat
+    {
+    public:
+        FailingWavFormat (const int64 failurePosition_) : failurePosition (failurePosition_) {}
+
+        AudioFormatReader* createReaderFor (InputStream* sourceStream, const bool deleteStreamIfOpeningFails) override
+        {
+            if (AudioFormatReader* const source = WavAudioFormat::createReaderFor (sourceStream, deleteStreamIfOpeningFails))
+                return new FailingReader (source, failurePosition);
+
+            return nullptr;
+        }
+
+    private:
+        struct FailingReader  : public AudioFormatReader
+        {
+            FailingReader (AudioFormatReader* const source_, const int64 failurePosition_)
+                : AudioFormatReader (nullptr, source_->getFormatName()),
+                  source (source_), failurePosition (failurePosition_)
+            {
+                sampleRate = source->sampleRate;
+                bitsPerSample = source->bitsPerSample;
+                lengthInSamples = source->lengthInSamples;
+                numChannels = source->numChannels;
+                usesFloatingPointData = source->usesFloatingPointData;
+            }
+
+            bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                              int64 startSampleInFile, int numSamples) override
+            {
+                return startSampleInFile + numSamples <= failurePosition
+                        && source->readSamples (destSamples, numDestChannels, startOffsetInDestBuffer,
+                                                startSampleInFile, numSamples);
+            }
+
+            ScopedPointer<AudioFormatReader> source;
+            const int64 failurePosition;
+        };
+
+        const int64 failurePosition;
+    };
+
+    static bool writeTestFile (Random& random, const File& file, const int numChannels,
+                               const int bitsPerSample, const int numSamples)
+    {
+        AudioSampleBuffer buffer (numChannels, numSamples);
+
+        for (int chan = 0; chan < numChannels; ++chan)
+            for (int i = 0; i < numSamples; ++i)
+                buffer.getSampleData (chan)[i] = random.nextFloat() * 1.8f - 0.9f;
+
+        WavAudioFormat wav;
+        ScopedPointer<AudioFormatWriter> writer (wav.createWriterFor (new FileOutputStream (file), 44100.0,
+                                                                      (unsigned int) numChannels, bitsPerSample,
+                                                                      StringPairArray(), 0));
+
+        return writer != nullptr && writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+    }
+};
+
+static ParallelAudioFileDecoderTests parallelAudioFileDecoderTests;
+
+#endif
@@ -0,0 +1,213 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+#ifndef JUCE_PARALLELAUDIOFILEDECODER_H_INCLUDED
+#define JUCE_PARALLELAUDIOFILEDECODER_H_INCLUDED
+
+
+//==============================================================================
+/**
+    Decodes a list of audio files using a pool of background threads.
+
+    Add the files that you want to decode with addFile(), and the decoder will start
+    reading them, several at a time, using readers that it creates with an
+    AudioFormatManager. The decoded audio is handed back as blocks of floating-point
+    samples, which you can collect with DecodedFile::readNextBlock().
+
+    Each file has a small, fixed-size queue of blocks. The decoding threads are never
+    held up by a slow consumer: when a file's queue is full, its decoder gives up its
+    thread to the other files until some space has been freed.
+
+    To limit the number of open files and the amount of memory used, only a few
+    files (twice the number of threads) are in progress at any time - the next
+    file is started when all of the data from one of them has been read, or when one
+    fails to open. That means you should consume the files in the order that you added
+    them, or at least only wait for data from a file once its status is no longer
+    DecodedFile::waitingToStart.
+
+    @see AudioFormatManager, AudioFormatReader
+*/
+class JUCE_API  ParallelAudioFileDecoder
+{
+public:
+    //==============================================================================
+    /** Creates a decoder.
+
+        @param formatManager        the formats to use when opening the files. This must not be
+                                    deleted before the decoder
+        @param numThreads           the number of threads to decode with
+        @param samplesPerBlock      the number of samples in each block of decoded data
+        @param numBlocksPerFile     the number of blocks that can be queued up for each file
+    */
+    ParallelAudioFileDecoder (AudioFormatManager& formatManager,
+                              int numThreads,
+                              int samplesPerBlock = 65536,
+                              int numBlocksPerFile = 4);
+
+    /** Destructor.
+        This will stop any decoding that's still in progress.
+    */
+    ~ParallelAudioFileDecoder();
+
+    //==============================================================================
+    /**
+        The decoded data and statistics for one of the files in a ParallelAudioFileDecoder.
+
+        @see ParallelAudioFileDecoder::getFile
+    */
+    class JUCE_API  DecodedFile  : private ThreadPoolJob
+    {
+    public:
+        /** Destructor. */
+        ~DecodedFile();
+
+        //==============================================================================
+        enum Status
+        {
+            waitingToStart,     /**< The file hasn't been opened yet. */
+            decoding,           /**< The file has been opened, and its details are available. */
+            finishedDecoding,   /**< All the data has been decoded, though some may not have been read yet. */
+            failed              /**< The file couldn't be opened or read. */
+        };
+
+        /** Returns the file being decoded. */
+        const File& getFile() const noexcept                        { return file; }
+
+        /** Returns the current status of the file. */
+        Status getStatus() const noexcept                           { return (Status) status.get(); }
+
+        /** Returns true if all the file's data has been read, or if it failed and all the
+            data that was decoded before the failure has been read.
+        */
+        bool isFinished() const noexcept;
+
+        /** Returns the file's sample rate.
+            This is only valid once the file has been opened, i.e. when getStatus() returns
+            decoding or finishedDecoding.
+        */
+        double getSampleRate() const noexcept                       { return sampleRate; }
+
+        /** Returns the file's number of channels, once it has been opened. */
+        int getNumChannels() const noexcept                         { return numChannels; }
+
+        /** Returns the file's length, once it has been opened. */
+        int64 getLengthInSamples() const noexcept                   { return lengthInSamples; }
+
+        //==============================================================================
+        /** Takes the next decoded block from the file's queue.
+
+            The destination buffer will be resized to the file's number of channels and the
+            block's length (without reallocating if it's already big enough), and the
+            block's samples are copied into it.
+
+            This is safe to call from one thread at a time, and needs no locking.
+
+            @param destBuffer           the buffer to fill
+            @param timeOutMilliseconds  if no block is ready, how long to wait for one. A value
+                                        of 0 returns immediately, and a negative value waits
+                                        until a block arrives or the file finishes
+            @returns    the number of samples read, or 0 if no data was available
+        */
+        int readNextBlock (AudioSampleBuffer& destBuffer, int timeOutMilliseconds = 0);
+
+        //==============================================================================
+        /** Returns the number of samples that have been decoded so far. */
+        int64 getNumSamplesDecoded() const noexcept                 { return numSamplesDecoded.get(); }
+
+        /** Returns the total time, in seconds, that the decoding threads have spent reading this file. */
+        double getDecodingTime() const noexcept;
+
+        /** Returns the number of samples per second that this file has been decoded at.
+            This is measured in the time that the decoding threads actually spent reading
+            the file, so it doesn't include any time spent waiting for the consumer.
+        */
+        double getDecodingSpeed() const noexcept;
+
+    private:
+        //==============================================================================
+        friend class ParallelAudioFileDecoder;
+
+        DecodedFile (ParallelAudioFileDecoder&, const File&);
+
+        ParallelAudioFileDecoder& owner;
+        const File file;
+        Atomic<int> status, hasBeenReleased, isWaitingForSpace;
+        double sampleRate;
+        int numChannels;
+        int64 lengthInSamples, nextSampleToDecode;
+        ScopedPointer<AudioFormatReader> reader;
+
+        OwnedArray<AudioSampleBuffer> blocks;
+        HeapBlock<int> blockLengths;
+        AbstractFifo fifo;
+        WaitableEvent dataAvailable;
+        Atomic<int64> numSamplesDecoded, decodingTicks;
+
+        JobStatus runJob() override;
+        bool open();
+        bool decodeNextBlock (int blockIndex);
+        void setFinished (Status);
+        void releaseIfFinished();
+
+        JUCE_DECLARE_NON_COPYABLE (DecodedFile)
+    };
+
+    //==============================================================================
+    /** Adds a file to the end of the list, and returns its index. */
+    int addFile (const File& file);
+
+    /** Adds a list of files to the end of the list. */
+    void addFiles (const Array<File>& files);
+
+    /** Returns the number of files that have been added. */
+    int getNumFiles() const;
+
+    /** Returns one of the files that has been added.
+        The object that's returned will remain valid until the decoder is deleted.
+    */
+    DecodedFile* getFile (int index) const;
+
+    /** Returns the total number of samples that have been decoded, from all the files. */
+    int64 getTotalNumSamplesDecoded() const;
+
+private:
+    //==============================================================================
+    AudioFormatManager& formatManager;
+    ThreadPool pool;
+    const int samplesPerBlock, numBlocksPerFile, maxFilesInProgress;
+    OwnedArray<DecodedFile> files;
+    int numFilesInProgress, nextFileToStart;
+    Atomic<int> numFilesWaitingForSpace;
+    WaitableEvent spaceAvailable;
+    CriticalSection lock;
+
+    void startMoreFiles();
+    bool areAllFilesWaitingForSpace() const;
+    void fileReleased();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParallelAudioFileDecoder)
+};
+
+
+#endif   // JUCE_PARALLELAUDIOFILEDECODER_H_INCLUDED
@@ -104,6 +104,7 @@ namespace juce
 #include "format/juce_AudioFormatWriter.cpp"
 #include "format/juce_AudioSubsectionReader.cpp"
 #include "format/juce_BufferingAudioFormatReader.cpp"
+#include "format/juce_ParallelAudioFileDecoder.cpp"
 #include "sampler/juce_Sampler.cpp"
 #include "codecs/juce_AiffAudioFormat.cpp"
 #include "codecs/juce_CoreAudioFormat.cpp"
@@ -111,6 +112,7 @@ namespace juce
 #include "codecs/juce_MP3AudioFormat.cpp"
 #include "codecs/juce_OggVorbisAudioFormat.cpp"
 #include "codecs/juce_QuickTimeAudioFormat.cpp"
+#include "codecs/juce_RawPCMAudioFormat.cpp"
 #include "codecs/juce_WavAudioFormat.cpp"
 #include "codecs/juce_LAMEEncoderAudioFormat.cpp"
 
@@ -94,6 +94,7 @@ class AudioFormat;
 #include "format/juce_AudioFormatReaderSource.h"
 #include "format/juce_AudioSubsectionReader.h"
 #include "format/juce_BufferingAudioFormatReader.h"
+#include "format/juce_ParallelAudioFileDecoder.h"
 #include "codecs/juce_AiffAudioFormat.h"
 #include "codecs/juce_CoreAudioFormat.h"
 #include "codecs/juce_FlacAudioFormat.h"
@@ -101,6 +102,7 @@ class AudioFormat;
 #include "codecs/juce_MP3AudioFormat.h"
 #include "codecs/juce_OggVorbisAudioFormat.h"
 #include "codecs/juce_QuickTimeAudioFormat.h"
+#include "codecs/juce_RawPCMAudioFormat.h"
 #include "codecs/juce_WavAudioFormat.h"
 #include "codecs/juce_WindowsMediaAudioFormat.h"
 #include "sampler/juce_Sampler.h"
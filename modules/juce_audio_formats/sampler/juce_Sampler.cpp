@@ -31,7 +31,8 @@ SamplerSound::SamplerSound (const String& soundName,
                             const double maxSampleLengthSeconds)
     : name (soundName),
       midiNotes (notes),
-      midiRootNote (midiNoteForNormalPitch)
+      midiRootNote (midiNoteForNormalPitch),
+      preloadLength (0)
 {
     sourceSampleRate = source.sampleRate;
 
@@ -55,6 +56,50 @@ SamplerSound::SamplerSound (const String& soundName,
     }
 }
 
+SamplerSound::SamplerSound (const String& soundName,
+                            MemoryMappedAudioFormatReader* const source,
+                            const BigInteger& notes,
+                            const int midiNoteForNormalPitch,
+                            const double attackTimeSecs,
+                            const double releaseTimeSecs,
+                            const double preloadTimeSecs)
+    : name (soundName),
+      streamingSource (source),
+      sourceSampleRate (0),
+      midiNotes (notes),
+      length (0), attackSamples (0), releaseSamples (0),
+      midiRootNote (midiNoteForNormalPitch),
+      preloadLength (0)
+{
+    jassert (source != nullptr);
+
+    if (source != nullptr)
+        source->setAccessPattern (MemoryMappedFile::sequentialAccess);
+
+    if (source != nullptr && source->sampleRate > 0 && source->lengthInSamples > 0
+         && source->mapEntireFile())
+    {
+        sourceSampleRate = source->sampleRate;
+        length = (int) jmin (source->lengthInSamples, (int64) std::numeric_limits<int>::max() - 4);
+
+        // (like the in-memory version, the stream is padded with a few samples of silence,
+        // to give the interpolator something to read after the last sample)
+        preloadLength = jlimit (0, length + 4, roundToInt (preloadTimeSecs * sourceSampleRate));
+
+        data = new AudioSampleBuffer (jmin (2, (int) source->numChannels), jmax (1, preloadLength));
+        data->clear();
+
+        source->read (data, 0, preloadLength, 0, true, true);
+
+        attackSamples = roundToInt (attackTimeSecs * sourceSampleRate);
+        releaseSamples = roundToInt (releaseTimeSecs * sourceSampleRate);
+    }
+    else
+    {
+        streamingSource = nullptr;
+    }
+}
+
 SamplerSound::~SamplerSound()
 {
 }
@@ -69,6 +114,232 @@ bool SamplerSound::appliesToChannel (const int /*midiChannel*/)
     return true;
 }
 
+//==============================================================================
+/*  Reads ahead of a voice's playback position from a streamed SamplerSound, into
+    a ring buffer that holds source sample n at index (n & mask).
+
+    The audio thread owns the playback position and the background thread owns the
+    fill position, and these are exchanged with atomics. The sample data is written
+    and read in regions that the two positions keep apart.
+
+    When a note starts or stops, the audio thread posts a request to the background
+    thread through a FIFO, tagged with a new generation number, and the ring buffer's
+    data is only used once the background thread has published a fill position for
+    that generation. The audio thread takes a reference to the sound it posts, and it's
+    the background thread that releases it, so the audio thread never waits for a lock
+    or deletes a sound that's been removed from the synth.
+*/
+class SamplerVoice::DiskStream  : private TimeSliceClient
+{
+public:
+    DiskStream (TimeSliceThread& t, const int bufferSize)
+        : thread (t),
+          buffer (2, nextPowerOfTwo (jmax (256, bufferSize))),
+          mask (buffer.getNumSamples() - 1),
+          requestFifo ((int) maxPendingRequests),
+          reader (nullptr),
+          streamEnd (0),
+          generation (0)
+    {
+        buffer.clear();
+        thread.addTimeSliceClient (this);
+    }
+
+    ~DiskStream()
+    {
+        thread.removeTimeSliceClient (this);
+        takeRequests(); // (releases any sounds that were still waiting in the FIFO)
+    }
+
+    // Called by the audio thread to start reading a new sound, beginning at firstSampleToRead.
+    void start (SynthesiserSound* const newSound, MemoryMappedAudioFormatReader* const newReader,
+                const int firstSampleToRead, const int endOfStream) noexcept
+    {
+        // (the generation changes even if the FIFO is full, so that the old sound's data
+        // can't be mistaken for the new one's - the voice will just play silence instead)
+        ++generation;
+        readPosition = 0;
+
+        int start1, size1, start2, size2;
+        requestFifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 > 0)
+        {
+            if (newSound != nullptr)
+                newSound->incReferenceCount();
+
+            Request& r = requests [start1];
+            r.sound = newSound;
+            r.reader = newReader;
+            r.firstSampleToRead = firstSampleToRead;
+            r.streamEnd = endOfStream;
+            r.generation = generation;
+
+            requestFifo.finishedWrite (1);
+        }
+    }
+
+    void stop() noexcept
+    {
+        start (nullptr, nullptr, 0, 0);
+    }
+
+    // Called by the audio thread: returns the source sample index up to which the buffer
+    // contains valid data for the sound that was last started.
+    int getAvailableEnd() const noexcept
+    {
+        // (fillEnd is set before the generation is published, so if this generation
+        // matches, the fill position can't belong to an earlier sound)
+        if (filledGeneration.get() != generation)
+            return 0;
+
+        return fillEnd.get();
+    }
+
+    // Tells the reader that the samples before this index are no longer needed.
+    void setReadPosition (const int newPosition) noexcept   { readPosition = newPosition; }
+
+    const AudioSampleBuffer& getBuffer() const noexcept     { return buffer; }
+    int getMask() const noexcept                            { return mask; }
+
+private:
+    TimeSliceThread& thread;
+    AudioSampleBuffer buffer;
+    const int mask;
+
+    struct Request
+    {
+        SynthesiserSound* sound;    // (the audio thread has taken a reference to this)
+        MemoryMappedAudioFormatReader* reader;
+        int firstSampleToRead, streamEnd, generation;
+    };
+
+    enum { maxPendingRequests = 32, maxSamplesPerRead = 16384 };
+
+    AbstractFifo requestFifo;
+    Request requests [maxPendingRequests];
+
+    // These are only used by the background thread..
+    SynthesiserSound::Ptr sound;  // keeps the sound and its reader alive while we use them
+    MemoryMappedAudioFormatReader* reader;
+    int streamEnd;
+
+    // ..and this one by the audio thread.
+    int generation;
+
+    Atomic<int> fillEnd, filledGeneration, readPosition;
+
+    void takeRequests()
+    {
+        int start1, size1, start2, size2;
+        requestFifo.prepareToRead (requestFifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; ++i)   takeRequest (requests [start1 + i]);
+        for (int i = 0; i < size2; ++i)   takeRequest (requests [start2 + i]);
+
+        requestFifo.finishedRead (size1 + size2);
+    }
+
+    void takeRequest (const Request& r)
+    {
+        sound = r.sound;  // (if the old sound has been removed from the synth, it gets deleted here)
+
+        if (r.sound != nullptr)
+            r.sound->decReferenceCount();
+
+        reader = r.reader;
+        streamEnd = r.streamEnd;
+        fillEnd = r.firstSampleToRead;
+        filledGeneration = r.generation;
+    }
+
+    int useTimeSlice() override
+    {
+        takeRequests();
+
+        if (reader == nullptr)
+            return 5;
+
+        // (if the voice has run out of data and skipped ahead, there's no point reading what it missed)
+        const int readPos = readPosition.get();
+        const int start = jmax (fillEnd.get(), readPos);
+        const int end = jmin (streamEnd, readPos + buffer.getNumSamples(), start + (int) maxSamplesPerRead);
+
+        if (start >= end)
+            return 1;
+
+        const int startIndex = start & mask;
+        const int numBeforeWrap = jmin (end - start, buffer.getNumSamples() - startIndex);
+
+        readIntoBuffer (*reader, startIndex, start, numBeforeWrap);
+        readIntoBuffer (*reader, 0, start + numBeforeWrap, end - start - numBeforeWrap);
+
+        fillEnd = end;
+        return 0;
+    }
+
+    void readIntoBuffer (AudioFormatReader& source, const int bufferIndex, const int startSample, const int numSamples)
+    {
+        if (numSamples > 0)
+        {
+            float* const dest[] = { buffer.getSampleData (0, bufferIndex),
+                                    buffer.getSampleData (1, bufferIndex) };
+
+            source.read (dest, 2, startSample, numSamples, true);
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (DiskStream)
+};
+
+//==============================================================================
+namespace SamplerHelpers
+{
+    struct InMemorySampleSource
+    {
+        InMemorySampleSource (const AudioSampleBuffer& data) noexcept
+            : inL (data.getSampleData (0, 0)),
+              inR (data.getNumChannels() > 1 ? data.getSampleData (1, 0) : nullptr)
+        {
+        }
+
+        bool isAvailable (int) const noexcept                   { return true; }
+        bool isStereo() const noexcept                          { return inR != nullptr; }
+        float getLeft (const int pos) const noexcept            { return inL [pos]; }
+        float getRight (const int pos) const noexcept           { return inR [pos]; }
+
+        const float* const inL;
+        const float* const inR;
+    };
+
+    // Reads the start of the sample from the sound's preloaded data, and
+    // the rest from a voice's ring buffer.
+    struct StreamedSampleSource
+    {
+        StreamedSampleSource (const AudioSampleBuffer& preload, const int preloadLength_,
+                              const AudioSampleBuffer& ring, const int mask_, const int availableEnd_) noexcept
+            : preloadL (preload.getSampleData (0, 0)),
+              preloadR (preload.getNumChannels() > 1 ? preload.getSampleData (1, 0) : nullptr),
+              ringL (ring.getSampleData (0, 0)),
+              ringR (ring.getSampleData (1, 0)),
+              preloadLength (preloadLength_), mask (mask_),
+              availableEnd (jmax (preloadLength_, availableEnd_))
+        {
+        }
+
+        bool isAvailable (const int pos) const noexcept         { return pos + 1 < availableEnd; }
+        bool isStereo() const noexcept                          { return preloadR != nullptr; }
+        float getLeft (const int pos) const noexcept            { return pos < preloadLength ? preloadL [pos] : ringL [pos & mask]; }
+        float getRight (const int pos) const noexcept           { return pos < preloadLength ? preloadR [pos] : ringR [pos & mask]; }
+
+        const float* const preloadL;
+        const float* const preloadR;
+        const float* const ringL;
+        const float* const ringR;
+        const int preloadLength, mask, availableEnd;
+    };
+}
+
 //==============================================================================
 SamplerVoice::SamplerVoice()
     : pitchRatio (0.0),
@@ -79,13 +350,26 @@ SamplerVoice::SamplerVoice()
 {
 }
 
+SamplerVoice::SamplerVoice (TimeSliceThread& streamingThread, const int streamingBufferSize)
+    : diskStream (new DiskStream (streamingThread, streamingBufferSize)),
+      pitchRatio (0.0),
+      sourceSamplePosition (0.0),
+      lgain (0.0f), rgain (0.0f),
+      attackReleaseLevel (0), attackDelta (0), releaseDelta (0),
+      isInAttack (false), isInRelease (false)
+{
+}
+
 SamplerVoice::~SamplerVoice()
 {
 }
 
 bool SamplerVoice::canPlaySound (SynthesiserSound* sound)
 {
-    return dynamic_cast<const SamplerSound*> (sound) != nullptr;
+    if (const SamplerSound* const s = dynamic_cast<const SamplerSound*> (sound))
+        return diskStream != nullptr || ! s->isStreaming();
+
+    return false;
 }
 
 void SamplerVoice::startNote (const int midiNoteNumber,
@@ -120,6 +404,14 @@ void SamplerVoice::startNote (const int midiNoteNumber,
             releaseDelta = (float) (-pitchRatio / sound->releaseSamples);
         else
             releaseDelta = 0.0f;
+
+        if (diskStream != nullptr)
+        {
+            if (sound->isStreaming())
+                diskStream->start (s, sound->streamingSource, sound->preloadLength, sound->length + 4);
+            else
+                diskStream->stop();
+        }
     }
     else
     {
@@ -137,6 +429,9 @@ void SamplerVoice::stopNote (const bool allowTailOff)
     else
     {
         clearCurrentNote();
+
+        if (diskStream != nullptr)
+            diskStream->stop();
     }
 }
 
@@ -150,75 +445,296 @@ void SamplerVoice::controllerMoved (const int /*controllerNumber*/,
 }
 
 //==============================================================================
-void SamplerVoice::renderNextBlock (AudioSampleBuffer& outputBuffer, int startSample, int numSamples)
+template <class SampleSource>
+bool SamplerVoice::renderSamples (const SampleSource& source, const int soundLength,
+                                  AudioSampleBuffer& outputBuffer, int startSample, int numSamples)
 {
-    if (const SamplerSound* const playingSound = static_cast <SamplerSound*> (getCurrentlyPlayingSound().get()))
-    {
-        const float* const inL = playingSound->data->getSampleData (0, 0);
-        const float* const inR = playingSound->data->getNumChannels() > 1
-                                    ? playingSound->data->getSampleData (1, 0) : nullptr;
+    float* outL = outputBuffer.getSampleData (0, startSample);
+    float* outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getSampleData (1, startSample) : nullptr;
+    bool hasRunOutOfData = false;
 
-        float* outL = outputBuffer.getSampleData (0, startSample);
-        float* outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getSampleData (1, startSample) : nullptr;
+    while (--numSamples >= 0)
+    {
+        const int pos = (int) sourceSamplePosition;
+        float l = 0, r = 0;
 
-        while (--numSamples >= 0)
+        if (source.isAvailable (pos))
         {
-            const int pos = (int) sourceSamplePosition;
             const float alpha = (float) (sourceSamplePosition - pos);
             const float invAlpha = 1.0f - alpha;
 
             // just using a very simple linear interpolation here..
-            float l = (inL [pos] * invAlpha + inL [pos + 1] * alpha);
-            float r = (inR != nullptr) ? (inR [pos] * invAlpha + inR [pos + 1] * alpha)
-                                       : l;
+            l = (source.getLeft (pos) * invAlpha + source.getLeft (pos + 1) * alpha);
+            r = source.isStereo() ? (source.getRight (pos) * invAlpha + source.getRight (pos + 1) * alpha)
+                                  : l;
+        }
+        else
+        {
+            // a streamed sound's data hasn't arrived from disk yet
+            hasRunOutOfData = true;
+        }
 
-            l *= lgain;
-            r *= rgain;
+        l *= lgain;
+        r *= rgain;
 
-            if (isInAttack)
-            {
-                l *= attackReleaseLevel;
-                r *= attackReleaseLevel;
+        if (isInAttack)
+        {
+            l *= attackReleaseLevel;
+            r *= attackReleaseLevel;
 
-                attackReleaseLevel += attackDelta;
+            attackReleaseLevel += attackDelta;
 
-                if (attackReleaseLevel >= 1.0f)
-                {
-                    attackReleaseLevel = 1.0f;
-                    isInAttack = false;
-                }
-            }
-            else if (isInRelease)
+            if (attackReleaseLevel >= 1.0f)
             {
-                l *= attackReleaseLevel;
-                r *= attackReleaseLevel;
-
-                attackReleaseLevel += releaseDelta;
-
-                if (attackReleaseLevel <= 0.0f)
-                {
-                    stopNote (false);
-                    break;
-                }
+                attackReleaseLevel = 1.0f;
+                isInAttack = false;
             }
+        }
+        else if (isInRelease)
+        {
+            l *= attackReleaseLevel;
+            r *= attackReleaseLevel;
+
+            attackReleaseLevel += releaseDelta;
 
-            if (outR != nullptr)
+            if (attackReleaseLevel <= 0.0f)
             {
-                *outL++ += l;
-                *outR++ += r;
+                stopNote (false);
+                break;
             }
-            else
+        }
+
+        if (outR != nullptr)
+        {
+            *outL++ += l;
+            *outR++ += r;
+        }
+        else
+        {
+            *outL++ += (l + r) * 0.5f;
+        }
+
+        sourceSamplePosition += pitchRatio;
+
+        if (sourceSamplePosition > soundLength)
+        {
+            stopNote (false);
+            break;
+        }
+    }
+
+    return hasRunOutOfData;
+}
+
+void SamplerVoice::renderNextBlock (AudioSampleBuffer& outputBuffer, int startSample, int numSamples)
+{
+    if (const SamplerSound* const playingSound = static_cast <SamplerSound*> (getCurrentlyPlayingSound().get()))
+    {
+        if (playingSound->data == nullptr)
+        {
+            stopNote (false);
+        }
+        else if (playingSound->isStreaming())
+        {
+            jassert (diskStream != nullptr);
+
+            const SamplerHelpers::StreamedSampleSource source (*playingSound->data, playingSound->preloadLength,
+                                                               diskStream->getBuffer(), diskStream->getMask(),
+                                                               diskStream->getAvailableEnd());
+
+            if (renderSamples (source, playingSound->length, outputBuffer, startSample, numSamples))
+                ++numUnderruns;
+
+            diskStream->setReadPosition ((int) sourceSamplePosition);
+        }
+        else
+        {
+            renderSamples (SamplerHelpers::InMemorySampleSource (*playingSound->data),
+                           playingSound->length, outputBuffer, startSample, numSamples);
+        }
+    }
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class SamplerTests  : public UnitTest
+{
+public:
+    SamplerTests() : UnitTest ("Sampler") {}
+
+    void runTest()
+    {
+        const TemporaryFile tempFile (".wav");
+        const File& file = tempFile.getFile();
+
+        beginTest ("Streamed playback matches in-memory playback");
+
+        expect (writeTestFile (file));
+
+        {
+            // (this thread is never started: the test pumps its clients itself, so that the
+            // streams are always fully primed before each block, whatever the machine's load)
+            TimeSliceThread pumpedThread ("Sampler test reader");
+
+            Synthesiser memorySynth, streamedSynth;
+            createSynth (memorySynth, file, 8, nullptr, 0, 0.1);
+            createSynth (streamedSynth, file, 8, &pumpedThread, 1 << 17, 0.1);
+
+            AudioSampleBuffer memoryOutput (2, testBlockSize), streamedOutput (2, testBlockSize);
+            Random random (getRandom());
+            bool outputsMatch = true;
+
+            for (int block = 0; block < 300; ++block)
             {
-                *outL++ += (l + r) * 0.5f;
+                MidiBuffer midi;
+                createRandomMidi (random, midi, 4, 12);
+
+                primeStreams (pumpedThread);
+
+                memoryOutput.clear();
+                streamedOutput.clear();
+                memorySynth.renderNextBlock (memoryOutput, midi, 0, testBlockSize);
+                streamedSynth.renderNextBlock (streamedOutput, midi, 0, testBlockSize);
+
+                for (int chan = 0; chan < 2; ++chan)
+                    if (memcmp (memoryOutput.getSampleData (chan), streamedOutput.getSampleData (chan),
+                                sizeof (float) * testBlockSize) != 0)
+                        outputsMatch = false;
             }
 
-            sourceSamplePosition += pitchRatio;
+            expect (getNumUnderruns (streamedSynth) == 0);
+            expect (outputsMatch);
+        }
 
-            if (sourceSamplePosition > playingSound->length)
+        beginTest ("Streaming stress test");
+
+        TimeSliceThread thread ("Sampler test reader");
+        thread.startThread();
+
+        {
+            // lots of voices playing up to two octaves above the root note, with short
+            // buffers, rendered in real time so that the reader thread has to keep up
+            const int numVoices = 64;
+            Synthesiser synth;
+            createSynth (synth, file, numVoices, &thread, 8192, 0.05);
+
+            AudioSampleBuffer output (2, testBlockSize);
+            Random random (getRandom());
+            const int numBlocks = (int) (2.0 * sampleRate / testBlockSize);
+            const double blockTimeMs = 1000.0 * testBlockSize / sampleRate;
+            const double startTime = Time::getMillisecondCounterHiRes();
+            float maxLevel = 0;
+
+            for (int block = 0; block < numBlocks; ++block)
             {
-                stopNote (false);
-                break;
+                MidiBuffer midi;
+                createRandomMidi (random, midi, numVoices / 4, 24);
+
+                output.clear();
+                synth.renderNextBlock (output, midi, 0, testBlockSize);
+                maxLevel = jmax (maxLevel, output.getMagnitude (0, testBlockSize));
+
+                const double msToWait = startTime + (block + 1) * blockTimeMs - Time::getMillisecondCounterHiRes();
+
+                if (msToWait >= 1.0)
+                    Thread::sleep ((int) msToWait);
             }
+
+            logMessage (String (numVoices) + " voices: " + String (getNumUnderruns (synth))
+                          + " underruns in " + String (numBlocks) + " blocks");
+
+            expect (maxLevel > 0);
         }
     }
-}
+
+private:
+    enum { testBlockSize = 512 };
+    static const double sampleRate;
+
+    static bool writeTestFile (const File& file)
+    {
+        // a 2 second stereo file with a different noisy tone in each channel
+        const int numSamples = (int) (2.0 * sampleRate);
+        AudioSampleBuffer buffer (2, numSamples);
+        Random random (1);
+
+        for (int chan = 0; chan < 2; ++chan)
+            for (int i = 0; i < numSamples; ++i)
+                buffer.getSampleData (chan)[i] = 0.4f * (float) std::sin (i * (chan + 1) * 0.03)
+                                                   + 0.1f * (random.nextFloat() - 0.5f);
+
+        WavAudioFormat wav;
+        ScopedPointer<AudioFormatWriter> writer (wav.createWriterFor (new FileOutputStream (file), sampleRate,
+                                                                      2, 16, StringPairArray(), 0));
+
+        return writer != nullptr && writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+    }
+
+    static void createSynth (Synthesiser& synth, const File& file, const int numVoices,
+                             TimeSliceThread* streamingThread, const int streamingBufferSize,
+                             const double preloadTimeSecs)
+    {
+        BigInteger allNotes;
+        allNotes.setRange (0, 128, true);
+
+        WavAudioFormat wav;
+
+        if (streamingThread != nullptr)
+        {
+            synth.addSound (new SamplerSound ("streamed", wav.createMemoryMappedReader (file),
+                                              allNotes, 60, 0.01, 0.1, preloadTimeSecs));
+
+            for (int i = 0; i < numVoices; ++i)
+                synth.addVoice (new SamplerVoice (*streamingThread, streamingBufferSize));
+        }
+        else
+        {
+            ScopedPointer<AudioFormatReader> reader (wav.createReaderFor (new FileInputStream (file), true));
+            synth.addSound (new SamplerSound ("in-memory", *reader, allNotes, 60, 0.01, 0.1, 10.0));
+
+            for (int i = 0; i < numVoices; ++i)
+                synth.addVoice (new SamplerVoice());
+        }
+
+        synth.setCurrentPlaybackSampleRate (sampleRate);
+    }
+
+    static void createRandomMidi (Random& random, MidiBuffer& midi, const int maxNotes, const int maxInterval)
+    {
+        for (int i = random.nextInt (maxNotes); --i >= 0;)
+        {
+            const int note = 60 - 12 + random.nextInt (12 + maxInterval);
+            const int time = random.nextInt (testBlockSize);
+
+            if (random.nextBool())
+                midi.addEvent (MidiMessage::noteOn (1, note, 0.2f), time);
+            else
+                midi.addEvent (MidiMessage::noteOff (1, note), time);
+        }
+    }
+
+    // Runs each of a (stopped) thread's clients until it has nothing left to read.
+    static void primeStreams (TimeSliceThread& thread)
+    {
+        for (int i = thread.getNumClients(); --i >= 0;)
+            while (thread.getClient (i)->useTimeSlice() == 0)
+            {}
+    }
+
+    static int getNumUnderruns (Synthesiser& synth)
+    {
+        int total = 0;
+
+        for (int i = synth.getNumVoices(); --i >= 0;)
+            total += static_cast<SamplerVoice*> (synth.getVoice (i))->getNumUnderruns();
+
+        return total;
+    }
+};
+
+const double SamplerTests::sampleRate = 44100.0;
+
+static SamplerTests samplerTests;
+
+#endif
@@ -30,8 +30,10 @@
 /**
     A subclass of SynthesiserSound that represents a sampled audio clip.
 
-    This is a pretty basic sampler, and just attempts to load the whole audio stream
-    into memory.
+    This is a pretty basic sampler. By default it just loads the whole audio stream
+    into memory, but it can also be created in a disk-streaming mode, where only the
+    start of the sample is kept in memory, and the rest is read from a memory-mapped
+    file as it's played - see the constructor that takes a MemoryMappedAudioFormatReader.
 
     To use it, create a Synthesiser, add some SamplerVoice objects to it, then
     give it some SampledSound objects to play.
@@ -68,6 +70,37 @@ public:
                   double releaseTimeSecs,
                   double maxSampleLengthSeconds);
 
+    /** Creates a sampled sound that streams its audio from disk.
+
+        Only the first preloadTimeSecs of audio is loaded into memory. The rest of the
+        sound is read on demand by a background thread belonging to each SamplerVoice that
+        plays it, so to play a streamed sound, the voices must have been created with the
+        SamplerVoice constructor that takes a TimeSliceThread.
+
+        The preload length needs to be long enough to cover the worst-case time that the
+        voice's background thread might take to read the first block of data that follows
+        it, at the highest pitch that the sound will be played at. If it's too short, the
+        voice will output silence until the data arrives (see SamplerVoice::getNumUnderruns()).
+
+        @param name         a name for the sample
+        @param source       the audio file to stream from. This object will be deleted by the
+                            SamplerSound when it is no longer needed. Its entire file will be mapped,
+                            so that the background threads can read from any part of it
+        @param midiNotes    the set of midi keys that this sound should be played on
+        @param midiNoteForNormalPitch   the midi note at which the sample should be played
+                                        with its natural rate
+        @param attackTimeSecs   the attack (fade-in) time, in seconds
+        @param releaseTimeSecs  the decay (fade-out) time, in seconds
+        @param preloadTimeSecs  the length of audio from the start of the sample to keep in memory
+    */
+    SamplerSound (const String& name,
+                  MemoryMappedAudioFormatReader* source,
+                  const BigInteger& midiNotes,
+                  int midiNoteForNormalPitch,
+                  double attackTimeSecs,
+                  double releaseTimeSecs,
+                  double preloadTimeSecs);
+
     /** Destructor. */
     ~SamplerSound();
 
@@ -76,10 +109,14 @@ public:
     const String& getName() const noexcept                  { return name; }
 
     /** Returns the audio sample data.
-        This could return nullptr if there was a problem loading the data.
+        This could return nullptr if there was a problem loading the data. For a sound
+        that is being streamed from disk, this only contains the preloaded section.
     */
     AudioSampleBuffer* getAudioData() const noexcept        { return data; }
 
+    /** Returns true if this sound streams its audio from disk rather than holding it all in memory. */
+    bool isStreaming() const noexcept                       { return streamingSource != nullptr; }
+
 
     //==============================================================================
     bool appliesToNote (const int midiNoteNumber) override;
@@ -92,10 +129,11 @@ private:
 
     String name;
     ScopedPointer<AudioSampleBuffer> data;
+    ScopedPointer<MemoryMappedAudioFormatReader> streamingSource;
     double sourceSampleRate;
     BigInteger midiNotes;
     int length, attackSamples, releaseSamples;
-    int midiRootNote;
+    int midiRootNote, preloadLength;
 
     JUCE_LEAK_DETECTOR (SamplerSound)
 };
@@ -114,9 +152,27 @@ class JUCE_API  SamplerVoice    : public SynthesiserVoice
 {
 public:
     //==============================================================================
-    /** Creates a SamplerVoice. */
+    /** Creates a SamplerVoice.
+        A voice created like this can only play SamplerSounds that are held in memory.
+    */
     SamplerVoice();
 
+    /** Creates a SamplerVoice that can also play SamplerSounds which are streamed from disk.
+
+        The voice will register itself with the given thread, which it will use to read
+        ahead of the current playback position into a private buffer.
+
+        @param streamingThread      the thread to use for reading - this must not be deleted
+                                    before the voice. Many voices can share the same thread
+        @param streamingBufferSize  the number of source samples that the voice can buffer ahead
+                                    of its playback position (this will be rounded up to a power
+                                    of two). It needs to be long enough to cover the worst-case
+                                    disk latency at the highest pitch the voice will play at - e.g.
+                                    50ms of latency when playing a 44.1KHz sample 2 octaves up
+                                    needs at least 0.05 * 44100 * 4 samples, plus some headroom
+    */
+    SamplerVoice (TimeSliceThread& streamingThread, int streamingBufferSize);
+
     /** Destructor. */
     ~SamplerVoice();
 
@@ -131,14 +187,31 @@ public:
 
     void renderNextBlock (AudioSampleBuffer&, int startSample, int numSamples) override;
 
+    //==============================================================================
+    /** Returns the number of rendered blocks in which a streamed sound's data hadn't
+        been read from disk in time, and silence was played instead.
+    */
+    int getNumUnderruns() const noexcept                    { return numUnderruns.get(); }
+
+    /** Resets the count returned by getNumUnderruns(). */
+    void resetUnderrunCount() noexcept                      { numUnderruns = 0; }
+
 
 private:
     //==============================================================================
+    class DiskStream;
+    friend struct ContainerDeletePolicy<DiskStream>;
+    ScopedPointer<DiskStream> diskStream;
+    Atomic<int> numUnderruns;
+
     double pitchRatio;
     double sourceSamplePosition;
     float lgain, rgain, attackReleaseLevel, attackDelta, releaseDelta;
     bool isInAttack, isInRelease;
 
+    template <class SampleSource>
+    bool renderSamples (const SampleSource&, int soundLength, AudioSampleBuffer&, int startSample, int numSamples);
+
     JUCE_LEAK_DETECTOR (SamplerVoice)
 };
 
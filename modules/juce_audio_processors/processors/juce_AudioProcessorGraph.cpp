@@ -29,255 +29,537 @@ namespace GraphRenderingOps
 {
 
 //==============================================================================
-class AudioGraphRenderingOp
+/** Records which of the shared audio channels and midi buffers a rendering op
+    touches, so that ops which have nothing in common can be run concurrently.
+*/
+struct SharedBufferUsage
 {
-public:
-    AudioGraphRenderingOp() {}
-    virtual ~AudioGraphRenderingOp()  {}
+    SharedBufferUsage() {}
 
-    virtual void perform (AudioSampleBuffer& sharedBufferChans,
-                          const OwnedArray <MidiBuffer>& sharedMidiBuffers,
-                          const int numSamples) = 0;
+    void readsAudio (const int channel)         { reads.add (getAudioResource (channel)); }
+    void writesAudio (const int channel)        { writes.add (getAudioResource (channel)); }
+    void readsMidi (const int bufferNum)        { reads.add (getMidiResource (bufferNum)); }
+    void writesMidi (const int bufferNum)       { writes.add (getMidiResource (bufferNum)); }
+    void writesGraphOutput()                    { writes.add (graphOutputResource); }
+
+    // Audio channels, midi buffers and the graph's own output buffers all share
+    // one range of resource numbers, so that they can be tracked together.
+    enum { graphOutputResource = 0 };
+    static int getAudioResource (const int channel) noexcept      { return channel * 2 + 1; }
+    static int getMidiResource (const int bufferNum) noexcept     { return bufferNum * 2 + 2; }
 
-    JUCE_LEAK_DETECTOR (AudioGraphRenderingOp)
+    SortedSet<int> reads, writes;
+
+    JUCE_DECLARE_NON_COPYABLE (SharedBufferUsage)
 };
 
 //==============================================================================
-class ClearChannelOp : public AudioGraphRenderingOp
-{
-public:
-    ClearChannelOp (const int channelNum_)
-        : channelNum (channelNum_)
-    {}
+/** A single step in a graph's rendering sequence.
 
-    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray <MidiBuffer>&, const int numSamples)
+    Rather than each op being a separately-allocated polymorphic object, all the
+    ops are packed together into a RenderingProgram, which runs them with a switch
+    statement. For a graph with lots of small mixing ops, that avoids a virtual call
+    and a likely cache-miss per op, which matters at small block sizes.
+*/
+struct RenderingOp
+{
+    enum Type
     {
-        sharedBufferChans.clear (channelNum, 0, numSamples);
-    }
-
-private:
-    const int channelNum;
+        clearChannelOp,
+        copyChannelOp,
+        addChannelOp,
+        addTwoChannelsOp,   // a copy followed by an add, done in a single pass
+        delayChannelOp,
+        clearMidiBufferOp,
+        copyMidiBufferOp,
+        addMidiBufferOp,
+        processBufferOp
+    };
 
-    JUCE_DECLARE_NON_COPYABLE (ClearChannelOp)
+    Type type;
+    int source1, source2, dest;   // shared audio channel or midi buffer numbers
+    int index;                    // for delay and process ops, the index of the object holding their state
 };
 
 //==============================================================================
-class CopyChannelOp : public AudioGraphRenderingOp
+class DelayLine
 {
 public:
-    CopyChannelOp (const int srcChannelNum_, const int dstChannelNum_)
-        : srcChannelNum (srcChannelNum_),
-          dstChannelNum (dstChannelNum_)
-    {}
+    DelayLine (const int numSamplesDelay)
+        : bufferSize (numSamplesDelay + 1),
+          readIndex (0), writeIndex (numSamplesDelay)
+    {
+        buffer.calloc ((size_t) bufferSize);
+    }
 
-    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray <MidiBuffer>&, const int numSamples)
+    void process (float* data, const int numSamples) noexcept
     {
-        sharedBufferChans.copyFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
+        for (int i = numSamples; --i >= 0;)
+        {
+            buffer [writeIndex] = *data;
+            *data++ = buffer [readIndex];
+
+            if (++readIndex  >= bufferSize) readIndex = 0;
+            if (++writeIndex >= bufferSize) writeIndex = 0;
+        }
     }
 
 private:
-    const int srcChannelNum, dstChannelNum;
+    HeapBlock<float> buffer;
+    const int bufferSize;
+    int readIndex, writeIndex;
 
-    JUCE_DECLARE_NON_COPYABLE (CopyChannelOp)
+    JUCE_DECLARE_NON_COPYABLE (DelayLine)
 };
 
 //==============================================================================
-class AddChannelOp : public AudioGraphRenderingOp
+/** Describes a processBufferOp: the node to call, and the shared channels and midi
+    buffer that it should be given. */
+struct ProcessorCallInfo
 {
-public:
-    AddChannelOp (const int srcChannelNum_, const int dstChannelNum_)
-        : srcChannelNum (srcChannelNum_),
-          dstChannelNum (dstChannelNum_)
-    {}
-
-    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray <MidiBuffer>&, const int numSamples)
+    ProcessorCallInfo (const AudioProcessorGraph::Node::Ptr& node_,
+                       const Array <int>& audioChannelsToUse_,
+                       const int totalChans_,
+                       const int midiBufferToUse_)
+        : node (node_),
+          audioChannelsToUse (audioChannelsToUse_),
+          totalChans (totalChans_),
+          midiBufferToUse (midiBufferToUse_)
     {
-        sharedBufferChans.addFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
     }
 
-private:
-    const int srcChannelNum, dstChannelNum;
+    const AudioProcessorGraph::Node::Ptr node;
+    const Array <int> audioChannelsToUse;
+    const int totalChans, midiBufferToUse;
 
-    JUCE_DECLARE_NON_COPYABLE (AddChannelOp)
+    JUCE_DECLARE_NON_COPYABLE (ProcessorCallInfo)
 };
 
 //==============================================================================
-class ClearMidiBufferOp : public AudioGraphRenderingOp
+class ProcessorCall
 {
 public:
-    ClearMidiBufferOp (const int bufferNum_)
-        : bufferNum (bufferNum_)
-    {}
+    ProcessorCall (const ProcessorCallInfo& info)
+        : node (info.node),
+          processor (info.node->getProcessor()),
+          audioChannelsToUse (info.audioChannelsToUse),
+          totalChans (jmax (1, info.totalChans)),
+          midiBufferToUse (info.midiBufferToUse)
+    {
+        channels.calloc ((size_t) totalChans);
+
+        while (audioChannelsToUse.size() < totalChans)
+            audioChannelsToUse.add (0);
+    }
+
+    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray <MidiBuffer>& sharedMidiBuffers, const int numSamples)
+    {
+        for (int i = totalChans; --i >= 0;)
+            channels[i] = sharedBufferChans.getSampleData (audioChannelsToUse.getUnchecked (i), 0);
+
+        AudioSampleBuffer buffer (channels, totalChans, numSamples);
+
+        processor->processBlock (buffer, *sharedMidiBuffers.getUnchecked (midiBufferToUse));
+    }
 
-    void perform (AudioSampleBuffer&, const OwnedArray <MidiBuffer>& sharedMidiBuffers, const int)
+    void getBufferUsage (SharedBufferUsage& usage) const
     {
-        sharedMidiBuffers.getUnchecked (bufferNum)->clear();
+        for (int i = totalChans; --i >= 0;)
+        {
+            const int chan = audioChannelsToUse.getUnchecked (i);
+
+            if (chan == 0)
+                usage.readsAudio (chan); // (the first channel is the read-only empty buffer)
+            else
+                usage.writesAudio (chan);
+        }
+
+        usage.writesMidi (midiBufferToUse);
+
+        // the graph's output nodes all mix into the same buffers, so they mustn't overlap
+        if (AudioProcessorGraph::AudioGraphIOProcessor* const ioProc
+                = dynamic_cast <AudioProcessorGraph::AudioGraphIOProcessor*> (processor))
+            if (ioProc->isOutput())
+                usage.writesGraphOutput();
     }
 
+    const AudioProcessorGraph::Node::Ptr node;
+    AudioProcessor* const processor;
+
 private:
-    const int bufferNum;
+    Array <int> audioChannelsToUse;
+    HeapBlock <float*> channels;
+    int totalChans;
+    int midiBufferToUse;
 
-    JUCE_DECLARE_NON_COPYABLE (ClearMidiBufferOp)
+    JUCE_DECLARE_NON_COPYABLE (ProcessorCall)
 };
 
 //==============================================================================
-class CopyMidiBufferOp : public AudioGraphRenderingOp
+/** The ops that make up a RenderingProgram, held as plain values.
+
+    The RenderingOpSequenceCalculator keeps hold of these between builds, so that
+    after the graph has been edited, it can keep the ops for the nodes that haven't
+    been affected and only work out the rest again.
+*/
+struct RenderingOpList
 {
-public:
-    CopyMidiBufferOp (const int srcBufferNum_, const int dstBufferNum_)
-        : srcBufferNum (srcBufferNum_),
-          dstBufferNum (dstBufferNum_)
-    {}
+    RenderingOpList() {}
+
+    void addClearChannelOp (const int channel)                      { addOp (RenderingOp::clearChannelOp, 0, 0, channel, 0); }
+    void addCopyChannelOp (const int source, const int dest)        { addOp (RenderingOp::copyChannelOp, source, 0, dest, 0); }
+    void addClearMidiBufferOp (const int bufferNum)                 { addOp (RenderingOp::clearMidiBufferOp, 0, 0, bufferNum, 0); }
+    void addCopyMidiBufferOp (const int source, const int dest)     { addOp (RenderingOp::copyMidiBufferOp, source, 0, dest, 0); }
+    void addAddMidiBufferOp (const int source, const int dest)      { addOp (RenderingOp::addMidiBufferOp, source, 0, dest, 0); }
+
+    void addAddChannelOp (const int source, const int dest)
+    {
+        // If the previous op just cleared or filled the same channel, the two
+        // can be combined, saving a pass over the data..
+        if (ops.size() > 0)
+        {
+            RenderingOp& last = ops.getReference (ops.size() - 1);
+
+            if (last.dest == dest && source != dest)
+            {
+                if (last.type == RenderingOp::clearChannelOp)
+                {
+                    last.type = RenderingOp::copyChannelOp;
+                    last.source1 = source;
+                    return;
+                }
+
+                if (last.type == RenderingOp::copyChannelOp && last.source1 != dest)
+                {
+                    last.type = RenderingOp::addTwoChannelsOp;
+                    last.source2 = source;
+                    return;
+                }
+            }
+        }
+
+        addOp (RenderingOp::addChannelOp, source, 0, dest, 0);
+    }
+
+    void addDelayChannelOp (const int channel, const int numSamplesDelay)
+    {
+        addOp (RenderingOp::delayChannelOp, 0, 0, channel, delays.size());
+        delays.add (numSamplesDelay);
+    }
 
-    void perform (AudioSampleBuffer&, const OwnedArray <MidiBuffer>& sharedMidiBuffers, const int)
+    void addProcessBufferOp (const AudioProcessorGraph::Node::Ptr& node, const Array <int>& audioChannelsToUse,
+                             const int totalChans, const int midiBufferToUse)
     {
-        *sharedMidiBuffers.getUnchecked (dstBufferNum) = *sharedMidiBuffers.getUnchecked (srcBufferNum);
+        addOp (RenderingOp::processBufferOp, 0, 0, 0, processorCalls.size());
+        processorCalls.add (new ProcessorCallInfo (node, audioChannelsToUse, totalChans, midiBufferToUse));
     }
 
+    // Throws away all the ops after the given number, along with their delays and processor calls.
+    void truncate (const int numOpsToKeep, const int numDelaysToKeep, const int numProcessorCallsToKeep)
+    {
+        ops.removeRange (numOpsToKeep, ops.size() - numOpsToKeep);
+        delays.removeRange (numDelaysToKeep, delays.size() - numDelaysToKeep);
+        processorCalls.removeRange (numProcessorCallsToKeep, processorCalls.size() - numProcessorCallsToKeep);
+    }
+
+    Array<RenderingOp> ops;
+    Array<int> delays;   // the length of each delay op's delay, in samples
+    OwnedArray<ProcessorCallInfo> processorCalls;
+
 private:
-    const int srcBufferNum, dstBufferNum;
+    void addOp (const RenderingOp::Type type, const int source1, const int source2, const int dest, const int index)
+    {
+        const RenderingOp op = { type, source1, source2, dest, index };
+        ops.add (op);
+    }
 
-    JUCE_DECLARE_NON_COPYABLE (CopyMidiBufferOp)
+    JUCE_DECLARE_NON_COPYABLE (RenderingOpList)
 };
 
 //==============================================================================
-class AddMidiBufferOp : public AudioGraphRenderingOp
+/** Holds a graph's rendering ops in one contiguous array, and runs them. */
+class RenderingProgram
 {
 public:
-    AddMidiBufferOp (const int srcBufferNum_, const int dstBufferNum_)
-        : srcBufferNum (srcBufferNum_),
-          dstBufferNum (dstBufferNum_)
-    {}
+    RenderingProgram() {}
 
-    void perform (AudioSampleBuffer&, const OwnedArray <MidiBuffer>& sharedMidiBuffers, const int numSamples)
+    void setOps (const RenderingOpList& list)
     {
-        sharedMidiBuffers.getUnchecked (dstBufferNum)
-            ->addEvents (*sharedMidiBuffers.getUnchecked (srcBufferNum), 0, numSamples, 0);
+        ops = list.ops;
+
+        for (int i = 0; i < list.delays.size(); ++i)
+            delayLines.add (new DelayLine (list.delays.getUnchecked(i)));
+
+        for (int i = 0; i < list.processorCalls.size(); ++i)
+            processorCalls.add (new ProcessorCall (*list.processorCalls.getUnchecked(i)));
     }
 
-private:
-    const int srcBufferNum, dstBufferNum;
+    //==============================================================================
+    int getNumOps() const noexcept                          { return ops.size(); }
 
-    JUCE_DECLARE_NON_COPYABLE (AddMidiBufferOp)
-};
+    bool isProcessBufferOp (const int opIndex) const noexcept
+    {
+        return ops.getReference (opIndex).type == RenderingOp::processBufferOp;
+    }
 
-//==============================================================================
-class DelayChannelOp : public AudioGraphRenderingOp
-{
-public:
-    DelayChannelOp (const int channel_, const int numSamplesDelay_)
-        : channel (channel_),
-          bufferSize (numSamplesDelay_ + 1),
-          readIndex (0), writeIndex (numSamplesDelay_)
+    void getBufferUsage (const int opIndex, SharedBufferUsage& usage) const
     {
-        buffer.calloc ((size_t) bufferSize);
+        const RenderingOp& op = ops.getReference (opIndex);
+
+        switch (op.type)
+        {
+            case RenderingOp::clearChannelOp:
+            case RenderingOp::delayChannelOp:       usage.writesAudio (op.dest); break;
+
+            case RenderingOp::addTwoChannelsOp:     usage.readsAudio (op.source2); usage.readsAudio (op.source1); usage.writesAudio (op.dest); break;
+
+            case RenderingOp::copyChannelOp:
+            case RenderingOp::addChannelOp:         usage.readsAudio (op.source1); usage.writesAudio (op.dest); break;
+
+            case RenderingOp::clearMidiBufferOp:    usage.writesMidi (op.dest); break;
+
+            case RenderingOp::copyMidiBufferOp:
+            case RenderingOp::addMidiBufferOp:      usage.readsMidi (op.source1); usage.writesMidi (op.dest); break;
+
+            case RenderingOp::processBufferOp:      processorCalls.getUnchecked (op.index)->getBufferUsage (usage); break;
+            default:                                jassertfalse; break;
+        }
     }
 
-    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray <MidiBuffer>&, const int numSamples)
+    //==============================================================================
+    void perform (AudioSampleBuffer& sharedBufferChans,
+                  const OwnedArray <MidiBuffer>& sharedMidiBuffers,
+                  const int numSamples)
     {
-        float* data = sharedBufferChans.getSampleData (channel, 0);
+        perform (0, ops.size(), sharedBufferChans, sharedMidiBuffers, numSamples);
+    }
 
-        for (int i = numSamples; --i >= 0;)
+    void perform (const int startOp, const int endOp,
+                  AudioSampleBuffer& sharedBufferChans,
+                  const OwnedArray <MidiBuffer>& sharedMidiBuffers,
+                  const int numSamples)
+    {
+        float* const* const chans = sharedBufferChans.getArrayOfChannels();
+        const RenderingOp* const opData = ops.getRawDataPointer();
+
+        for (int i = startOp; i < endOp; ++i)
         {
-            buffer [writeIndex] = *data;
-            *data++ = buffer [readIndex];
+            const RenderingOp& op = opData[i];
 
-            if (++readIndex  >= bufferSize) readIndex = 0;
-            if (++writeIndex >= bufferSize) writeIndex = 0;
+            switch (op.type)
+            {
+                case RenderingOp::clearChannelOp:       FloatVectorOperations::clear (chans [op.dest], numSamples); break;
+                case RenderingOp::copyChannelOp:        FloatVectorOperations::copy (chans [op.dest], chans [op.source1], numSamples); break;
+                case RenderingOp::addChannelOp:         FloatVectorOperations::add (chans [op.dest], chans [op.source1], numSamples); break;
+                case RenderingOp::addTwoChannelsOp:     FloatVectorOperations::add (chans [op.dest], chans [op.source1], chans [op.source2], numSamples); break;
+                case RenderingOp::delayChannelOp:       delayLines.getUnchecked (op.index)->process (chans [op.dest], numSamples); break;
+                case RenderingOp::clearMidiBufferOp:    sharedMidiBuffers.getUnchecked (op.dest)->clear(); break;
+                case RenderingOp::copyMidiBufferOp:     *sharedMidiBuffers.getUnchecked (op.dest) = *sharedMidiBuffers.getUnchecked (op.source1); break;
+                case RenderingOp::addMidiBufferOp:      sharedMidiBuffers.getUnchecked (op.dest)->addEvents (*sharedMidiBuffers.getUnchecked (op.source1), 0, numSamples, 0); break;
+                case RenderingOp::processBufferOp:      processorCalls.getUnchecked (op.index)->perform (sharedBufferChans, sharedMidiBuffers, numSamples); break;
+                default:                                jassertfalse; break;
+            }
         }
     }
 
 private:
-    HeapBlock<float> buffer;
-    const int channel, bufferSize;
-    int readIndex, writeIndex;
+    //==============================================================================
+    Array<RenderingOp> ops;
+    OwnedArray<DelayLine> delayLines;
+    OwnedArray<ProcessorCall> processorCalls;
 
-    JUCE_DECLARE_NON_COPYABLE (DelayChannelOp)
+    JUCE_DECLARE_NON_COPYABLE (RenderingProgram)
 };
 
-
 //==============================================================================
-class ProcessBufferOp : public AudioGraphRenderingOp
+struct ConnectionSorter
 {
-public:
-    ProcessBufferOp (const AudioProcessorGraph::Node::Ptr& node_,
-                     const Array <int>& audioChannelsToUse_,
-                     const int totalChans_,
-                     const int midiBufferToUse_)
-        : node (node_),
-          processor (node_->getProcessor()),
-          audioChannelsToUse (audioChannelsToUse_),
-          totalChans (jmax (1, totalChans_)),
-          midiBufferToUse (midiBufferToUse_)
+    static int compareElements (const AudioProcessorGraph::Connection* const first,
+                                const AudioProcessorGraph::Connection* const second) noexcept
     {
-        channels.calloc ((size_t) totalChans);
+        if (first->sourceNodeId < second->sourceNodeId)                return -1;
+        if (first->sourceNodeId > second->sourceNodeId)                return 1;
+        if (first->destNodeId < second->destNodeId)                    return -1;
+        if (first->destNodeId > second->destNodeId)                    return 1;
+        if (first->sourceChannelIndex < second->sourceChannelIndex)    return -1;
+        if (first->sourceChannelIndex > second->sourceChannelIndex)    return 1;
+        if (first->destChannelIndex < second->destChannelIndex)        return -1;
+        if (first->destChannelIndex > second->destChannelIndex)        return 1;
 
-        while (audioChannelsToUse.size() < totalChans)
-            audioChannelsToUse.add (0);
+        return 0;
     }
+};
 
-    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray <MidiBuffer>& sharedMidiBuffers, const int numSamples)
+//==============================================================================
+/** Remembers how a RenderingOpSequenceCalculator last worked out a graph's ops.
+
+    As well as the ops, this keeps the state of the shared buffers at the end of the
+    last build, and a log of every change that was made to them along the way. Undoing
+    the log gets back to the state at the start of any earlier step, so a rebuild can
+    carry on from there.
+*/
+struct RenderingHistory
+{
+    RenderingHistory() : reusedFreedBuffers (false) {}
+
+    struct Step
     {
-        for (int i = totalChans; --i >= 0;)
-            channels[i] = sharedBufferChans.getSampleData (audioChannelsToUse.getUnchecked (i), 0);
+        const AudioProcessorGraph::Node* node;
+        uint32 nodeId;
+        int numIns, numOuts, latency;
+        bool acceptsMidi, producesMidi;
 
-        AudioSampleBuffer buffer (channels, totalChans, numSamples);
+        // the sizes of the op list and the buffer log when this step began
+        int numOps, numDelays, numProcessorCalls, numBufferChanges;
 
-        processor->processBlock (buffer, *sharedMidiBuffers.getUnchecked (midiBufferToUse));
+        bool matches (const AudioProcessorGraph::Node* const n) const
+        {
+            const AudioProcessor* const p = n->getProcessor();
+
+            return node == n
+                && numIns == p->getNumInputChannels()
+                && numOuts == p->getNumOutputChannels()
+                && latency == p->getLatencySamples()
+                && acceptsMidi == p->acceptsMidi()
+                && producesMidi == p->producesMidi();
+        }
+    };
+
+    struct BufferChange
+    {
+        bool isMidi, wasAdded;
+        int index;
+        uint32 previousNodeId;
+        int previousChannel;
+    };
+
+    // Puts the ops and buffers back to the way they were at the start of the given step.
+    void rewindTo (const int stepIndex)
+    {
+        if (stepIndex >= steps.size())
+            return;
+
+        const Step step (steps.getReference (stepIndex));
+
+        ops.truncate (step.numOps, step.numDelays, step.numProcessorCalls);
+
+        for (int i = bufferChanges.size(); --i >= step.numBufferChanges;)
+        {
+            const BufferChange& change = bufferChanges.getReference (i);
+
+            if (change.isMidi)
+            {
+                if (change.wasAdded)
+                    midiNodeIds.removeLast();
+                else
+                    midiNodeIds.set (change.index, change.previousNodeId);
+            }
+            else
+            {
+                if (change.wasAdded)
+                {
+                    nodeIds.removeLast();
+                    channels.removeLast();
+                }
+                else
+                {
+                    nodeIds.set (change.index, change.previousNodeId);
+                    channels.set (change.index, change.previousChannel);
+                }
+            }
+        }
+
+        bufferChanges.removeRange (step.numBufferChanges, bufferChanges.size() - step.numBufferChanges);
+        steps.removeRange (stepIndex, steps.size() - stepIndex);
     }
 
-    const AudioProcessorGraph::Node::Ptr node;
-    AudioProcessor* const processor;
+    Array<Step> steps;
+    OwnedArray<AudioProcessorGraph::Connection> connections;   // sorted with a ConnectionSorter
+    RenderingOpList ops;
 
-private:
-    Array <int> audioChannelsToUse;
-    HeapBlock <float*> channels;
-    int totalChans;
-    int midiBufferToUse;
+    Array <int> channels;
+    Array <uint32> nodeIds, midiNodeIds;
+    Array<BufferChange> bufferChanges;
+    bool reusedFreedBuffers;
 
-    JUCE_DECLARE_NON_COPYABLE (ProcessBufferOp)
+    JUCE_DECLARE_NON_COPYABLE (RenderingHistory)
 };
 
 //==============================================================================
 /** Used to calculate the correct sequence of rendering ops needed, based on
     the best re-use of shared buffers at each stage.
+
+    The ops end up in the RenderingHistory that's passed in. If that holds the results
+    of an earlier build, only the steps from the first one that the graph's changes
+    could have affected are worked out again; the ops and buffer assignments for all
+    the nodes before that are kept as they were.
 */
 class RenderingOpSequenceCalculator
 {
 public:
     //==============================================================================
     RenderingOpSequenceCalculator (AudioProcessorGraph& graph_,
-                                   const Array<void*>& orderedNodes_,
-                                   Array<void*>& renderingOps)
+                                   const Array<AudioProcessorGraph::Node*>& orderedNodes_,
+                                   RenderingHistory& history_,
+                                   const bool reuseFreedBuffers_)
         : graph (graph_),
           orderedNodes (orderedNodes_),
-          totalLatency (0)
+          history (history_),
+          channels (history_.channels),
+          nodeIds (history_.nodeIds),
+          midiNodeIds (history_.midiNodeIds),
+          totalLatency (0),
+          reuseFreedBuffers (reuseFreedBuffers_),
+          numStepsReused (0)
     {
-        nodeIds.add ((uint32) zeroNodeID); // first buffer is read-only zeros
-        channels.add (0);
+        buildConnectionIndex();
 
-        midiNodeIds.add ((uint32) zeroNodeID);
+        numStepsReused = findFirstStepToRebuild();
+        history.rewindTo (numStepsReused);
 
-        for (int i = 0; i < orderedNodes.size(); ++i)
+        if (nodeIds.size() == 0)
+        {
+            nodeIds.add ((uint32) zeroNodeID); // first buffer is read-only zeros
+            channels.add (0);
+
+            midiNodeIds.add ((uint32) zeroNodeID);
+        }
+
+        // the steps that are being kept still pass their latency on to the later ones..
+        for (int i = 0; i < numStepsReused; ++i)
+            updateLatencies (orderedNodes.getUnchecked(i), getInputLatencyForNode (i));
+
+        for (int i = numStepsReused; i < orderedNodes.size(); ++i)
         {
-            createRenderingOpsForNode ((AudioProcessorGraph::Node*) orderedNodes.getUnchecked(i),
-                                       renderingOps, i);
+            addStepToHistory (orderedNodes.getUnchecked(i));
+
+            createRenderingOpsForNode (orderedNodes.getUnchecked(i), history.ops, i);
 
             markAnyUnusedBuffersAsFree (i);
         }
 
+        history.connections.clear();
+
+        for (int i = 0; i < graph.getNumConnections(); ++i)
+            history.connections.add (new AudioProcessorGraph::Connection (*graph.getConnection (i)));
+
+        history.reusedFreedBuffers = reuseFreedBuffers;
+
         graph.setLatencySamples (totalLatency);
     }
 
     int getNumBuffersNeeded() const         { return nodeIds.size(); }
     int getNumMidiBuffersNeeded() const     { return midiNodeIds.size(); }
+    int getNumStepsReused() const           { return numStepsReused; }
 
 private:
     //==============================================================================
     AudioProcessorGraph& graph;
-    const Array<void*>& orderedNodes;
-    Array <int> channels;
-    Array <uint32> nodeIds, midiNodeIds;
+    const Array<AudioProcessorGraph::Node*>& orderedNodes;
+    RenderingHistory& history;
+    Array <int>& channels;
+    Array <uint32>& nodeIds;
+    Array <uint32>& midiNodeIds;
 
     enum { freeNodeID = 0xffffffff, zeroNodeID = 0xfffffffe };
 
@@ -287,6 +569,13 @@ private:
     Array <int> nodeDelays;
     int totalLatency;
 
+    // When rendering in parallel, recycling a buffer that an unrelated node has
+    // finished with would force the two nodes to run one after the other, so each
+    // node gets buffers of its own instead.
+    const bool reuseFreedBuffers;
+
+    int numStepsReused;
+
     int getNodeDelay (const uint32 nodeID) const          { return nodeDelays [nodeDelayIDs.indexOf (nodeID)]; }
 
     void setNodeDelay (const uint32 nodeID, const int latency)
@@ -304,24 +593,186 @@ private:
         }
     }
 
-    int getInputLatencyForNode (const uint32 nodeID) const
+    int getInputLatencyForNode (const int step) const
     {
+        const Array<const AudioProcessorGraph::Connection*>& inputs = *nodeInputs.getUnchecked (step);
         int maxLatency = 0;
 
+        for (int i = 0; i < inputs.size(); ++i)
+            maxLatency = jmax (maxLatency, getNodeDelay (inputs.getUnchecked(i)->sourceNodeId));
+
+        return maxLatency;
+    }
+
+    void updateLatencies (const AudioProcessorGraph::Node* const node, const int maxInputLatency)
+    {
+        setNodeDelay (node->nodeId, maxInputLatency + node->getProcessor()->getLatencySamples());
+
+        if (node->getProcessor()->getNumOutputChannels() == 0)
+            totalLatency = maxInputLatency;
+    }
+
+    //==============================================================================
+    // Rather than searching the whole connection list over and over again, the calculator
+    // indexes it up-front: each step gets a list of the connections that feed into it
+    // (in the same order that a backwards search of the graph's connections would find
+    // them), and every use of a node's output channel is kept in a sorted table, so that
+    // isBufferNeededLater() can be answered with a binary search.
+    struct ChannelUse
+    {
+        uint32 sourceNodeId;
+        int sourceChannel, step, destChannel;
+    };
+
+    struct ChannelUseSorter
+    {
+        static int compareElements (const ChannelUse& first, const ChannelUse& second) noexcept
+        {
+            if (first.sourceNodeId < second.sourceNodeId)      return -1;
+            if (first.sourceNodeId > second.sourceNodeId)      return 1;
+            if (first.sourceChannel < second.sourceChannel)    return -1;
+            if (first.sourceChannel > second.sourceChannel)    return 1;
+            if (first.step < second.step)                      return -1;
+            if (first.step > second.step)                      return 1;
+            if (first.destChannel < second.destChannel)        return -1;
+            if (first.destChannel > second.destChannel)        return 1;
+
+            return 0;
+        }
+    };
+
+    OwnedArray<Array<const AudioProcessorGraph::Connection*> > nodeInputs;
+    Array<ChannelUse> channelUses;
+    HashMap<int, int> stepsForNodes;
+
+    void buildConnectionIndex()
+    {
+        for (int i = 0; i < orderedNodes.size(); ++i)
+        {
+            stepsForNodes.set ((int) orderedNodes.getUnchecked(i)->nodeId, i);
+            nodeInputs.add (new Array<const AudioProcessorGraph::Connection*>());
+        }
+
         for (int i = graph.getNumConnections(); --i >= 0;)
         {
             const AudioProcessorGraph::Connection* const c = graph.getConnection (i);
 
-            if (c->destNodeId == nodeID)
-                maxLatency = jmax (maxLatency, getNodeDelay (c->sourceNodeId));
+            if (stepsForNodes.contains ((int) c->destNodeId))
+            {
+                const int step = stepsForNodes [(int) c->destNodeId];
+                nodeInputs.getUnchecked (step)->add (c);
+
+                const bool isMidi = (c->destChannelIndex == AudioProcessorGraph::midiChannelIndex);
+
+                if (isMidi ? (c->sourceChannelIndex == AudioProcessorGraph::midiChannelIndex)
+                           : isPositiveAndBelow (c->destChannelIndex, orderedNodes.getUnchecked (step)->getProcessor()->getNumInputChannels()))
+                {
+                    const ChannelUse use = { c->sourceNodeId, c->sourceChannelIndex, step, c->destChannelIndex };
+                    channelUses.add (use);
+                }
+            }
         }
 
-        return maxLatency;
+        ChannelUseSorter sorter;
+        channelUses.sort (sorter);
+    }
+
+    int getStepForNode (const uint32 nodeId) const
+    {
+        return stepsForNodes.contains ((int) nodeId) ? stepsForNodes [(int) nodeId]
+                                                     : std::numeric_limits<int>::max();
+    }
+
+    //==============================================================================
+    // Works out how many of the steps from the last build can be kept. A step can only be
+    // kept if all the nodes up to and including it are the same as last time, and none of
+    // the changes since then alter how long the buffers in use at that point are needed for.
+    int findFirstStepToRebuild() const
+    {
+        if (history.reusedFreedBuffers != reuseFreedBuffers)
+            return 0;
+
+        const Array<RenderingHistory::Step>& oldSteps = history.steps;
+        int firstStep = jmin (oldSteps.size(), orderedNodes.size());
+
+        HashMap<int, int> oldStepsForNodes;
+
+        for (int i = oldSteps.size(); --i >= 0;)
+            oldStepsForNodes.set ((int) oldSteps.getReference(i).nodeId, i);
+
+        for (int i = 0; i < orderedNodes.size(); ++i)
+        {
+            const AudioProcessorGraph::Node* const node = orderedNodes.getUnchecked(i);
+
+            if (i < firstStep && oldSteps.getReference(i).node != node)
+                firstStep = i;
+
+            // a node that's new, or whose channels or latency have changed, needs its own step
+            // redoing, and so do all the nodes that feed into it, because it may use their
+            // outputs for longer or shorter than before..
+            if (! (oldStepsForNodes.contains ((int) node->nodeId)
+                    && oldSteps.getReference (oldStepsForNodes [(int) node->nodeId]).matches (node)))
+            {
+                firstStep = jmin (firstStep, i);
+
+                const Array<const AudioProcessorGraph::Connection*>& inputs = *nodeInputs.getUnchecked (i);
+
+                for (int j = 0; j < inputs.size(); ++j)
+                    firstStep = jmin (firstStep, getStepForNode (inputs.getUnchecked(j)->sourceNodeId));
+            }
+        }
+
+        // ..and the same goes for both ends of any connection that's been made or broken.
+        const OwnedArray<AudioProcessorGraph::Connection>& oldConnections = history.connections;
+        ConnectionSorter sorter;
+        int oldIndex = 0, newIndex = 0;
+
+        while (oldIndex < oldConnections.size() || newIndex < graph.getNumConnections())
+        {
+            const AudioProcessorGraph::Connection* const oldConnection = oldConnections [oldIndex];
+            const AudioProcessorGraph::Connection* const newConnection = graph.getConnection (newIndex);
+
+            const int comparison = oldConnection == nullptr ? 1
+                                    : (newConnection == nullptr ? -1
+                                        : sorter.compareElements (oldConnection, newConnection));
+
+            if (comparison == 0)
+            {
+                ++oldIndex;
+                ++newIndex;
+                continue;
+            }
+
+            const AudioProcessorGraph::Connection* const changed = (comparison < 0) ? oldConnection : newConnection;
+
+            firstStep = jmin (firstStep,
+                              getStepForNode (changed->sourceNodeId),
+                              getStepForNode (changed->destNodeId));
+
+            if (comparison < 0)
+                ++oldIndex;
+            else
+                ++newIndex;
+        }
+
+        return firstStep;
+    }
+
+    void addStepToHistory (const AudioProcessorGraph::Node* const node)
+    {
+        const AudioProcessor* const p = node->getProcessor();
+
+        const RenderingHistory::Step step = { node, node->nodeId,
+                                              p->getNumInputChannels(), p->getNumOutputChannels(), p->getLatencySamples(),
+                                              p->acceptsMidi(), p->producesMidi(),
+                                              history.ops.ops.size(), history.ops.delays.size(),
+                                              history.ops.processorCalls.size(), history.bufferChanges.size() };
+        history.steps.add (step);
     }
 
     //==============================================================================
     void createRenderingOpsForNode (AudioProcessorGraph::Node* const node,
-                                    Array<void*>& renderingOps,
+                                    RenderingOpList& renderingOps,
                                     const int ourRenderingIndex)
     {
         const int numIns = node->getProcessor()->getNumInputChannels();
@@ -331,7 +782,9 @@ private:
         Array <int> audioChannelsToUse;
         int midiBufferToUse = -1;
 
-        int maxLatency = getInputLatencyForNode (node->nodeId);
+        const Array<const AudioProcessorGraph::Connection*>& inputs = *nodeInputs.getUnchecked (ourRenderingIndex);
+
+        int maxLatency = getInputLatencyForNode (ourRenderingIndex);
 
         for (int inputChan = 0; inputChan < numIns; ++inputChan)
         {
@@ -339,11 +792,11 @@ private:
             Array <uint32> sourceNodes;
             Array<int> sourceOutputChans;
 
-            for (int i = graph.getNumConnections(); --i >= 0;)
+            for (int i = 0; i < inputs.size(); ++i)
             {
-                const AudioProcessorGraph::Connection* const c = graph.getConnection (i);
+                const AudioProcessorGraph::Connection* const c = inputs.getUnchecked (i);
 
-                if (c->destNodeId == node->nodeId && c->destChannelIndex == inputChan)
+                if (c->destChannelIndex == inputChan)
                 {
                     sourceNodes.add (c->sourceNodeId);
                     sourceOutputChans.add (c->sourceChannelIndex);
@@ -364,7 +817,7 @@ private:
                 else
                 {
                     bufIndex = getFreeBuffer (false);
-                    renderingOps.add (new ClearChannelOp (bufIndex));
+                    renderingOps.addClearChannelOp (bufIndex);
                 }
             }
             else if (sourceNodes.size() == 1)
@@ -391,7 +844,7 @@ private:
                     // need to use a copy of it..
                     const int newFreeBuffer = getFreeBuffer (false);
 
-                    renderingOps.add (new CopyChannelOp (bufIndex, newFreeBuffer));
+                    renderingOps.addCopyChannelOp (bufIndex, newFreeBuffer);
 
                     bufIndex = newFreeBuffer;
                 }
@@ -399,7 +852,7 @@ private:
                 const int nodeDelay = getNodeDelay (srcNode);
 
                 if (nodeDelay < maxLatency)
-                    renderingOps.add (new DelayChannelOp (bufIndex, maxLatency - nodeDelay));
+                    renderingOps.addDelayChannelOp (bufIndex, maxLatency - nodeDelay);
             }
             else
             {
@@ -425,7 +878,7 @@ private:
 
                         const int nodeDelay = getNodeDelay (sourceNodes.getUnchecked (i));
                         if (nodeDelay < maxLatency)
-                            renderingOps.add (new DelayChannelOp (sourceBufIndex, maxLatency - nodeDelay));
+                            renderingOps.addDelayChannelOp (sourceBufIndex, maxLatency - nodeDelay);
 
                         break;
                     }
@@ -442,18 +895,18 @@ private:
                     if (srcIndex < 0)
                     {
                         // if not found, this is probably a feedback loop
-                        renderingOps.add (new ClearChannelOp (bufIndex));
+                        renderingOps.addClearChannelOp (bufIndex);
                     }
                     else
                     {
-                        renderingOps.add (new CopyChannelOp (srcIndex, bufIndex));
+                        renderingOps.addCopyChannelOp (srcIndex, bufIndex);
                     }
 
                     reusableInputIndex = 0;
                     const int nodeDelay = getNodeDelay (sourceNodes.getFirst());
 
                     if (nodeDelay < maxLatency)
-                        renderingOps.add (new DelayChannelOp (bufIndex, maxLatency - nodeDelay));
+                        renderingOps.addDelayChannelOp (bufIndex, maxLatency - nodeDelay);
                 }
 
                 for (int j = 0; j < sourceNodes.size(); ++j)
@@ -472,18 +925,18 @@ private:
                                                            sourceNodes.getUnchecked(j),
                                                            sourceOutputChans.getUnchecked(j)))
                                 {
-                                    renderingOps.add (new DelayChannelOp (srcIndex, maxLatency - nodeDelay));
+                                    renderingOps.addDelayChannelOp (srcIndex, maxLatency - nodeDelay);
                                 }
                                 else // buffer is reused elsewhere, can't be delayed
                                 {
                                     const int bufferToDelay = getFreeBuffer (false);
-                                    renderingOps.add (new CopyChannelOp (srcIndex, bufferToDelay));
-                                    renderingOps.add (new DelayChannelOp (bufferToDelay, maxLatency - nodeDelay));
+                                    renderingOps.addCopyChannelOp (srcIndex, bufferToDelay);
+                                    renderingOps.addDelayChannelOp (bufferToDelay, maxLatency - nodeDelay);
                                     srcIndex = bufferToDelay;
                                 }
                             }
 
-                            renderingOps.add (new AddChannelOp (srcIndex, bufIndex));
+                            renderingOps.addAddChannelOp (srcIndex, bufIndex);
                         }
                     }
                 }
@@ -508,11 +961,11 @@ private:
         // Now the same thing for midi..
         Array <uint32> midiSourceNodes;
 
-        for (int i = graph.getNumConnections(); --i >= 0;)
+        for (int i = 0; i < inputs.size(); ++i)
         {
-            const AudioProcessorGraph::Connection* const c = graph.getConnection (i);
+            const AudioProcessorGraph::Connection* const c = inputs.getUnchecked (i);
 
-            if (c->destNodeId == node->nodeId && c->destChannelIndex == AudioProcessorGraph::midiChannelIndex)
+            if (c->destChannelIndex == AudioProcessorGraph::midiChannelIndex)
                 midiSourceNodes.add (c->sourceNodeId);
         }
 
@@ -522,7 +975,7 @@ private:
             midiBufferToUse = getFreeBuffer (true); // need to pick a buffer even if the processor doesn't use midi
 
             if (node->getProcessor()->acceptsMidi() || node->getProcessor()->producesMidi())
-                renderingOps.add (new ClearMidiBufferOp (midiBufferToUse));
+                renderingOps.addClearMidiBufferOp (midiBufferToUse);
         }
         else if (midiSourceNodes.size() == 1)
         {
@@ -540,7 +993,7 @@ private:
                     // can't mess up this channel because it's needed later by another node, so we
                     // need to use a copy of it..
                     const int newFreeBuffer = getFreeBuffer (true);
-                    renderingOps.add (new CopyMidiBufferOp (midiBufferToUse, newFreeBuffer));
+                    renderingOps.addCopyMidiBufferOp (midiBufferToUse, newFreeBuffer);
                     midiBufferToUse = newFreeBuffer;
                 }
             }
@@ -582,9 +1035,9 @@ private:
                 const int srcIndex = getBufferContaining (midiSourceNodes.getUnchecked(0),
                                                           AudioProcessorGraph::midiChannelIndex);
                 if (srcIndex >= 0)
-                    renderingOps.add (new CopyMidiBufferOp (srcIndex, midiBufferToUse));
+                    renderingOps.addCopyMidiBufferOp (srcIndex, midiBufferToUse);
                 else
-                    renderingOps.add (new ClearMidiBufferOp (midiBufferToUse));
+                    renderingOps.addClearMidiBufferOp (midiBufferToUse);
 
                 reusableInputIndex = 0;
             }
@@ -596,7 +1049,7 @@ private:
                     const int srcIndex = getBufferContaining (midiSourceNodes.getUnchecked(j),
                                                               AudioProcessorGraph::midiChannelIndex);
                     if (srcIndex >= 0)
-                        renderingOps.add (new AddMidiBufferOp (srcIndex, midiBufferToUse));
+                        renderingOps.addAddMidiBufferOp (srcIndex, midiBufferToUse);
                 }
             }
         }
@@ -605,13 +1058,10 @@ private:
             markBufferAsContaining (midiBufferToUse, node->nodeId,
                                     AudioProcessorGraph::midiChannelIndex);
 
-        setNodeDelay (node->nodeId, maxLatency + node->getProcessor()->getLatencySamples());
-
-        if (numOuts == 0)
-            totalLatency = maxLatency;
+        updateLatencies (node, maxLatency);
 
-        renderingOps.add (new ProcessBufferOp (node, audioChannelsToUse,
-                                               totalChans, midiBufferToUse));
+        renderingOps.addProcessBufferOp (node, audioChannelsToUse,
+                                         totalChans, midiBufferToUse);
     }
 
     //==============================================================================
@@ -619,22 +1069,60 @@ private:
     {
         if (forMidi)
         {
-            for (int i = 1; i < midiNodeIds.size(); ++i)
-                if (midiNodeIds.getUnchecked(i) == freeNodeID)
-                    return i;
+            if (reuseFreedBuffers)
+                for (int i = 1; i < midiNodeIds.size(); ++i)
+                    if (midiNodeIds.getUnchecked(i) == freeNodeID)
+                        return i;
 
-            midiNodeIds.add ((uint32) freeNodeID);
+            addBuffer (true);
             return midiNodeIds.size() - 1;
         }
         else
         {
-            for (int i = 1; i < nodeIds.size(); ++i)
-                if (nodeIds.getUnchecked(i) == freeNodeID)
-                    return i;
+            if (reuseFreedBuffers)
+                for (int i = 1; i < nodeIds.size(); ++i)
+                    if (nodeIds.getUnchecked(i) == freeNodeID)
+                        return i;
+
+            addBuffer (false);
+            return nodeIds.size() - 1;
+        }
+    }
+
+    // All changes to the buffers go through addBuffer() and setBuffer(), which log
+    // them in the history so that a later build can undo them.
+    void addBuffer (const bool isMidi)
+    {
+        const RenderingHistory::BufferChange change = { isMidi, true, 0, 0, 0 };
+        history.bufferChanges.add (change);
 
+        if (isMidi)
+        {
+            midiNodeIds.add ((uint32) freeNodeID);
+        }
+        else
+        {
             nodeIds.add ((uint32) freeNodeID);
             channels.add (0);
-            return nodeIds.size() - 1;
+        }
+    }
+
+    void setBuffer (const bool isMidi, const int index, const uint32 nodeId, const int channel)
+    {
+        if (isMidi)
+        {
+            const RenderingHistory::BufferChange change = { true, false, index, midiNodeIds.getUnchecked (index), 0 };
+            history.bufferChanges.add (change);
+
+            midiNodeIds.set (index, nodeId);
+        }
+        else
+        {
+            const RenderingHistory::BufferChange change = { false, false, index, nodeIds.getUnchecked (index), channels.getUnchecked (index) };
+            history.bufferChanges.add (change);
+
+            nodeIds.set (index, nodeId);
+            channels.set (index, channel);
         }
     }
 
@@ -671,7 +1159,7 @@ private:
                                            nodeIds.getUnchecked(i),
                                            channels.getUnchecked(i)))
             {
-                nodeIds.set (i, (uint32) freeNodeID);
+                setBuffer (false, i, (uint32) freeNodeID, channels.getUnchecked(i));
             }
         }
 
@@ -682,38 +1170,42 @@ private:
                                            midiNodeIds.getUnchecked(i),
                                            AudioProcessorGraph::midiChannelIndex))
             {
-                midiNodeIds.set (i, (uint32) freeNodeID);
+                setBuffer (true, i, (uint32) freeNodeID, 0);
             }
         }
     }
 
-    bool isBufferNeededLater (int stepIndexToSearchFrom,
-                              int inputChannelOfIndexToIgnore,
+    bool isBufferNeededLater (const int stepIndexToSearchFrom,
+                              const int inputChannelOfIndexToIgnore,
                               const uint32 nodeId,
                               const int outputChanIndex) const
     {
-        while (stepIndexToSearchFrom < orderedNodes.size())
+        // find the first use of this channel at or after the step we're searching from..
+        const ChannelUse target = { nodeId, outputChanIndex, stepIndexToSearchFrom, std::numeric_limits<int>::min() };
+        ChannelUseSorter sorter;
+
+        int start = 0;
+        int end = channelUses.size();
+
+        while (start < end)
         {
-            const AudioProcessorGraph::Node* const node = (const AudioProcessorGraph::Node*) orderedNodes.getUnchecked (stepIndexToSearchFrom);
+            const int halfway = (start + end) / 2;
 
-            if (outputChanIndex == AudioProcessorGraph::midiChannelIndex)
-            {
-                if (inputChannelOfIndexToIgnore != AudioProcessorGraph::midiChannelIndex
-                     && graph.getConnectionBetween (nodeId, AudioProcessorGraph::midiChannelIndex,
-                                                    node->nodeId, AudioProcessorGraph::midiChannelIndex) != nullptr)
-                    return true;
-            }
+            if (sorter.compareElements (channelUses.getReference (halfway), target) < 0)
+                start = halfway + 1;
             else
-            {
-                for (int i = 0; i < node->getProcessor()->getNumInputChannels(); ++i)
-                    if (i != inputChannelOfIndexToIgnore
-                         && graph.getConnectionBetween (nodeId, outputChanIndex,
-                                                        node->nodeId, i) != nullptr)
-                        return true;
-            }
+                end = halfway;
+        }
+
+        for (int i = start; i < channelUses.size(); ++i)
+        {
+            const ChannelUse& use = channelUses.getReference (i);
+
+            if (use.sourceNodeId != nodeId || use.sourceChannel != outputChanIndex)
+                break;
 
-            inputChannelOfIndexToIgnore = -1;
-            ++stepIndexToSearchFrom;
+            if (use.step > stepIndexToSearchFrom || use.destChannel != inputChannelOfIndexToIgnore)
+                return true;
         }
 
         return false;
@@ -725,14 +1217,13 @@ private:
         {
             jassert (bufferNum > 0 && bufferNum < midiNodeIds.size());
 
-            midiNodeIds.set (bufferNum, nodeId);
+            setBuffer (true, bufferNum, nodeId, 0);
         }
         else
         {
             jassert (bufferNum >= 0 && bufferNum < nodeIds.size());
 
-            nodeIds.set (bufferNum, nodeId);
-            channels.set (bufferNum, outputIndex);
+            setBuffer (false, bufferNum, nodeId, outputIndex);
         }
     }
 
@@ -740,135 +1231,561 @@ private:
 };
 
 //==============================================================================
-// Holds a fast lookup table for checking which nodes are inputs to others.
-class ConnectionLookupTable
+/** Keeps the graph's nodes in an order where each node comes after all of the
+    nodes that feed into it.
+
+    Rather than re-sorting all the nodes whenever a connection is made, this only
+    shuffles the nodes that lie between the two ends of the new connection, using
+    the dynamic topological sort described by Pearce and Kelly.
+
+    A connection that completes a feedback loop can't be put in order, so it gets left
+    running the wrong way. Removing a connection can't upset an order that was valid,
+    but if there's been a loop, removing part of it may leave one of those backwards
+    connections behind, so the graph re-sorts everything with sortAll() until the
+    loop has gone.
+*/
+struct RenderingOrderUpdater
 {
-public:
-    explicit ConnectionLookupTable (const OwnedArray<AudioProcessorGraph::Connection>& connections)
+    // Returns false if the new connection completes a feedback loop, in which case
+    // the order is left as it was.
+    static bool connectionAdded (Array<AudioProcessorGraph::Node*>& order,
+                                 const AudioProcessorGraph& graph,
+                                 const uint32 sourceNodeId,
+                                 const uint32 destNodeId)
     {
-        for (int i = 0; i < connections.size(); ++i)
+        HashMap<int, int> positions;
+        getPositions (order, positions);
+
+        if (! (positions.contains ((int) sourceNodeId) && positions.contains ((int) destNodeId)))
+            return true;
+
+        const int lowerBound = positions [(int) destNodeId];
+        const int upperBound = positions [(int) sourceNodeId];
+
+        if (lowerBound > upperBound)
+            return true; // the order's already ok
+
+        SortedSet<int> downstreamNodes, upstreamNodes;
+
+        if (! findAffectedNodes (order, graph, positions, lowerBound, lowerBound, upperBound, true, downstreamNodes))
+            return false;
+
+        findAffectedNodes (order, graph, positions, upperBound, lowerBound, upperBound, false, upstreamNodes);
+
+        // The nodes that lead up to the source now take the first of the affected
+        // slots, followed by the nodes that depend on the destination..
+        Array<AudioProcessorGraph::Node*> newOrder;
+
+        for (int i = 0; i < upstreamNodes.size(); ++i)
+            newOrder.add (order.getUnchecked (upstreamNodes.getUnchecked(i)));
+
+        for (int i = 0; i < downstreamNodes.size(); ++i)
+            newOrder.add (order.getUnchecked (downstreamNodes.getUnchecked(i)));
+
+        SortedSet<int> slots (upstreamNodes);
+        slots.addSet (downstreamNodes);
+
+        for (int i = 0; i < slots.size(); ++i)
+            order.set (slots.getUnchecked(i), newOrder.getUnchecked(i));
+
+        return true;
+    }
+
+    // Sorts the whole order from scratch, keeping the nodes in their existing order
+    // wherever the connections allow it. Returns false if the graph still contains a
+    // feedback loop, in which case the nodes that couldn't be sorted are left at the end.
+    static bool sortAll (Array<AudioProcessorGraph::Node*>& order,
+                         const AudioProcessorGraph& graph)
+    {
+        HashMap<int, int> positions;
+        getPositions (order, positions);
+
+        Array<int> numUnsortedInputs;
+        numUnsortedInputs.insertMultiple (0, 0, order.size());
+
+        OwnedArray<Array<int> > outputs;
+
+        for (int i = 0; i < order.size(); ++i)
+            outputs.add (new Array<int>());
+
+        for (int i = 0; i < graph.getNumConnections(); ++i)
+        {
+            const AudioProcessorGraph::Connection* const c = graph.getConnection (i);
+
+            if (positions.contains ((int) c->sourceNodeId) && positions.contains ((int) c->destNodeId))
+            {
+                const int destPosition = positions [(int) c->destNodeId];
+
+                outputs.getUnchecked (positions [(int) c->sourceNodeId])->add (destPosition);
+                numUnsortedInputs.getReference (destPosition)++;
+            }
+        }
+
+        SortedSet<int> readyNodes;
+
+        for (int i = 0; i < order.size(); ++i)
+            if (numUnsortedInputs.getUnchecked(i) == 0)
+                readyNodes.add (i);
+
+        Array<AudioProcessorGraph::Node*> newOrder;
+
+        while (readyNodes.size() > 0)
         {
-            const AudioProcessorGraph::Connection* const c = connections.getUnchecked(i);
+            const int position = readyNodes.getFirst();
+            readyNodes.remove (0);
+            newOrder.add (order.getUnchecked (position));
 
-            int index;
-            Entry* entry = findEntry (c->destNodeId, index);
+            const Array<int>& destPositions = *outputs.getUnchecked (position);
 
-            if (entry == nullptr)
+            for (int i = 0; i < destPositions.size(); ++i)
+                if (--numUnsortedInputs.getReference (destPositions.getUnchecked(i)) == 0)
+                    readyNodes.add (destPositions.getUnchecked(i));
+        }
+
+        const bool sortedEverything = (newOrder.size() == order.size());
+
+        for (int i = 0; i < order.size(); ++i)
+            if (numUnsortedInputs.getUnchecked(i) > 0)
+                newOrder.add (order.getUnchecked(i));
+
+        order.swapWith (newOrder);
+        return sortedEverything;
+    }
+
+private:
+    static void getPositions (const Array<AudioProcessorGraph::Node*>& order, HashMap<int, int>& positions)
+    {
+        for (int i = order.size(); --i >= 0;)
+            positions.set ((int) order.getUnchecked(i)->nodeId, i);
+    }
+
+    // Finds all the nodes that can be reached from the node at startPosition, going either
+    // downstream or upstream, but only visiting those which lie between the two bounds.
+    // Returns false if a downstream search gets to the upper bound, i.e. it's found a loop.
+    static bool findAffectedNodes (const Array<AudioProcessorGraph::Node*>& order,
+                                   const AudioProcessorGraph& graph,
+                                   const HashMap<int, int>& positions,
+                                   const int startPosition, const int lowerBound, const int upperBound,
+                                   const bool downstream, SortedSet<int>& visited)
+    {
+        Array<int> positionsToVisit;
+        positionsToVisit.add (startPosition);
+        visited.add (startPosition);
+
+        while (positionsToVisit.size() > 0)
+        {
+            const uint32 nodeId = order.getUnchecked (positionsToVisit.remove (positionsToVisit.size() - 1))->nodeId;
+
+            for (int i = graph.getNumConnections(); --i >= 0;)
             {
-                entry = new Entry (c->destNodeId);
-                entries.insert (index, entry);
+                const AudioProcessorGraph::Connection* const c = graph.getConnection (i);
+
+                if ((downstream ? c->sourceNodeId : c->destNodeId) == nodeId)
+                {
+                    const int otherNodeId = (int) (downstream ? c->destNodeId : c->sourceNodeId);
+
+                    if (positions.contains (otherNodeId))
+                    {
+                        const int position = positions [otherNodeId];
+
+                        if (downstream && position == upperBound)
+                            return false;
+
+                        if (position >= lowerBound && position <= upperBound && visited.add (position))
+                            positionsToVisit.add (position);
+                    }
+                }
             }
+        }
 
-            entry->srcNodes.add (c->sourceNodeId);
+        return true;
+    }
+};
+
+//==============================================================================
+/** Takes the sequence of ops produced by the RenderingOpSequenceCalculator and
+    turns it into a dependency graph that can be rendered by several threads at once.
+
+    Each processBufferOp becomes a task, along with the copy/add/clear/delay ops that
+    prepare its input buffers. A task depends on every earlier task that touches one
+    of the same shared buffers, so any buffers which the calculator has re-used are
+    still accessed in exactly the same order as they would be by the serial sequence,
+    and the output is identical.
+
+    While a block is being rendered, any number of threads can call performNextTask()
+    to pick up tasks as soon as their inputs are ready. This is all done with atomic
+    counters, so it's safe to use on the audio thread.
+*/
+class ParallelRenderingSchedule
+{
+public:
+    ParallelRenderingSchedule (RenderingProgram& program_)
+        : program (program_)
+    {
+        Task* currentTask = nullptr;
+
+        for (int i = 0; i < program.getNumOps(); ++i)
+        {
+            if (currentTask == nullptr)
+            {
+                tasks.add (currentTask = new Task());
+                currentTask->startOp = i;
+            }
+
+            currentTask->endOp = i + 1;
+            program.getBufferUsage (i, currentTask->usage);
+
+            if (program.isProcessBufferOp (i))
+                currentTask = nullptr;
+        }
+
+        findDependencies();
+
+        readyQueue.calloc ((size_t) jmax (1, tasks.size()));
+    }
+
+    /** Must be called by the audio thread before the other threads are allowed to
+        start calling performNextTask().
+    */
+    void prepareForNextBlock() noexcept
+    {
+        numTasksQueued = 0;
+        numTasksStarted = 0;
+        numTasksFinished = 0;
+
+        for (int i = tasks.size(); --i >= 0;)
+        {
+            readyQueue[i] = 0;
+            tasks.getUnchecked (i)->numInputsRemaining = tasks.getUnchecked (i)->numInputs;
         }
+
+        for (int i = 0; i < tasks.size(); ++i)
+            if (tasks.getUnchecked (i)->numInputs == 0)
+                addToReadyQueue (i);
     }
 
-    bool isAnInputTo (const uint32 possibleInputId,
-                      const uint32 possibleDestinationId) const noexcept
+    /** Tries to grab a task that's ready to go, and performs it.
+        Returns false if there was nothing to do right now.
+    */
+    bool performNextTask (AudioSampleBuffer& sharedBufferChans,
+                          const OwnedArray <MidiBuffer>& sharedMidiBuffers,
+                          const int numSamples) noexcept
     {
-        return isAnInputToRecursive (possibleInputId, possibleDestinationId, entries.size());
+        for (;;)
+        {
+            const int queueIndex = numTasksStarted.get();
+
+            if (queueIndex >= numTasksQueued.get())
+                return false;
+
+            if (numTasksStarted.compareAndSetBool (queueIndex + 1, queueIndex))
+            {
+                // The queue slot is reserved before the task number is written into it,
+                // so it may take a moment to appear..
+                int taskPlusOne;
+                while ((taskPlusOne = readyQueue[queueIndex].get()) == 0)
+                {}
+
+                performTask (taskPlusOne - 1, sharedBufferChans, sharedMidiBuffers, numSamples);
+                return true;
+            }
+        }
     }
 
+    bool isBlockFinished() const noexcept   { return numTasksFinished.get() >= tasks.size(); }
+
 private:
     //==============================================================================
-    struct Entry
+    struct Task
+    {
+        Task() : startOp (0), endOp (0), numInputs (0) {}
+
+        int startOp, endOp; // the range of ops in the program that this task runs
+        SharedBufferUsage usage;
+        SortedSet<int> dependentTasks;
+        int numInputs;
+        Atomic<int> numInputsRemaining;
+
+        JUCE_DECLARE_NON_COPYABLE (Task)
+    };
+
+    struct ResourceState
+    {
+        ResourceState() : lastWriter (-1) {}
+
+        int lastWriter;
+        Array<int> readersSinceLastWrite;
+    };
+
+    RenderingProgram& program;
+    OwnedArray<Task> tasks;
+    HeapBlock<Atomic<int> > readyQueue; // (holds task index + 1, so that zero means not-yet-written)
+    Atomic<int> numTasksQueued, numTasksStarted, numTasksFinished;
+
+    void findDependencies()
+    {
+        OwnedArray<ResourceState> resources;
+
+        for (int i = 0; i < tasks.size(); ++i)
+        {
+            const SharedBufferUsage& usage = tasks.getUnchecked (i)->usage;
+
+            for (int j = 0; j < usage.reads.size(); ++j)
+            {
+                const int resource = usage.reads.getUnchecked (j);
+
+                if (! usage.writes.contains (resource))
+                {
+                    ResourceState& state = getResourceState (resources, resource);
+                    addDependency (state.lastWriter, i);
+                    state.readersSinceLastWrite.add (i);
+                }
+            }
+
+            for (int j = 0; j < usage.writes.size(); ++j)
+            {
+                ResourceState& state = getResourceState (resources, usage.writes.getUnchecked (j));
+                addDependency (state.lastWriter, i);
+
+                for (int k = state.readersSinceLastWrite.size(); --k >= 0;)
+                    addDependency (state.readersSinceLastWrite.getUnchecked (k), i);
+
+                state.lastWriter = i;
+                state.readersSinceLastWrite.clearQuick();
+            }
+        }
+    }
+
+    static ResourceState& getResourceState (OwnedArray<ResourceState>& resources, const int resource)
+    {
+        while (resources.size() <= resource)
+            resources.add (new ResourceState());
+
+        return *resources.getUnchecked (resource);
+    }
+
+    void addDependency (const int sourceTask, const int destTask)
+    {
+        if (sourceTask >= 0 && sourceTask != destTask)
+        {
+            SortedSet<int>& dependents = tasks.getUnchecked (sourceTask)->dependentTasks;
+
+            if (! dependents.contains (destTask))
+            {
+                dependents.add (destTask);
+                ++(tasks.getUnchecked (destTask)->numInputs);
+            }
+        }
+    }
+
+    void addToReadyQueue (const int taskIndex) noexcept
+    {
+        const int queueIndex = (++numTasksQueued) - 1;
+        readyQueue[queueIndex] = taskIndex + 1;
+    }
+
+    void performTask (const int taskIndex,
+                      AudioSampleBuffer& sharedBufferChans,
+                      const OwnedArray <MidiBuffer>& sharedMidiBuffers,
+                      const int numSamples) noexcept
+    {
+        const Task& task = *tasks.getUnchecked (taskIndex);
+
+        program.perform (task.startOp, task.endOp, sharedBufferChans, sharedMidiBuffers, numSamples);
+
+        for (int i = 0; i < task.dependentTasks.size(); ++i)
+        {
+            const int dependent = task.dependentTasks.getUnchecked (i);
+
+            if (--(tasks.getUnchecked (dependent)->numInputsRemaining) == 0)
+                addToReadyQueue (dependent);
+        }
+
+        ++numTasksFinished;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParallelRenderingSchedule)
+};
+
+}
+
+//==============================================================================
+/** Everything that's needed to render the graph in its current state: the ops,
+    the shared buffers that they work on, and (if the graph is rendering in parallel)
+    the schedule for running them.
+
+    These are built on the message thread and then handed over to the audio thread
+    by swapping an atomic pointer, so the audio thread never has to wait for a lock
+    or do any allocation when the graph changes.
+*/
+class AudioProcessorGraph::RenderingSequence
+{
+public:
+    RenderingSequence()
+        : renderingBuffers (1, 1), nextRetiredSequence (nullptr)
+    {
+    }
+
+    ~RenderingSequence()
+    {
+        schedule = nullptr;
+    }
+
+    void prepareBuffers (const int numRenderingBuffersNeeded, const int numMidiBuffersNeeded, const int blockSize)
+    {
+        renderingBuffers.setSize (numRenderingBuffersNeeded, blockSize);
+        renderingBuffers.clear();
+
+        while (midiBuffers.size() < numMidiBuffersNeeded)
+            midiBuffers.add (new MidiBuffer());
+    }
+
+    void perform (ParallelRenderer* const parallelRenderer, const int numSamples);
+
+    GraphRenderingOps::RenderingProgram renderingOps;
+    AudioSampleBuffer renderingBuffers;
+    OwnedArray <MidiBuffer> midiBuffers;
+    ScopedPointer<GraphRenderingOps::ParallelRenderingSchedule> schedule;
+
+    // used to chain together the sequences that the audio thread has finished with
+    RenderingSequence* nextRetiredSequence;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderingSequence)
+};
+
+//==============================================================================
+/** Kept between builds of the rendering sequence, so that each build only has to
+    redo the part of the sequence that the graph's changes have affected.
+*/
+class AudioProcessorGraph::RenderingHistory  : public GraphRenderingOps::RenderingHistory
+{
+};
+
+//==============================================================================
+/** Owns the worker threads used by an AudioProcessorGraph when it's rendering in
+    parallel.
+*/
+class AudioProcessorGraph::ParallelRenderer
+{
+public:
+    ParallelRenderer (const int numThreads)
+        : currentSchedule (nullptr), currentBuffers (nullptr),
+          currentMidiBuffers (nullptr), currentNumSamples (0)
+    {
+        for (int i = 0; i < numThreads; ++i)
+        {
+            WorkerThread* const t = new WorkerThread (*this, i);
+            workers.add (t);
+            t->startThread (10);
+        }
+    }
+
+    ~ParallelRenderer()
+    {
+        for (int i = workers.size(); --i >= 0;)
+        {
+            workers.getUnchecked(i)->signalThreadShouldExit();
+            workers.getUnchecked(i)->notify();
+        }
+
+        for (int i = workers.size(); --i >= 0;)
+            workers.getUnchecked(i)->stopThread (4000);
+    }
+
+    int getNumThreads() const noexcept      { return workers.size(); }
+
+    void perform (GraphRenderingOps::ParallelRenderingSchedule& schedule,
+                  AudioSampleBuffer& sharedBufferChans,
+                  const OwnedArray <MidiBuffer>& sharedMidiBuffers,
+                  const int numSamples)
     {
-        explicit Entry (const uint32 destNodeId_) noexcept : destNodeId (destNodeId_) {}
+        schedule.prepareForNextBlock();
 
-        const uint32 destNodeId;
-        SortedSet<uint32> srcNodes;
+        currentSchedule = &schedule;
+        currentBuffers = &sharedBufferChans;
+        currentMidiBuffers = &sharedMidiBuffers;
+        currentNumSamples = numSamples;
+        blockIsRunning = 1;
 
-        JUCE_DECLARE_NON_COPYABLE (Entry)
-    };
+        for (int i = workers.size(); --i >= 0;)
+            workers.getUnchecked(i)->notify();
 
-    OwnedArray<Entry> entries;
+        // The audio thread doesn't just wait for the workers, it joins in too..
+        while (! schedule.isBlockFinished())
+            schedule.performNextTask (sharedBufferChans, sharedMidiBuffers, numSamples);
 
-    bool isAnInputToRecursive (const uint32 possibleInputId,
-                               const uint32 possibleDestinationId,
-                               int recursionCheck) const noexcept
-    {
-        int index;
+        // ..and before returning, it needs to be sure that none of the workers is still
+        // looking at the schedule.
+        blockIsRunning = 0;
 
-        if (const Entry* const entry = findEntry (possibleDestinationId, index))
-        {
-            const SortedSet<uint32>& srcNodes = entry->srcNodes;
+        while (numWorkersActive.get() != 0)
+        {}
+    }
 
-            if (srcNodes.contains (possibleInputId))
-                return true;
+private:
+    //==============================================================================
+    class WorkerThread  : public Thread
+    {
+    public:
+        WorkerThread (ParallelRenderer& owner_, const int index)
+            : Thread ("Audio graph render thread " + String (index + 1)),
+              owner (owner_)
+        {
+        }
 
-            if (--recursionCheck >= 0)
+        void run() override
+        {
+            while (! threadShouldExit())
             {
-                for (int i = 0; i < srcNodes.size(); ++i)
-                    if (isAnInputToRecursive (possibleInputId, srcNodes.getUnchecked(i), recursionCheck))
-                        return true;
+                wait (-1);
+                owner.performWorkerTasks();
             }
         }
 
-        return false;
-    }
+    private:
+        ParallelRenderer& owner;
 
-    Entry* findEntry (const uint32 destNodeId, int& insertIndex) const noexcept
-    {
-        Entry* result = nullptr;
+        JUCE_DECLARE_NON_COPYABLE (WorkerThread)
+    };
 
-        int start = 0;
-        int end = entries.size();
+    OwnedArray<WorkerThread> workers;
+    Atomic<int> blockIsRunning, numWorkersActive;
 
-        for (;;)
-        {
-            if (start >= end)
-            {
-                break;
-            }
-            else if (destNodeId == entries.getUnchecked (start)->destNodeId)
-            {
-                result = entries.getUnchecked (start);
-                break;
-            }
-            else
-            {
-                const int halfway = (start + end) / 2;
+    GraphRenderingOps::ParallelRenderingSchedule* currentSchedule;
+    AudioSampleBuffer* currentBuffers;
+    const OwnedArray <MidiBuffer>* currentMidiBuffers;
+    int currentNumSamples;
 
-                if (halfway == start)
-                {
-                    if (destNodeId >= entries.getUnchecked (halfway)->destNodeId)
-                        ++start;
+    void performWorkerTasks()
+    {
+        ++numWorkersActive;
 
-                    break;
-                }
-                else if (destNodeId >= entries.getUnchecked (halfway)->destNodeId)
-                    start = halfway;
-                else
-                    end = halfway;
-            }
+        // If a worker wakes up late, the block that it was woken for may already be
+        // finished, in which case it mustn't touch anything.
+        if (blockIsRunning.get() != 0)
+        {
+            while (! currentSchedule->isBlockFinished())
+                if (! currentSchedule->performNextTask (*currentBuffers, *currentMidiBuffers, currentNumSamples))
+                    Thread::yield();
         }
 
-        insertIndex = start;
-        return result;
+        --numWorkersActive;
     }
 
-    JUCE_DECLARE_NON_COPYABLE (ConnectionLookupTable)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParallelRenderer)
 };
 
-//==============================================================================
-struct ConnectionSorter
+void AudioProcessorGraph::RenderingSequence::perform (ParallelRenderer* const parallelRenderer, const int numSamples)
 {
-    static int compareElements (const AudioProcessorGraph::Connection* const first,
-                                const AudioProcessorGraph::Connection* const second) noexcept
+    if (parallelRenderer != nullptr && schedule != nullptr)
     {
-        if (first->sourceNodeId < second->sourceNodeId)                return -1;
-        if (first->sourceNodeId > second->sourceNodeId)                return 1;
-        if (first->destNodeId < second->destNodeId)                    return -1;
-        if (first->destNodeId > second->destNodeId)                    return 1;
-        if (first->sourceChannelIndex < second->sourceChannelIndex)    return -1;
-        if (first->sourceChannelIndex > second->sourceChannelIndex)    return 1;
-        if (first->destChannelIndex < second->destChannelIndex)        return -1;
-        if (first->destChannelIndex > second->destChannelIndex)        return 1;
-
-        return 0;
+        parallelRenderer->perform (*schedule, renderingBuffers, midiBuffers, numSamples);
+    }
+    else
+    {
+        renderingOps.perform (renderingBuffers, midiBuffers, numSamples);
     }
-};
-
 }
 
 //==============================================================================
@@ -922,8 +1839,9 @@ void AudioProcessorGraph::Node::setParentGraph (AudioProcessorGraph* const graph
 
 //==============================================================================
 AudioProcessorGraph::AudioProcessorGraph()
-    : lastNodeId (0),
-      renderingBuffers (1, 1),
+    : renderingOrderHasLoops (false),
+      lastNodeId (0),
+      currentSequence (nullptr),
       currentAudioInputBuffer (nullptr),
       currentAudioOutputBuffer (1, 1),
       currentMidiInputBuffer (nullptr)
@@ -944,6 +1862,8 @@ const String AudioProcessorGraph::getName() const
 //==============================================================================
 void AudioProcessorGraph::clear()
 {
+    renderingOrder.clear();
+    renderingOrderHasLoops = false;
     nodes.clear();
     connections.clear();
     triggerAsyncUpdate();
@@ -993,6 +1913,7 @@ AudioProcessorGraph::Node* AudioProcessorGraph::addNode (AudioProcessor* const n
 
     Node* const n = new Node (nodeId, newProcessor);
     nodes.add (n);
+    renderingOrder.add (n);
     triggerAsyncUpdate();
 
     n->setParentGraph (this);
@@ -1008,6 +1929,7 @@ bool AudioProcessorGraph::removeNode (const uint32 nodeId)
         if (nodes.getUnchecked(i)->nodeId == nodeId)
         {
             nodes.getUnchecked(i)->setParentGraph (nullptr);
+            renderingOrder.removeFirstMatchingValue (nodes.getUnchecked(i));
             nodes.remove (i);
             triggerAsyncUpdate();
 
@@ -1086,6 +2008,10 @@ bool AudioProcessorGraph::addConnection (const uint32 sourceNodeId,
     GraphRenderingOps::ConnectionSorter sorter;
     connections.addSorted (sorter, new Connection (sourceNodeId, sourceChannelIndex,
                                                    destNodeId, destChannelIndex));
+
+    if (! GraphRenderingOps::RenderingOrderUpdater::connectionAdded (renderingOrder, *this, sourceNodeId, destNodeId))
+        renderingOrderHasLoops = true;
+
     triggerAsyncUpdate();
     return true;
 }
@@ -1093,6 +2019,12 @@ bool AudioProcessorGraph::addConnection (const uint32 sourceNodeId,
 void AudioProcessorGraph::removeConnection (const int index)
 {
     connections.remove (index);
+
+    // if this breaks a feedback loop, the connections that were left running backwards
+    // around it need to be put in order again..
+    if (renderingOrderHasLoops)
+        renderingOrderHasLoops = ! GraphRenderingOps::RenderingOrderUpdater::sortAll (renderingOrder, *this);
+
     triggerAsyncUpdate();
 }
 
@@ -1168,97 +2100,108 @@ bool AudioProcessorGraph::removeIllegalConnections()
 }
 
 //==============================================================================
-static void deleteRenderOpArray (Array<void*>& ops)
+void AudioProcessorGraph::publishRenderingSequence (RenderingSequence* const newSequence)
 {
-    for (int i = ops.size(); --i >= 0;)
-        delete static_cast<GraphRenderingOps::AudioGraphRenderingOp*> (ops.getUnchecked(i));
+    // If the audio thread hasn't picked up the last sequence yet, it never will now..
+    delete nextSequence.exchange (newSequence);
+
+    deleteRetiredRenderingSequences();
 }
 
-void AudioProcessorGraph::clearRenderingSequence()
+void AudioProcessorGraph::retireRenderingSequence (RenderingSequence* const sequence) noexcept
 {
-    Array<void*> oldOps;
-
+    for (;;)
     {
-        const ScopedLock sl (getCallbackLock());
-        renderingOps.swapWith (oldOps);
-    }
+        RenderingSequence* const head = retiredSequences.get();
+        sequence->nextRetiredSequence = head;
 
-    deleteRenderOpArray (oldOps);
+        if (retiredSequences.compareAndSetBool (sequence, head))
+            break;
+    }
 }
 
-bool AudioProcessorGraph::isAnInputTo (const uint32 possibleInputId,
-                                       const uint32 possibleDestinationId,
-                                       const int recursionCheck) const
+void AudioProcessorGraph::deleteRetiredRenderingSequences()
 {
-    if (recursionCheck > 0)
+    for (RenderingSequence* s = retiredSequences.exchange (nullptr); s != nullptr;)
     {
-        for (int i = connections.size(); --i >= 0;)
-        {
-            const AudioProcessorGraph::Connection* const c = connections.getUnchecked (i);
+        RenderingSequence* const next = s->nextRetiredSequence;
+        delete s;
+        s = next;
+    }
+}
 
-            if (c->destNodeId == possibleDestinationId
-                 && (c->sourceNodeId == possibleInputId
-                      || isAnInputTo (possibleInputId, c->sourceNodeId, recursionCheck - 1)))
-                return true;
-        }
+void AudioProcessorGraph::clearRenderingSequence()
+{
+    // This is only called when the graph isn't playing, so the audio thread's current
+    // sequence can be deleted here too.
+    delete nextSequence.exchange (nullptr);
+    deleteRetiredRenderingSequences();
+    renderingHistory = nullptr;
+
+    RenderingSequence* oldSequence;
+
+    {
+        const ScopedLock sl (getCallbackLock());
+        oldSequence = currentSequence;
+        currentSequence = nullptr;
     }
 
-    return false;
+    delete oldSequence;
 }
 
 void AudioProcessorGraph::buildRenderingSequence()
 {
-    Array<void*> newRenderingOps;
-    int numRenderingBuffersNeeded = 2;
-    int numMidiBuffersNeeded = 1;
+    ScopedPointer<RenderingSequence> newSequence (new RenderingSequence());
 
     {
         MessageManagerLock mml;
 
-        Array<void*> orderedNodes;
-
-        {
-            const GraphRenderingOps::ConnectionLookupTable table (connections);
+        for (int i = 0; i < nodes.size(); ++i)
+            nodes.getUnchecked(i)->prepare (getSampleRate(), getBlockSize(), this);
 
-            for (int i = 0; i < nodes.size(); ++i)
-            {
-                Node* const node = nodes.getUnchecked(i);
+        if (renderingHistory == nullptr)
+            renderingHistory = new RenderingHistory();
 
-                node->prepare (getSampleRate(), getBlockSize(), this);
+        GraphRenderingOps::RenderingOpSequenceCalculator calculator (*this, renderingOrder, *renderingHistory,
+                                                                     parallelRenderer == nullptr);
 
-                int j = 0;
-                for (; j < orderedNodes.size(); ++j)
-                    if (table.isAnInputTo (node->nodeId, ((Node*) orderedNodes.getUnchecked(j))->nodeId))
-                      break;
+        newSequence->renderingOps.setOps (renderingHistory->ops);
+        newSequence->prepareBuffers (calculator.getNumBuffersNeeded(),
+                                     calculator.getNumMidiBuffersNeeded(),
+                                     getBlockSize());
+    }
 
-                orderedNodes.insert (j, node);
-            }
-        }
+    if (parallelRenderer != nullptr)
+        newSequence->schedule = new GraphRenderingOps::ParallelRenderingSchedule (newSequence->renderingOps);
 
-        GraphRenderingOps::RenderingOpSequenceCalculator calculator (*this, orderedNodes, newRenderingOps);
+    publishRenderingSequence (newSequence.release());
+}
 
-        numRenderingBuffersNeeded = calculator.getNumBuffersNeeded();
-        numMidiBuffersNeeded = calculator.getNumMidiBuffersNeeded();
-    }
+void AudioProcessorGraph::setNumRenderingThreads (int numThreads)
+{
+    numThreads = jmax (0, numThreads);
 
+    if (numThreads != getNumRenderingThreads())
     {
-        // swap over to the new rendering sequence..
-        const ScopedLock sl (getCallbackLock());
-
-        renderingBuffers.setSize (numRenderingBuffersNeeded, getBlockSize());
-        renderingBuffers.clear();
+        ScopedPointer<ParallelRenderer> newRenderer;
 
-        for (int i = midiBuffers.size(); --i >= 0;)
-            midiBuffers.getUnchecked(i)->clear();
+        if (numThreads > 0)
+            newRenderer = new ParallelRenderer (numThreads);
 
-        while (midiBuffers.size() < numMidiBuffersNeeded)
-            midiBuffers.add (new MidiBuffer());
+        {
+            const ScopedLock sl (getCallbackLock());
+            parallelRenderer.swapWith (newRenderer);
+        }
 
-        renderingOps.swapWith (newRenderingOps);
+        // the current sequence will carry on rendering on a single thread until
+        // a new one has been built to suit the new number of threads.
+        triggerAsyncUpdate();
     }
+}
 
-    // delete the old ones..
-    deleteRenderOpArray (newRenderingOps);
+int AudioProcessorGraph::getNumRenderingThreads() const noexcept
+{
+    return parallelRenderer != nullptr ? parallelRenderer->getNumThreads() : 0;
 }
 
 void AudioProcessorGraph::handleAsyncUpdate()
@@ -1283,8 +2226,7 @@ void AudioProcessorGraph::releaseResources()
     for (int i = 0; i < nodes.size(); ++i)
         nodes.getUnchecked(i)->unprepare();
 
-    renderingBuffers.setSize (1, 1);
-    midiBuffers.clear();
+    clearRenderingSequence();
 
     currentAudioInputBuffer = nullptr;
     currentAudioOutputBuffer.setSize (1, 1);
@@ -1304,19 +2246,24 @@ void AudioProcessorGraph::processBlock (AudioSampleBuffer& buffer, MidiBuffer& m
 {
     const int numSamples = buffer.getNumSamples();
 
+    if (RenderingSequence* const newSequence = nextSequence.exchange (nullptr))
+    {
+        // the old sequence can't be deleted on this thread, so it gets handed back
+        // to the message thread to clean up later.
+        if (currentSequence != nullptr)
+            retireRenderingSequence (currentSequence);
+
+        currentSequence = newSequence;
+    }
+
     currentAudioInputBuffer = &buffer;
     currentAudioOutputBuffer.setSize (jmax (1, buffer.getNumChannels()), numSamples);
     currentAudioOutputBuffer.clear();
     currentMidiInputBuffer = &midiMessages;
     currentMidiOutputBuffer.clear();
 
-    for (int i = 0; i < renderingOps.size(); ++i)
-    {
-        GraphRenderingOps::AudioGraphRenderingOp* const op
-            = (GraphRenderingOps::AudioGraphRenderingOp*) renderingOps.getUnchecked(i);
-
-        op->perform (renderingBuffers, midiBuffers, numSamples);
-    }
+    if (currentSequence != nullptr)
+        currentSequence->perform (parallelRenderer, numSamples);
 
     for (int i = 0; i < buffer.getNumChannels(); ++i)
         buffer.copyFrom (i, 0, currentAudioOutputBuffer, i, 0, numSamples);
@@ -1531,3 +2478,381 @@ void AudioProcessorGraph::AudioGraphIOProcessor::setParentGraph (AudioProcessorG
         updateHostDisplay();
     }
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AudioProcessorGraphTests  : public UnitTest
+{
+public:
+    AudioProcessorGraphTests() : UnitTest ("AudioProcessorGraph") {}
+
+    void runTest()
+    {
+        beginTest ("Parallel rendering matches serial rendering");
+
+        for (int numChains = 1; numChains <= 16; numChains *= 2)
+        {
+            AudioSampleBuffer serialOutput (2, testBlockSize), parallelOutput (2, testBlockSize);
+            AudioProcessorGraph serialGraph, parallelGraph;
+            createTestGraph (serialGraph, numChains, 0, 8);
+            createTestGraph (parallelGraph, numChains, 3, 8);
+
+            for (int block = 0; block < 20; ++block)
+            {
+                renderBlock (serialGraph, serialOutput);
+                renderBlock (parallelGraph, parallelOutput);
+
+                for (int chan = 0; chan < 2; ++chan)
+                    expect (memcmp (serialOutput.getSampleData (chan), parallelOutput.getSampleData (chan),
+                                    sizeof (float) * (size_t) testBlockSize) == 0);
+            }
+        }
+
+        beginTest ("Rendering order follows connections");
+
+        {
+            // the same chains, but with the nodes created back-to-front and the
+            // connections made in a scrambled order..
+            AudioProcessorGraph forwardsGraph, backwardsGraph;
+            createChainGraph (forwardsGraph, false);
+            createChainGraph (backwardsGraph, true);
+
+            AudioSampleBuffer forwardsOutput (2, testBlockSize), backwardsOutput (2, testBlockSize);
+
+            for (int block = 0; block < 4; ++block)
+            {
+                renderBlock (forwardsGraph, forwardsOutput);
+                renderBlock (backwardsGraph, backwardsOutput);
+
+                for (int chan = 0; chan < 2; ++chan)
+                    expect (memcmp (forwardsOutput.getSampleData (chan), backwardsOutput.getSampleData (chan),
+                                    sizeof (float) * (size_t) testBlockSize) == 0);
+            }
+
+            expect (forwardsOutput.getMagnitude (0, testBlockSize) > 0);
+        }
+
+        beginTest ("Breaking a feedback loop restores the order");
+
+        {
+            // Connecting b -> a after a -> b makes a loop, so the order can't follow both.
+            // Once a -> b is removed, the order has to follow b -> a again.
+            AudioProcessorGraph graph;
+            graph.setPlayConfigDetails (1, 1, 44100.0, testBlockSize);
+
+            const uint32 input  = graph.addNode (new AudioProcessorGraph::AudioGraphIOProcessor (AudioProcessorGraph::AudioGraphIOProcessor::audioInputNode))->nodeId;
+            const uint32 output = graph.addNode (new AudioProcessorGraph::AudioGraphIOProcessor (AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode))->nodeId;
+            const uint32 a = graph.addNode (new GainProcessor (2.0f))->nodeId;
+            const uint32 b = graph.addNode (new GainProcessor (3.0f))->nodeId;
+
+            graph.addConnection (a, 0, b, 0);
+            graph.addConnection (b, 0, a, 0);
+            graph.removeConnection (a, 0, b, 0);
+            graph.addConnection (input, 0, b, 0);
+            graph.addConnection (a, 0, output, 0);
+
+            graph.prepareToPlay (44100.0, testBlockSize);
+
+            AudioSampleBuffer buffer (1, testBlockSize);
+            MidiBuffer midi;
+            FloatVectorOperations::fill (buffer.getSampleData (0), 1.0f, testBlockSize);
+
+            {
+                const ScopedLock sl (graph.getCallbackLock());
+                graph.processBlock (buffer, midi);
+            }
+
+            expectEquals (buffer.getSampleData (0)[0], 6.0f);
+            expectEquals (buffer.getSampleData (0)[testBlockSize - 1], 6.0f);
+        }
+
+        beginTest ("Incremental rebuilds match full rebuilds");
+
+        for (int reuseFreedBuffers = 0; reuseFreedBuffers < 2; ++reuseFreedBuffers)
+        {
+            Random r (getRandom().nextInt64());
+
+            AudioProcessorGraph graph;
+            graph.setPlayConfigDetails (0, 2, 44100.0, testBlockSize);
+
+            // all the connections run forwards through this list, so it's always a valid order
+            Array<AudioProcessorGraph::Node*> order;
+
+            for (int i = 0; i < 20; ++i)
+                order.add (addRandomNode (graph, r));
+
+            GraphRenderingOps::RenderingHistory history;
+            int numStepsReused = 0;
+
+            for (int edit = 0; edit < 300; ++edit)
+            {
+                if (r.nextInt (20) == 0)
+                {
+                    const int index = r.nextInt (order.size());
+                    graph.removeNode (order.getUnchecked (index)->nodeId);
+                    order.remove (index);
+                    order.add (addRandomNode (graph, r));
+                }
+                else if (r.nextInt (20) == 0)
+                {
+                    order.getUnchecked (r.nextInt (order.size()))->getProcessor()->setLatencySamples (r.nextInt (4));
+                }
+                else
+                {
+                    const int source = r.nextInt (order.size() - 1);
+                    const int dest = source + 1 + r.nextInt (order.size() - 1 - source);
+                    const bool isMidi = r.nextInt (4) == 0;
+                    const int sourceChan = isMidi ? (int) AudioProcessorGraph::midiChannelIndex : r.nextInt (2);
+                    const int destChan   = isMidi ? (int) AudioProcessorGraph::midiChannelIndex : r.nextInt (2);
+
+                    if (! graph.removeConnection (order.getUnchecked (source)->nodeId, sourceChan,
+                                                  order.getUnchecked (dest)->nodeId, destChan))
+                        graph.addConnection (order.getUnchecked (source)->nodeId, sourceChan,
+                                             order.getUnchecked (dest)->nodeId, destChan);
+                }
+
+                GraphRenderingOps::RenderingHistory fullHistory;
+
+                const GraphRenderingOps::RenderingOpSequenceCalculator incremental (graph, order, history, reuseFreedBuffers != 0);
+                const GraphRenderingOps::RenderingOpSequenceCalculator full (graph, order, fullHistory, reuseFreedBuffers != 0);
+
+                expectEquals (incremental.getNumBuffersNeeded(), full.getNumBuffersNeeded());
+                expectEquals (incremental.getNumMidiBuffersNeeded(), full.getNumMidiBuffersNeeded());
+                expect (haveSameOps (history.ops, fullHistory.ops));
+
+                numStepsReused += incremental.getNumStepsReused();
+            }
+
+            expect (numStepsReused > 0);
+        }
+
+        beginTest ("Parallel rendering speed");
+
+        const int numThreads = jmax (1, SystemStats::getNumCpus() - 1);
+
+        for (int numChains = 4; numChains <= 32; numChains *= 2)
+        {
+            const double serialTime   = timeGraph (numChains, 0);
+            const double parallelTime = timeGraph (numChains, numThreads);
+
+            logMessage (String (numChains * 2 + 1) + " nodes: serial " + String (serialTime, 2) + "ms, "
+                          + String (numThreads) + " extra threads " + String (parallelTime, 2) + "ms");
+        }
+    }
+
+private:
+    enum { testBlockSize = 256 };
+
+    //==============================================================================
+    struct TestProcessor  : public AudioProcessor
+    {
+        TestProcessor (int numIns, int numOuts, int64 seed, int workPerSample_)
+            : random (seed), workPerSample (workPerSample_), state (0), usesMidi (false)
+        {
+            setPlayConfigDetails (numIns, numOuts, 44100.0, testBlockSize);
+        }
+
+        void processBlock (AudioSampleBuffer& buffer, MidiBuffer&)
+        {
+            for (int chan = 0; chan < getNumOutputChannels(); ++chan)
+            {
+                float* const data = buffer.getSampleData (chan);
+
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                {
+                    float in = (getNumInputChannels() == 0) ? random.nextFloat() - 0.5f : data[i];
+
+                    for (int j = workPerSample; --j >= 0;)
+                        in = std::sin (in) * 0.999f;
+
+                    state += (in - state) * 0.1f;
+                    data[i] = state;
+                }
+            }
+        }
+
+        const String getName() const                            { return "Test"; }
+        void prepareToPlay (double, int)                        {}
+        void releaseResources()                                 {}
+        const String getInputChannelName (int) const            { return String(); }
+        const String getOutputChannelName (int) const           { return String(); }
+        bool isInputChannelStereoPair (int) const               { return false; }
+        bool isOutputChannelStereoPair (int) const              { return false; }
+        bool silenceInProducesSilenceOut() const                { return false; }
+        double getTailLengthSeconds() const                     { return 0; }
+        bool acceptsMidi() const                                { return usesMidi; }
+        bool producesMidi() const                               { return usesMidi; }
+        AudioProcessorEditor* createEditor()                    { return nullptr; }
+        bool hasEditor() const                                  { return false; }
+        int getNumParameters()                                  { return 0; }
+        const String getParameterName (int)                     { return String(); }
+        float getParameter (int)                                { return 0; }
+        const String getParameterText (int)                     { return String(); }
+        void setParameter (int, float)                          {}
+        int getNumPrograms()                                    { return 0; }
+        int getCurrentProgram()                                 { return 0; }
+        void setCurrentProgram (int)                            {}
+        const String getProgramName (int)                       { return String(); }
+        void changeProgramName (int, const String&)             {}
+        void getStateInformation (juce::MemoryBlock&)           {}
+        void setStateInformation (const void*, int)             {}
+
+        Random random;
+        const int workPerSample;
+        float state;
+        bool usesMidi;
+    };
+
+    struct GainProcessor  : public TestProcessor
+    {
+        GainProcessor (float gain_)  : TestProcessor (1, 1, 0, 0), gain (gain_) {}
+
+        void processBlock (AudioSampleBuffer& buffer, MidiBuffer&)
+        {
+            buffer.applyGain (gain);
+        }
+
+        const float gain;
+    };
+
+    // Builds a set of source -> effect -> effect chains that all feed the output,
+    // with each chain's first effect also feeding into its neighbour's second one,
+    // so that there are shared buffers and mixed inputs to deal with.
+    static void createTestGraph (AudioProcessorGraph& graph, const int numChains,
+                                 const int numThreads, const int workPerSample)
+    {
+        graph.setPlayConfigDetails (0, 2, 44100.0, testBlockSize);
+        graph.setNumRenderingThreads (numThreads);
+
+        const uint32 outputNode = graph.addNode (new AudioProcessorGraph::AudioGraphIOProcessor (AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode))->nodeId;
+
+        Array<uint32> firstEffects, secondEffects;
+
+        for (int i = 0; i < numChains; ++i)
+        {
+            const uint32 source = graph.addNode (new TestProcessor (0, 2, i + 1, 0))->nodeId;
+            firstEffects.add (graph.addNode (new TestProcessor (2, 2, 0, workPerSample))->nodeId);
+            secondEffects.add (graph.addNode (new TestProcessor (2, 2, 0, workPerSample))->nodeId);
+
+            for (int chan = 0; chan < 2; ++chan)
+            {
+                graph.addConnection (source, chan, firstEffects.getLast(), chan);
+                graph.addConnection (firstEffects.getLast(), chan, secondEffects.getLast(), chan);
+                graph.addConnection (secondEffects.getLast(), chan, outputNode, chan);
+            }
+        }
+
+        for (int i = 1; i < numChains; ++i)
+            graph.addConnection (firstEffects[i - 1], 0, secondEffects[i], 1);
+
+        graph.prepareToPlay (44100.0, testBlockSize);
+    }
+
+    static void createChainGraph (AudioProcessorGraph& graph, const bool scrambled)
+    {
+        enum { numNodes = 12 };
+
+        graph.setPlayConfigDetails (0, 2, 44100.0, testBlockSize);
+
+        uint32 nodeIds [numNodes];
+
+        for (int i = 0; i < numNodes; ++i)
+        {
+            const int n = scrambled ? (numNodes - 1 - i) : i;
+
+            nodeIds[n] = graph.addNode (n == numNodes - 1 ? static_cast<AudioProcessor*> (new AudioProcessorGraph::AudioGraphIOProcessor (AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode))
+                                                          : new TestProcessor (n == 0 ? 0 : 2, 2, 1, 1))->nodeId;
+        }
+
+        Array<int> connectionOrder;
+
+        for (int i = 0; i < numNodes - 1; ++i)
+            connectionOrder.add (i);
+
+        Random r (123);
+
+        if (scrambled)
+            for (int i = connectionOrder.size(); --i > 0;)
+                connectionOrder.swap (i, r.nextInt (i + 1));
+
+        for (int i = 0; i < connectionOrder.size(); ++i)
+        {
+            const int n = connectionOrder.getUnchecked(i);
+
+            for (int chan = 0; chan < 2; ++chan)
+                graph.addConnection (nodeIds[n], chan, nodeIds[n + 1], chan);
+        }
+
+        graph.prepareToPlay (44100.0, testBlockSize);
+    }
+
+    static AudioProcessorGraph::Node* addRandomNode (AudioProcessorGraph& graph, Random& r)
+    {
+        TestProcessor* const processor = new TestProcessor (r.nextInt (3), 1 + r.nextInt (2), 0, 0);
+        processor->usesMidi = r.nextBool();
+        processor->setLatencySamples (r.nextInt (3));
+
+        return graph.addNode (processor);
+    }
+
+    static bool haveSameOps (const GraphRenderingOps::RenderingOpList& first,
+                             const GraphRenderingOps::RenderingOpList& second)
+    {
+        if (first.ops.size() != second.ops.size()
+             || first.delays != second.delays
+             || first.processorCalls.size() != second.processorCalls.size())
+            return false;
+
+        for (int i = 0; i < first.ops.size(); ++i)
+        {
+            const GraphRenderingOps::RenderingOp& op1 = first.ops.getReference (i);
+            const GraphRenderingOps::RenderingOp& op2 = second.ops.getReference (i);
+
+            if (op1.type != op2.type || op1.source1 != op2.source1 || op1.source2 != op2.source2
+                 || op1.dest != op2.dest || op1.index != op2.index)
+                return false;
+        }
+
+        for (int i = 0; i < first.processorCalls.size(); ++i)
+        {
+            const GraphRenderingOps::ProcessorCallInfo& call1 = *first.processorCalls.getUnchecked (i);
+            const GraphRenderingOps::ProcessorCallInfo& call2 = *second.processorCalls.getUnchecked (i);
+
+            if (call1.node != call2.node || call1.audioChannelsToUse != call2.audioChannelsToUse
+                 || call1.totalChans != call2.totalChans || call1.midiBufferToUse != call2.midiBufferToUse)
+                return false;
+        }
+
+        return true;
+    }
+
+    static void renderBlock (AudioProcessorGraph& graph, AudioSampleBuffer& output)
+    {
+        MidiBuffer midi;
+        output.clear();
+
+        const ScopedLock sl (graph.getCallbackLock());
+        graph.processBlock (output, midi);
+    }
+
+    static double timeGraph (const int numChains, const int numThreads)
+    {
+        AudioProcessorGraph graph;
+        createTestGraph (graph, numChains, numThreads, 16);
+
+        AudioSampleBuffer output (2, testBlockSize);
+        renderBlock (graph, output);
+
+        const double startTime = Time::getMillisecondCounterHiRes();
+
+        for (int i = 0; i < 50; ++i)
+            renderBlock (graph, output);
+
+        return Time::getMillisecondCounterHiRes() - startTime;
+    }
+};
+
+static AudioProcessorGraphTests audioProcessorGraphTests;
+
+#endif
@@ -251,6 +251,28 @@ public:
     */
     static const int midiChannelIndex;
 
+    //==============================================================================
+    /** Sets the number of extra threads that the graph can use to render its nodes.
+
+        By default this is zero, and all the nodes are rendered one after another on
+        whichever thread calls processBlock(). If you set it to a higher number, the
+        graph will start that many high-priority worker threads, and any nodes which
+        don't depend on each other's output can be rendered at the same time. The
+        thread that calls processBlock() also joins in, so for a machine with N cores,
+        N - 1 is a sensible number to use.
+
+        The result is exactly the same as when rendering on a single thread, but bear
+        in mind that each processor's processBlock() method may now be called from one
+        of the worker threads rather than from the audio callback thread.
+
+        @see getNumRenderingThreads
+    */
+    void setNumRenderingThreads (int numThreads);
+
+    /** Returns the number of extra rendering threads that the graph is using.
+        @see setNumRenderingThreads
+    */
+    int getNumRenderingThreads() const noexcept;
 
     //==============================================================================
     /** A special type of AudioProcessor that can live inside an AudioProcessorGraph
@@ -390,10 +412,21 @@ private:
     //==============================================================================
     ReferenceCountedArray <Node> nodes;
     OwnedArray <Connection> connections;
+    Array<Node*> renderingOrder;
+    bool renderingOrderHasLoops;
     uint32 lastNodeId;
-    AudioSampleBuffer renderingBuffers;
-    OwnedArray <MidiBuffer> midiBuffers;
-    Array<void*> renderingOps;
+
+    class RenderingSequence;
+    RenderingSequence* currentSequence;
+    Atomic<RenderingSequence*> nextSequence, retiredSequences;
+
+    class RenderingHistory;
+    friend struct ContainerDeletePolicy<RenderingHistory>;
+    ScopedPointer<RenderingHistory> renderingHistory;
+
+    class ParallelRenderer;
+    friend struct ContainerDeletePolicy<ParallelRenderer>;
+    ScopedPointer<ParallelRenderer> parallelRenderer;
 
     friend class AudioGraphIOProcessor;
     AudioSampleBuffer* currentAudioInputBuffer;
@@ -404,7 +437,9 @@ private:
     void handleAsyncUpdate() override;
     void clearRenderingSequence();
     void buildRenderingSequence();
-    bool isAnInputTo (uint32 possibleInputId, uint32 possibleDestinationId, int recursionCheck) const;
+    void publishRenderingSequence (RenderingSequence*);
+    void retireRenderingSequence (RenderingSequence*) noexcept;
+    void deleteRetiredRenderingSequences();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioProcessorGraph)
 };
@@ -64,8 +64,17 @@ struct AudioThumbnail::MinMaxValue
                      std::abs ((int) values[1]));
     }
 
-    inline void read (InputStream& input)      { input.read (values, 2); }
-    inline void write (OutputStream& output)   { output.write (values, 2); }
+    inline void read (InputStream& input)           { input.read (values, 2); }
+    inline void write (OutputStream& output) const  { output.write (values, 2); }
+
+    /** Returns a value that spans the ranges of both of these. */
+    static MinMaxValue merge (const MinMaxValue& a, const MinMaxValue& b) noexcept
+    {
+        MinMaxValue v;
+        v.set (jmin (a.values[0], b.values[0]),
+               jmax (a.values[1], b.values[1]));
+        return v;
+    }
 
 private:
     char values[2];
@@ -77,19 +86,27 @@ class AudioThumbnail::LevelDataSource   : public TimeSliceClient
 public:
     LevelDataSource (AudioThumbnail& thumb, AudioFormatReader* newReader, int64 hash)
         : lengthInSamples (0), numSamplesFinished (0), sampleRate (0), numChannels (0),
-          hashCode (hash), owner (thumb), reader (newReader), lastReaderUseTime (0)
+          hashCode (hash), owner (thumb), reader (newReader), lastReaderUseTime (0),
+          readBuffer (1, 0), isGenerating (false)
     {
     }
 
     LevelDataSource (AudioThumbnail& thumb, InputSource* src)
         : lengthInSamples (0), numSamplesFinished (0), sampleRate (0), numChannels (0),
-          hashCode (src->hashCode()), owner (thumb), source (src), lastReaderUseTime (0)
+          hashCode (src->hashCode()), owner (thumb), source (src), lastReaderUseTime (0),
+          readBuffer (1, 0), isGenerating (false)
     {
     }
 
     ~LevelDataSource()
     {
+        if (scanJob != nullptr)
+            owner.cache.getThreadPool()->removeJob (scanJob, true, -1);
+
         owner.cache.getTimeSliceThread().removeTimeSliceClient (this);
+
+        const ScopedLock sl (readerLock);
+        finishGeneration();
     }
 
     enum { timeBeforeDeletingReader = 3000 };
@@ -111,7 +128,7 @@ public:
             if (lengthInSamples <= 0 || isFullyLoaded())
                 reader = nullptr;
             else
-                owner.cache.getTimeSliceThread().addTimeSliceClient (this);
+                startGeneration();
         }
     }
 
@@ -163,6 +180,9 @@ public:
             return -1;
         }
 
+        if (scanJob != nullptr)   // (the cache's thread pool is doing the work)
+            return 200;
+
         bool justFinished = false;
 
         {
@@ -185,6 +205,36 @@ public:
         return 200;
     }
 
+    ThreadPoolJob::JobStatus runScanJob (ThreadPoolJob& job)
+    {
+        for (;;)
+        {
+            if (job.shouldExit())
+                return ThreadPoolJob::jobHasFinished;
+
+            const ScopedLock sl (readerLock);
+
+            createReader();
+
+            if (reader == nullptr)
+            {
+                finishGeneration();
+                return ThreadPoolJob::jobHasFinished;
+            }
+
+            if (readNextBlock())
+                break;
+        }
+
+        owner.cache.storeThumb (owner, hashCode);
+
+        // the reader is kept open for a while in case it's needed for drawing, then the
+        // time-slice thread releases it
+        lastReaderUseTime = Time::getMillisecondCounter();
+        owner.cache.getTimeSliceThread().addTimeSliceClient (this);
+        return ThreadPoolJob::jobHasFinished;
+    }
+
     bool isFullyLoaded() const noexcept
     {
         return numSamplesFinished >= lengthInSamples;
@@ -206,6 +256,51 @@ private:
     ScopedPointer <AudioFormatReader> reader;
     CriticalSection readerLock;
     uint32 lastReaderUseTime;
+    AudioSampleBuffer readBuffer;
+    bool isGenerating;
+
+    class ScanJob  : public ThreadPoolJob
+    {
+    public:
+        ScanJob (LevelDataSource& s)  : ThreadPoolJob ("Thumbnail scan"), levelData (s) {}
+
+        JobStatus runJob() override     { return levelData.runScanJob (*this); }
+
+    private:
+        LevelDataSource& levelData;
+
+        JUCE_DECLARE_NON_COPYABLE (ScanJob)
+    };
+
+    ScopedPointer<ScanJob> scanJob;
+
+    void startGeneration()
+    {
+        isGenerating = true;
+        owner.cache.thumbnailGenerationStarted (lengthInSamples - numSamplesFinished);
+
+        if (ThreadPool* const pool = owner.cache.getThreadPool())
+        {
+            if (scanJob == nullptr)
+                scanJob = new ScanJob (*this);
+
+            if (! pool->contains (scanJob))
+                pool->addJob (scanJob, false);
+        }
+        else
+        {
+            owner.cache.getTimeSliceThread().addTimeSliceClient (this);
+        }
+    }
+
+    void finishGeneration()
+    {
+        if (isGenerating)
+        {
+            isGenerating = false;
+            owner.cache.thumbnailGenerationFinished (jmax ((int64) 0, lengthInSamples - numSamplesFinished));
+        }
+    }
 
     void createReader()
     {
@@ -230,72 +325,120 @@ private:
                 const int lastThumbIndex  = sampleToThumbSample (startSample + numToDo);
                 const int numThumbSamps = lastThumbIndex - firstThumbIndex;
 
-                HeapBlock<MinMaxValue> levelData ((size_t) numThumbSamps * 2);
-                MinMaxValue* levels[2] = { levelData, levelData + numThumbSamps };
-
-                for (int i = 0; i < numThumbSamps; ++i)
+                if (numThumbSamps > 0)
                 {
-                    float lowestLeft, highestLeft, lowestRight, highestRight;
+                    const int sampsPerThumbSample = owner.samplesPerThumbSample;
+                    const int numChans = (int) numChannels;
 
-                    reader->readMaxLevels ((firstThumbIndex + i) * owner.samplesPerThumbSample, owner.samplesPerThumbSample,
-                                           lowestLeft, highestLeft, lowestRight, highestRight);
+                    // read the whole block in one go, rather than making the reader
+                    // do a separate read for each thumbnail sample..
+                    readBuffer.setSize (numChans, numThumbSamps * sampsPerThumbSample, false, false, true);
+                    reader->read (readBuffer.getArrayOfChannels(), numChans,
+                                  firstThumbIndex * (int64) sampsPerThumbSample,
+                                  numThumbSamps * sampsPerThumbSample, true);
 
-                    levels[0][i].setFloat (lowestLeft, highestLeft);
-                    levels[1][i].setFloat (lowestRight, highestRight);
-                }
+                    HeapBlock<MinMaxValue> levelData ((size_t) (numThumbSamps * numChans));
+                    HeapBlock<MinMaxValue*> levels ((size_t) numChans);
+
+                    for (int chan = 0; chan < numChans; ++chan)
+                    {
+                        const float* const samples = readBuffer.getSampleData (chan);
+                        levels[chan] = levelData + chan * numThumbSamps;
+
+                        for (int i = 0; i < numThumbSamps; ++i)
+                        {
+                            float low, high;
+                            FloatVectorOperations::findMinAndMax (samples + i * sampsPerThumbSample,
+                                                                  sampsPerThumbSample, low, high);
+                            levels[chan][i].setFloat (low, high);
+                        }
+                    }
 
-                {
                     const ScopedUnlock su (readerLock);
-                    owner.setLevels (levels, firstThumbIndex, 2, numThumbSamps);
+                    owner.setLevels (levels, firstThumbIndex, numChans, numThumbSamps);
                 }
 
                 numSamplesFinished += numToDo;
                 lastReaderUseTime = Time::getMillisecondCounter();
+
+                if (isGenerating)
+                    owner.cache.thumbnailGenerationProgressed (numToDo);
             }
         }
 
-        return isFullyLoaded();
+        if (! isFullyLoaded())
+            return false;
+
+        finishGeneration();
+        return true;
     }
 };
 
 //==============================================================================
+/*  Holds the min/max values for one channel as a pyramid: level 0 is the thumbnail data
+    itself, and each level above it merges pairs of values from the one below, so that the
+    range of any span of samples can be found by looking at O (log n) values.
+
+    The levels are either owned by this object, or point into a memory-mapped thumbnail
+    file, in which case they get copied the first time anything is written to them.
+*/
 class AudioThumbnail::ThumbData
 {
 public:
     ThumbData (const int numThumbSamples)
-        : peakLevel (-1)
+        : size (0), peakLevel (-1)
     {
         ensureSize (numThumbSamples);
     }
 
-    inline MinMaxValue* getData (const int thumbSampleIndex) noexcept
+    ThumbData (const MinMaxValue* mappedData, const int numThumbSamples)
+        : size (numThumbSamples), peakLevel (-1)
     {
-        jassert (thumbSampleIndex < data.size());
-        return data.getRawDataPointer() + thumbSampleIndex;
+        for (int level = 0; level < getNumLevels (size); ++level)
+        {
+            mappedLevels.add (mappedData);
+            mappedData += getLevelSize (size, level);
+        }
     }
 
     int getSize() const noexcept
     {
-        return data.size();
+        return size;
+    }
+
+    inline const MinMaxValue& getValue (const int thumbSampleIndex) const noexcept
+    {
+        jassert (isPositiveAndBelow (thumbSampleIndex, size));
+        return getLevel (0) [thumbSampleIndex];
     }
 
     void getMinMax (int startSample, int endSample, MinMaxValue& result) const noexcept
     {
         if (startSample >= 0)
         {
-            endSample = jmin (endSample, data.size() - 1);
+            endSample = jmin (endSample, size - 1);
 
             char mx = -128;
             char mn = 127;
 
-            while (startSample <= endSample)
+            for (int level = 0; startSample <= endSample; ++level)
             {
-                const MinMaxValue& v = data.getReference (startSample);
+                const MinMaxValue* const values = getLevel (level);
+
+                if (endSample - startSample < 2 || level == getNumLevels (size) - 1)
+                {
+                    while (startSample <= endSample)
+                        include (values [startSample++], mn, mx);
 
-                if (v.getMinValue() < mn)  mn = v.getMinValue();
-                if (v.getMaxValue() > mx)  mx = v.getMaxValue();
+                    break;
+                }
+
+                // trim the ends until the range covers whole pairs, then move up a level..
+                if ((startSample & 1) != 0)  include (values [startSample++], mn, mx);
+                if ((endSample & 1) == 0)    include (values [endSample--], mn, mx);
 
-                ++startSample;
+                startSample >>= 1;
+                endSample >>= 1;
             }
 
             if (mn <= mx)
@@ -311,14 +454,17 @@ public:
     void write (const MinMaxValue* const values, const int startIndex, const int numValues)
     {
         resetPeak();
+        makeWritable();
 
-        if (startIndex + numValues > data.size())
+        if (startIndex + numValues > size)
             ensureSize (startIndex + numValues);
 
-        MinMaxValue* const dest = getData (startIndex);
+        MinMaxValue* const dest = levels.getUnchecked (0)->getRawDataPointer() + startIndex;
 
         for (int i = 0; i < numValues; ++i)
             dest[i] = values[i];
+
+        updateLevels (startIndex, startIndex + numValues);
     }
 
     void resetPeak() noexcept
@@ -329,28 +475,120 @@ public:
     int getPeak() noexcept
     {
         if (peakLevel < 0)
+            peakLevel = size > 0 ? getLevel (getNumLevels (size) - 1)->getPeak() : 0;
+
+        return peakLevel;
+    }
+
+    /** Writes all the levels, in the layout that the mapped constructor expects. */
+    void writeLevels (OutputStream& output) const
+    {
+        for (int level = 0; level < getNumLevels (size); ++level)
+            output.write (getLevel (level), sizeof (MinMaxValue) * (size_t) getLevelSize (size, level));
+    }
+
+    static int getNumLevels (int numThumbSamples) noexcept
+    {
+        int num = 1;
+
+        while (numThumbSamples > 1)
         {
-            for (int i = 0; i < data.size(); ++i)
-            {
-                const int peak = data[i].getPeak();
-                if (peak > peakLevel)
-                    peakLevel = peak;
-            }
+            numThumbSamples = (numThumbSamples + 1) / 2;
+            ++num;
         }
 
-        return peakLevel;
+        return num;
+    }
+
+    static int getLevelSize (const int numThumbSamples, const int level) noexcept
+    {
+        return level == 0 ? numThumbSamples
+                          : (int) ((numThumbSamples + ((int64) 1 << level) - 1) >> level);
+    }
+
+    static int64 getTotalSizeOfLevels (const int numThumbSamples) noexcept
+    {
+        int64 total = 0;
+
+        for (int level = 0; level < getNumLevels (numThumbSamples); ++level)
+            total += getLevelSize (numThumbSamples, level);
+
+        return total;
     }
 
 private:
-    Array <MinMaxValue> data;
-    int peakLevel;
+    OwnedArray<Array<MinMaxValue> > levels;
+    Array<const MinMaxValue*> mappedLevels;
+    int size, peakLevel;
+
+    const MinMaxValue* getLevel (const int level) const noexcept
+    {
+        return mappedLevels.size() > 0 ? mappedLevels.getUnchecked (level)
+                                       : levels.getUnchecked (level)->getRawDataPointer();
+    }
+
+    static void include (const MinMaxValue& v, char& mn, char& mx) noexcept
+    {
+        if (v.getMinValue() < mn)  mn = v.getMinValue();
+        if (v.getMaxValue() > mx)  mx = v.getMaxValue();
+    }
+
+    void makeWritable()
+    {
+        if (mappedLevels.size() > 0)
+        {
+            for (int level = 0; level < mappedLevels.size(); ++level)
+                levels.add (new Array<MinMaxValue> (mappedLevels.getUnchecked (level), getLevelSize (size, level)));
+
+            mappedLevels.clear();
+        }
+    }
 
     void ensureSize (const int thumbSamples)
     {
-        const int extraNeeded = thumbSamples - data.size();
-        if (extraNeeded > 0)
-            data.insertMultiple (-1, MinMaxValue(), extraNeeded);
+        const int oldSize = size;
+
+        if (thumbSamples > oldSize || levels.size() == 0)
+        {
+            size = jmax (size, thumbSamples);
+
+            for (int level = 0; level < getNumLevels (size); ++level)
+            {
+                if (level >= levels.size())
+                    levels.add (new Array<MinMaxValue>());
+
+                Array<MinMaxValue>& values = *levels.getUnchecked (level);
+                const int extraNeeded = getLevelSize (size, level) - values.size();
+
+                if (extraNeeded > 0)
+                    values.insertMultiple (-1, MinMaxValue(), extraNeeded);
+            }
+
+            // any newly-added upper levels must summarise the existing data
+            updateLevels (jmax (0, oldSize - 1), size);
+        }
     }
+
+    void updateLevels (int start, int end)
+    {
+        for (int level = 1; level < levels.size(); ++level)
+        {
+            const Array<MinMaxValue>& src = *levels.getUnchecked (level - 1);
+            MinMaxValue* const dest = levels.getUnchecked (level)->getRawDataPointer();
+            const int srcSize = src.size();
+
+            start >>= 1;
+            end = (end + 1) >> 1;
+
+            for (int i = start; i < end; ++i)
+            {
+                const MinMaxValue& a = src.getReference (i * 2);
+                dest[i] = MinMaxValue::merge (a, i * 2 + 1 < srcSize ? src.getReference (i * 2 + 1) : a);
+            }
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (ThumbData)
 };
 
 //==============================================================================
@@ -561,6 +799,7 @@ void AudioThumbnail::clearChannelData()
 {
     window->invalidate();
     channels.clear();
+    mappedFile = nullptr;
     totalSamples = numSamplesFinished = 0;
     numChannels = 0;
     sampleRate = 0;
@@ -607,9 +846,14 @@ bool AudioThumbnail::loadFrom (InputStream& rawInput)
 
     createChannels (numThumbnailSamples);
 
+    HeapBlock<MinMaxValue> values ((size_t) numThumbnailSamples * (size_t) numChannels);
+
     for (int i = 0; i < numThumbnailSamples; ++i)
         for (int chan = 0; chan < numChannels; ++chan)
-            channels.getUnchecked(chan)->getData(i)->read (input);
+            values [chan * numThumbnailSamples + i].read (input);
+
+    for (int chan = 0; chan < numChannels; ++chan)
+        channels.getUnchecked(chan)->write (values + chan * numThumbnailSamples, 0, numThumbnailSamples);
 
     return true;
 }
@@ -632,7 +876,108 @@ void AudioThumbnail::saveTo (OutputStream& output) const
 
     for (int i = 0; i < numThumbnailSamples; ++i)
         for (int chan = 0; chan < numChannels; ++chan)
-            channels.getUnchecked(chan)->getData(i)->write (output);
+            channels.getUnchecked(chan)->getValue(i).write (output);
+}
+
+//==============================================================================
+/*  The mappable file format is a 64-byte little-endian header, followed by each channel's
+    block of levels, as written by ThumbData::writeLevels().
+*/
+enum
+{
+    mappedThumbnailHeaderSize = 64,
+    maxMappedThumbnailChannels = 1024  // (anything more than this is assumed to be a corrupt file)
+};
+
+bool AudioThumbnail::saveToFile (const File& file) const
+{
+    TemporaryFile temp (file);
+
+    {
+        FileOutputStream output (temp.getFile());
+
+        if (output.failedToOpen())
+            return false;
+
+        const ScopedLock sl (lock);
+
+        const int numChans = jmin (numChannels, channels.size());
+        const int numThumbnailSamples = numChans == 0 ? 0 : channels.getUnchecked(0)->getSize();
+
+        jassert (numChans <= maxMappedThumbnailChannels); // this couldn't be loaded again
+
+        output.write ("jatp", 4);
+        output.writeInt (1);                          // Format version.
+        output.writeInt (samplesPerThumbSample);
+        output.writeInt64 (totalSamples);
+        output.writeInt64 (numSamplesFinished);
+        output.writeInt (numThumbnailSamples);
+        output.writeInt (numChans);
+        output.writeInt ((int) sampleRate);
+
+        while (output.getPosition() < mappedThumbnailHeaderSize)
+            output.writeByte (0);
+
+        for (int chan = 0; chan < numChans; ++chan)
+        {
+            // (all the channels must have the same length for the file to be read back)
+            jassert (channels.getUnchecked (chan)->getSize() == numThumbnailSamples);
+            channels.getUnchecked (chan)->writeLevels (output);
+        }
+
+        output.flush();
+
+        if (output.getStatus().failed())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+bool AudioThumbnail::loadFromFile (const File& file)
+{
+    ScopedPointer<MemoryMappedFile> newMappedFile (new MemoryMappedFile (file, MemoryMappedFile::readOnly));
+    const char* const header = static_cast<const char*> (newMappedFile->getData());
+
+    if (header == nullptr || newMappedFile->getSize() < mappedThumbnailHeaderSize
+         || memcmp (header, "jatp", 4) != 0)
+        return AudioThumbnailBase::loadFromFile (file);
+
+    if (ByteOrder::littleEndianInt (header + 4) != 1)
+        return false;
+
+    const int newSamplesPerThumbSample = (int) ByteOrder::littleEndianInt (header + 8);
+    const int numThumbnailSamples      = (int) ByteOrder::littleEndianInt (header + 28);
+    const int newNumChannels           = (int) ByteOrder::littleEndianInt (header + 32);
+
+    if (newSamplesPerThumbSample <= 0 || numThumbnailSamples < 0
+         || ! isPositiveAndNotGreaterThan (newNumChannels, (int) maxMappedThumbnailChannels)
+         || (int64) newMappedFile->getSize() < mappedThumbnailHeaderSize
+                                                 + newNumChannels * (int64) sizeof (MinMaxValue)
+                                             * ThumbData::getTotalSizeOfLevels (numThumbnailSamples))
+        return false;
+
+    newMappedFile->setAccessPattern (MemoryMappedFile::randomAccess);
+
+    const ScopedLock sl (lock);
+    clearChannelData();
+
+    samplesPerThumbSample = newSamplesPerThumbSample;
+    totalSamples       = (int64) ByteOrder::littleEndianInt64 (header + 12);
+    numSamplesFinished = (int64) ByteOrder::littleEndianInt64 (header + 20);
+    numChannels        = newNumChannels;
+    sampleRate         = (int) ByteOrder::littleEndianInt (header + 36);
+
+    const MinMaxValue* data = reinterpret_cast<const MinMaxValue*> (header + mappedThumbnailHeaderSize);
+
+    for (int chan = 0; chan < numChannels; ++chan)
+    {
+        channels.add (new ThumbData (data, numThumbnailSamples));
+        data += ThumbData::getTotalSizeOfLevels (numThumbnailSamples);
+    }
+
+    mappedFile = newMappedFile;
+    return true;
 }
 
 //==============================================================================
@@ -818,3 +1163,265 @@ void AudioThumbnail::drawChannels (Graphics& g, const Rectangle<int>& area, doub
                      startTimeSeconds, endTimeSeconds, i, verticalZoomFactor);
     }
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AudioThumbnailTests  : public UnitTest
+{
+public:
+    AudioThumbnailTests() : UnitTest ("AudioThumbnail") {}
+
+    enum { samplesPerThumbSample = 512 };
+
+    // With the sample rate equal to samplesPerThumbSample, each second of audio is one thumbnail value
+    static void getMinMax (const AudioThumbnail& thumb, int start, int end, int chan, float& mn, float& mx)
+    {
+        thumb.getApproximateMinMax ((double) start, (double) end, chan, mn, mx);
+    }
+
+    // Finds the range of some values by looking at each of them separately
+    static void getMinMaxOneByOne (const AudioThumbnail& thumb, int start, int end, int chan, float& mn, float& mx)
+    {
+        mn = 1.0f;
+        mx = -1.0f;
+
+        for (int i = start; i <= end; ++i)
+        {
+            float low, high;
+            getMinMax (thumb, i, i, chan, low, high);
+            mn = jmin (mn, low);
+            mx = jmax (mx, high);
+        }
+    }
+
+    void expectSameRanges (const AudioThumbnail& thumb, const AudioThumbnail& reference, const int numThumbSamples, Random& r)
+    {
+        expectEquals (thumb.getNumChannels(), reference.getNumChannels());
+        expectEquals (thumb.getTotalLength(), reference.getTotalLength());
+        expectEquals (thumb.getApproximatePeak(), reference.getApproximatePeak());
+
+        for (int i = 0; i < 300; ++i)
+        {
+            const int chan = r.nextInt (reference.getNumChannels());
+            const int start = r.nextInt (numThumbSamples);
+            const int end = jmin (numThumbSamples - 1, start + r.nextInt (i < 150 ? 8 : numThumbSamples));
+
+            float mn, mx, expectedMin, expectedMax;
+            getMinMax (thumb, start, end, chan, mn, mx);
+            getMinMaxOneByOne (reference, start, end, chan, expectedMin, expectedMax);
+
+            expectEquals (mn, expectedMin);
+            expectEquals (mx, expectedMax);
+        }
+    }
+
+    void addRandomBlock (AudioThumbnail& thumb, const int startThumbSample, const int numThumbSamples, Random& r)
+    {
+        AudioSampleBuffer buffer (2, numThumbSamples * samplesPerThumbSample);
+
+        for (int chan = 0; chan < buffer.getNumChannels(); ++chan)
+        {
+            float* const data = buffer.getSampleData (chan);
+            const float scale = r.nextFloat();
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                data[i] = (r.nextFloat() * 2.0f - 1.0f) * scale;
+        }
+
+        thumb.addBlock (startThumbSample * (int64) samplesPerThumbSample, buffer, 0, buffer.getNumSamples());
+    }
+
+    void runTest()
+    {
+        AudioFormatManager formatManager;
+        AudioThumbnailCache cache (4);
+        Random r (getRandom());
+
+        const int numThumbSamples = 1000 + r.nextInt (1000);
+
+        AudioThumbnail thumb (samplesPerThumbSample, formatManager, cache);
+        thumb.reset (2, samplesPerThumbSample, numThumbSamples * (int64) samplesPerThumbSample);
+
+        for (int pos = 0; pos < numThumbSamples;)
+        {
+            const int num = jmin (numThumbSamples - pos, 1 + r.nextInt (100));
+            addRandomBlock (thumb, pos, num, r);
+            pos += num;
+        }
+
+        beginTest ("Ranges");
+        expectSameRanges (thumb, thumb, numThumbSamples, r);
+
+        TemporaryFile temp (".thumb");
+        const File& file = temp.getFile();
+
+        {
+            beginTest ("Mapped files");
+            expect (thumb.saveToFile (file));
+
+            AudioThumbnail loaded (samplesPerThumbSample, formatManager, cache);
+            expect (loaded.loadFromFile (file));
+            expect (loaded.isFullyLoaded());
+            expectSameRanges (loaded, thumb, numThumbSamples, r);
+
+            beginTest ("Changing a mapped thumbnail");
+            addRandomBlock (loaded, numThumbSamples / 3, 50, r);
+            addRandomBlock (loaded, numThumbSamples - 10, 30, r);
+            expectSameRanges (loaded, loaded, numThumbSamples + 20, r);
+        }
+
+        {
+            beginTest ("Stream data in files");
+            expect (thumb.AudioThumbnailBase::saveToFile (file));
+
+            AudioThumbnail loaded (samplesPerThumbSample, formatManager, cache);
+            expect (loaded.loadFromFile (file));
+            expectSameRanges (loaded, thumb, numThumbSamples, r);
+        }
+
+        {
+            beginTest ("Corrupt mapped files");
+            expect (thumb.saveToFile (file));
+
+            MemoryBlock data;
+            expect (file.loadFileAsData (data));
+
+            // an empty thumbnail with an absurd number of channels would pass the size check
+            uint32* const header = static_cast<uint32*> (data.getData());
+            header[7] = ByteOrder::swapIfBigEndian ((uint32) 0);            // number of thumbnail samples
+            header[8] = ByteOrder::swapIfBigEndian ((uint32) 0x7fffffff);   // number of channels
+            expect (file.replaceWithData (data.getData(), data.getSize()));
+
+            AudioThumbnail loaded (samplesPerThumbSample, formatManager, cache);
+            expect (! loaded.loadFromFile (file));
+            expectEquals (loaded.getNumChannels(), 0);
+        }
+
+        {
+            beginTest ("Cache directory");
+            const File dir (File::getSpecialLocation (File::tempDirectory).getNonexistentChildFile ("thumbs", String::empty));
+            cache.setCacheDirectory (dir);
+            cache.storeThumb (thumb, 1234);
+            cache.clear();
+
+            AudioThumbnail loaded (samplesPerThumbSample, formatManager, cache);
+            expect (cache.loadThumb (loaded, 1234));
+            expectSameRanges (loaded, thumb, numThumbSamples, r);
+
+            loaded.clear();
+            cache.setCacheDirectory (File::nonexistent);
+            dir.deleteRecursively();
+        }
+
+        beginTest ("Generating with a thread pool");
+        testGeneration (formatManager, r);
+    }
+
+    void testGeneration (AudioFormatManager& formatManager, Random& r)
+    {
+        formatManager.registerBasicFormats();
+
+        const File dir (File::getSpecialLocation (File::tempDirectory).getNonexistentChildFile ("thumbs", String::empty));
+        dir.createDirectory();
+
+        const int numFiles = 6;
+        OwnedArray<File> files;
+        float levels [numFiles];
+
+        for (int i = 0; i < numFiles; ++i)
+        {
+            const File file (dir.getChildFile ("test" + String (i) + ".wav"));
+            const float level = 0.2f + 0.7f * r.nextFloat();
+            const int numSamples = 100000 + r.nextInt (100000);
+
+            AudioSampleBuffer buffer (2, numSamples);
+
+            for (int chan = 0; chan < 2; ++chan)
+                for (int j = 0; j < numSamples; ++j)
+                    *buffer.getSampleData (chan, j) = level * (float) std::sin (j * (0.01 + 0.02 * chan));
+
+            WavAudioFormat wav;
+            ScopedPointer<AudioFormatWriter> writer (wav.createWriterFor (new FileOutputStream (file), 44100.0, 2, 16, StringPairArray(), 0));
+            expect (writer != nullptr);
+            writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+
+            files.add (new File (file));
+            levels[i] = level;
+        }
+
+        {
+            const int numThreads = 3;
+            AudioThumbnailCache cache (numFiles, numThreads);
+            OwnedArray<AudioThumbnail> thumbs;
+
+            // Occupies all the pool's threads, so that the scans are queued until it's released
+            WaitableEvent release (true);
+            OwnedArray<BlockingJob> blockers;
+
+            for (int i = 0; i < numThreads; ++i)
+                cache.getThreadPool()->addJob (blockers.add (new BlockingJob (release)), false);
+
+            for (int i = 0; i < numFiles; ++i)
+            {
+                AudioThumbnail* const thumb = thumbs.add (new AudioThumbnail (samplesPerThumbSample, formatManager, cache));
+                expect (thumb->setSource (new FileInputSource (*files[i])));
+            }
+
+            expectEquals (cache.getNumThumbnailsBeingGenerated(), numFiles);
+            expectEquals (cache.getGenerationProgress(), 0.0);
+
+            release.signal();
+
+            double lastProgress = 0;
+            bool progressIsMonotonic = true;
+
+            for (int i = 0; i < 10000 && cache.getNumThumbnailsBeingGenerated() > 0; ++i)
+            {
+                const double progress = cache.getGenerationProgress();
+
+                if (progress < lastProgress || progress > 1.0)
+                    progressIsMonotonic = false;
+
+                lastProgress = progress;
+                Thread::sleep (1);
+            }
+
+            expect (progressIsMonotonic);
+            expectEquals (cache.getNumThumbnailsBeingGenerated(), 0);
+            expectEquals (cache.getGenerationProgress(), 1.0);
+
+            for (int i = 0; i < numThreads; ++i)
+                cache.getThreadPool()->removeJob (blockers.getUnchecked (i), true, -1);
+
+            for (int i = 0; i < numFiles; ++i)
+            {
+                expect (thumbs[i]->isFullyLoaded());
+                expect (std::abs (thumbs[i]->getApproximatePeak() - levels[i]) < 0.02f);
+
+                AudioThumbnail reloaded (samplesPerThumbSample, formatManager, cache);
+                expect (reloaded.setSource (new FileInputSource (*files[i])));
+                expect (reloaded.isFullyLoaded());   // (should have come from the cache)
+            }
+        }
+
+        dir.deleteRecursively();
+    }
+
+    struct BlockingJob  : public ThreadPoolJob
+    {
+        BlockingJob (WaitableEvent& e) : ThreadPoolJob ("Blocker"), event (e) {}
+
+        JobStatus runJob() override
+        {
+            event.wait (-1);
+            return jobHasFinished;
+        }
+
+        WaitableEvent& event;
+    };
+};
+
+static AudioThumbnailTests audioThumbnailTests;
+
+#endif
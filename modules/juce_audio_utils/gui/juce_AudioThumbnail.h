@@ -125,6 +125,27 @@ public:
     */
     void saveTo (OutputStream& output) const;
 
+    /** Saves the thumbnail data to a file in a format that loadFromFile() can memory-map.
+
+        As well as the thumbnail's own min/max values, the file contains a pyramid of
+        progressively lower-resolution copies of them, so that a thumbnail that's loaded
+        from it can be drawn at any zoom level without scanning all its data.
+        @see loadFromFile
+    */
+    bool saveToFile (const File& file) const override;
+
+    /** Loads a file that was written by saveToFile().
+
+        Rather than reading the data, this maps the file into memory, so re-opening even a very
+        large thumbnail is almost instantaneous, and only the parts that actually get drawn are
+        paged in. The file must not be modified while it's in use. If the thumbnail is later
+        changed, its data will be copied out of the file first.
+
+        For compatibility, a file containing data written by saveTo() will also be accepted.
+        @see saveToFile
+    */
+    bool loadFromFile (const File& file) override;
+
     //==============================================================================
     /** Returns the number of channels in the file. */
     int getNumChannels() const noexcept;
@@ -207,6 +228,7 @@ private:
 
     ScopedPointer<LevelDataSource> source;
     ScopedPointer<CachedWindow> window;
+    ScopedPointer<MemoryMappedFile> mappedFile;
     OwnedArray<ThumbData> channels;
 
     int32 samplesPerThumbSample;
@@ -91,6 +91,40 @@ public:
     */
     virtual void saveTo (OutputStream& output) const = 0;
 
+    /** Reloads the low res thumbnail data from a file.
+
+        The file should have been written by saveToFile(). The default implementation just
+        reads it with loadFrom(), but subclasses may use a faster format.
+        @see saveToFile
+    */
+    virtual bool loadFromFile (const File& file)
+    {
+        FileInputStream input (file);
+        return input.openedOk() && loadFrom (input);
+    }
+
+    /** Saves the low res thumbnail data to a file.
+
+        The default implementation writes the same data as saveTo(). The file is written
+        to a temporary file first, and then moved into place.
+        @see loadFromFile
+    */
+    virtual bool saveToFile (const File& file) const
+    {
+        TemporaryFile temp (file);
+
+        {
+            FileOutputStream output (temp.getFile());
+
+            if (output.failedToOpen())
+                return false;
+
+            saveTo (output);
+        }
+
+        return temp.overwriteTargetFileWithTemporary();
+    }
+
     //==============================================================================
     /** Returns the number of channels in the file. */
     virtual int getNumChannels() const noexcept = 0;
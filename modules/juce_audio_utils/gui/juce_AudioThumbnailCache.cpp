@@ -57,14 +57,29 @@ private:
 //==============================================================================
 AudioThumbnailCache::AudioThumbnailCache (const int maxNumThumbs)
     : thread ("thumb cache"),
-      maxNumThumbsToStore (maxNumThumbs)
+      maxNumThumbsToStore (maxNumThumbs),
+      numThumbsGenerating (0), numSamplesToGenerate (0), numSamplesGenerated (0)
 {
     jassert (maxNumThumbsToStore > 0);
     thread.startThread (2);
 }
 
+AudioThumbnailCache::AudioThumbnailCache (const int maxNumThumbs, const int numThreadsForGeneration)
+    : thread ("thumb cache"),
+      maxNumThumbsToStore (maxNumThumbs),
+      numThumbsGenerating (0), numSamplesToGenerate (0), numSamplesGenerated (0)
+{
+    jassert (maxNumThumbsToStore > 0);
+    jassert (numThreadsForGeneration > 0);
+
+    pool = new ThreadPool (jmax (1, numThreadsForGeneration));
+    thread.startThread (2);
+}
+
 AudioThumbnailCache::~AudioThumbnailCache()
 {
+    // all the thumbnails that use this cache must be deleted before it is!
+    jassert (pool == nullptr || pool->getNumJobs() == 0);
 }
 
 AudioThumbnailCache::ThumbnailCacheEntry* AudioThumbnailCache::findThumbFor (const int64 hash) const
@@ -99,6 +114,14 @@ bool AudioThumbnailCache::loadThumb (AudioThumbnailBase& thumb, const int64 hash
 {
     const ScopedLock sl (lock);
 
+    if (cacheDirectory != File::nonexistent)
+    {
+        const File file (getCacheFileFor (hashCode));
+
+        if (file.existsAsFile() && thumb.loadFromFile (file))
+            return true;
+    }
+
     if (ThumbnailCacheEntry* te = findThumbFor (hashCode))
     {
         te->lastUsed = Time::getMillisecondCounter();
@@ -132,9 +155,74 @@ void AudioThumbnailCache::storeThumb (const AudioThumbnailBase& thumb,
         thumb.saveTo (out);
     }
 
+    if (cacheDirectory != File::nonexistent)
+        thumb.saveToFile (getCacheFileFor (hashCode));
+
     saveNewlyFinishedThumbnail (thumb, hashCode);
 }
 
+void AudioThumbnailCache::setCacheDirectory (const File& directory)
+{
+    const ScopedLock sl (lock);
+    cacheDirectory = directory;
+
+    if (cacheDirectory != File::nonexistent)
+        cacheDirectory.createDirectory();
+}
+
+File AudioThumbnailCache::getCacheDirectory() const
+{
+    const ScopedLock sl (lock);
+    return cacheDirectory;
+}
+
+File AudioThumbnailCache::getCacheFileFor (const int64 hash) const
+{
+    return cacheDirectory.getChildFile (String::toHexString (hash) + ".thumb");
+}
+
+//==============================================================================
+int AudioThumbnailCache::getNumThumbnailsBeingGenerated() const
+{
+    const ScopedLock sl (progressLock);
+    return numThumbsGenerating;
+}
+
+double AudioThumbnailCache::getGenerationProgress() const
+{
+    const ScopedLock sl (progressLock);
+
+    return numSamplesToGenerate > 0 ? jlimit (0.0, 1.0, numSamplesGenerated / (double) numSamplesToGenerate)
+                                    : 1.0;
+}
+
+void AudioThumbnailCache::thumbnailGenerationStarted (const int64 numSamplesToScan)
+{
+    const ScopedLock sl (progressLock);
+
+    ++numThumbsGenerating;
+    numSamplesToGenerate += numSamplesToScan;
+}
+
+void AudioThumbnailCache::thumbnailGenerationProgressed (const int64 numSamplesScanned)
+{
+    const ScopedLock sl (progressLock);
+    numSamplesGenerated += numSamplesScanned;
+}
+
+void AudioThumbnailCache::thumbnailGenerationFinished (const int64 numSamplesNotScanned)
+{
+    const ScopedLock sl (progressLock);
+
+    numSamplesGenerated += numSamplesNotScanned;
+
+    if (--numThumbsGenerating <= 0)
+    {
+        numThumbsGenerating = 0;
+        numSamplesToGenerate = numSamplesGenerated = 0;
+    }
+}
+
 void AudioThumbnailCache::clear()
 {
     const ScopedLock sl (lock);
@@ -47,6 +47,18 @@ public:
     */
     explicit AudioThumbnailCache (int maxNumThumbsToStore);
 
+    /** Creates a cache object which uses a pool of threads to generate thumbnails.
+
+        Normally, thumbnails are generated a small chunk at a time on the cache's single
+        TimeSliceThread, so when many files are being scanned at once, they share that one
+        thread. With this constructor, each thumbnail that needs scanning gets a job in a
+        ThreadPool with the given number of threads, so several files are scanned in parallel.
+        The TimeSliceThread is still used to release readers that are no longer needed.
+
+        @see getGenerationProgress
+    */
+    AudioThumbnailCache (int maxNumThumbsToStore, int numThreadsForGeneration);
+
     /** Destructor. */
     virtual ~AudioThumbnailCache();
 
@@ -84,9 +96,62 @@ public:
     */
     void writeToStream (OutputStream& stream);
 
+    //==============================================================================
+    /** Gives the cache a directory in which to keep a file for each thumbnail that it stores.
+
+        Thumbnails are written there with AudioThumbnailBase::saveToFile() when they finish
+        loading, and when one is needed again, loadFromFile() is used to re-open it, which
+        an AudioThumbnail does by memory-mapping the file rather than copying its data.
+        This lets an app that displays a very large number of waveforms re-open them quickly
+        without holding them all in memory. Pass File::nonexistent to stop using a directory.
+    */
+    void setCacheDirectory (const File& directory);
+
+    /** Returns the directory that was set with setCacheDirectory(). */
+    File getCacheDirectory() const;
+
     /** Returns the thread that client thumbnails can use. */
     TimeSliceThread& getTimeSliceThread() noexcept      { return thread; }
 
+    /** Returns the pool that client thumbnails should use to generate their data, or
+        nullptr if this cache was created without one.
+    */
+    ThreadPool* getThreadPool() const noexcept          { return pool; }
+
+    //==============================================================================
+    /** Returns the number of thumbnails that are currently being generated. */
+    int getNumThumbnailsBeingGenerated() const;
+
+    /** Returns the overall progress of the thumbnails that are being generated, from 0 to 1.
+
+        This is measured in source samples, and covers all the thumbnails that have started
+        since the last time none were being generated, so it's useful for showing the progress
+        of a bulk import. When nothing is being generated, it returns 1.0.
+    */
+    double getGenerationProgress() const;
+
+    /** Called by a thumbnail when it starts scanning its source.
+
+        This is called automatically by the AudioThumbnail class, so you shouldn't
+        normally need to call it directly.
+    */
+    void thumbnailGenerationStarted (int64 numSamplesToScan);
+
+    /** Called by a thumbnail after it scans part of its source.
+
+        This is called automatically by the AudioThumbnail class, so you shouldn't
+        normally need to call it directly.
+    */
+    void thumbnailGenerationProgressed (int64 numSamplesScanned);
+
+    /** Called by a thumbnail when it stops scanning its source, either because it has
+        finished or because it was cleared.
+
+        This is called automatically by the AudioThumbnail class, so you shouldn't
+        normally need to call it directly.
+    */
+    void thumbnailGenerationFinished (int64 numSamplesNotScanned);
+
 protected:
     /** This can be overridden to provide a custom callback for saving thumbnails
         once they have finished being loaded.
@@ -101,15 +166,22 @@ protected:
 private:
     //==============================================================================
     TimeSliceThread thread;
+    ScopedPointer<ThreadPool> pool;
 
     class ThumbnailCacheEntry;
     friend struct ContainerDeletePolicy<ThumbnailCacheEntry>;
     OwnedArray<ThumbnailCacheEntry> thumbs;
     CriticalSection lock;
     int maxNumThumbsToStore;
+    File cacheDirectory;
+
+    CriticalSection progressLock;
+    int numThumbsGenerating;
+    int64 numSamplesToGenerate, numSamplesGenerated;
 
     ThumbnailCacheEntry* findThumbFor (int64 hash) const;
     int findOldestThumb() const;
+    File getCacheFileFor (int64 hash) const;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioThumbnailCache)
 };
@@ -95,6 +95,28 @@ public:
     /** Returns the section of the file at which the mapped memory represents. */
     Range<int64> getRange() const noexcept      { return range; }
 
+    //==============================================================================
+    /** The ways in which the mapped memory can be accessed, used by setAccessPattern(). */
+    enum AccessPattern
+    {
+        normalAccess,       /**< No particular pattern. This is how the OS treats a newly-mapped file. */
+        sequentialAccess,   /**< The data will be read in order, so the OS can read ahead aggressively. */
+        randomAccess        /**< The data will be read in no particular order, so reading ahead would be wasted. */
+    };
+
+    /** Tells the OS how the mapped memory is likely to be accessed.
+        This is just a hint, and will be ignored on platforms that don't support it.
+    */
+    void setAccessPattern (AccessPattern pattern) noexcept;
+
+    /** Asks the OS to start loading a section of the file into memory in the background,
+        so that it's ready by the time it's needed.
+
+        The range is in bytes from the start of the file, and will be clipped to the mapped
+        range. This is just a hint, and will be ignored on platforms that don't support it.
+    */
+    void prefetch (Range<int64> fileRange) noexcept;
+
 private:
     //==============================================================================
     void* address;
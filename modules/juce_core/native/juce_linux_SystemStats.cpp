@@ -146,6 +146,12 @@ void CPUInformation::initialise() noexcept
     hasSSE3  = flags.contains ("sse3");
     has3DNow = flags.contains ("3dnow");
 
+    // (the kernel only lists these if it's saving the AVX registers across context switches)
+    const StringArray flagList (StringArray::fromTokens (flags, false));
+    hasAVX   = flagList.contains ("avx");
+    hasAVX2  = hasAVX && flagList.contains ("avx2");
+    hasFMA   = hasAVX && flagList.contains ("fma");
+
     numCpus = LinuxStatsHelpers::getCpuInfo ("processor").getIntValue() + 1;
 }
 
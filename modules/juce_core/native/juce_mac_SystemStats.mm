@@ -80,6 +80,20 @@ void CPUInformation::initialise() noexcept
     hasSSE2  = (d & (1u << 26)) != 0;
     has3DNow = (b & (1u << 31)) != 0;
     hasSSE3  = (c & (1u <<  0)) != 0;
+
+    // AVX also needs the OS to be saving the upper halves of the YMM registers..
+    if ((c & (1u << 27)) != 0 && (c & (1u << 28)) != 0)
+    {
+        uint32 xcr0 = 0;
+        asm ("xgetbv" : "=a" (xcr0) : "c" (0) : "%edx");
+        hasAVX = (xcr0 & 6) == 6;
+    }
+
+    hasFMA = hasAVX && (c & (1u << 12)) != 0;
+
+    a = b = c = d = 0;
+    SystemStatsHelpers::doCPUID (a, b, c, d, 7);
+    hasAVX2 = hasAVX && (b & (1u << 5)) != 0;
    #endif
 
    #if JUCE_IOS || (MAC_OS_X_VERSION_MIN_REQUIRED >= MAC_OS_X_VERSION_10_5)
@@ -557,6 +557,30 @@ MemoryMappedFile::~MemoryMappedFile()
         close (fileHandle);
 }
 
+void MemoryMappedFile::setAccessPattern (const AccessPattern pattern) noexcept
+{
+    if (address != nullptr)
+        madvise (address, (size_t) range.getLength(),
+                 pattern == randomAccess ? MADV_RANDOM
+                                         : (pattern == sequentialAccess ? MADV_SEQUENTIAL : MADV_NORMAL));
+}
+
+void MemoryMappedFile::prefetch (Range<int64> fileRange) noexcept
+{
+    fileRange = fileRange.getIntersectionWith (range);
+
+    if (address != nullptr && ! fileRange.isEmpty())
+    {
+        // (the mapping starts on a page boundary, and madvise needs the address to do so too)
+        const int64 pageSize = sysconf (_SC_PAGE_SIZE);
+        const int64 offset = fileRange.getStart() - range.getStart();
+        const int64 alignedOffset = offset - (offset % pageSize);
+
+        madvise (addBytesToPointer (address, alignedOffset),
+                 (size_t) (fileRange.getEnd() - range.getStart() - alignedOffset), MADV_WILLNEED);
+    }
+}
+
 //==============================================================================
 #if JUCE_PROJUCER_LIVE_BUILD
 extern "C" const char* juce_getCurrentExecutablePath();
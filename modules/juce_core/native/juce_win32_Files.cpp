@@ -367,6 +367,10 @@ MemoryMappedFile::~MemoryMappedFile()
         CloseHandle ((HANDLE) fileHandle);
 }
 
+// (PrefetchVirtualMemory is only available from Windows 8, so these are just no-ops for now)
+void MemoryMappedFile::setAccessPattern (AccessPattern) noexcept   {}
+void MemoryMappedFile::prefetch (Range<int64>) noexcept            {}
+
 //==============================================================================
 int64 File::getSize() const
 {
@@ -112,6 +112,20 @@ void CPUInformation::initialise() noexcept
     hasSSE3  = IsProcessorFeaturePresent (13 /*PF_SSE3_INSTRUCTIONS_AVAILABLE*/) != 0;
     has3DNow = IsProcessorFeaturePresent (7  /*PF_AMD3D_INSTRUCTIONS_AVAILABLE*/) != 0;
 
+   #if JUCE_USE_INTRINSICS
+    int info [4];
+    __cpuid (info, 1);
+
+    // AVX also needs the OS to be saving the upper halves of the YMM registers..
+    if ((info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0)
+        hasAVX = (_xgetbv (0) & 6) == 6;
+
+    hasFMA = hasAVX && (info[2] & (1 << 12)) != 0;
+
+    __cpuidex (info, 7, 0);
+    hasAVX2 = hasAVX && (info[1] & (1 << 5)) != 0;
+   #endif
+
     SYSTEM_INFO systemInfo;
     GetNativeSystemInfo (&systemInfo);
     numCpus = (int) systemInfo.dwNumberOfProcessors;
@@ -67,7 +67,8 @@ struct CPUInformation
 {
     CPUInformation() noexcept
         : numCpus (0), hasMMX (false), hasSSE (false),
-          hasSSE2 (false), hasSSE3 (false), has3DNow (false)
+          hasSSE2 (false), hasSSE3 (false), has3DNow (false),
+          hasAVX (false), hasAVX2 (false), hasFMA (false)
     {
         initialise();
     }
@@ -75,7 +76,7 @@ struct CPUInformation
     void initialise() noexcept;
 
     int numCpus;
-    bool hasMMX, hasSSE, hasSSE2, hasSSE3, has3DNow;
+    bool hasMMX, hasSSE, hasSSE2, hasSSE3, has3DNow, hasAVX, hasAVX2, hasFMA;
 };
 
 static const CPUInformation& getCPUInformation() noexcept
@@ -90,6 +91,9 @@ bool SystemStats::hasSSE() noexcept           { return getCPUInformation().hasSS
 bool SystemStats::hasSSE2() noexcept          { return getCPUInformation().hasSSE2; }
 bool SystemStats::hasSSE3() noexcept          { return getCPUInformation().hasSSE3; }
 bool SystemStats::has3DNow() noexcept         { return getCPUInformation().has3DNow; }
+bool SystemStats::hasAVX() noexcept           { return getCPUInformation().hasAVX; }
+bool SystemStats::hasAVX2() noexcept          { return getCPUInformation().hasAVX2; }
+bool SystemStats::hasFMA() noexcept           { return getCPUInformation().hasFMA; }
 
 
 //==============================================================================
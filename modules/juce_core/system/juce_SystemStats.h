@@ -149,6 +149,9 @@ public:
     static bool hasSSE2() noexcept;  /**< Returns true if Intel SSE2 instructions are available. */
     static bool hasSSE3() noexcept;  /**< Returns true if Intel SSE2 instructions are available. */
     static bool has3DNow() noexcept; /**< Returns true if AMD 3DNOW instructions are available. */
+    static bool hasAVX() noexcept;   /**< Returns true if Intel AVX instructions are available, and the OS supports them. */
+    static bool hasAVX2() noexcept;  /**< Returns true if Intel AVX2 instructions are available, and the OS supports them. */
+    static bool hasFMA() noexcept;   /**< Returns true if the FMA3 fused multiply-add instructions are available, and the OS supports them. */
 
     //==============================================================================
     /** Finds out how much RAM is in the machine.
@@ -0,0 +1,747 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+
+class TiledRendererThreadPool  : private DeletedAtShutdown
+{
+public:
+    TiledRendererThreadPool()
+        : numThreads (jmax (1, SystemStats::getNumCpus() - 1)),
+          pool (numThreads)
+    {
+    }
+
+    ~TiledRendererThreadPool()
+    {
+        clearSingletonInstance();
+    }
+
+    juce_DeclareSingleton (TiledRendererThreadPool, false);
+
+    const int numThreads;
+    ThreadPool pool;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (TiledRendererThreadPool)
+};
+
+juce_ImplementSingleton (TiledRendererThreadPool)
+
+//==============================================================================
+class LowLevelGraphicsTiledSoftwareRenderer::Recording
+{
+public:
+    Recording (const Image& image, Point<int> origin, const RectangleList<int>& initialClip, int numTiles)
+        : nextTile (0)
+    {
+        RectangleList<int> area (initialClip);
+        area.clipTo (image.getBounds());
+        const Rectangle<int> bounds (area.getBounds());
+
+        if (numTiles <= 0)
+        {
+            numTiles = 1;
+
+            if (bounds.getWidth() * bounds.getHeight() >= minimumAreaForTiling && SystemStats::getNumCpus() > 1)
+                numTiles = jmin (bounds.getHeight() / minimumTileHeight,
+                                 SystemStats::getNumCpus() * tilesPerThread);
+        }
+
+        numTiles = jmin (numTiles, bounds.getHeight());
+
+        if (numTiles <= 1)
+        {
+            tiles.add (new TileContext (image, origin, initialClip));
+        }
+        else
+        {
+            // The tiles are full-width bands, so every horizontal run of pixels is
+            // rendered in one go, exactly as a single renderer would draw it.
+            const int tileHeight = (bounds.getHeight() + numTiles - 1) / numTiles;
+
+            for (int y = bounds.getY(); y < bounds.getBottom(); y += tileHeight)
+            {
+                RectangleList<int> tileClip (area);
+                tileClip.clipTo (Rectangle<int> (bounds.getX(), y, bounds.getWidth(), tileHeight));
+
+                if (! tileClip.isEmpty())
+                    tiles.add (new TileContext (image, origin, tileClip));
+            }
+        }
+    }
+
+    //==============================================================================
+    class TileContext  : public RenderingHelpers::StackBasedLowLevelGraphicsContext<RenderingHelpers::SoftwareRendererSavedState>
+    {
+    public:
+        TileContext (const Image& image, Point<int> origin, const RectangleList<int>& clip)
+            : RenderingHelpers::StackBasedLowLevelGraphicsContext<RenderingHelpers::SoftwareRendererSavedState>
+                (new RenderingHelpers::SoftwareRendererSavedState (image, clip, origin))
+        {
+        }
+
+        void fillTransformedGlyph (const EdgeTable& et)     { stack->fillTransformedGlyph (et); }
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE (TileContext)
+    };
+
+    //==============================================================================
+    struct Command
+    {
+        Command() {}
+        virtual ~Command() {}
+        virtual void perform (TileContext&) const = 0;
+
+        JUCE_DECLARE_NON_COPYABLE (Command)
+    };
+
+    struct SetOrigin  : public Command
+    {
+        SetOrigin (Point<int> o) : origin (o) {}
+        void perform (TileContext& c) const override    { c.setOrigin (origin); }
+        const Point<int> origin;
+    };
+
+    struct AddTransform  : public Command
+    {
+        AddTransform (const AffineTransform& t) : transform (t) {}
+        void perform (TileContext& c) const override    { c.addTransform (transform); }
+        const AffineTransform transform;
+    };
+
+    struct ClipToRectangle  : public Command
+    {
+        ClipToRectangle (const Rectangle<int>& r) : area (r) {}
+        void perform (TileContext& c) const override    { c.clipToRectangle (area); }
+        const Rectangle<int> area;
+    };
+
+    struct ClipToRectangleList  : public Command
+    {
+        ClipToRectangleList (const RectangleList<int>& r) : list (r) {}
+        void perform (TileContext& c) const override    { c.clipToRectangleList (list); }
+        const RectangleList<int> list;
+    };
+
+    struct ExcludeClipRectangle  : public Command
+    {
+        ExcludeClipRectangle (const Rectangle<int>& r) : area (r) {}
+        void perform (TileContext& c) const override    { c.excludeClipRectangle (area); }
+        const Rectangle<int> area;
+    };
+
+    struct ClipToPath  : public Command
+    {
+        ClipToPath (const Path& p, const AffineTransform& t) : path (p), transform (t) {}
+        void perform (TileContext& c) const override    { c.clipToPath (path, transform); }
+        const Path path;
+        const AffineTransform transform;
+    };
+
+    struct ClipToImageAlpha  : public Command
+    {
+        ClipToImageAlpha (const Image& im, const AffineTransform& t) : image (im), transform (t) {}
+        void perform (TileContext& c) const override    { c.clipToImageAlpha (image, transform); }
+        const Image image;
+        const AffineTransform transform;
+    };
+
+    struct SaveState  : public Command
+    {
+        void perform (TileContext& c) const override    { c.saveState(); }
+    };
+
+    struct RestoreState  : public Command
+    {
+        void perform (TileContext& c) const override    { c.restoreState(); }
+    };
+
+    struct BeginTransparencyLayer  : public Command
+    {
+        BeginTransparencyLayer (float o) : opacity (o) {}
+        void perform (TileContext& c) const override    { c.beginTransparencyLayer (opacity); }
+        const float opacity;
+    };
+
+    struct EndTransparencyLayer  : public Command
+    {
+        void perform (TileContext& c) const override    { c.endTransparencyLayer(); }
+    };
+
+    struct SetFill  : public Command
+    {
+        SetFill (const FillType& f) : fill (f) {}
+        void perform (TileContext& c) const override    { c.setFill (fill); }
+        const FillType fill;
+    };
+
+    struct SetOpacity  : public Command
+    {
+        SetOpacity (float o) : opacity (o) {}
+        void perform (TileContext& c) const override    { c.setOpacity (opacity); }
+        const float opacity;
+    };
+
+    struct SetInterpolationQuality  : public Command
+    {
+        SetInterpolationQuality (Graphics::ResamplingQuality q) : quality (q) {}
+        void perform (TileContext& c) const override    { c.setInterpolationQuality (quality); }
+        const Graphics::ResamplingQuality quality;
+    };
+
+    struct FillRect  : public Command
+    {
+        FillRect (const Rectangle<int>& r, bool replace) : area (r), replaceContents (replace) {}
+        void perform (TileContext& c) const override    { c.fillRect (area, replaceContents); }
+        const Rectangle<int> area;
+        const bool replaceContents;
+    };
+
+    struct FillRectFloat  : public Command
+    {
+        FillRectFloat (const Rectangle<float>& r) : area (r) {}
+        void perform (TileContext& c) const override    { c.fillRect (area); }
+        const Rectangle<float> area;
+    };
+
+    struct FillRectList  : public Command
+    {
+        FillRectList (const RectangleList<float>& r) : list (r) {}
+        void perform (TileContext& c) const override    { c.fillRectList (list); }
+        const RectangleList<float> list;
+    };
+
+    struct FillPath  : public Command
+    {
+        FillPath (const Path& p, const AffineTransform& t) : path (p), transform (t) {}
+        void perform (TileContext& c) const override    { c.fillPath (path, transform); }
+        const Path path;
+        const AffineTransform transform;
+    };
+
+    struct DrawImage  : public Command
+    {
+        DrawImage (const Image& im, const AffineTransform& t) : image (im), transform (t) {}
+        void perform (TileContext& c) const override    { c.drawImage (image, transform); }
+        const Image image;
+        const AffineTransform transform;
+    };
+
+    struct DrawGlyph  : public Command
+    {
+        DrawGlyph (int glyph, const AffineTransform& t) : glyphNumber (glyph), transform (t) {}
+        void perform (TileContext& c) const override    { c.drawGlyph (glyphNumber, transform); }
+        const int glyphNumber;
+        const AffineTransform transform;
+    };
+
+    struct FillTransformedGlyph  : public Command
+    {
+        FillTransformedGlyph (EdgeTable* et) : edgeTable (et) {}
+        void perform (TileContext& c) const override    { c.fillTransformedGlyph (*edgeTable); }
+        const ScopedPointer<EdgeTable> edgeTable;
+    };
+
+    struct DrawLine  : public Command
+    {
+        DrawLine (const Line<float>& l) : line (l) {}
+        void perform (TileContext& c) const override    { c.drawLine (line); }
+        const Line<float> line;
+    };
+
+    struct SetFont  : public Command
+    {
+        SetFont (const Font& f) : font (f) {}
+        void perform (TileContext& c) const override    { c.setFont (font); }
+        const Font font;
+    };
+
+    //==============================================================================
+    void add (Command* command)
+    {
+        commands.add (command);
+    }
+
+    void flush()
+    {
+        if (commands.size() == 0)
+            return;
+
+        if (tiles.size() == 1)
+        {
+            replay (*tiles.getUnchecked (0));
+        }
+        else
+        {
+            TiledRendererThreadPool& threads = *TiledRendererThreadPool::getInstance();
+
+            nextTile.set (0);
+
+            OwnedArray<TileJob> jobs;
+
+            for (int i = jmin (threads.numThreads, tiles.size() - 1); --i >= 0;)
+            {
+                TileJob* const job = new TileJob (*this);
+                jobs.add (job);
+                threads.pool.addJob (job, false);
+            }
+
+            renderTiles();
+
+            // (any jobs that haven't started yet will find no tiles left, so are just removed)
+            for (int i = jobs.size(); --i >= 0;)
+                threads.pool.removeJob (jobs.getUnchecked (i), false, -1);
+        }
+
+        commands.clear();
+    }
+
+private:
+    //==============================================================================
+    struct TileJob  : public ThreadPoolJob
+    {
+        TileJob (Recording& r) : ThreadPoolJob ("Tiled renderer"), owner (r) {}
+
+        JobStatus runJob() override
+        {
+            owner.renderTiles();
+            return jobHasFinished;
+        }
+
+        Recording& owner;
+
+        JUCE_DECLARE_NON_COPYABLE (TileJob)
+    };
+
+    OwnedArray<Command> commands;
+    OwnedArray<TileContext> tiles;
+    Atomic<int> nextTile;
+
+    enum
+    {
+        minimumAreaForTiling = 256 * 256,
+        minimumTileHeight = 32,
+        tilesPerThread = 4
+    };
+
+    void renderTiles()
+    {
+        for (;;)
+        {
+            const int index = ++nextTile - 1;
+
+            if (index >= tiles.size())
+                break;
+
+            replay (*tiles.getUnchecked (index));
+        }
+    }
+
+    void replay (TileContext& tile) const
+    {
+        for (int i = 0; i < commands.size(); ++i)
+            commands.getUnchecked (i)->perform (tile);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (Recording)
+};
+
+//==============================================================================
+LowLevelGraphicsTiledSoftwareRenderer::LowLevelGraphicsTiledSoftwareRenderer (const Image& image)
+    : RenderingHelpers::StackBasedLowLevelGraphicsContext<RenderingHelpers::SoftwareRendererSavedState>
+        (new RenderingHelpers::SoftwareRendererSavedState (image, image.getBounds())),
+      recording (new Recording (image, Point<int>(), RectangleList<int> (image.getBounds()), 0))
+{
+}
+
+LowLevelGraphicsTiledSoftwareRenderer::LowLevelGraphicsTiledSoftwareRenderer (const Image& image, Point<int> origin,
+                                                                              const RectangleList<int>& initialClip,
+                                                                              int numTiles)
+    : RenderingHelpers::StackBasedLowLevelGraphicsContext<RenderingHelpers::SoftwareRendererSavedState>
+        (new RenderingHelpers::SoftwareRendererSavedState (image, initialClip, origin)),
+      recording (new Recording (image, origin, initialClip, numTiles))
+{
+}
+
+LowLevelGraphicsTiledSoftwareRenderer::~LowLevelGraphicsTiledSoftwareRenderer()
+{
+    flush();
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::flush()
+{
+    recording->flush();
+}
+
+//==============================================================================
+// The base class's state is kept up to date with every call, so that clip and font
+// queries can be answered while recording. It never draws anything though.
+void LowLevelGraphicsTiledSoftwareRenderer::setOrigin (Point<int> o)
+{
+    stack->transform.setOrigin (o);
+    recording->add (new Recording::SetOrigin (o));
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::addTransform (const AffineTransform& t)
+{
+    stack->transform.addTransform (t);
+    recording->add (new Recording::AddTransform (t));
+}
+
+bool LowLevelGraphicsTiledSoftwareRenderer::clipToRectangle (const Rectangle<int>& r)
+{
+    recording->add (new Recording::ClipToRectangle (r));
+    return stack->clipToRectangle (r);
+}
+
+bool LowLevelGraphicsTiledSoftwareRenderer::clipToRectangleList (const RectangleList<int>& r)
+{
+    recording->add (new Recording::ClipToRectangleList (r));
+    return stack->clipToRectangleList (r);
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::excludeClipRectangle (const Rectangle<int>& r)
+{
+    stack->excludeClipRectangle (r);
+    recording->add (new Recording::ExcludeClipRectangle (r));
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::clipToPath (const Path& path, const AffineTransform& t)
+{
+    stack->clipToPath (path, t);
+    recording->add (new Recording::ClipToPath (path, t));
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::clipToImageAlpha (const Image& im, const AffineTransform& t)
+{
+    stack->clipToImageAlpha (im, t);
+    recording->add (new Recording::ClipToImageAlpha (im, t));
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::saveState()
+{
+    stack.save();
+    recording->add (new Recording::SaveState());
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::restoreState()
+{
+    stack.restore();
+    recording->add (new Recording::RestoreState());
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::beginTransparencyLayer (float opacity)
+{
+    // A layer has the same clip and transform as the state it was made from, so there's
+    // no need to allocate and composite a real layer just to keep track of them.
+    stack.save();
+    recording->add (new Recording::BeginTransparencyLayer (opacity));
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::endTransparencyLayer()
+{
+    stack.restore();
+    recording->add (new Recording::EndTransparencyLayer());
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::setFill (const FillType& fillType)
+{
+    stack->setFillType (fillType);
+    recording->add (new Recording::SetFill (fillType));
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::setOpacity (float newOpacity)
+{
+    stack->fillType.setOpacity (newOpacity);
+    recording->add (new Recording::SetOpacity (newOpacity));
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::setInterpolationQuality (Graphics::ResamplingQuality quality)
+{
+    stack->interpolationQuality = quality;
+    recording->add (new Recording::SetInterpolationQuality (quality));
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::fillRect (const Rectangle<int>& r, bool replace)
+{
+    if (! isClipEmpty())
+        recording->add (new Recording::FillRect (r, replace));
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::fillRect (const Rectangle<float>& r)
+{
+    if (! isClipEmpty())
+        recording->add (new Recording::FillRectFloat (r));
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::fillRectList (const RectangleList<float>& list)
+{
+    if (! isClipEmpty())
+        recording->add (new Recording::FillRectList (list));
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::fillPath (const Path& path, const AffineTransform& t)
+{
+    if (! isClipEmpty())
+        recording->add (new Recording::FillPath (path, t));
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::drawImage (const Image& im, const AffineTransform& t)
+{
+    if (! isClipEmpty())
+        recording->add (new Recording::DrawImage (im, t));
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::drawGlyph (int glyphNumber, const AffineTransform& t)
+{
+    if (! isClipEmpty())
+    {
+        if (stack->canUseGlyphCache (t))
+        {
+            // The cache singleton is created the first time it's asked for, which isn't
+            // thread-safe, so that has to happen here rather than on the tile threads.
+            RenderingHelpers::SoftwareRendererSavedState::GlyphCacheType::getInstance();
+
+            recording->add (new Recording::DrawGlyph (glyphNumber, t));
+        }
+        else
+        {
+            // Typefaces aren't safe to use from several threads at once, so glyphs that
+            // can't come from the (thread-safe) glyph cache are turned into paths up-front.
+            if (EdgeTable* const et = stack->createTransformedGlyph (glyphNumber, t))
+                recording->add (new Recording::FillTransformedGlyph (et));
+        }
+    }
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::drawLine (const Line<float>& line)
+{
+    if (! isClipEmpty())
+        recording->add (new Recording::DrawLine (line));
+}
+
+void LowLevelGraphicsTiledSoftwareRenderer::setFont (const Font& newFont)
+{
+    // (text drawing sets the font before every glyph, so avoid recording it each time)
+    if (newFont == stack->font)
+        return;
+
+    // Looking up the typeface here means the tiles will all share an already-resolved
+    // one, rather than racing to fill in the font's lazily-created typeface pointer.
+    newFont.getTypeface();
+
+    stack->font = newFont;
+    recording->add (new Recording::SetFont (newFont));
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class TiledSoftwareRendererTests  : public UnitTest
+{
+public:
+    TiledSoftwareRendererTests() : UnitTest ("LowLevelGraphicsTiledSoftwareRenderer") {}
+
+    static void drawScene (Graphics& g, int w, int h, const Image& sprite, int seed)
+    {
+        Random r (seed);
+        const float fw = (float) w, fh = (float) h;
+
+        g.fillAll (Colours::white);
+
+        for (int i = 0; i < 120; ++i)
+        {
+            const Colour c ((uint8) r.nextInt (256), (uint8) r.nextInt (256), (uint8) r.nextInt (256), (uint8) r.nextInt (256));
+
+            switch (i % 8)
+            {
+                case 0:
+                    g.setColour (c);
+                    g.fillRect (r.nextFloat() * fw, r.nextFloat() * fh, r.nextFloat() * fw * 0.5f, r.nextFloat() * fh * 0.5f);
+                    break;
+
+                case 1:
+                    g.setGradientFill (ColourGradient (c, r.nextFloat() * fw, r.nextFloat() * fh,
+                                                       c.contrasting(), r.nextFloat() * fw, r.nextFloat() * fh, i % 16 == 1));
+                    g.fillEllipse (r.nextFloat() * fw, r.nextFloat() * fh, r.nextFloat() * fw * 0.5f, r.nextFloat() * fh * 0.5f);
+                    break;
+
+                case 2:
+                    g.setOpacity (r.nextFloat());
+                    g.drawImageTransformed (sprite, AffineTransform::rotation (r.nextFloat() * 6.0f)
+                                                        .scaled (0.5f + r.nextFloat() * 2.0f)
+                                                        .translated (r.nextFloat() * fw, r.nextFloat() * fh));
+                    break;
+
+                case 3:
+                    g.setTiledImageFill (sprite, r.nextInt (100), r.nextInt (100), r.nextFloat());
+                    g.fillRect (r.nextInt (w), r.nextInt (h), r.nextInt (w / 2), r.nextInt (h / 2));
+                    break;
+
+                case 4:
+                {
+                    Graphics::ScopedSaveState ss (g);
+                    g.setColour (c);
+                    g.setFont (8.0f + r.nextFloat() * 40.0f);
+                    g.drawSingleLineText ("The quick brown fox", r.nextInt (w), r.nextInt (h));
+                    g.addTransform (AffineTransform::rotation (r.nextFloat() - 0.5f, fw * 0.5f, fh * 0.5f));
+                    g.drawSingleLineText ("jumps over the lazy dog", r.nextInt (w), r.nextInt (h));
+                    break;
+                }
+
+                case 5:
+                {
+                    Graphics::ScopedSaveState ss (g);
+                    g.reduceClipRegion (r.nextInt (w), r.nextInt (h), r.nextInt (w), r.nextInt (h));
+                    g.excludeClipRegion (Rectangle<int> (r.nextInt (w), r.nextInt (h), r.nextInt (w / 3), r.nextInt (h / 3)));
+                    g.setColour (c);
+                    g.drawLine (r.nextFloat() * fw, r.nextFloat() * fh, r.nextFloat() * fw, r.nextFloat() * fh, 1.0f + r.nextFloat() * 10.0f);
+                    break;
+                }
+
+                case 6:
+                {
+                    Path p;
+                    p.addStar (Point<float> (r.nextFloat() * fw, r.nextFloat() * fh), 7, 20.0f, 20.0f + r.nextFloat() * fh * 0.3f);
+
+                    Graphics::ScopedSaveState ss (g);
+                    g.reduceClipRegion (p);
+                    g.beginTransparencyLayer (r.nextFloat());
+                    g.setGradientFill (ColourGradient (c, 0, 0, c.contrasting(), fw, fh, false));
+                    g.fillAll();
+                    g.endTransparencyLayer();
+                    break;
+                }
+
+                default:
+                {
+                    Graphics::ScopedSaveState ss (g);
+                    g.addTransform (AffineTransform::rotation (r.nextFloat(), fw * 0.5f, fh * 0.5f));
+                    g.setColour (c);
+                    g.drawRoundedRectangle (r.nextFloat() * fw, r.nextFloat() * fh, r.nextFloat() * fw * 0.5f, r.nextFloat() * fh * 0.5f, 8.0f, 3.0f);
+                    break;
+                }
+            }
+        }
+    }
+
+    static Image createSprite()
+    {
+        Image sprite (Image::ARGB, 97, 61, true);
+        Graphics g (sprite);
+        g.setGradientFill (ColourGradient (Colours::red.withAlpha (0.7f), 0, 0, Colours::blue, 97, 61, false));
+        g.fillEllipse (0, 0, 97, 61);
+        g.setColour (Colours::green);
+        g.fillRect (20, 10, 30, 30);
+        return sprite;
+    }
+
+    static bool imagesAreIdentical (const Image& a, const Image& b)
+    {
+        const Image::BitmapData da (a, Image::BitmapData::readOnly);
+        const Image::BitmapData db (b, Image::BitmapData::readOnly);
+
+        for (int y = 0; y < a.getHeight(); ++y)
+            if (memcmp (da.getLinePointer (y), db.getLinePointer (y), (size_t) (a.getWidth() * da.pixelStride)) != 0)
+                return false;
+
+        return true;
+    }
+
+    void runTest() override
+    {
+        const Image sprite (createSprite());
+
+        beginTest ("Output matches the software renderer");
+
+        const Image::PixelFormat formats[] = { Image::ARGB, Image::RGB };
+
+        for (int i = 0; i < 6; ++i)
+        {
+            const int w = 700 + 37 * i, h = 500 + 53 * i;
+
+            RectangleList<int> clip (Rectangle<int> (13, 7, w - 40, h - 20));
+            clip.subtract (Rectangle<int> (w / 3, h / 4, w / 5, h / 2));
+
+            Image expected (formats[i & 1], w, h, true), actual (formats[i & 1], w, h, true);
+
+            {
+                LowLevelGraphicsSoftwareRenderer context (expected, Point<int> (5, -3), clip);
+                Graphics g (context);
+                drawScene (g, w, h, sprite, i);
+            }
+
+            {
+                // (the number of tiles is forced for most of these, so that they're rendered
+                // on several threads even on a single-core machine)
+                LowLevelGraphicsTiledSoftwareRenderer context (actual, Point<int> (5, -3), clip, i == 0 ? 0 : i * 5);
+                Graphics g (context);
+                drawScene (g, w, h, sprite, i);
+            }
+
+            expect (imagesAreIdentical (expected, actual));
+        }
+
+        beginTest ("4K repaint speed");
+
+        const int w = 3840, h = 2160, numRepaints = 5;
+        Image image (Image::ARGB, w, h, true);
+
+        double normalTime = 0, tiledTime = 0;
+
+        // (the first repaint fills the glyph cache and starts the pool's threads, so it isn't timed)
+        for (int i = -1; i < numRepaints; ++i)
+        {
+            const double start = Time::getMillisecondCounterHiRes();
+
+            {
+                LowLevelGraphicsSoftwareRenderer context (image);
+                Graphics g (context);
+                drawScene (g, w, h, sprite, i);
+            }
+
+            const double normalEnd = Time::getMillisecondCounterHiRes();
+
+            {
+                LowLevelGraphicsTiledSoftwareRenderer context (image);
+                Graphics g (context);
+                drawScene (g, w, h, sprite, i);
+            }
+
+            if (i >= 0)
+            {
+                normalTime += normalEnd - start;
+                tiledTime += Time::getMillisecondCounterHiRes() - normalEnd;
+            }
+        }
+
+        logMessage ("Average 4K repaint: " + String (normalTime / numRepaints, 1) + "ms single-threaded, "
+                      + String (tiledTime / numRepaints, 1) + "ms tiled on " + String (SystemStats::getNumCpus()) + " CPUs");
+    }
+};
+
+static TiledSoftwareRendererTests tiledSoftwareRendererTests;
+
+#endif
@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+
+#ifndef JUCE_LOWLEVELGRAPHICSTILEDSOFTWARERENDERER_H_INCLUDED
+#define JUCE_LOWLEVELGRAPHICSTILEDSOFTWARERENDERER_H_INCLUDED
+
+
+//==============================================================================
+/**
+    A software renderer that spreads its work across several CPU cores.
+
+    Rather than drawing straight away, this context records the drawing operations
+    it is given. When it is flushed (or deleted), the clip region is split into
+    horizontal bands and the recorded operations are replayed for each band on a
+    shared thread pool. Each band is rendered by its own software renderer state,
+    clipped to that band, so the output is pixel-identical to the output of a
+    LowLevelGraphicsSoftwareRenderer.
+
+    Recording has a small cost, so this only pays off when large areas are being
+    repainted, e.g. full-screen redraws on high resolution displays. Small
+    repaints are replayed directly on the calling thread.
+
+    To use it for a window's painting, override LookAndFeel::createGraphicsContext()
+    and return one of these.
+
+    Nothing will appear in the image until flush() has been called or the context
+    has been deleted, so the image mustn't be read while the context is still alive.
+    Likewise, images that are drawn are referenced rather than copied, so they
+    mustn't be modified until the operations that use them have been flushed.
+
+    @see LowLevelGraphicsSoftwareRenderer
+*/
+class JUCE_API  LowLevelGraphicsTiledSoftwareRenderer    : public RenderingHelpers::StackBasedLowLevelGraphicsContext<RenderingHelpers::SoftwareRendererSavedState>
+{
+public:
+    //==============================================================================
+    /** Creates a context to render into an image. */
+    LowLevelGraphicsTiledSoftwareRenderer (const Image& imageToRenderOnto);
+
+    /** Creates a context to render into a clipped subsection of an image.
+
+        The area is split into the given number of tiles, or if numTiles is 0, the
+        number is chosen to suit the size of the area and the number of CPUs.
+    */
+    LowLevelGraphicsTiledSoftwareRenderer (const Image& imageToRenderOnto, Point<int> origin,
+                                           const RectangleList<int>& initialClip, int numTiles = 0);
+
+    /** Destructor.
+        This renders any operations that haven't yet been flushed.
+    */
+    ~LowLevelGraphicsTiledSoftwareRenderer();
+
+    //==============================================================================
+    /** Renders all the operations recorded so far into the target image.
+        This blocks until all the tiles have been drawn. Drawing can carry on
+        afterwards, with the graphics state left as it was.
+    */
+    void flush();
+
+    //==============================================================================
+    void setOrigin (Point<int>) override;
+    void addTransform (const AffineTransform&) override;
+    bool clipToRectangle (const Rectangle<int>&) override;
+    bool clipToRectangleList (const RectangleList<int>&) override;
+    void excludeClipRectangle (const Rectangle<int>&) override;
+    void clipToPath (const Path&, const AffineTransform&) override;
+    void clipToImageAlpha (const Image&, const AffineTransform&) override;
+    void saveState() override;
+    void restoreState() override;
+    void beginTransparencyLayer (float opacity) override;
+    void endTransparencyLayer() override;
+    void setFill (const FillType&) override;
+    void setOpacity (float) override;
+    void setInterpolationQuality (Graphics::ResamplingQuality) override;
+    void fillRect (const Rectangle<int>&, bool replaceExistingContents) override;
+    void fillRect (const Rectangle<float>&) override;
+    void fillRectList (const RectangleList<float>&) override;
+    void fillPath (const Path&, const AffineTransform&) override;
+    void drawImage (const Image&, const AffineTransform&) override;
+    void drawGlyph (int glyphNumber, const AffineTransform&) override;
+    void drawLine (const Line<float>&) override;
+    void setFont (const Font&) override;
+
+private:
+    //==============================================================================
+    class Recording;
+    friend struct ContainerDeletePolicy<Recording>;
+    ScopedPointer<Recording> recording;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LowLevelGraphicsTiledSoftwareRenderer)
+};
+
+
+#endif   // JUCE_LOWLEVELGRAPHICSTILEDSOFTWARERENDERER_H_INCLUDED
@@ -103,6 +103,7 @@ class LowLevelGraphicsContext;
 #include "colour/juce_FillType.h"
 #include "native/juce_RenderingHelpers.h"
 #include "contexts/juce_LowLevelGraphicsSoftwareRenderer.h"
+#include "contexts/juce_LowLevelGraphicsTiledSoftwareRenderer.h"
 #include "contexts/juce_LowLevelGraphicsPostScriptRenderer.h"
 #include "effects/juce_ImageEffectFilter.h"
 #include "effects/juce_DropShadowEffect.h"
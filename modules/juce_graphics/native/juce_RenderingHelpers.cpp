@@ -0,0 +1,254 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2013 - Raw Material Software Ltd.
+
+   Permission is granted to use this software under the terms of either:
+   a) the GPL v2 (or any later version)
+   b) the Affero GPL v3
+
+   Details of these licenses can be found at: www.gnu.org/licenses
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.juce.com for more information.
+
+  ==============================================================================
+*/
+
+
+namespace RenderingHelpers
+{
+
+namespace PixelSpanHelpers
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    static bool sse2Present = false;
+
+    static bool isSSE2Available() noexcept
+    {
+        if (sse2Present)
+            return true;
+
+        sse2Present = SystemStats::hasSSE2();
+        return sse2Present;
+    }
+
+    // These work on four pixels at a time, with each of their components spread out into
+    // 16 bits, and do exactly the same sums as the PixelARGB methods.
+    static forcedinline __m128i getAlphas (const __m128i pixels) noexcept
+    {
+        return _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (pixels, _MM_SHUFFLE (PixelARGB::indexA, PixelARGB::indexA, PixelARGB::indexA, PixelARGB::indexA)),
+                                    _MM_SHUFFLE (PixelARGB::indexA, PixelARGB::indexA, PixelARGB::indexA, PixelARGB::indexA));
+    }
+
+    static forcedinline __m128i blendComponents (const __m128i src, const __m128i dest, const __m128i inverseAlpha) noexcept
+    {
+        return _mm_add_epi16 (src, _mm_srli_epi16 (_mm_mullo_epi16 (dest, inverseAlpha), 8));
+    }
+
+    static forcedinline __m128i blendPixels (const __m128i src, const __m128i dest) noexcept
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i x100 = _mm_set1_epi16 (0x100);
+
+        const __m128i srcLo = _mm_unpacklo_epi8 (src, zero);
+        const __m128i srcHi = _mm_unpackhi_epi8 (src, zero);
+
+        return _mm_packus_epi16 (blendComponents (srcLo, _mm_unpacklo_epi8 (dest, zero), _mm_sub_epi16 (x100, getAlphas (srcLo))),
+                                 blendComponents (srcHi, _mm_unpackhi_epi8 (dest, zero), _mm_sub_epi16 (x100, getAlphas (srcHi))));
+    }
+
+    static forcedinline __m128i blendPixels (const __m128i src, const __m128i dest, const __m128i extraAlpha) noexcept
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i x100 = _mm_set1_epi16 (0x100);
+
+        const __m128i srcLo = _mm_srli_epi16 (_mm_mullo_epi16 (_mm_unpacklo_epi8 (src, zero), extraAlpha), 8);
+        const __m128i srcHi = _mm_srli_epi16 (_mm_mullo_epi16 (_mm_unpackhi_epi8 (src, zero), extraAlpha), 8);
+
+        return _mm_packus_epi16 (blendComponents (srcLo, _mm_unpacklo_epi8 (dest, zero), _mm_sub_epi16 (x100, getAlphas (srcLo))),
+                                 blendComponents (srcHi, _mm_unpackhi_epi8 (dest, zero), _mm_sub_epi16 (x100, getAlphas (srcHi))));
+    }
+
+    static forcedinline __m128i load (const PixelARGB* p) noexcept        { return _mm_loadu_si128 ((const __m128i*) p); }
+    static forcedinline void store (PixelARGB* p, __m128i v) noexcept     { _mm_storeu_si128 ((__m128i*) p, v); }
+   #endif
+}
+
+//==============================================================================
+void PixelARGBSpans::fill (PixelARGB* dest, const PixelARGB colour, int width) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    if (PixelSpanHelpers::isSSE2Available())
+    {
+        const __m128i c = _mm_set1_epi32 ((int) colour.getARGB());
+
+        for (; width >= 4; width -= 4)
+        {
+            PixelSpanHelpers::store (dest, c);
+            dest += 4;
+        }
+    }
+   #endif
+
+    while (--width >= 0)
+        (dest++)->set (colour);
+}
+
+void PixelARGBSpans::blend (PixelARGB* dest, const PixelARGB colour, int width) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    if (PixelSpanHelpers::isSSE2Available())
+    {
+        using namespace PixelSpanHelpers;
+
+        // the source components and inverse alpha are the same for every pixel, so are only unpacked once
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i src = _mm_unpacklo_epi8 (_mm_set1_epi32 ((int) colour.getARGB()), zero);
+        const __m128i inverseAlpha = _mm_sub_epi16 (_mm_set1_epi16 (0x100), getAlphas (src));
+
+        for (; width >= 4; width -= 4)
+        {
+            const __m128i d = load (dest);
+
+            store (dest, _mm_packus_epi16 (blendComponents (src, _mm_unpacklo_epi8 (d, zero), inverseAlpha),
+                                           blendComponents (src, _mm_unpackhi_epi8 (d, zero), inverseAlpha)));
+            dest += 4;
+        }
+    }
+   #endif
+
+    while (--width >= 0)
+        (dest++)->blend (colour);
+}
+
+void PixelARGBSpans::blend (PixelARGB* dest, const PixelARGB* src, int width) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    if (PixelSpanHelpers::isSSE2Available())
+    {
+        using namespace PixelSpanHelpers;
+
+        for (; width >= 4; width -= 4)
+        {
+            store (dest, blendPixels (load (src), load (dest)));
+            dest += 4;
+            src += 4;
+        }
+    }
+   #endif
+
+    while (--width >= 0)
+        (dest++)->blend (*src++);
+}
+
+void PixelARGBSpans::blend (PixelARGB* dest, const PixelARGB* src, int width, const uint32 extraAlpha) noexcept
+{
+    jassert (extraAlpha <= 0x100);
+
+   #if JUCE_USE_SSE_INTRINSICS
+    if (PixelSpanHelpers::isSSE2Available())
+    {
+        using namespace PixelSpanHelpers;
+        const __m128i alpha = _mm_set1_epi16 ((short) extraAlpha);
+
+        for (; width >= 4; width -= 4)
+        {
+            store (dest, blendPixels (load (src), load (dest), alpha));
+            dest += 4;
+            src += 4;
+        }
+    }
+   #endif
+
+    while (--width >= 0)
+        (dest++)->blend (*src++, extraAlpha);
+}
+
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class PixelARGBSpansTests  : public UnitTest
+{
+public:
+    PixelARGBSpansTests() : UnitTest ("PixelARGBSpans") {}
+
+    void runTest()
+    {
+        beginTest ("Spans match the PixelARGB methods exactly");
+
+        enum { maxWidth = 67, bufferSize = maxWidth + 4 };
+
+        Random r (getRandom());
+        HeapBlock<PixelARGB> src (bufferSize), expected (bufferSize), actual (bufferSize);
+
+        for (int i = 0; i < 4000; ++i)
+        {
+            // random widths and start positions, so that the spans aren't always aligned
+            // and the SIMD loops are left with a few odd pixels at the end..
+            const int width = r.nextInt (maxWidth + 1);
+            const int start = r.nextInt (4);
+            const PixelARGB colour (createRandomPixel (r));
+            const uint32 extraAlpha = (uint32) r.nextInt (0x101);
+
+            for (int j = 0; j < bufferSize; ++j)
+            {
+                src[j] = createRandomPixel (r);
+                expected[j] = actual[j] = createRandomPixel (r);
+            }
+
+            PixelARGB* const e = expected + start;
+            PixelARGB* const a = actual + start;
+            const PixelARGB* const s = src + start;
+
+            switch (i % 4)
+            {
+                case 0:
+                    RenderingHelpers::PixelARGBSpans::fill (a, colour, width);
+                    for (int j = 0; j < width; ++j)  e[j].set (colour);
+                    break;
+
+                case 1:
+                    RenderingHelpers::PixelARGBSpans::blend (a, colour, width);
+                    for (int j = 0; j < width; ++j)  e[j].blend (colour);
+                    break;
+
+                case 2:
+                    RenderingHelpers::PixelARGBSpans::blend (a, s, width);
+                    for (int j = 0; j < width; ++j)  e[j].blend (s[j]);
+                    break;
+
+                default:
+                    RenderingHelpers::PixelARGBSpans::blend (a, s, width, extraAlpha);
+                    for (int j = 0; j < width; ++j)  e[j].blend (s[j], extraAlpha);
+                    break;
+            }
+
+            expect (memcmp (expected, actual, sizeof (PixelARGB) * bufferSize) == 0);
+        }
+    }
+
+    // the pixels need to be premultiplied, or the results can overflow
+    static PixelARGB createRandomPixel (Random& r)
+    {
+        const int alpha = r.nextInt (256);
+
+        return PixelARGB ((uint8) alpha,
+                          (uint8) r.nextInt (alpha + 1),
+                          (uint8) r.nextInt (alpha + 1),
+                          (uint8) r.nextInt (alpha + 1));
+    }
+};
+
+static PixelARGBSpansTests pixelARGBSpansTests;
+
+#endif
@@ -164,26 +164,27 @@ public:
     void drawGlyph (RenderTargetType& target, const Font& font, const int glyphNumber, Point<float> pos)
     {
         ++accessCounter;
-        CachedGlyphType* glyph = nullptr;
 
-        const ScopedReadLock srl (lock);
-
-        for (int i = glyphs.size(); --i >= 0;)
         {
-            CachedGlyphType* const g = glyphs.getUnchecked (i);
+            const ScopedReadLock srl (lock);
 
-            if (g->glyph == glyphNumber && g->font == font)
+            if (CachedGlyphType* const glyph = findGlyph (font, glyphNumber))
             {
-                glyph = g;
                 ++hits;
-                break;
+                glyph->lastAccessCount = accessCounter.value;
+                glyph->draw (target, pos);
+                return;
             }
         }
 
+        // The read lock has to be released before taking the write lock, otherwise two threads
+        // that miss at the same time would each wait forever for the other's read lock.
+        const ScopedWriteLock swl (lock);
+        CachedGlyphType* glyph = findGlyph (font, glyphNumber);
+
         if (glyph == nullptr)
         {
             ++misses;
-            const ScopedWriteLock swl (lock);
 
             if (hits.value + misses.value > glyphs.size() * 16)
             {
@@ -230,6 +231,19 @@ private:
             glyphs.add (new CachedGlyphType());
     }
 
+    CachedGlyphType* findGlyph (const Font& font, const int glyphNumber) const noexcept
+    {
+        for (int i = glyphs.size(); --i >= 0;)
+        {
+            CachedGlyphType* const g = glyphs.getUnchecked (i);
+
+            if (g->glyph == glyphNumber && g->font == font)
+                return g;
+        }
+
+        return nullptr;
+    }
+
     CachedGlyphType* findLeastRecentlyUsedGlyph() const noexcept
     {
         CachedGlyphType* oldest = glyphs.getLast();
@@ -549,6 +563,33 @@ namespace GradientPixelIterators
     };
 }
 
+//==============================================================================
+/** Fills and blends runs of contiguous PixelARGB values, using SIMD instructions
+    where they're available.
+
+    The results are exactly the same as calling the equivalent PixelARGB methods on
+    each pixel in turn.
+*/
+struct JUCE_API  PixelARGBSpans
+{
+    /** Sets each pixel to the given colour. */
+    static void fill (PixelARGB* dest, PixelARGB colour, int width) noexcept;
+
+    /** Blends the given colour onto each pixel. */
+    static void blend (PixelARGB* dest, PixelARGB colour, int width) noexcept;
+
+    /** Blends each source pixel onto the corresponding destination pixel. */
+    static void blend (PixelARGB* dest, const PixelARGB* src, int width) noexcept;
+
+    /** Blends each source pixel onto the corresponding destination pixel, with an
+        extra opacity (0 to 0x100) applied to the source.
+    */
+    static void blend (PixelARGB* dest, const PixelARGB* src, int width, uint32 extraAlpha) noexcept;
+
+    /** Runs that are shorter than this are quicker to do one pixel at a time. */
+    enum { minimumWidth = 8 };
+};
+
 #define JUCE_PERFORM_PIXEL_OP_LOOP(op) \
 { \
     const int destStride = destData.pixelStride;  \
@@ -634,11 +675,20 @@ namespace EdgeTableFillers
             return addBytesToPointer (linePixels, x * destData.pixelStride);
         }
 
-        inline void blendLine (PixelType* dest, const PixelARGB colour, int width) const noexcept
+        template <class DestPixelType>
+        inline void blendLine (DestPixelType* dest, const PixelARGB colour, int width) const noexcept
         {
             JUCE_PERFORM_PIXEL_OP_LOOP (blend (colour))
         }
 
+        inline void blendLine (PixelARGB* dest, const PixelARGB colour, int width) const noexcept
+        {
+            if (destData.pixelStride == sizeof (*dest) && width >= PixelARGBSpans::minimumWidth)
+                PixelARGBSpans::blend (dest, colour, width);
+            else
+                JUCE_PERFORM_PIXEL_OP_LOOP (blend (colour))
+        }
+
         forcedinline void replaceLine (PixelRGB* dest, const PixelARGB colour, int width) const noexcept
         {
             if (destData.pixelStride == sizeof (*dest))
@@ -694,7 +744,10 @@ namespace EdgeTableFillers
 
         forcedinline void replaceLine (PixelARGB* dest, const PixelARGB colour, int width) const noexcept
         {
-            JUCE_PERFORM_PIXEL_OP_LOOP (set (colour))
+            if (destData.pixelStride == sizeof (*dest) && width >= PixelARGBSpans::minimumWidth)
+                PixelARGBSpans::fill (dest, colour, width);
+            else
+                JUCE_PERFORM_PIXEL_OP_LOOP (set (colour))
         }
 
         JUCE_DECLARE_NON_COPYABLE (SolidColour)
@@ -731,24 +784,59 @@ namespace EdgeTableFillers
 
         void handleEdgeTableLine (int x, int width, const int alphaLevel) const noexcept
         {
-            PixelType* dest = getPixel (x);
-
-            if (alphaLevel < 0xff)
-                JUCE_PERFORM_PIXEL_OP_LOOP (blend (GradientType::getPixel (x++), (uint32) alphaLevel))
-            else
-                JUCE_PERFORM_PIXEL_OP_LOOP (blend (GradientType::getPixel (x++)))
+            blendLine (getPixel (x), x, width, alphaLevel);
         }
 
         void handleEdgeTableLineFull (int x, int width) const noexcept
         {
-            PixelType* dest = getPixel (x);
-            JUCE_PERFORM_PIXEL_OP_LOOP (blend (GradientType::getPixel (x++)))
+            blendLine (getPixel (x), x, width, 0xff);
         }
 
     private:
         const Image::BitmapData& destData;
         PixelType* linePixels;
 
+        template <class DestPixelType>
+        inline void blendLine (DestPixelType* dest, int x, int width, const int alphaLevel) const noexcept
+        {
+            if (alphaLevel < 0xff)
+                JUCE_PERFORM_PIXEL_OP_LOOP (blend (GradientType::getPixel (x++), (uint32) alphaLevel))
+            else
+                JUCE_PERFORM_PIXEL_OP_LOOP (blend (GradientType::getPixel (x++)))
+        }
+
+        inline void blendLine (PixelARGB* dest, int x, int width, const int alphaLevel) const noexcept
+        {
+            if (destData.pixelStride != sizeof (*dest) || width < PixelARGBSpans::minimumWidth)
+            {
+                if (alphaLevel < 0xff)
+                    JUCE_PERFORM_PIXEL_OP_LOOP (blend (GradientType::getPixel (x++), (uint32) alphaLevel))
+                else
+                    JUCE_PERFORM_PIXEL_OP_LOOP (blend (GradientType::getPixel (x++)))
+
+                return;
+            }
+
+            // The gradient colours are looked up in chunks, which can then be blended in one go.
+            PixelARGB colours [64];
+
+            while (width > 0)
+            {
+                const int num = jmin (width, numElementsInArray (colours));
+
+                for (int i = 0; i < num; ++i)
+                    colours[i] = GradientType::getPixel (x++);
+
+                if (alphaLevel < 0xff)
+                    PixelARGBSpans::blend (dest, colours, num, (uint32) alphaLevel);
+                else
+                    PixelARGBSpans::blend (dest, colours, num);
+
+                dest += num;
+                width -= num;
+            }
+        }
+
         forcedinline PixelType* getPixel (const int x) const noexcept
         {
             return addBytesToPointer (linePixels, x * destData.pixelStride);
@@ -807,17 +895,7 @@ namespace EdgeTableFillers
 
             jassert (repeatPattern || (x >= 0 && x + width <= srcData.width));
 
-            if (alphaLevel < 0xfe)
-            {
-                JUCE_PERFORM_PIXEL_OP_LOOP (blend (*getSrcPixel (repeatPattern ? (x++ % srcData.width) : x++), (uint32) alphaLevel))
-            }
-            else
-            {
-                if (repeatPattern)
-                    JUCE_PERFORM_PIXEL_OP_LOOP (blend (*getSrcPixel (x++ % srcData.width)))
-                else
-                    copyRow (dest, getSrcPixel (x), width);
-            }
+            blendLine (dest, x, width, alphaLevel);
         }
 
         void handleEdgeTableLineFull (int x, int width) const noexcept
@@ -827,17 +905,7 @@ namespace EdgeTableFillers
 
             jassert (repeatPattern || (x >= 0 && x + width <= srcData.width));
 
-            if (extraAlpha < 0xfe)
-            {
-                JUCE_PERFORM_PIXEL_OP_LOOP (blend (*getSrcPixel (repeatPattern ? (x++ % srcData.width) : x++), (uint32) extraAlpha))
-            }
-            else
-            {
-                if (repeatPattern)
-                    JUCE_PERFORM_PIXEL_OP_LOOP (blend (*getSrcPixel (x++ % srcData.width)))
-                else
-                    copyRow (dest, getSrcPixel (x), width);
-            }
+            blendLine (dest, x, width, extraAlpha);
         }
 
         void clipEdgeTableLine (EdgeTable& et, int x, int y, int width)
@@ -869,7 +937,67 @@ namespace EdgeTableFillers
             return addBytesToPointer (sourceLineStart, x * srcData.pixelStride);
         }
 
-        forcedinline void copyRow (DestPixelType* dest, SrcPixelType const* src, int width) const noexcept
+        // x is the position in the source image
+        void blendLine (DestPixelType* dest, int x, int width, const int alphaLevel) const noexcept
+        {
+            if (repeatPattern)
+            {
+                // (each run of pixels that doesn't wrap around the edge of the source can be done in one go)
+                while (width > 0)
+                {
+                    const int srcX = x % srcData.width;
+                    const int num = jmin (width, srcData.width - srcX);
+
+                    blendRow (dest, getSrcPixel (srcX), num, alphaLevel);
+
+                    dest = addBytesToPointer (dest, num * destData.pixelStride);
+                    x += num;
+                    width -= num;
+                }
+            }
+            else
+            {
+                blendRow (dest, getSrcPixel (x), width, alphaLevel);
+            }
+        }
+
+        forcedinline void blendRow (DestPixelType* dest, SrcPixelType const* src, int width, const int alphaLevel) const noexcept
+        {
+            if (alphaLevel < 0xfe)
+                blendRowWithAlpha (dest, src, width, (uint32) alphaLevel);
+            else
+                copyRow (dest, src, width);
+        }
+
+        template <class DestType, class SrcType>
+        forcedinline void blendRowWithAlpha (DestType* dest, SrcType const* src, int width, const uint32 alphaLevel) const noexcept
+        {
+            const int destStride = destData.pixelStride;
+            const int srcStride = srcData.pixelStride;
+
+            do
+            {
+                dest->blend (*src, alphaLevel);
+                dest = addBytesToPointer (dest, destStride);
+                src = addBytesToPointer (src, srcStride);
+            } while (--width > 0);
+        }
+
+        forcedinline void blendRowWithAlpha (PixelARGB* dest, PixelARGB const* src, int width, const uint32 alphaLevel) const noexcept
+        {
+            if (destData.pixelStride == sizeof (PixelARGB) && srcData.pixelStride == sizeof (PixelARGB)
+                 && width >= PixelARGBSpans::minimumWidth)
+            {
+                PixelARGBSpans::blend (dest, src, width, alphaLevel);
+            }
+            else
+            {
+                blendRowWithAlpha<PixelARGB, PixelARGB> (dest, src, width, alphaLevel);
+            }
+        }
+
+        template <class DestType, class SrcType>
+        forcedinline void copyRow (DestType* dest, SrcType const* src, int width) const noexcept
         {
             if (srcData.pixelStride == 3 && destData.pixelStride == 3)
             {
@@ -889,6 +1017,19 @@ namespace EdgeTableFillers
             }
         }
 
+        forcedinline void copyRow (PixelARGB* dest, PixelARGB const* src, int width) const noexcept
+        {
+            if (destData.pixelStride == sizeof (PixelARGB) && srcData.pixelStride == sizeof (PixelARGB)
+                 && width >= PixelARGBSpans::minimumWidth)
+            {
+                PixelARGBSpans::blend (dest, src, width);
+            }
+            else
+            {
+                copyRow<PixelARGB, PixelARGB> (dest, src, width);
+            }
+        }
+
         JUCE_DECLARE_NON_COPYABLE (ImageFill)
     };
 
@@ -2456,7 +2597,7 @@ public:
     {
         if (clip != nullptr)
         {
-            if (trans.isOnlyTranslation() && ! transform.isRotated)
+            if (canUseGlyphCache (trans))
             {
                 GlyphCacheType& cache = GlyphCacheType::getInstance();
 
@@ -2482,19 +2623,37 @@ public:
             }
             else
             {
-                const float fontHeight = font.getHeight();
-
-                AffineTransform t (transform.getTransformWith (AffineTransform::scale (fontHeight * font.getHorizontalScale(), fontHeight)
-                                                                               .followedBy (trans)));
-
-                const ScopedPointer<EdgeTable> et (font.getTypeface()->getEdgeTableForGlyph (glyphNumber, t, fontHeight));
+                const ScopedPointer<EdgeTable> et (createTransformedGlyph (glyphNumber, trans));
 
                 if (et != nullptr)
-                    fillShape (new EdgeTableRegionType (*et), false);
+                    fillTransformedGlyph (*et);
             }
         }
     }
 
+    /** True if drawGlyph() will render a glyph with this transform from the glyph cache. */
+    bool canUseGlyphCache (const AffineTransform& trans) const noexcept
+    {
+        return trans.isOnlyTranslation() && ! transform.isRotated;
+    }
+
+    /** Creates the device-space edge table that drawGlyph() fills when the cache can't be used. */
+    EdgeTable* createTransformedGlyph (int glyphNumber, const AffineTransform& trans) const
+    {
+        const float fontHeight = font.getHeight();
+
+        AffineTransform t (transform.getTransformWith (AffineTransform::scale (fontHeight * font.getHorizontalScale(), fontHeight)
+                                                                       .followedBy (trans)));
+
+        return font.getTypeface()->getEdgeTableForGlyph (glyphNumber, t, fontHeight);
+    }
+
+    void fillTransformedGlyph (const EdgeTable& et)
+    {
+        if (clip != nullptr)
+            fillShape (new EdgeTableRegionType (et), false);
+    }
+
     Rectangle<int> getMaximumBounds() const     { return image.getBounds(); }
 
     //==============================================================================